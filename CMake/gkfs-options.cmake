@@ -229,6 +229,13 @@ gkfs_define_option(
 
 cmake_dependent_option(GKFS_INSTALL_TESTS "Install GekkoFS self tests" OFF "GKFS_BUILD_TESTS" OFF)
 
+# build microbenchmarks
+gkfs_define_option(
+  GKFS_BUILD_BENCHMARKS
+  HELP_TEXT "Build the ${PROJECT_NAME} microbenchmarks (gkfs_microbench)"
+  DEFAULT_VALUE OFF
+)
+
 
 ################################################################################
 # Variables and options controlling POSIX semantics
@@ -17,12 +17,20 @@ import collections
 
 file = sys.argv[1]
 
+# matches the trace_reads lines of the clients. Chunks are assigned to the
+# node of the client that read them. The hot chunk lines of the daemon stats
+# file (--enable-chunkstats) name the daemon that served the read instead and
+# are not valid input.
 pattern = re.compile(r".+(read\ )(.*)( host: )(\d+).+(path: )(.+),.+(chunk_start: )(\d+).+(chunk_end: )(\d+)")
+daemon_stats = re.compile(r"^hot (read|write) ")
 
 d = collections.OrderedDict()
 
 with open(file) as f:
     for line in f:
+        if daemon_stats.match(line):
+            sys.exit("{}: daemon stats do not record the reading client, "
+                     "use a trace_reads log instead".format(file))
         result = pattern.match(line)
         if result:
             d[result.group(2)] = 1
@@ -0,0 +1,67 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef GEKKOFS_CLIENT_CAPTURE_HPP
+#define GEKKOFS_CLIENT_CAPTURE_HPP
+
+#include <common/capture_util.hpp>
+
+#include <string>
+
+namespace gkfs::capture {
+
+/**
+ * A syscall being captured. Only syscalls on GekkoFS files, i.e., on paths
+ * in the mountdir or on GekkoFS file descriptors, are captured.
+ */
+struct call {
+    bool active = false;
+    uint64_t start = 0;
+    record rec{};
+    std::string path;
+    std::string path2;
+};
+
+/**
+ * @brief Starts capturing a syscall before it is executed. The call is
+ * inactive if capturing is disabled (LIBGKFS_CAPTURE_DIR) or the syscall is
+ * not GekkoFS-bound.
+ */
+call
+begin(long syscall_number, long arg0, long arg1, long arg2, long arg3,
+      long arg4);
+
+/**
+ * @brief Records an active call with the result of the syscall
+ */
+void
+end(call& c, long result);
+
+} // namespace gkfs::capture
+
+#endif // GEKKOFS_CLIENT_CAPTURE_HPP
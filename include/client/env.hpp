@@ -46,6 +46,10 @@ static constexpr auto LOG_SYSCALL_FILTER = ADD_PREFIX("LOG_SYSCALL_FILTER");
 
 static constexpr auto LOG_OUTPUT = ADD_PREFIX("LOG_OUTPUT");
 static constexpr auto LOG_OUTPUT_TRUNC = ADD_PREFIX("LOG_OUTPUT_TRUNC");
+static constexpr auto LOG_ASYNC = ADD_PREFIX("LOG_ASYNC");
+static constexpr auto TRACE_SAMPLING = ADD_PREFIX("TRACE_SAMPLING");
+static constexpr auto TRACE_DIR = ADD_PREFIX("TRACE_DIR");
+static constexpr auto CAPTURE_DIR = ADD_PREFIX("CAPTURE_DIR");
 static constexpr auto CWD = ADD_PREFIX("CWD");
 static constexpr auto HOSTS_FILE = ADD_PREFIX("HOSTS_FILE");
 static constexpr auto WORK_FLOW = ADD_PREFIX("WORK_FLOW");
@@ -53,6 +57,12 @@ static constexpr auto MERGE = ADD_PREFIX("MERGE");
 static constexpr auto MERGE_FLOWS = ADD_PREFIX("MERGE_FLOWS");
 static constexpr auto REGISTRY_FILE = ADD_PREFIX("REGISTRY_FILE");
 static constexpr auto HOSTS_CONFIG_FILE = ADD_PREFIX("HOSTS_CONFIG_FILE");
+static constexpr auto PLACEMENT_POLICY = ADD_PREFIX("PLACEMENT_POLICY");
+static constexpr auto REG_CACHE_ENTRIES = ADD_PREFIX("REG_CACHE_ENTRIES");
+static constexpr auto LOOKUP_PARALLELISM = ADD_PREFIX("LOOKUP_PARALLELISM");
+static constexpr auto HOST_SEGMENT = ADD_PREFIX("HOST_SEGMENT");
+static constexpr auto PATH_CACHE_ENTRIES = ADD_PREFIX("PATH_CACHE_ENTRIES");
+static constexpr auto PATH_CACHE_TTL = ADD_PREFIX("PATH_CACHE_TTL");
 #ifdef GKFS_ENABLE_FORWARDING
 static constexpr auto FORWARDING_MAP_FILE = ADD_PREFIX("FORWARDING_MAP_FILE");
 #endif
@@ -0,0 +1,122 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS' POSIX interface.
+
+  GekkoFS' POSIX interface is free software: you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, either version 3 of the License,
+  or (at your option) any later version.
+
+  GekkoFS' POSIX interface is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with GekkoFS' POSIX interface.  If not, see
+  <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+
+#ifndef GEKKOFS_CLIENT_HOST_SEGMENT_HPP
+#define GEKKOFS_CLIENT_HOST_SEGMENT_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gkfs::utils {
+
+/**
+ * @brief Everything a client reads from the hosts file and the hosts config
+ * file (which the registry writes when workflows are merged).
+ */
+struct HostTable {
+    // host name, daemon URI
+    std::vector<std::pair<std::string, std::string>> hosts;
+    // file system size and priority of each host, see read_hosts_config_file()
+    std::vector<unsigned int> fs_sizes;
+    std::vector<unsigned int> priorities;
+};
+
+/**
+ * @brief Node-shared, read-only copy of the parsed host table.
+ *
+ * The first client process on a node parses the hosts files and publishes the
+ * result in a POSIX shared memory segment. All later processes map the segment
+ * instead of asking the registry and parsing the files again.
+ *
+ * A published segment is never modified. It carries the epoch of the files it
+ * was built from (see host_files_epoch()). A process that finds a different
+ * epoch parses the files itself and replaces the segment with shm_unlink() and
+ * a new segment of the same name, so processes that still map the old segment
+ * are not affected. If several processes publish at the same time, only the
+ * one that creates the segment writes it, the others skip publishing.
+ */
+class HostSegment {
+
+public:
+    /**
+     * @param hostfile path of the hosts file
+     * @param hostconfigfile path of the hosts config file
+     */
+    HostSegment(const std::string& hostfile, const std::string& hostconfigfile);
+
+    /**
+     * @brief Name of the segment: per user and per pair of hosts files.
+     */
+    const std::string&
+    name() const;
+
+    /**
+     * @brief Epoch of the hosts files: inode, size, and mtime of both files.
+     * @return epoch, or 0 if one of the files does not exist (yet)
+     */
+    uint64_t
+    epoch() const;
+
+    /**
+     * @brief Reads the host table from the segment.
+     * @param epoch epoch the table must have been built from
+     * @return the table, or nothing if there is no complete segment with this
+     * epoch
+     */
+    std::optional<HostTable>
+    load(uint64_t epoch) const;
+
+    /**
+     * @brief Publishes the host table, replacing a segment of another epoch or
+     * one whose writer died before it was complete.
+     * @param epoch epoch of the files the table was read from
+     * @param table
+     * @return true if this process published the segment
+     */
+    bool
+    publish(uint64_t epoch, const HostTable& table) const;
+
+    /**
+     * @brief Removes the segment. Processes mapping it are not affected.
+     */
+    void
+    remove() const;
+
+private:
+    std::string hostfile_;
+    std::string hostconfigfile_;
+    std::string name_;
+};
+
+} // namespace gkfs::utils
+
+#endif // GEKKOFS_CLIENT_HOST_SEGMENT_HPP
@@ -0,0 +1,200 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS' POSIX interface.
+
+  GekkoFS' POSIX interface is free software: you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, either version 3 of the License,
+  or (at your option) any later version.
+
+  GekkoFS' POSIX interface is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with GekkoFS' POSIX interface.  If not, see
+  <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+
+#ifndef LIBGKFS_LOG_RING_HPP
+#define LIBGKFS_LOG_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace gkfs::log {
+
+enum class record_kind : uint16_t { padding = 0, message, syscall };
+
+/**
+ * @brief Header of a binary log record. The payload follows the header and
+ * the record is padded to a multiple of 8 bytes.
+ */
+struct record_header {
+    uint32_t size; // header, payload, and padding
+    record_kind kind;
+    uint16_t level;     // log_level of a message
+    uint32_t tid;       // thread that produced the record
+    uint32_t length;    // payload length
+    uint64_t timestamp; // in ns since the epoch
+};
+
+static_assert(sizeof(record_header) % 8 == 0,
+              "record_header must keep records 8-byte aligned");
+
+/**
+ * @brief Single-producer single-consumer ring of variable-size log records.
+ *
+ * The producer (the thread that logs) reserves space for a record, writes it,
+ * and commits it. It never blocks: if the ring is full, the record is dropped
+ * and counted. The consumer (the flusher) visits the committed records in
+ * order. Records never wrap around the end of the ring. If a record does not
+ * fit into the rest of the ring, the rest is skipped with a padding record (or
+ * implicitly if it is smaller than a header).
+ */
+class ring_buffer {
+
+    std::unique_ptr<char[]> data_;
+    const size_t capacity_;
+
+    // bytes written and read since the ring was created
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    // producer-only: bytes skipped before the reserved record
+    size_t skip_{0};
+
+    static size_t
+    aligned(size_t size) {
+        return (size + 7) & ~size_t(7);
+    }
+
+public:
+    /**
+     * @param capacity size in bytes, rounded up to a power of two
+     */
+    explicit ring_buffer(size_t capacity)
+        : capacity_([capacity] {
+              size_t c = 64;
+              while(c < capacity)
+                  c <<= 1;
+              return c;
+          }()) {
+        data_.reset(new char[capacity_]);
+    }
+
+    size_t
+    capacity() const {
+        return capacity_;
+    }
+
+    /**
+     * @brief Reserves a record with `length` bytes of payload.
+     * @return the header of the record to fill in, or nullptr if the ring is
+     * full and the record was dropped
+     */
+    record_header*
+    reserve(size_t length) {
+        auto size = aligned(sizeof(record_header) + length);
+        auto head = head_.load(std::memory_order_relaxed);
+        auto pos = static_cast<size_t>(head % capacity_);
+        skip_ = capacity_ - pos < size ? capacity_ - pos : 0;
+        auto used = head - tail_.load(std::memory_order_acquire);
+        if(size > capacity_ / 2 || used + skip_ + size > capacity_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if(skip_ >= sizeof(record_header)) {
+            auto padding = reinterpret_cast<record_header*>(&data_[pos]);
+            padding->size = static_cast<uint32_t>(skip_);
+            padding->kind = record_kind::padding;
+        }
+        pos = static_cast<size_t>((head + skip_) % capacity_);
+        auto header = reinterpret_cast<record_header*>(&data_[pos]);
+        header->size = static_cast<uint32_t>(size);
+        header->length = static_cast<uint32_t>(length);
+        return header;
+    }
+
+    /**
+     * @brief Publishes the record returned by the last reserve().
+     */
+    void
+    commit(const record_header* header) {
+        head_.store(head_.load(std::memory_order_relaxed) + skip_ +
+                            header->size,
+                    std::memory_order_release);
+    }
+
+    /**
+     * @brief Visits all committed records in order and frees their space.
+     * @param visit called with the header and the payload of each record
+     * @return number of records visited
+     */
+    template <typename Visitor>
+    size_t
+    consume(Visitor&& visit) {
+        size_t n = 0;
+        auto tail = tail_.load(std::memory_order_relaxed);
+        auto head = head_.load(std::memory_order_acquire);
+        while(tail < head) {
+            auto pos = static_cast<size_t>(tail % capacity_);
+            if(capacity_ - pos < sizeof(record_header)) {
+                tail += capacity_ - pos;
+                continue;
+            }
+            auto header = reinterpret_cast<const record_header*>(&data_[pos]);
+            if(header->kind != record_kind::padding) {
+                visit(*header, reinterpret_cast<const char*>(header + 1));
+                n++;
+            }
+            tail += header->size;
+        }
+        tail_.store(tail, std::memory_order_release);
+        return n;
+    }
+
+    bool
+    empty() const {
+        return head_.load(std::memory_order_acquire) ==
+               tail_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Number of records dropped since the last call.
+     */
+    uint64_t
+    take_dropped() {
+        return dropped_.exchange(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Discards all records. Neither producer nor consumer may use the
+     * ring concurrently, e.g., in the child after fork().
+     */
+    void
+    reset() {
+        tail_.store(head_.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+        dropped_.store(0, std::memory_order_relaxed);
+    }
+};
+
+} // namespace gkfs::log
+
+#endif // LIBGKFS_LOG_RING_HPP
@@ -35,6 +35,7 @@
 #include <type_traits>
 #include <client/make_array.hpp>
 #include <client/syscalls.hpp>
+#include <memory>
 #include <optional>
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -195,6 +196,21 @@ log_buffer(int fd, const void* buffer, std::size_t length) {
  * NOTE: we use the date C++ library to query the timezone database and
  * to format the timestamps.
  */
+template <typename Buffer>
+static inline void
+format_timestamp_to(Buffer&& buffer,
+                    date::sys_time<std::chrono::microseconds> now,
+                    const date::time_zone* const timezone = nullptr) {
+
+    if(!timezone) {
+        fmt::format_to(buffer, "[{}] ", now.time_since_epoch().count());
+        return;
+    }
+
+    fmt::format_to(buffer, "[{}] ",
+                   date::zoned_time<std::chrono::microseconds>{timezone, now});
+}
+
 template <typename Buffer>
 static inline void
 format_timestamp_to(Buffer&& buffer,
@@ -212,21 +228,14 @@ format_timestamp_to(Buffer&& buffer,
             std::chrono::seconds{tv.tv_sec} +
             std::chrono::microseconds{tv.tv_usec}};
 
-    if(!timezone) {
-        fmt::format_to(buffer, "[{}] ", now.time_since_epoch().count());
-        return;
-    }
-
-    fmt::format_to(buffer, "[{}] ",
-                   date::zoned_time<std::chrono::microseconds>{timezone, now});
+    format_timestamp_to(buffer, now, timezone);
 }
 
 template <typename Buffer>
 static inline void
-format_syscall_info_to(Buffer&& buffer, gkfs::syscall::info info) {
+format_syscall_info_to(Buffer&& buffer, gkfs::syscall::info info, long tid) {
 
-    const auto ttid = syscall_no_intercept(SYS_gettid);
-    fmt::format_to(buffer, "[{}] [syscall] ", ttid);
+    fmt::format_to(buffer, "[{}] [syscall] ", tid);
 
     char o;
     char t;
@@ -259,6 +268,12 @@ format_syscall_info_to(Buffer&& buffer, gkfs::syscall::info info) {
     fmt::format_to(buffer, fmt::string_view(tmp.data(), tmp.size()));
 }
 
+template <typename Buffer>
+static inline void
+format_syscall_info_to(Buffer&& buffer, gkfs::syscall::info info) {
+    format_syscall_info_to(buffer, info, syscall_no_intercept(SYS_gettid));
+}
+
 } // namespace detail
 
 enum { max_buffer_size = LIBGKFS_LOG_MESSAGE_SIZE };
@@ -273,7 +288,8 @@ protected:
 
 struct logger {
 
-    logger(const std::string& opts, const std::string& path, bool trunc
+    logger(const std::string& opts, const std::string& path, bool trunc,
+           bool async
 #ifdef GKFS_DEBUG_BUILD
            ,
            const std::string& filter, int verbosity
@@ -291,6 +307,17 @@ struct logger {
             return;
         }
 
+        if(async_) {
+            // the prefix is added when the record is written out
+            static_buffer buffer;
+            if(!!(level & log::debug)) {
+                fmt::format_to(buffer, "<{}():{}> ", func, lineno);
+            }
+            fmt::format_to(buffer, std::forward<Args>(args)...);
+            enqueue_message(level, buffer.data(), buffer.size());
+            return;
+        }
+
         static_buffer buffer;
         detail::format_timestamp_to(buffer, timezone_);
         fmt::format_to(buffer, "[{}] [{}] ", ::syscall_no_intercept(SYS_gettid),
@@ -395,6 +422,20 @@ struct logger {
     log_syscall(syscall::info info, const long syscall_number,
                 const long args[6], std::optional<long> result = {});
 
+    /**
+     * @brief Stores a formatted message in the log ring of the calling thread
+     * (asynchronous logging only).
+     */
+    void
+    enqueue_message(log_level level, const char* msg, std::size_t length);
+
+    /**
+     * @brief Writes out all records of the log rings (asynchronous logging
+     * only).
+     */
+    void
+    flush();
+
     static std::shared_ptr<logger>&
     global_logger() {
         static std::shared_ptr<logger> s_global_logger;
@@ -410,6 +451,12 @@ struct logger {
 #endif
 
     const date::time_zone* timezone_;
+
+    // Asynchronous logging: messages and syscalls are stored as binary
+    // records in per-thread rings and are formatted and written out by a
+    // background thread. Null if logging is synchronous.
+    struct async_writer;
+    std::shared_ptr<async_writer> async_;
 };
 
 // the following static functions can be used to interact
@@ -30,11 +30,14 @@
 #ifndef GEKKOFS_OPEN_FILE_MAP_HPP
 #define GEKKOFS_OPEN_FILE_MAP_HPP
 
+#include <config.hpp>
+
 #include <map>
 #include <mutex>
 #include <memory>
 #include <atomic>
 #include <array>
+#include <string>
 
 namespace gkfs::filemap {
 
@@ -59,11 +62,9 @@ class OpenFile {
 protected:
     FileType type_;
     std::string path_;
-    std::array<bool, static_cast<int>(OpenFile_flags::flag_count)> flags_ = {
-            {false}};
-    unsigned long pos_;
-    std::mutex pos_mutex_;
-    std::mutex flag_mutex_;
+    std::array<std::atomic<bool>, static_cast<int>(OpenFile_flags::flag_count)>
+            flags_{};
+    std::atomic<unsigned long> pos_;
 
 public:
     // multiple threads may want to update the file position if fd has been
@@ -98,15 +99,31 @@ public:
 };
 
 
+/**
+ * @brief Open GekkoFS files and directories of the process.
+ *
+ * File descriptors [fd_base, fd_base + table size) are kept in a fixed-size
+ * table indexed by fd. A bitmap marks the slots in use, so checking whether an
+ * fd belongs to GekkoFS is a single atomic load and does not take a lock. This
+ * matters because the interception layer checks almost every fd-based syscall,
+ * including those on fds GekkoFS does not own. Slots are claimed by setting
+ * their bit with compare-and-swap, in next-fit order so that a closed fd is not
+ * reused right away. The shared_ptr of a slot is read and written with the
+ * atomic shared_ptr access functions, so get() never sees a partially written
+ * slot and a file that is removed concurrently stays valid for the caller.
+ *
+ * An empty slot is only filled by the thread that set its bit, and a bit is
+ * only cleared by the thread that emptied the slot. dup2() onto a used slot
+ * replaces its file with compare-and-swap and never fills an empty slot
+ * without claiming it first. So a slot with a file always has its bit set.
+ *
+ * fds outside of the table, i.e., targets of dup2() and fds handed out while
+ * the table is full, are kept in a map behind a mutex. That map is only
+ * searched if it is not empty.
+ */
 class OpenFileMap {
 
 private:
-    std::map<int, std::shared_ptr<OpenFile>> files_;
-    std::recursive_mutex files_mutex_;
-
-    int
-    safe_generate_fd_idx_();
-
     /*
      * TODO: Setting our file descriptor index to a specific value is dangerous
      * because we might clash with the kernel. E.g., if we would passthrough and
@@ -114,18 +131,42 @@ private:
      * use the same fd value, we will intercept calls that were supposed to be
      * going to the kernel. This works the other way around too. To mitigate
      * this issue, we set the initial fd number to a high value. We "hope" that
-     * we do not clash but this is no permanent solution. Note: This solution
-     * will probably work well already for many cases because kernel fd values
-     * are reused, unlike to ours. The only case where we will clash with the
-     * kernel is, if one process has more than 100000 files open at the same
-     * time.
+     * we do not clash but this is no permanent solution. The only case where
+     * we will clash with the kernel is, if one process has more than 10000
+     * files open at the same time.
      */
-    int fd_idx;
-    std::mutex fd_idx_mutex;
-    std::atomic<bool> fd_validation_needed;
+    static constexpr int fd_base = 10000;
+
+    size_t table_size_;
+    std::unique_ptr<std::shared_ptr<OpenFile>[]> slots_;
+    std::unique_ptr<std::atomic<uint64_t>[]> used_;
+    // slot at which the search for a free slot starts
+    std::atomic<size_t> next_slot_;
+
+    std::map<int, std::shared_ptr<OpenFile>> overflow_;
+    std::mutex overflow_mutex_;
+    std::atomic<size_t> overflow_size_;
+    // next fd handed out when the table is full
+    int overflow_fd_idx_;
+
+    bool
+    in_table(int fd) const;
+
+    bool
+    slot_used(size_t slot) const;
+
+    size_t
+    claim_slot();
+
+    bool
+    claim(size_t slot);
+
+    int
+    add_overflow(std::shared_ptr<OpenFile> open_file);
 
 public:
-    OpenFileMap();
+    explicit OpenFileMap(
+            size_t table_size = gkfs::config::open_file_table_size);
 
     std::shared_ptr<OpenFile>
     get(int fd);
@@ -146,12 +187,6 @@ public:
 
     int
     dup2(int oldfd, int newfd);
-
-    int
-    generate_fd_idx();
-
-    int
-    get_fd_idx();
 };
 
 } // namespace gkfs::filemap
@@ -0,0 +1,174 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS' POSIX interface.
+
+  GekkoFS' POSIX interface is free software: you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, either version 3 of the License,
+  or (at your option) any later version.
+
+  GekkoFS' POSIX interface is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with GekkoFS' POSIX interface.  If not, see
+  <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+
+#ifndef GEKKOFS_CLIENT_PATH_CACHE_HPP
+#define GEKKOFS_CLIENT_PATH_CACHE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace gkfs::path {
+
+/**
+ * @brief Caches what gkfs::path::resolve() learned about paths outside of the
+ * mountdir so that it does not call lstat() on every component again.
+ *
+ * Keys are canonical paths, i.e., paths built from resolved components. Each
+ * entry records whether the path is a directory, a symbolic link (with its
+ * resolved target), or something else. Paths that do not exist are not
+ * cached.
+ *
+ * Entries belong to a generation (the generation of the client's cwd). Looking
+ * up or inserting with another generation discards all entries, so changing
+ * the working directory starts with an empty cache. The cache holds at most
+ * `max_entries` entries and evicts an arbitrary entry when it is full. It is
+ * safe to use from several threads.
+ *
+ * Other processes may replace a cached path, e.g., with a link into the
+ * mountdir, without the client noticing. Entries therefore expire `ttl` after
+ * they were inserted, which bounds how long such a change goes unnoticed.
+ */
+class PathCache {
+
+public:
+    enum class kind : uint8_t { directory, link, other };
+
+    struct entry {
+        kind type;
+        // resolved target of a link
+        std::string target;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct statistics {
+        uint64_t hits;
+        uint64_t misses;
+    };
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, entry> entries_;
+    uint64_t generation_{0};
+    size_t max_entries_;
+    std::chrono::steady_clock::duration ttl_;
+
+    mutable std::atomic<uint64_t> hits_{0};
+    mutable std::atomic<uint64_t> misses_{0};
+
+public:
+    /**
+     * @param max_entries
+     * @param ttl time after which an entry is looked up again
+     */
+    PathCache(size_t max_entries, std::chrono::steady_clock::duration ttl)
+        : max_entries_(max_entries), ttl_(ttl) {}
+
+    /**
+     * @brief Looks up the kind of a canonical path. Expired entries are
+     * misses.
+     * @param path
+     * @param generation current cwd generation
+     * @param type set to the kind of the path on a hit
+     * @param target if not null, set to the target of a link on a hit
+     * @return true on a hit
+     */
+    bool
+    lookup(const std::string& path, uint64_t generation, kind& type,
+           std::string* target = nullptr) const {
+        auto now = std::chrono::steady_clock::now();
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if(generation == generation_) {
+            auto it = entries_.find(path);
+            if(it != entries_.end() && now < it->second.expires) {
+                type = it->second.type;
+                if(target != nullptr && type == kind::link)
+                    *target = it->second.target;
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * @brief Records the kind of a canonical path.
+     * @param path
+     * @param generation current cwd generation
+     * @param type
+     * @param target resolved target if `path` is a link
+     */
+    void
+    insert(const std::string& path, uint64_t generation, kind type,
+           const std::string& target = {}) {
+        if(max_entries_ == 0)
+            return;
+        auto expires = std::chrono::steady_clock::now() + ttl_;
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if(generation != generation_) {
+            entries_.clear();
+            generation_ = generation;
+        }
+        if(entries_.size() >= max_entries_ && entries_.count(path) == 0)
+            entries_.erase(entries_.begin());
+        entries_[path] = {type, type == kind::link ? target : std::string{},
+                          expires};
+    }
+
+    /**
+     * @brief Discards all entries, e.g., after the application changed the
+     * namespace outside of the mountdir.
+     */
+    void
+    clear() {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        entries_.clear();
+    }
+
+    size_t
+    size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    statistics
+    stats() const {
+        return {hits_.load(std::memory_order_relaxed),
+                misses_.load(std::memory_order_relaxed)};
+    }
+};
+
+} // namespace gkfs::path
+
+#endif // GEKKOFS_CLIENT_PATH_CACHE_HPP
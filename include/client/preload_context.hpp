@@ -31,6 +31,7 @@
 #define GEKKOFS_PRELOAD_CTX_HPP
 
 #include <hermes.hpp>
+#include <atomic>
 #include <map>
 #include <mercury.h>
 #include <memory>
@@ -38,6 +39,7 @@
 #include <string>
 #include <config.hpp>
 #include <common/metadata.hpp>
+#include <client/rpc/endpoint_table.hpp>
 
 #include <bitset>
 
@@ -48,6 +50,18 @@ class OpenFileMap;
 }
 namespace rpc {
 class Distributor;
+class PlacementPolicy;
+template <typename Memory>
+class RegistrationCache;
+}
+namespace path {
+class PathCache;
+}
+namespace trace {
+class writer;
+}
+namespace capture {
+class writer;
 }
 namespace log {
 struct logger;
@@ -86,13 +100,25 @@ private:
 
     std::shared_ptr<gkfs::filemap::OpenFileMap> ofm_;
     std::shared_ptr<gkfs::rpc::Distributor> distributor_;
+    std::shared_ptr<gkfs::rpc::PlacementPolicy> placement_policy_;
+    std::shared_ptr<gkfs::rpc::RegistrationCache<hermes::exposed_memory>>
+            reg_cache_;
     std::shared_ptr<FsConfig> fs_conf_;
 
     std::string cwd_;
+    // incremented whenever cwd_ changes
+    std::atomic<uint64_t> cwd_generation_{0};
+    std::shared_ptr<gkfs::path::PathCache> path_cache_;
+    std::shared_ptr<gkfs::trace::writer> tracer_;
+    double trace_sampling_{0.0};
+    // owns the capture writer until the process exits
+    std::shared_ptr<gkfs::capture::writer> capture_;
+    // checked on every intercepted syscall, nullptr while not capturing
+    std::atomic<gkfs::capture::writer*> active_capture_{nullptr};
     std::vector<std::string> mountdir_components_;
     std::string mountdir_;
 
-    std::vector<hermes::endpoint> hosts_;
+    std::shared_ptr<gkfs::rpc::EndpointTable<hermes::endpoint>> hosts_;
     hermes::endpoint registry_;
     std::vector<unsigned int> hostsconfig_;
     std::vector<unsigned int> fspriority_;
@@ -143,11 +169,14 @@ public:
     const std::string&
     cwd() const;
 
-    const std::vector<hermes::endpoint>&
+    uint64_t
+    cwd_generation() const;
+
+    const gkfs::rpc::EndpointTable<hermes::endpoint>&
     hosts() const;
 
     void
-    hosts(const std::vector<hermes::endpoint>& addrs);
+    hosts(std::shared_ptr<gkfs::rpc::EndpointTable<hermes::endpoint>> hosts);
 
     const hermes::endpoint
     registry() const;
@@ -225,6 +254,58 @@ public:
     std::shared_ptr<gkfs::rpc::Distributor>
     distributor() const;
 
+    void
+    placement_policy(std::shared_ptr<gkfs::rpc::PlacementPolicy> policy);
+
+    std::shared_ptr<gkfs::rpc::PlacementPolicy>
+    placement_policy() const;
+
+    void
+    reg_cache(std::shared_ptr<
+              gkfs::rpc::RegistrationCache<hermes::exposed_memory>>
+                      reg_cache);
+
+    std::shared_ptr<gkfs::rpc::RegistrationCache<hermes::exposed_memory>>
+    reg_cache() const;
+
+    void
+    path_cache(std::shared_ptr<gkfs::path::PathCache> path_cache);
+
+    const std::shared_ptr<gkfs::path::PathCache>&
+    path_cache() const;
+
+    void
+    tracer(std::shared_ptr<gkfs::trace::writer> tracer,
+           double sampling = 0.0);
+
+    const std::shared_ptr<gkfs::trace::writer>&
+    tracer() const;
+
+    double
+    trace_sampling() const;
+
+    /**
+     * @brief Starts capturing to the given writer. Called once during
+     * initialization. The writer is kept until the process exits, so
+     * intercepted syscalls use it without taking a reference.
+     */
+    void
+    capture(std::shared_ptr<gkfs::capture::writer> capture);
+
+    /**
+     * @brief Returns the capture writer or nullptr if syscalls are not
+     * captured. This is a single atomic load.
+     */
+    gkfs::capture::writer*
+    capture() const;
+
+    /**
+     * @brief Stops capturing and flushes the captured syscalls. Records of
+     * calls still in flight are flushed when the writer is destroyed at exit.
+     */
+    void
+    stop_capture();
+
     const std::shared_ptr<FsConfig>&
     fs_conf() const;
 
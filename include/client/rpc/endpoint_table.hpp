@@ -0,0 +1,234 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS' POSIX interface.
+
+  GekkoFS' POSIX interface is free software: you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, either version 3 of the License,
+  or (at your option) any later version.
+
+  GekkoFS' POSIX interface is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with GekkoFS' POSIX interface.  If not, see
+  <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+
+#ifndef GEKKOFS_CLIENT_ENDPOINT_TABLE_HPP
+#define GEKKOFS_CLIENT_ENDPOINT_TABLE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gkfs::rpc {
+
+/**
+ * @brief Daemon endpoints indexed by host id that are looked up on first use.
+ *
+ * Each host is resolved at most once. Concurrent users of the same host wait
+ * for the lookup in progress. A failed lookup is not remembered and is tried
+ * again on the next use. resolve_all() additionally resolves all hosts in
+ * the background with a bounded number of lookups in flight so that most
+ * endpoints are ready before they are used.
+ *
+ * Resolution never throws. get() returns no endpoint if the host id is
+ * invalid or the host cannot be resolved, and the caller fails its operation
+ * with an errno instead.
+ *
+ * Endpoint is the address type (hermes::endpoint in the client). It must be
+ * default constructible and copyable.
+ */
+template <typename Endpoint>
+class EndpointTable {
+
+public:
+    using lookup_function = std::function<Endpoint(const std::string&)>;
+
+private:
+    enum class slot_state { unresolved, resolving, resolved };
+
+    struct slot {
+        std::string uri;
+        // written under mutex_, read without it on the fast path
+        std::atomic<slot_state> state{slot_state::unresolved};
+        Endpoint endpoint{};
+    };
+
+    std::unique_ptr<slot[]> slots_;
+    size_t size_{0};
+    lookup_function lookup_;
+
+    // guards slot state transitions and wakes users waiting for a lookup
+    mutable std::mutex mutex_;
+    mutable std::condition_variable lookup_done_;
+
+    std::vector<std::thread> resolvers_;
+    std::atomic<size_t> next_{0};
+    std::atomic<bool> stop_{false};
+    mutable std::atomic<size_t> resolved_{0};
+    std::atomic<size_t> failed_{0};
+
+public:
+    EndpointTable() = default;
+
+    /**
+     * @param uris Addresses of the hosts in host id order
+     * @param lookup Resolves an address, throws on failure
+     */
+    EndpointTable(const std::vector<std::string>& uris, lookup_function lookup)
+        : slots_(new slot[uris.size()]), size_(uris.size()),
+          lookup_(std::move(lookup)) {
+        for(size_t id = 0; id < size_; id++)
+            slots_[id].uri = uris[id];
+    }
+
+    EndpointTable(const EndpointTable&) = delete;
+
+    EndpointTable&
+    operator=(const EndpointTable&) = delete;
+
+    ~EndpointTable() {
+        stop();
+    }
+
+    /**
+     * @brief Returns the endpoint of a host and resolves it on first use.
+     * @return The endpoint, or nothing for an invalid host id or a host whose
+     * lookup failed
+     */
+    std::optional<Endpoint>
+    get(size_t id) const noexcept {
+        if(id >= size_)
+            return {};
+        auto& s = slots_[id];
+        if(s.state.load(std::memory_order_acquire) == slot_state::resolved)
+            return s.endpoint;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        lookup_done_.wait(lock, [&] {
+            return s.state.load(std::memory_order_relaxed) !=
+                   slot_state::resolving;
+        });
+        if(s.state.load(std::memory_order_relaxed) == slot_state::resolved)
+            return s.endpoint;
+        s.state.store(slot_state::resolving, std::memory_order_relaxed);
+        lock.unlock();
+
+        std::optional<Endpoint> endpoint;
+        try {
+            endpoint = lookup_(s.uri);
+        } catch(...) {
+        }
+
+        lock.lock();
+        if(endpoint) {
+            s.endpoint = *endpoint;
+            s.state.store(slot_state::resolved, std::memory_order_release);
+            resolved_++;
+        } else {
+            s.state.store(slot_state::unresolved, std::memory_order_relaxed);
+        }
+        lock.unlock();
+        lookup_done_.notify_all();
+        return endpoint;
+    }
+
+    const std::string&
+    uri(size_t id) const {
+        return slots_[id].uri;
+    }
+
+    size_t
+    size() const {
+        return size_;
+    }
+
+    bool
+    empty() const {
+        return size_ == 0;
+    }
+
+    /**
+     * @brief Starts resolving all hosts in the background.
+     * @param max_in_flight Maximum number of concurrent lookups
+     * @param order Host ids in the order they should be resolved, e.g.,
+     * shuffled to spread the lookups of many clients over all hosts
+     */
+    void
+    resolve_all(size_t max_in_flight, std::vector<size_t> order) {
+        if(max_in_flight == 0 || size_ == 0 || !resolvers_.empty())
+            return;
+        auto shared_order =
+                std::make_shared<std::vector<size_t>>(std::move(order));
+        for(size_t t = 0; t < std::min(max_in_flight, size_); t++) {
+            resolvers_.emplace_back([this, shared_order] {
+                size_t i;
+                while(!stop_ && (i = next_++) < shared_order->size()) {
+                    if(!get((*shared_order)[i]))
+                        failed_++;
+                }
+            });
+        }
+    }
+
+    /**
+     * @brief Waits for the background lookups started by resolve_all().
+     */
+    void
+    wait() {
+        for(auto& resolver : resolvers_)
+            resolver.join();
+        resolvers_.clear();
+    }
+
+    /**
+     * @brief Stops the background lookups after the ones in flight.
+     */
+    void
+    stop() {
+        stop_ = true;
+        wait();
+    }
+
+    /**
+     * @brief Number of hosts resolved so far.
+     */
+    size_t
+    resolved() const {
+        return resolved_;
+    }
+
+    /**
+     * @brief Number of failed background lookups.
+     */
+    size_t
+    failed() const {
+        return failed_;
+    }
+};
+
+} // namespace gkfs::rpc
+
+#endif // GEKKOFS_CLIENT_ENDPOINT_TABLE_HPP
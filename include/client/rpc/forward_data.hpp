@@ -36,6 +36,7 @@ struct ChunkStat {
     unsigned long chunk_size;
     unsigned long chunk_total;
     unsigned long chunk_free;
+    unsigned long queue_depth{}; ///< I/O tasks queued on the daemons
 };
 
 // TODO once we have LEAF, remove all the error code returns and throw them as
@@ -55,6 +56,9 @@ forward_truncate(const std::string& path, size_t current_size, size_t new_size);
 std::pair<int, ChunkStat>
 forward_get_chunk_stat();
 
+std::pair<int, std::vector<ChunkStat>>
+forward_get_fs_chunk_stat();
+
 } // namespace gkfs::rpc
 
 #endif // GEKKOFS_CLIENT_FORWARD_DATA_HPP
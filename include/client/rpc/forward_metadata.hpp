@@ -76,6 +76,42 @@ std::pair<int, off64_t>
 forward_update_metadentry_size(const std::string& path, size_t size,
                                off64_t offset, bool append_flag, const std::string& buf = "");
 
+/**
+ * Size update whose RPC was sent without waiting for the response, so that
+ * the caller can overlap it with the data transfer of a write.
+ */
+class pending_size_update {
+    struct impl;
+    std::unique_ptr<impl> impl_;
+
+public:
+    explicit pending_size_update(std::unique_ptr<impl> impl);
+
+    ~pending_size_update();
+
+    pending_size_update(pending_size_update&&) noexcept;
+
+    pending_size_update&
+    operator=(pending_size_update&&) noexcept;
+
+    /**
+     * Waits for the response. Must be called at most once.
+     * @return pair<error code, size after update>
+     */
+    std::pair<int, off64_t>
+    wait();
+
+    friend pending_size_update
+    post_update_metadentry_size(const std::string& path, size_t size,
+                                off64_t offset, bool append_flag,
+                                const std::string& buf);
+};
+
+pending_size_update
+post_update_metadentry_size(const std::string& path, size_t size,
+                            off64_t offset, bool append_flag,
+                            const std::string& buf = "");
+
 std::pair<int, off64_t>
 forward_get_metadentry_size(const std::string& path);
 
@@ -0,0 +1,209 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS' POSIX interface.
+
+  GekkoFS' POSIX interface is free software: you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, either version 3 of the License,
+  or (at your option) any later version.
+
+  GekkoFS' POSIX interface is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with GekkoFS' POSIX interface.  If not, see
+  <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+
+#ifndef GEKKOFS_CLIENT_REGISTRATION_CACHE_HPP
+#define GEKKOFS_CLIENT_REGISTRATION_CACHE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+namespace gkfs::rpc {
+
+/**
+ * @brief Caches memory registrations of application buffers so that buffers
+ * which are reused for many I/O calls are exposed for RMA only once.
+ *
+ * Entries are kept in an interval map ordered by start address and are
+ * evicted in LRU order once `max_entries` or `max_bytes` is exceeded. A lookup
+ * hits if an entry has the same start address, size, and access mode, since
+ * daemons derive the transfer layout from the start and size of the exposed
+ * memory. Entries overlapping an address
+ * range are dropped with invalidate() when the application unmaps or replaces
+ * the pages of this range.
+ *
+ * Memory is the registration handle (hermes::exposed_memory in the client).
+ * It must be copyable, and a copy must keep the registration alive so that an
+ * entry evicted during a transfer stays valid until the transfer ends.
+ */
+template <typename Memory>
+class RegistrationCache {
+
+public:
+    struct statistics {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t invalidations;
+    };
+
+private:
+    // start address, access mode, and size of a registration
+    using key_type = std::tuple<uintptr_t, int, size_t>;
+
+    struct entry {
+        Memory memory;
+        typename std::list<key_type>::iterator lru_pos;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<key_type, entry> entries_;
+    std::list<key_type> lru_; // most recently used first
+    size_t max_entries_;
+    size_t max_bytes_;
+    size_t bytes_{0};
+    size_t max_size_{0}; // largest entry size, bounds the overlap search
+    statistics stats_{};
+
+    void
+    erase(typename std::map<key_type, entry>::iterator it) {
+        bytes_ -= std::get<2>(it->first);
+        lru_.erase(it->second.lru_pos);
+        entries_.erase(it);
+        if(entries_.empty())
+            max_size_ = 0;
+    }
+
+public:
+    RegistrationCache(size_t max_entries, size_t max_bytes)
+        : max_entries_(max_entries), max_bytes_(max_bytes) {}
+
+    /**
+     * @brief Returns a cached registration for the buffer.
+     * @param addr Start address of the buffer
+     * @param size Size of the buffer
+     * @param access Access mode the buffer is exposed with
+     * @return registration or std::nullopt on a miss
+     */
+    std::optional<Memory>
+    lookup(const void* addr, size_t size, int access) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(
+                {reinterpret_cast<uintptr_t>(addr), access, size});
+        if(it == entries_.end()) {
+            stats_.misses++;
+            return std::nullopt;
+        }
+        stats_.hits++;
+        lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+        return it->second.memory;
+    }
+
+    /**
+     * @brief Adds a registration and evicts least recently used entries if
+     * the cache is full. Registrations larger than the byte limit are not
+     * cached. An existing entry of the same buffer is replaced.
+     */
+    void
+    insert(const void* addr, size_t size, int access, const Memory& memory) {
+        if(size == 0 || size > max_bytes_ || max_entries_ == 0)
+            return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        key_type key{reinterpret_cast<uintptr_t>(addr), access, size};
+        auto it = entries_.find(key);
+        if(it != entries_.end())
+            erase(it);
+        while(!lru_.empty() && (entries_.size() >= max_entries_ ||
+                                bytes_ + size > max_bytes_)) {
+            erase(entries_.find(lru_.back()));
+            stats_.evictions++;
+        }
+        lru_.push_front(key);
+        entries_.emplace(key, entry{memory, lru_.begin()});
+        bytes_ += size;
+        max_size_ = std::max(max_size_, size);
+    }
+
+    /**
+     * @brief Drops all registrations that overlap [addr, addr + size).
+     * @return number of dropped registrations
+     */
+    size_t
+    invalidate(const void* addr, size_t size) {
+        auto lo = reinterpret_cast<uintptr_t>(addr);
+        auto hi = size > UINTPTR_MAX - lo ? UINTPTR_MAX : lo + size;
+        size_t dropped = 0;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(entries_.empty() || size == 0)
+            return 0;
+        // no entry starting before lo - max_size_ can reach lo
+        auto first = lo > max_size_ ? lo - max_size_ : 0;
+        auto it = entries_.lower_bound(
+                {first, std::numeric_limits<int>::min(), 0});
+        while(it != entries_.end() && std::get<0>(it->first) < hi) {
+            if(std::get<0>(it->first) + std::get<2>(it->first) > lo) {
+                auto next = std::next(it);
+                erase(it);
+                it = next;
+                dropped++;
+            } else {
+                ++it;
+            }
+        }
+        stats_.invalidations += dropped;
+        return dropped;
+    }
+
+    void
+    clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        lru_.clear();
+        bytes_ = 0;
+        max_size_ = 0;
+    }
+
+    size_t
+    size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    size_t
+    bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bytes_;
+    }
+
+    statistics
+    stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+};
+
+} // namespace gkfs::rpc
+
+#endif // GEKKOFS_CLIENT_REGISTRATION_CACHE_HPP
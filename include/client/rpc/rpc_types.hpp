@@ -48,6 +48,7 @@
 
 #include <common/common_defs.hpp>
 #include <common/rpc/rpc_types.hpp>
+#include <common/trace_util.hpp>
 
 namespace hermes::detail {
 
@@ -1348,8 +1349,10 @@ struct update_metadentry_size {
 
     public:
         input(const std::string& path, uint64_t size, int64_t offset,
-              bool append, const std::string &buf)
-            : m_path(path), m_size(size), m_offset(offset), m_append(append), m_buf(std::move(buf)) {}
+              bool append, const std::string &buf,
+              const gkfs::trace::context& trace = {})
+            : m_path(path), m_size(size), m_offset(offset), m_append(append), m_buf(std::move(buf)),
+              m_trace(trace) {}
 
         input(input&& rhs) = default;
 
@@ -1386,12 +1389,20 @@ struct update_metadentry_size {
             return m_append;
         }
 
+        gkfs::trace::context
+        trace() const {
+            return m_trace;
+        }
+
         explicit input(const rpc_update_metadentry_size_in_t& other)
             : m_path(other.path), m_size(other.size), m_offset(other.offset),
-              m_append(other.append), m_buf(std::move(other.buf)) {}
+              m_append(other.append), m_buf(std::move(other.buf)),
+              m_trace{other.trace_id, other.span_id, other.send_time} {}
 
         explicit operator rpc_update_metadentry_size_in_t() {
-            return {m_path.c_str(), m_size, m_offset, m_append, m_buf.c_str()};
+            return {m_path.c_str(),     m_size,           m_offset,
+                    m_append,           m_buf.c_str(),    m_trace.trace_id,
+                    m_trace.span_id,    m_trace.send_time};
         }
 
     private:
@@ -1400,6 +1411,7 @@ struct update_metadentry_size {
         uint64_t m_size;
         int64_t m_offset;
         bool m_append;
+        gkfs::trace::context m_trace;
     };
 
     class output {
@@ -1722,11 +1734,13 @@ struct write_data {
         input(const std::string& path, int64_t offset, uint64_t host_id,
               uint64_t host_size, uint64_t chunk_n, uint64_t chunk_start,
               uint64_t chunk_end, uint64_t total_chunk_size,
-              const hermes::exposed_memory& buffers)
+              const hermes::exposed_memory& buffers,
+              const gkfs::trace::context& trace = {})
             : m_path(path), m_offset(offset), m_host_id(host_id),
               m_host_size(host_size), m_chunk_n(chunk_n),
               m_chunk_start(chunk_start), m_chunk_end(chunk_end),
-              m_total_chunk_size(total_chunk_size), m_buffers(buffers) {}
+              m_total_chunk_size(total_chunk_size), m_buffers(buffers),
+              m_trace(trace) {}
 
         input(input&& rhs) = default;
 
@@ -1783,18 +1797,27 @@ struct write_data {
             return m_buffers;
         }
 
+        gkfs::trace::context
+        trace() const {
+            return m_trace;
+        }
+
         explicit input(const rpc_write_data_in_t& other)
             : m_path(other.path), m_offset(other.offset),
               m_host_id(other.host_id), m_host_size(other.host_size),
               m_chunk_n(other.chunk_n), m_chunk_start(other.chunk_start),
               m_chunk_end(other.chunk_end),
               m_total_chunk_size(other.total_chunk_size),
-              m_buffers(other.bulk_handle) {}
+              m_buffers(other.bulk_handle),
+              m_trace{other.trace_id, other.span_id, other.send_time} {}
 
         explicit operator rpc_write_data_in_t() {
-            return {m_path.c_str(), m_offset,           m_host_id,
-                    m_host_size,    m_chunk_n,          m_chunk_start,
-                    m_chunk_end,    m_total_chunk_size, hg_bulk_t(m_buffers)};
+            return {m_path.c_str(),       m_offset,
+                    m_host_id,            m_host_size,
+                    m_chunk_n,            m_chunk_start,
+                    m_chunk_end,          m_total_chunk_size,
+                    hg_bulk_t(m_buffers), m_trace.trace_id,
+                    m_trace.span_id,      m_trace.send_time};
         }
 
     private:
@@ -1807,6 +1830,7 @@ struct write_data {
         uint64_t m_chunk_end;
         uint64_t m_total_chunk_size;
         hermes::exposed_memory m_buffers;
+        gkfs::trace::context m_trace;
     };
 
     class output {
@@ -1866,7 +1890,7 @@ struct read_data {
     using input_type = input;
     using output_type = output;
     using mercury_input_type = rpc_read_data_in_t;
-    using mercury_output_type = rpc_data_out_t;
+    using mercury_output_type = rpc_read_data_out_t;
 
     // RPC public identifier
     // (N.B: we reuse the same IDs assigned by Margo so that the daemon
@@ -1888,7 +1912,7 @@ struct read_data {
 
     // Mercury callback to serialize output arguments
     constexpr static const auto mercury_out_proc_cb =
-            HG_GEN_PROC_NAME(rpc_data_out_t);
+            HG_GEN_PROC_NAME(rpc_read_data_out_t);
 
     class input {
 
@@ -1900,11 +1924,14 @@ struct read_data {
         input(const std::string& path, int64_t offset, uint64_t host_id,
               uint64_t host_size, uint64_t chunk_n, uint64_t chunk_start,
               uint64_t chunk_end, uint64_t total_chunk_size,
-              const hermes::exposed_memory& buffers)
+              const hermes::exposed_memory& buffers,
+              int64_t replica_chunk = -1,
+              const gkfs::trace::context& trace = {})
             : m_path(path), m_offset(offset), m_host_id(host_id),
               m_host_size(host_size), m_chunk_n(chunk_n),
               m_chunk_start(chunk_start), m_chunk_end(chunk_end),
-              m_total_chunk_size(total_chunk_size), m_buffers(buffers) {}
+              m_total_chunk_size(total_chunk_size), m_buffers(buffers),
+              m_replica_chunk(replica_chunk), m_trace(trace) {}
 
         input(input&& rhs) = default;
 
@@ -1961,18 +1988,34 @@ struct read_data {
             return m_buffers;
         }
 
+        int64_t
+        replica_chunk() const {
+            return m_replica_chunk;
+        }
+
+        gkfs::trace::context
+        trace() const {
+            return m_trace;
+        }
+
         explicit input(const rpc_read_data_in_t& other)
             : m_path(other.path), m_offset(other.offset),
               m_host_id(other.host_id), m_host_size(other.host_size),
               m_chunk_n(other.chunk_n), m_chunk_start(other.chunk_start),
               m_chunk_end(other.chunk_end),
               m_total_chunk_size(other.total_chunk_size),
-              m_buffers(other.bulk_handle) {}
+              m_buffers(other.bulk_handle),
+              m_replica_chunk(other.replica_chunk),
+              m_trace{other.trace_id, other.span_id, other.send_time} {}
 
         explicit operator rpc_read_data_in_t() {
-            return {m_path.c_str(), m_offset,           m_host_id,
-                    m_host_size,    m_chunk_n,          m_chunk_start,
-                    m_chunk_end,    m_total_chunk_size, hg_bulk_t(m_buffers)};
+            return {m_path.c_str(),       m_offset,
+                    m_host_id,            m_host_size,
+                    m_chunk_n,            m_chunk_start,
+                    m_chunk_end,          m_total_chunk_size,
+                    hg_bulk_t(m_buffers), m_replica_chunk,
+                    m_trace.trace_id,     m_trace.span_id,
+                    m_trace.send_time};
         }
 
     private:
@@ -1985,6 +2028,8 @@ struct read_data {
         uint64_t m_chunk_end;
         uint64_t m_total_chunk_size;
         hermes::exposed_memory m_buffers;
+        int64_t m_replica_chunk;
+        gkfs::trace::context m_trace;
     };
 
     class output {
@@ -1994,9 +2039,12 @@ struct read_data {
         hermes::detail::post_to_mercury(ExecutionContext*);
 
     public:
-        output() : m_err(), m_io_size() {}
+        output() : m_err(), m_io_size(), m_replicas(), m_extents() {}
 
-        output(int32_t err, size_t io_size) : m_err(err), m_io_size(io_size) {}
+        output(int32_t err, size_t io_size, uint32_t replicas,
+               const std::string& extents)
+            : m_err(err), m_io_size(io_size), m_replicas(replicas),
+              m_extents(extents) {}
 
         output(output&& rhs) = default;
 
@@ -2008,9 +2056,13 @@ struct read_data {
         output&
         operator=(const output& other) = default;
 
-        explicit output(const rpc_data_out_t& out) {
+        explicit output(const rpc_read_data_out_t& out) {
             m_err = out.err;
             m_io_size = out.io_size;
+            m_replicas = out.replicas;
+            if(out.extents != nullptr) {
+                m_extents = out.extents;
+            }
         }
 
         int32_t
@@ -2023,9 +2075,21 @@ struct read_data {
             return m_io_size;
         }
 
+        uint32_t
+        replicas() const {
+            return m_replicas;
+        }
+
+        std::string
+        extents() const {
+            return m_extents;
+        }
+
     private:
         int32_t m_err;
         size_t m_io_size;
+        uint32_t m_replicas;
+        std::string m_extents;
     };
 };
 
@@ -2479,12 +2543,14 @@ struct chunk_stat {
         hermes::detail::post_to_mercury(ExecutionContext*);
 
     public:
-        output() : m_err(), m_chunk_size(), m_chunk_total(), m_chunk_free() {}
+        output()
+            : m_err(), m_chunk_size(), m_chunk_total(), m_chunk_free(),
+              m_queue_depth() {}
 
         output(int32_t err, uint64_t chunk_size, uint64_t chunk_total,
-               uint64_t chunk_free)
+               uint64_t chunk_free, uint64_t queue_depth)
             : m_err(err), m_chunk_size(chunk_size), m_chunk_total(chunk_total),
-              m_chunk_free(chunk_free) {}
+              m_chunk_free(chunk_free), m_queue_depth(queue_depth) {}
 
         output(output&& rhs) = default;
 
@@ -2501,6 +2567,7 @@ struct chunk_stat {
             m_chunk_size = out.chunk_size;
             m_chunk_total = out.chunk_total;
             m_chunk_free = out.chunk_free;
+            m_queue_depth = out.queue_depth;
         }
 
         int32_t
@@ -2523,11 +2590,17 @@ struct chunk_stat {
             return m_chunk_free;
         }
 
+        uint64_t
+        queue_depth() const {
+            return m_queue_depth;
+        }
+
     private:
         int32_t m_err;
         uint64_t m_chunk_size;
         uint64_t m_chunk_total;
         uint64_t m_chunk_free;
+        uint64_t m_queue_depth;
     };
 };
 
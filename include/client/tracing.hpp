@@ -0,0 +1,68 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS' POSIX interface.
+
+  GekkoFS' POSIX interface is free software: you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, either version 3 of the License,
+  or (at your option) any later version.
+
+  GekkoFS' POSIX interface is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with GekkoFS' POSIX interface.  If not, see
+  <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+
+#ifndef GEKKOFS_CLIENT_TRACING_HPP
+#define GEKKOFS_CLIENT_TRACING_HPP
+
+#include <common/trace_util.hpp>
+
+namespace gkfs::trace {
+
+/**
+ * Root span of a client operation, e.g., a pwrite(). A fraction of
+ * operations given by LIBGKFS_TRACE_SAMPLING is sampled. RPCs sent by the
+ * calling thread while a sampled operation is alive become its children.
+ * Nested operations belong to the outermost one.
+ */
+class operation {
+    span span_;
+
+public:
+    explicit operation(const char* name);
+
+    ~operation();
+
+    operation(const operation&) = delete;
+
+    operation&
+    operator=(const operation&) = delete;
+};
+
+/**
+ * @brief Starts the span of an RPC sent within the operation of the calling
+ * thread. The span is inactive if the operation is not sampled.
+ * @param name span name
+ * @return span whose rpc_context() is passed in the RPC input
+ */
+span
+rpc_span(const char* name);
+
+} // namespace gkfs::trace
+
+#endif // GEKKOFS_CLIENT_TRACING_HPP
@@ -0,0 +1,205 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef GEKKOFS_CAPTURE_UTIL_HPP
+#define GEKKOFS_CAPTURE_UTIL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Capture of the GekkoFS-bound syscalls of a client process. Every syscall is
+ * a fixed-size record, followed by the paths it takes relative to the
+ * mountdir. A capture is replayed against any mountdir by gkfs_replay, with
+ * the original timing or as fast as possible.
+ */
+namespace gkfs::capture {
+
+/**
+ * Captured operations. Related syscalls share an operation, e.g., readv() is
+ * captured as read with the total size of the vector.
+ */
+enum class op : uint16_t {
+    open,
+    close,
+    read,
+    write,
+    pread,
+    pwrite,
+    lseek,
+    stat,
+    fstat,
+    unlink,
+    rmdir,
+    mkdir,
+    truncate,
+    ftruncate,
+    fsync,
+    getdents,
+    access,
+    rename,
+    dup,
+    count ///< number of operations, not an operation
+};
+
+const char*
+op_name(op o);
+
+/**
+ * On-disk record (little-endian, 64 bytes). Paths are appended without
+ * terminating null character.
+ */
+struct record {
+    uint64_t start;    ///< ns since the start of the capture (monotonic)
+    uint64_t duration; ///< ns spent in the syscall
+    int64_t result;    ///< return value, -errno on failure
+    int64_t offset;    ///< offset of pread/pwrite/lseek, length of truncate
+    uint64_t size;     ///< bytes requested by read/write/getdents
+    int32_t fd;        ///< file descriptor, -1 for path operations
+    uint32_t tid;
+    uint32_t flags; ///< open flags, lseek whence, AT_* flags
+    uint32_t mode;  ///< open/mkdir mode, access mode
+    uint16_t op;
+    uint16_t path_len;
+    uint16_t path2_len; ///< second path of rename
+    uint16_t reserved;
+};
+
+static_assert(sizeof(record) == 64, "capture records must be 64 bytes");
+
+/**
+ * File header, followed by records
+ */
+struct file_header {
+    char magic[8];       ///< "GKFSCAP1"
+    char host[40];       ///< hostname of the writer, null-terminated
+    uint32_t pid;        ///< process id of the writer
+    uint32_t reserved;
+    uint64_t start_time; ///< ns since the epoch when the capture started
+};
+
+static_assert(sizeof(file_header) == 64, "capture header must be 64 bytes");
+
+constexpr char file_magic[8] = {'G', 'K', 'F', 'S', 'C', 'A', 'P', '1'};
+
+/**
+ * Buffers records and appends them to a capture file.
+ */
+class writer {
+public:
+    /// Function used to write to the file, e.g., to bypass interception
+    using write_fn = long (*)(int fd, const void* buf, size_t count);
+
+private:
+    int fd_;
+    write_fn write_;
+    uint64_t start_;
+    std::mutex mutex_;
+    std::vector<char> buffer_;
+
+    void
+    write_out(const void* data, size_t size);
+
+    void
+    flush_locked();
+
+public:
+    static constexpr size_t buffer_bytes = 64 * 1024;
+
+    /**
+     * @param fd open file to append to. It is not closed by the writer
+     * @param write function used to write to fd
+     */
+    writer(int fd, write_fn write);
+
+    ~writer();
+
+    writer(const writer&) = delete;
+
+    writer&
+    operator=(const writer&) = delete;
+
+    /**
+     * @brief ns since the capture started, used for record::start
+     */
+    uint64_t
+    elapsed() const;
+
+    /**
+     * @brief Adds a record. Its path lengths and tid are set here.
+     * @param path path relative to the mountdir, may be empty
+     * @param path2 second path of rename, may be empty
+     */
+    void
+    add(record r, const std::string& path = {},
+        const std::string& path2 = {});
+
+    void
+    flush();
+};
+
+/**
+ * A record with its paths
+ */
+struct entry {
+    record rec{};
+    std::string path;
+    std::string path2;
+};
+
+/**
+ * Reads a capture file. Throws std::runtime_error if it is not one. A
+ * partially written last record is ignored.
+ */
+class reader {
+    std::ifstream in_;
+    file_header header_{};
+
+public:
+    explicit reader(const std::string& path);
+
+    const file_header&
+    header() const {
+        return header_;
+    }
+
+    /**
+     * @brief Reads the next record
+     * @return false at the end of the file
+     */
+    bool
+    next(entry& e);
+};
+
+} // namespace gkfs::capture
+
+#endif // GEKKOFS_CAPTURE_UTIL_HPP
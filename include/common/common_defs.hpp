@@ -38,6 +38,7 @@ using chnk_id_t = unsigned long;
 namespace tag {
 
 constexpr auto fs_config = "rpc_srv_fs_config";
+constexpr auto daemon_status = "rpc_srv_daemon_status";
 constexpr auto registry_request = "rpc_srv_registry_request";
 constexpr auto registry_register = "rpc_srv_registry_register";
 constexpr auto create = "rpc_srv_mk_node";
@@ -57,6 +58,8 @@ constexpr auto write = "rpc_srv_write_data";
 constexpr auto read = "rpc_srv_read_data";
 constexpr auto truncate = "rpc_srv_trunc_data";
 constexpr auto get_chunk_stat = "rpc_srv_chunk_stat";
+constexpr auto replicate_chunk = "rpc_srv_replicate_chunk";
+constexpr auto invalidate_replica = "rpc_srv_invalidate_replica";
 } // namespace tag
 
 namespace protocol {
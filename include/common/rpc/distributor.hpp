@@ -208,6 +208,18 @@ public:
     locate_directory_metadata(const std::string& path) const override;
 };
 
+/**
+ * @brief Returns the daemon holding a replica of a hot chunk. Replicas are
+ * placed on the daemons following the chunk's owner so that clients and
+ * daemons compute the same replica set without communication.
+ * @param owner Daemon the chunk hashes to
+ * @param replica Replica number starting at 1
+ * @param hosts_size Number of daemons
+ * @return Daemon id
+ */
+host_t
+locate_replica(host_t owner, unsigned int replica, unsigned int hosts_size);
+
 } // namespace gkfs::rpc
 
 #endif // GEKKOFS_RPC_LOCATOR_HPP
@@ -0,0 +1,206 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#ifndef GEKKOFS_RPC_PLACEMENT_HPP
+#define GEKKOFS_RPC_PLACEMENT_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gkfs::rpc {
+
+/**
+ * Space and load information of a single file system in federated mode,
+ * accumulated over all its daemons.
+ */
+struct FsLoad {
+    uint64_t chunk_total;
+    uint64_t chunk_free;
+    uint64_t queue_depth;
+};
+
+using fs_load_fetcher_t = std::function<std::vector<FsLoad>()>;
+
+/**
+ * Decides on which file system of a federated mount a new file or directory is
+ * placed. Existing paths are never passed to a policy; their file system is
+ * found via stat and recorded in pathfs. The decision is not derivable from
+ * the path, so only the client that created the path knows it without a stat.
+ */
+class PlacementPolicy {
+public:
+    virtual ~PlacementPolicy() = default;
+
+    virtual std::string
+    name() const = 0;
+
+    /**
+     * Paths whose parent is not the root directory are placed on the file
+     * system of their parent if this returns true, as directory entries are
+     * only collected from the parent's file system. The policy then only
+     * decides for entries of the root directory.
+     */
+    virtual bool
+    follows_parent() const = 0;
+
+    virtual unsigned int
+    place(const std::string& path, bool is_dir) = 0;
+};
+
+/**
+ * New paths always go to the file system of the local node. This is the
+ * original behavior of the federated mode.
+ */
+class LocalFirstPolicy : public PlacementPolicy {
+private:
+    unsigned int localfs_;
+
+public:
+    explicit LocalFirstPolicy(unsigned int localfs);
+
+    std::string
+    name() const override;
+
+    bool
+    follows_parent() const override;
+
+    unsigned int
+    place(const std::string& path, bool is_dir) override;
+};
+
+/**
+ * Each new directory is assigned the next file system in turn. Files end up
+ * on the file system of their directory.
+ */
+class DirRoundRobinPolicy : public PlacementPolicy {
+private:
+    unsigned int fs_count_;
+    unsigned int next_;
+    std::map<std::string, unsigned int> dirs_;
+    std::mutex mutex_;
+
+public:
+    explicit DirRoundRobinPolicy(unsigned int fs_count,
+                                 unsigned int start = 0);
+
+    std::string
+    name() const override;
+
+    bool
+    follows_parent() const override;
+
+    unsigned int
+    place(const std::string& path, bool is_dir) override;
+};
+
+/**
+ * Base for policies that use the chunk stat of each file system. The stats
+ * are fetched at most once per refresh interval to keep creates cheap.
+ */
+class LoadBasedPolicy : public PlacementPolicy {
+protected:
+    unsigned int localfs_;
+    fs_load_fetcher_t fetcher_;
+    std::chrono::steady_clock::duration refresh_interval_;
+    std::chrono::steady_clock::time_point last_refresh_;
+    std::vector<FsLoad> loads_;
+    std::mutex mutex_;
+
+    /**
+     * Picks a file system from a non-empty load vector. Called under mutex_.
+     */
+    virtual unsigned int
+    choose(std::vector<FsLoad>& loads) = 0;
+
+public:
+    LoadBasedPolicy(unsigned int localfs, fs_load_fetcher_t fetcher,
+                    std::chrono::steady_clock::duration refresh_interval);
+
+    bool
+    follows_parent() const override;
+
+    unsigned int
+    place(const std::string& path, bool is_dir) override;
+};
+
+/**
+ * Places new paths on the file system with the most free chunks.
+ */
+class CapacityAwarePolicy : public LoadBasedPolicy {
+protected:
+    unsigned int
+    choose(std::vector<FsLoad>& loads) override;
+
+public:
+    using LoadBasedPolicy::LoadBasedPolicy;
+
+    std::string
+    name() const override;
+};
+
+/**
+ * Places new paths on the file system with the smallest number of queued I/O
+ * tasks per daemon. Every placement counts as one queued task until the next
+ * refresh so that a burst of creates does not pile onto one file system.
+ */
+class LoadAwarePolicy : public LoadBasedPolicy {
+private:
+    std::vector<unsigned int> hosts_size_;
+
+protected:
+    unsigned int
+    choose(std::vector<FsLoad>& loads) override;
+
+public:
+    LoadAwarePolicy(unsigned int localfs, std::vector<unsigned int> hosts_size,
+                    fs_load_fetcher_t fetcher,
+                    std::chrono::steady_clock::duration refresh_interval);
+
+    std::string
+    name() const override;
+};
+
+/**
+ * Creates a placement policy by name (local, capacity, roundrobin, load).
+ * @return nullptr if the name is unknown
+ */
+std::unique_ptr<PlacementPolicy>
+make_placement_policy(const std::string& name, unsigned int localfs,
+                      const std::vector<unsigned int>& hosts_size,
+                      fs_load_fetcher_t fetcher);
+
+} // namespace gkfs::rpc
+
+#endif // GEKKOFS_RPC_PLACEMENT_HPP
@@ -71,7 +71,8 @@ MERCURY_GEN_PROC(
 MERCURY_GEN_PROC(rpc_update_metadentry_size_in_t,
                  ((hg_const_string_t) (path))((hg_uint64_t) (size))(
                          (hg_int64_t) (offset))((hg_bool_t) (append))(
-                (hg_const_string_t) (buf)) )
+                (hg_const_string_t) (buf))((hg_uint64_t) (trace_id))(
+                (hg_uint64_t) (span_id))((hg_uint64_t) (send_time)))
 
 MERCURY_GEN_PROC(rpc_update_metadentry_size_out_t,
                  ((hg_int32_t) (err))((hg_int64_t) (ret_offset)))
@@ -92,9 +93,17 @@ MERCURY_GEN_PROC(
                 (hg_uint64_t) (host_id))((hg_uint64_t) (host_size))(
                 (hg_uint64_t) (chunk_n))((hg_uint64_t) (chunk_start))(
                 (hg_uint64_t) (chunk_end))((hg_uint64_t) (total_chunk_size))(
-                (hg_bulk_t) (bulk_handle)))
+                (hg_bulk_t) (bulk_handle))((hg_int64_t) (replica_chunk))(
+                (hg_uint64_t) (trace_id))((hg_uint64_t) (span_id))(
+                (hg_uint64_t) (send_time)))
 
-MERCURY_GEN_PROC(rpc_data_out_t, ((int32_t) (err))((hg_size_t) (io_size)))
+MERCURY_GEN_PROC(rpc_data_out_t, ((int32_t) (err))((hg_size_t) (io_size))(
+                                         (hg_uint32_t) (replicas)))
+
+// extents are the data ranges in the client buffer encoded as a string
+MERCURY_GEN_PROC(rpc_read_data_out_t,
+                 ((int32_t) (err))((hg_size_t) (io_size))(
+                         (hg_uint32_t) (replicas))((hg_const_string_t) (extents)))
 
 MERCURY_GEN_PROC(
         rpc_write_data_in_t,
@@ -102,7 +111,18 @@ MERCURY_GEN_PROC(
                 (hg_uint64_t) (host_id))((hg_uint64_t) (host_size))(
                 (hg_uint64_t) (chunk_n))((hg_uint64_t) (chunk_start))(
                 (hg_uint64_t) (chunk_end))((hg_uint64_t) (total_chunk_size))(
-                (hg_bulk_t) (bulk_handle)))
+                (hg_bulk_t) (bulk_handle))((hg_uint64_t) (trace_id))(
+                (hg_uint64_t) (span_id))((hg_uint64_t) (send_time)))
+
+// hot chunk replication between daemons
+MERCURY_GEN_PROC(rpc_replicate_chunk_in_t,
+                 ((hg_const_string_t) (path))((hg_uint64_t) (chunk_id))(
+                         (hg_uint64_t) (version))((hg_uint64_t) (size))(
+                         (hg_bulk_t) (bulk_handle)))
+
+MERCURY_GEN_PROC(rpc_invalidate_replica_in_t,
+                 ((hg_const_string_t) (path))((hg_uint64_t) (chunk_id))(
+                         (hg_uint64_t) (version)))
 
 MERCURY_GEN_PROC(rpc_get_dirents_in_t,
                  ((hg_const_string_t) (path))((hg_bulk_t) (bulk_handle)))
@@ -119,6 +139,10 @@ MERCURY_GEN_PROC(
                 (hg_bool_t) (blocks_state))((hg_uint32_t) (uid))(
                 (hg_uint32_t) (gid)))
 
+MERCURY_GEN_PROC(
+        rpc_daemon_status_out_t,
+        ((hg_int32_t) (err))((hg_const_string_t) (status)))
+
 MERCURY_GEN_PROC(
         rpc_registry_request_out_t,
         ((hg_int32_t) (err)))
@@ -136,6 +160,7 @@ MERCURY_GEN_PROC(rpc_chunk_stat_in_t, ((hg_int32_t) (dummy)))
 MERCURY_GEN_PROC(
         rpc_chunk_stat_out_t,
         ((hg_int32_t) (err))((hg_uint64_t) (chunk_size))(
-                (hg_uint64_t) (chunk_total))((hg_uint64_t) (chunk_free)))
+                (hg_uint64_t) (chunk_total))((hg_uint64_t) (chunk_free))(
+                (hg_uint64_t) (queue_depth)))
 
 #endif // LFS_RPC_TYPES_HPP
@@ -34,10 +34,28 @@ extern "C" {
 #include <mercury_proc_string.h>
 }
 
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace gkfs::rpc {
 
+/**
+ * @brief Range of data in the client buffer of a read request. Ranges of the
+ * buffer that are not covered by an extent are holes.
+ */
+struct data_extent {
+    uint64_t offset;
+    uint64_t size;
+};
+
+/**
+ * @brief Named value of the live state of a daemon. Names have the form
+ * "<group>/<name>", e.g., "inflight/write_data".
+ */
+using status_entry = std::pair<std::string, uint64_t>;
+
 hg_bool_t
 bool_to_merc_bool(bool state);
 
@@ -50,6 +68,21 @@ encode_string(std::string& input);
 std::string
 decode_string(std::string& input);
 
+void
+merge_extents(std::vector<data_extent>& extents);
+
+std::string
+encode_extents(std::vector<data_extent> extents);
+
+std::vector<data_extent>
+decode_extents(const std::string& input);
+
+std::string
+encode_status(const std::vector<status_entry>& entries);
+
+std::vector<status_entry>
+decode_status(const std::string& input);
+
 #ifdef GKFS_ENABLE_UNUSED_FUNCTIONS
 std::string
 get_host_by_name(const std::string& hostname);
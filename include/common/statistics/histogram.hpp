@@ -0,0 +1,153 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef GKFS_COMMON_HISTOGRAM_HPP
+#define GKFS_COMMON_HISTOGRAM_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace gkfs::utils {
+
+/**
+ * Latency histogram with fixed log-linear buckets (as in HdrHistogram).
+ * Values below 2^sub_bucket_bits are counted exactly. Above, every power of
+ * two is split into 2^sub_bucket_bits buckets, which bounds the relative
+ * error of a reported value to 2^-sub_bucket_bits. Values are capped at
+ * 2^max_bits - 1.
+ *
+ * Recording is a relaxed atomic increment and never allocates, so a
+ * histogram can be updated concurrently by several threads.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned sub_bucket_bits = 4;
+    static constexpr unsigned max_bits = 40; ///< ~18 minutes in ns
+    static constexpr unsigned sub_buckets = 1u << sub_bucket_bits;
+    static constexpr unsigned num_buckets =
+            (max_bits - sub_bucket_bits + 1) * sub_buckets;
+
+    using counts = std::array<uint64_t, num_buckets>;
+
+private:
+    std::array<std::atomic<uint64_t>, num_buckets> buckets_{};
+
+public:
+    /**
+     * @brief Returns the bucket a value is counted in
+     */
+    static constexpr unsigned
+    bucket_of(uint64_t value) {
+        constexpr uint64_t max_value = (uint64_t{1} << max_bits) - 1;
+        if(value > max_value) {
+            value = max_value;
+        }
+        if(value < sub_buckets) {
+            return static_cast<unsigned>(value);
+        }
+        const unsigned msb = 63 - __builtin_clzll(value);
+        const unsigned shift = msb - sub_bucket_bits;
+        return (shift + 1) * sub_buckets +
+               static_cast<unsigned>((value >> shift) - sub_buckets);
+    }
+
+    /**
+     * @brief Returns the smallest value counted in a bucket
+     */
+    static constexpr uint64_t
+    lowest_value(unsigned bucket) {
+        if(bucket < sub_buckets) {
+            return bucket;
+        }
+        const unsigned shift = bucket / sub_buckets - 1;
+        return (uint64_t{sub_buckets} + bucket % sub_buckets) << shift;
+    }
+
+    /**
+     * @brief Returns the largest value counted in a bucket
+     */
+    static constexpr uint64_t
+    highest_value(unsigned bucket) {
+        if(bucket + 1 >= num_buckets) {
+            return (uint64_t{1} << max_bits) - 1;
+        }
+        return lowest_value(bucket + 1) - 1;
+    }
+
+    void
+    record(uint64_t value) {
+        buckets_[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Adds the counts of this histogram to `out`
+     */
+    void
+    add_to(counts& out) const {
+        for(unsigned i = 0; i < num_buckets; i++) {
+            out[i] += buckets_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Returns the value below which `percentile` percent of the
+     * recorded values fall, reported as the highest value of its bucket
+     * @param c counts, e.g., merged with add_to()
+     * @param percentile in [0, 100]
+     * @return 0 if no value was recorded
+     */
+    static uint64_t
+    value_at(const counts& c, double percentile) {
+        uint64_t total = 0;
+        for(auto n : c) {
+            total += n;
+        }
+        if(total == 0) {
+            return 0;
+        }
+        auto rank = static_cast<uint64_t>(percentile / 100.0 *
+                                          static_cast<double>(total) +
+                                          0.5);
+        if(rank == 0) {
+            rank = 1;
+        }
+        uint64_t seen = 0;
+        for(unsigned i = 0; i < num_buckets; i++) {
+            seen += c[i];
+            if(seen >= rank) {
+                return highest_value(i);
+            }
+        }
+        return highest_value(num_buckets - 1);
+    }
+};
+
+} // namespace gkfs::utils
+
+#endif // GKFS_COMMON_HISTOGRAM_HPP
@@ -32,10 +32,11 @@
 #include <cstdint>
 #include <unistd.h>
 #include <cassert>
+#include <array>
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
-#include <deque>
 #include <chrono>
 #include <optional>
 #include <initializer_list>
@@ -46,6 +47,8 @@
 #include <atomic>
 #include <mutex>
 #include <config.hpp>
+#include <common/statistics/histogram.hpp>
+#include <common/statistics/top_k.hpp>
 
 
 // PROMETHEUS includes
@@ -80,9 +83,10 @@ namespace gkfs::utils {
  * 5 minute mean
  * 10 minute mean
  *
- * To provide the stats that we need,
- * we need to store the info and the timestamp to calculate it
- * A vector should work, with a maximum of elements,
+ * Counters and latency histograms are sharded by thread, so that the
+ * Argobots execution streams serving RPCs do not contend on them. The 1, 5,
+ * and 10 minute means are computed from snapshots of the totals that are
+ * taken every few seconds into a fixed ring.
  */
 
 class Stats {
@@ -113,34 +117,73 @@ private:
     const std::vector<std::string> SizeOp_s = {"WRITE_SIZE",
                                                "READ_SIZE"}; ///< Stats Labels
 
-    std::chrono::time_point<std::chrono::steady_clock>
-            start; ///< When we started the server
+public:
+    using clock = std::chrono::steady_clock;
+
+private:
+    static constexpr std::size_t num_IopsOp = 6;
+    static constexpr std::size_t num_SizeOp = 2;
 
+    clock::time_point start; ///< When we started the server
 
-    std::map<IopsOp, std::atomic<unsigned long>>
-            iops_mean; ///< Stores total value for global mean
-    std::map<SizeOp, std::atomic<unsigned long>>
-            size_mean; ///< Stores total value for global mean
+    /**
+     * Counters of the threads mapped to a shard. A thread picks a shard on
+     * first use, so usually each shard is updated by a single execution
+     * stream and no cache lines are shared between them.
+     */
+    struct alignas(64) Shard {
+        std::array<std::atomic<unsigned long long>, num_IopsOp> iops{};
+        std::array<std::atomic<unsigned long long>, num_SizeOp> size{};
+        std::array<LatencyHistogram, num_IopsOp> latency{};
+    };
 
-    std::mutex time_iops_mutex;
-    std::mutex size_iops_mutex;
+    std::size_t num_shards_;
+    std::unique_ptr<Shard[]> shards_;
 
-    std::map<IopsOp,
-             std::deque<std::chrono::time_point<std::chrono::steady_clock>>>
-            time_iops; ///< Stores timestamp when an operation comes removes if
-                       ///< first operation if > 10 minutes Different means will
-                       ///< be stored and cached 1 minuted
+    /**
+     * @brief Returns the shard of the calling thread
+     */
+    Shard&
+    shard();
 
+    /**
+     * Totals at a point in time
+     */
+    struct Snapshot {
+        clock::time_point taken;
+        std::array<unsigned long long, num_IopsOp> iops{};
+        std::array<unsigned long long, num_SizeOp> size{};
+        bool valid = false;
+    };
+
+    std::mutex windows_mutex; ///< Protects windows and last_window
+    std::array<Snapshot, gkfs::config::stats::window_slots>
+            windows;           ///< Ring of snapshots taken every
+                               ///< window_interval for the 1-5-10 minute means
+    std::size_t last_window{}; ///< Most recent snapshot in windows
 
-    std::map<SizeOp, std::deque<std::pair<
-                             std::chrono::time_point<std::chrono::steady_clock>,
-                             unsigned long long>>>
-            time_size; ///< For size operations we need to store the timestamp
-                       ///< and the size
+    /**
+     * @brief Sums up the counters of all shards
+     */
+    Snapshot
+    totals() const;
 
+    /**
+     * @brief Stores a new snapshot in windows if the last one is older than
+     * window_interval. Must be called with windows_mutex held
+     */
+    void
+    sample_windows();
+
+    /**
+     * @brief Returns the snapshot that the mean over the last `window` is
+     * computed from. Must be called with windows_mutex held
+     */
+    const Snapshot&
+    window_start(clock::time_point now, std::chrono::seconds window) const;
 
     std::thread t_output;    ///< Thread that outputs stats info
-    bool output_thread_;     ///< Enables or disables the output thread
+    bool output_thread_{false}; ///< Enables or disables the output thread
     bool enable_prometheus_; ///< Enables or disables the prometheus output
     bool enable_chunkstats_; ///< Enables or disables the chunk stats output
 
@@ -157,15 +200,37 @@ private:
     void
     output(std::chrono::seconds d, std::string file_output);
 
-    std::map<std::pair<std::string, unsigned long long>,
-             std::atomic<unsigned int>>
-            chunk_reads; ///< Stores the number of times a chunk/file is read
-    std::map<std::pair<std::string, unsigned long long>,
-             std::atomic<unsigned int>>
-            chunk_writes; ///< Stores the number of times a chunk/file is write
+    using ChunkKey = std::pair<std::string, unsigned long long>;
+
+    struct ChunkKeyHash {
+        std::size_t
+        operator()(const ChunkKey& key) const {
+            return std::hash<std::string>{}(key.first) ^
+                   (std::hash<unsigned long long>{}(key.second) * 0x9e3779b9);
+        }
+    };
+
+    SpaceSaving<ChunkKey, ChunkKeyHash>
+            chunk_reads; ///< Hottest chunks by number of reads
+    SpaceSaving<ChunkKey, ChunkKeyHash>
+            chunk_writes; ///< Hottest chunks by number of writes
+    SpaceSaving<std::string> file_reads;  ///< Hottest files by chunk reads
+    SpaceSaving<std::string> file_writes; ///< Hottest files by chunk writes
+    std::mutex chunk_stats_mutex; ///< Protects the chunk and file sketches
+    std::string hostname_;        ///< Tags the hot chunk output
+
+    std::atomic<unsigned long long> merge_batches{
+            0}; ///< Batches flushed by the I/O scheduler
+    std::atomic<unsigned long long> merge_requests{
+            0}; ///< Write requests served by the I/O scheduler
+    std::atomic<unsigned long long> merge_disk_ops{
+            0}; ///< Disk writes issued by the I/O scheduler
 
     /**
-     * @brief Called by output to generate CHUNK map
+     * @brief Called by output to write the hottest chunks and files since
+     * the last call. Chunks are written in the format of the trace_reads log
+     * lines, which examples/distributors/guided/generate.py turns into a
+     * guided distributor configuration
      *
      * @param output is the output stream
      */
@@ -191,6 +256,8 @@ private:
                                         ///< Prometheus cpp)
     std::map<IopsOp, Counter*> iops_prometheus; ///< Prometheus IOPS metrics
     std::map<SizeOp, Summary*> size_prometheus; ///< Prometheus SIZE metrics
+    Counter* merge_requests_prometheus; ///< Prometheus scheduled requests
+    Counter* merge_disk_ops_prometheus; ///< Prometheus scheduled disk writes
 #endif
 
 public:
@@ -238,6 +305,15 @@ public:
     void
     add_write(const std::string& path, unsigned long long chunk);
 
+    /**
+     * @brief Adds a batch of writes flushed by the I/O scheduler
+     *
+     * @param requests number of write requests in the batch
+     * @param disk_ops number of disk writes the batch was merged into
+     */
+    void
+    add_write_merge(unsigned long long requests, unsigned long long disk_ops);
+
 
     /**
      * Add a new value for a IOPS, that does not involve any size
@@ -245,9 +321,11 @@ public:
      * Size operations internally call this operation (read,write)
      *
      * @param IopsOp Which operation to add
+     * @param started when the operation started. If given, the latency of
+     * the operation is recorded
      */
 
-    void add_value_iops(enum IopsOp);
+    void add_value_iops(enum IopsOp, clock::time_point started = {});
 
     /**
      * @brief Store a new stat point, with a size value.
@@ -256,9 +334,11 @@ public:
      *
      * @param SizeOp Which operation we refer
      * @param value to store (SizeOp)
+     * @param started when the operation started (see add_value_iops)
      */
     void
-    add_value_size(enum SizeOp, unsigned long long value);
+    add_value_size(enum SizeOp, unsigned long long value,
+                   clock::time_point started = {});
 
     /**
      * @brief Get the total mean value of the asked stat
@@ -294,6 +374,25 @@ public:
      * @return std::vector< double > with 4 means
      */
     std::vector<double> get_four_means(enum IopsOp);
+
+    /**
+     * @brief Get the latency histogram of an IOPS_OP, merged over all threads
+     * @param IopsOp Which operation to get
+     *
+     * @return counts of the histogram buckets (latencies in ns)
+     */
+    LatencyHistogram::counts get_latency(enum IopsOp);
+
+    /**
+     * @brief Get the operation and byte counts since the start, the p99
+     * latencies, and the most accessed chunks as named values, e.g.,
+     * "ops/iops_write" or "hot_read/<chunk>/<path>"
+     * @param hot_chunks maximum number of read and of written chunks
+     *
+     * @return std::vector of pairs <name, value>
+     */
+    std::vector<std::pair<std::string, uint64_t>>
+    status(std::size_t hot_chunks);
 };
 
 } // namespace gkfs::utils
@@ -0,0 +1,212 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef GKFS_COMMON_TOP_K_HPP
+#define GKFS_COMMON_TOP_K_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gkfs::utils {
+
+/**
+ * Space-saving sketch of the most frequent keys of a stream (Metwally et al.,
+ * "Efficient Computation of Frequent and Top-k Elements in Data Streams").
+ *
+ * At most `capacity` keys are tracked. A key that is not tracked replaces the
+ * one with the smallest count and inherits that count, so counts are upper
+ * bounds that exceed the true count by at most the smallest tracked count.
+ * Every key whose true count is larger than that is guaranteed to be tracked.
+ * Entries are kept in a min-heap on their count, so an update costs
+ * O(log capacity).
+ *
+ * Not thread-safe.
+ */
+template <typename Key, typename Hash = std::hash<Key>>
+class SpaceSaving {
+    struct Entry {
+        Key key;
+        uint64_t count;    ///< estimated count (upper bound)
+        uint64_t reported; ///< count at the last take_interval()
+    };
+
+    std::size_t capacity_;
+    std::vector<Entry> heap_; ///< min-heap on count
+    std::unordered_map<Key, std::size_t, Hash> index_; ///< key -> heap_ pos
+
+    void
+    swap_entries(std::size_t a, std::size_t b) {
+        std::swap(heap_[a], heap_[b]);
+        index_[heap_[a].key] = a;
+        index_[heap_[b].key] = b;
+    }
+
+    void
+    sift_up(std::size_t i) {
+        while(i > 0) {
+            const auto parent = (i - 1) / 2;
+            if(heap_[parent].count <= heap_[i].count) {
+                break;
+            }
+            swap_entries(parent, i);
+            i = parent;
+        }
+    }
+
+    void
+    sift_down(std::size_t i) {
+        for(;;) {
+            const auto left = 2 * i + 1;
+            const auto right = left + 1;
+            auto smallest = i;
+            if(left < heap_.size() &&
+               heap_[left].count < heap_[smallest].count) {
+                smallest = left;
+            }
+            if(right < heap_.size() &&
+               heap_[right].count < heap_[smallest].count) {
+                smallest = right;
+            }
+            if(smallest == i) {
+                return;
+            }
+            swap_entries(i, smallest);
+            i = smallest;
+        }
+    }
+
+public:
+    explicit SpaceSaving(std::size_t capacity) : capacity_(capacity) {
+        heap_.reserve(capacity);
+        index_.reserve(capacity);
+    }
+
+    /**
+     * @brief Counts `n` occurrences of a key
+     * @return the estimated count of the key
+     */
+    uint64_t
+    add(const Key& key, uint64_t n = 1) {
+        if(capacity_ == 0) {
+            return n;
+        }
+        auto it = index_.find(key);
+        if(it != index_.end()) {
+            const auto i = it->second;
+            heap_[i].count += n;
+            const auto count = heap_[i].count;
+            sift_down(i);
+            return count;
+        }
+        if(heap_.size() < capacity_) {
+            heap_.push_back({key, n, 0});
+            index_[key] = heap_.size() - 1;
+            sift_up(heap_.size() - 1);
+            return n;
+        }
+        // replace the least frequent key. Only the new occurrences count
+        // towards the current interval
+        auto& min = heap_[0];
+        index_.erase(min.key);
+        min.key = key;
+        min.reported = min.count;
+        min.count += n;
+        const auto count = min.count;
+        index_[key] = 0;
+        sift_down(0);
+        return count;
+    }
+
+    /**
+     * @brief Returns the estimated count of a key, 0 if it is not tracked
+     */
+    uint64_t
+    estimate(const Key& key) const {
+        auto it = index_.find(key);
+        return it == index_.end() ? 0 : heap_[it->second].count;
+    }
+
+    std::size_t
+    size() const {
+        return heap_.size();
+    }
+
+    /**
+     * @brief Returns up to k keys with the largest estimated counts, in
+     * descending order of their count
+     */
+    std::vector<std::pair<Key, uint64_t>>
+    top(std::size_t k) const {
+        std::vector<std::pair<Key, uint64_t>> out;
+        out.reserve(heap_.size());
+        for(const auto& e : heap_) {
+            out.emplace_back(e.key, e.count);
+        }
+        return select(std::move(out), k);
+    }
+
+    /**
+     * @brief Returns up to k keys with the most occurrences since the last
+     * call, in descending order, and starts a new interval
+     */
+    std::vector<std::pair<Key, uint64_t>>
+    take_interval(std::size_t k) {
+        std::vector<std::pair<Key, uint64_t>> out;
+        for(auto& e : heap_) {
+            if(e.count > e.reported) {
+                out.emplace_back(e.key, e.count - e.reported);
+            }
+            e.reported = e.count;
+        }
+        return select(std::move(out), k);
+    }
+
+private:
+    static std::vector<std::pair<Key, uint64_t>>
+    select(std::vector<std::pair<Key, uint64_t>> entries, std::size_t k) {
+        const auto by_count = [](const auto& a, const auto& b) {
+            return a.second > b.second;
+        };
+        if(entries.size() > k) {
+            std::partial_sort(entries.begin(), entries.begin() + k,
+                              entries.end(), by_count);
+            entries.resize(k);
+        } else {
+            std::sort(entries.begin(), entries.end(), by_count);
+        }
+        return entries;
+    }
+};
+
+} // namespace gkfs::utils
+
+#endif // GKFS_COMMON_TOP_K_HPP
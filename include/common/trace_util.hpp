@@ -0,0 +1,226 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef GEKKOFS_TRACE_UTIL_HPP
+#define GEKKOFS_TRACE_UTIL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * Tracing of RPCs across clients and daemons. A sampled client operation
+ * gets a trace id. Every timed phase is a span with an id and the id of its
+ * parent span. The trace context travels with the RPC input, so daemon spans
+ * can be attached to the client span of the RPC. Spans are appended to a
+ * binary file per process. scripts/dev/gkfs_trace2json.py merges the files
+ * into the Chrome trace event format.
+ */
+namespace gkfs::trace {
+
+/**
+ * Trace context passed in RPC inputs. A trace id of 0 means not sampled.
+ */
+struct context {
+    uint64_t trace_id = 0;
+    uint64_t span_id = 0;   ///< span of the RPC on the caller
+    uint64_t send_time = 0; ///< when the caller sent the RPC (ns)
+
+    explicit operator bool() const {
+        return trace_id != 0;
+    }
+};
+
+/**
+ * On-disk span record (little-endian, 64 bytes). Times are ns since the
+ * epoch (CLOCK_REALTIME), so clocks must be synchronized across nodes to
+ * line up client and daemon spans.
+ */
+struct record {
+    uint64_t trace_id;
+    uint64_t span_id;
+    uint64_t parent_id; ///< 0 for the root span of a trace
+    uint64_t start;
+    uint64_t end;
+    uint32_t pid;
+    uint32_t tid;
+    char name[16]; ///< null-terminated unless all 16 bytes are used
+};
+
+static_assert(sizeof(record) == 64, "trace records must be 64 bytes");
+
+/**
+ * File header, followed by records
+ */
+struct file_header {
+    char magic[8]; ///< "GKFSTRC1"
+    char host[56]; ///< hostname of the writer, null-terminated
+};
+
+static_assert(sizeof(file_header) == 64, "trace header must be 64 bytes");
+
+constexpr char file_magic[8] = {'G', 'K', 'F', 'S', 'T', 'R', 'C', '1'};
+
+/**
+ * @brief Current time in ns since the epoch
+ */
+uint64_t
+now();
+
+/**
+ * @brief Returns a random non-zero id
+ */
+uint64_t
+new_id();
+
+/**
+ * @brief Returns true for a random fraction `rate` of calls
+ */
+bool
+sample(double rate);
+
+/**
+ * Buffers span records and appends them to a trace file.
+ */
+class writer {
+public:
+    /// Function used to write to the file, e.g., to bypass interception
+    using write_fn = long (*)(int fd, const void* buf, size_t count);
+
+private:
+    int fd_;
+    write_fn write_;
+    std::mutex mutex_;
+    std::vector<record> buffer_;
+
+    void
+    write_out(const void* data, size_t size);
+
+    void
+    flush_locked();
+
+public:
+    static constexpr size_t buffer_records = 1024;
+
+    /**
+     * @param fd open file to append to. It is not closed by the writer
+     * @param write function used to write to fd
+     */
+    writer(int fd, write_fn write);
+
+    ~writer();
+
+    writer(const writer&) = delete;
+
+    writer&
+    operator=(const writer&) = delete;
+
+    void
+    add(const record& r);
+
+    void
+    flush();
+};
+
+/**
+ * A timed phase. The span is recorded when it ends, at the latest when it is
+ * destroyed. Spans without a writer or outside a sampled trace do nothing.
+ */
+class span {
+    writer* writer_ = nullptr;
+    record record_{};
+
+public:
+    span() = default;
+
+    span(writer* w, const char* name, uint64_t trace_id, uint64_t parent_id,
+         uint64_t start = 0);
+
+    span(span&& other) noexcept;
+
+    span&
+    operator=(span&& other) noexcept;
+
+    span(const span&) = delete;
+
+    span&
+    operator=(const span&) = delete;
+
+    ~span();
+
+    bool
+    active() const {
+        return writer_ != nullptr;
+    }
+
+    uint64_t
+    trace_id() const {
+        return record_.trace_id;
+    }
+
+    uint64_t
+    id() const {
+        return record_.span_id;
+    }
+
+    /**
+     * @brief Context to pass to an RPC sent within this span
+     */
+    context
+    rpc_context() const;
+
+    /**
+     * @brief Starts a span nested in this span. It is inactive if this span
+     * is inactive.
+     */
+    span
+    child(const char* name) const;
+
+    /**
+     * @brief Records the span instead of on destruction
+     * @param time end of the span in ns since the epoch, 0 for now
+     */
+    void
+    end(uint64_t time = 0);
+};
+
+/**
+ * @brief Starts the span of a handler serving a traced RPC. The time between
+ * sending the RPC and calling this function is recorded as "queue" span.
+ * @param w writer of the serving process, may be nullptr
+ * @param name handler span name
+ * @param rpc context from the RPC input
+ * @return handler span, inactive if w is nullptr or the RPC is not traced
+ */
+span
+handler_span(writer* w, const char* name, const context& rpc);
+
+} // namespace gkfs::trace
+
+#endif // GEKKOFS_TRACE_UTIL_HPP
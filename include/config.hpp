@@ -43,13 +43,35 @@ constexpr auto hostfile_config_path = "./gkfs_hosts_config.txt";
 constexpr auto forwarding_file_path = "./gkfs_forwarding.map";
 constexpr auto registryfile_path = "./gkfs_registry.txt";
 constexpr auto merge_default = "off";
+/*
+ * Clients on a node share the parsed hosts files in a POSIX shared memory
+ * segment (see gkfs::utils::HostSegment). Can be changed with
+ * LIBGKFS_HOST_SEGMENT.
+ */
+constexpr auto host_segment_default = "on";
+/*
+ * Number of paths outside of the mountdir whose type (directory, link, other)
+ * the client caches to avoid lstat() calls when resolving paths. Can be changed
+ * with LIBGKFS_PATH_CACHE_ENTRIES (0 disables the cache). Entries are checked
+ * again after `path_cache_ttl` (LIBGKFS_PATH_CACHE_TTL) in case another
+ * process replaced a path.
+ */
+constexpr auto path_cache_entries = 4096;
+constexpr auto path_cache_ttl = 1000; // in milliseconds
+/*
+ * Number of GekkoFS file descriptors the client keeps in its lock-free fd
+ * table. Further descriptors, and dup2() targets outside of the table, are
+ * kept in a map behind a lock. Rounded up to a multiple of 64.
+ */
+constexpr auto open_file_table_size = 8192;
 
 namespace io {
 /*
- * Zero buffer before read. This is relevant if sparse files are used.
- * If buffer is not zeroed, sparse regions contain invalid data.
+ * Reads only transfer the data regions of sparse chunk files and the client
+ * zeroes the holes. Holes smaller than this are sent as zeros instead, to
+ * avoid many small bulk transfers.
  */
-constexpr auto zero_buffer_before_read = false;
+constexpr auto sparse_read_min_hole = 64 * 1024; // in bytes
 } // namespace io
 
 namespace log {
@@ -58,6 +80,14 @@ constexpr auto daemon_log_path = "/tmp/gkfs_daemon.log";
 
 constexpr auto client_log_level = "info,errors,critical,hermes";
 constexpr auto daemon_log_level = 4; // info
+
+// asynchronous client logging: size of each thread's log ring in bytes and
+// how often the rings are written out in ms
+constexpr auto client_log_ring_size = 1024 * 1024;
+constexpr auto client_log_flush_interval = 10;
+
+// directory of the RPC trace files of clients and daemons
+constexpr auto trace_dir = "/tmp";
 } // namespace log
 
 namespace metadata {
@@ -79,8 +109,8 @@ constexpr auto use_blocks = false;
 /*
  * If true, all chunks on the same host are removed during a metadata remove
  * rpc. This is a technical optimization that reduces the number of RPCs for
- * remove operations. This setting could be useful for future asynchronous
- * remove implementations where the data should not be removed immediately.
+ * remove operations. Chunks are only moved to a tombstone during the rpc and
+ * reclaimed asynchronously (see data::trash_dir).
  */
 constexpr auto implicit_data_removal = true;
 
@@ -92,6 +122,37 @@ constexpr auto create_exist_check = true;
 namespace data {
 // directory name below rootdir where chunks are placed
 constexpr auto chunk_dir = "chunks";
+/*
+ * Removed files leave a tombstone in `trash_dir` next to `chunk_dir`, which is
+ * reclaimed in the background. The collector removes up to `gc_batch` chunk
+ * files at a time and pauses `gc_interval` milliseconds between batches to
+ * leave the I/O execution streams to client requests.
+ */
+constexpr auto trash_dir = "trash";
+constexpr auto gc_batch = 256;
+constexpr auto gc_interval = 10; // in milliseconds
+/*
+ * Container chunk backend, selected with the daemon's --chunkbackend. Chunks
+ * are spread over `container_count` files. Extents are at least
+ * `container_block_size` bytes and containers are preallocated in steps of
+ * `container_grow_size` bytes. Every `container_compaction_interval` seconds,
+ * a container is compacted if more than `container_compaction_ratio` of it is
+ * free. Compaction scans at most `container_compaction_scan` index entries at
+ * a time.
+ */
+constexpr auto container_count = 8;
+constexpr auto container_block_size = 4096;            // in bytes
+constexpr auto container_grow_size = 16 * 1024 * 1024; // in bytes
+constexpr auto container_compaction_interval = 60;     // in seconds
+constexpr auto container_compaction_ratio = 0.5;
+constexpr auto container_compaction_scan = 4096;
+/*
+ * Reads can push chunk data directly from read-only mappings of the chunk
+ * files instead of copying it into a bulk buffer first. Mappings are cached up
+ * to this size. 0 disables mapped reads. Can be changed with the daemon's
+ * --chunk-map-cache. Only used with the `file` chunk backend.
+ */
+constexpr auto map_cache_size = 0; // in MiB
 } // namespace data
 
 namespace rpc {
@@ -107,15 +168,110 @@ constexpr auto dirents_buff_size = (8 * 1024 * 1024); // 8 mega
 constexpr auto daemon_io_xstreams = 8;
 // Number of threads used for RPC handlers at the daemon
 constexpr auto daemon_handler_xstreams = 4;
+/*
+ * If true, each I/O xstream has its own pool and steals tasks from the pools
+ * of the other xstreams when its own pool is empty. Otherwise, all I/O
+ * xstreams share a single pool. Can be changed with the daemon's --io-pools.
+ */
+constexpr auto daemon_io_private_pools = false;
+/*
+ * Pool of pre-registered bulk buffers used by the daemon's read and write
+ * handlers. Buffers have power of two sizes from one chunk up to
+ * `bulk_pool_max_buffer` bytes. Larger transfers use a buffer of their own.
+ * `bulk_pool_size` caps the memory of all buffers and can be changed with the
+ * daemon's --bulk-pool-size (0 disables the pool).
+ */
+constexpr auto bulk_pool_size = 1024;                 // in MiB
+constexpr auto bulk_pool_max_buffer = 64 * chunksize; // in bytes
+/*
+ * Client cache of RMA registrations of application buffers. Buffers that are
+ * reused for many reads or writes are exposed only once. The number of cached
+ * registrations can be changed with LIBGKFS_REG_CACHE_ENTRIES (0 disables the
+ * cache).
+ */
+constexpr auto client_reg_cache_entries = 64;
+constexpr auto client_reg_cache_size = 1024; // in MiB
+/*
+ * Daemon addresses are looked up by clients on first use. In addition, all
+ * addresses are resolved in the background with at most this many lookups in
+ * flight. Can be changed with LIBGKFS_LOOKUP_PARALLELISM (0 only looks up
+ * addresses on first use).
+ */
+constexpr auto client_lookup_parallelism = 16;
 } // namespace rpc
 
+namespace io_scheduler {
+/*
+ * Built-in write scheduler that is used if AGIOS is not compiled in. Writes to
+ * the same chunk file are collected until no new write arrived for `window`
+ * microseconds, but at most `deadline` microseconds after the first one, and
+ * are then merged. A window of 0 disables the scheduler. Both can be changed
+ * with the daemon's --io-scheduler-window and --io-scheduler-deadline.
+ */
+constexpr auto window = 0;      // in microseconds
+constexpr auto deadline = 2000; // in microseconds
+} // namespace io_scheduler
+
+namespace replication {
+/*
+ * Hot chunk read replication. A chunk becomes hot when it is read `threshold`
+ * times on its owning daemon within `window` seconds. Replication is enabled
+ * on the daemon with --hot-chunk-replicas.
+ */
+constexpr auto threshold = 64;
+constexpr auto window = 10; // in seconds
+// upper bound of chunks whose read rate is tracked and of copies held per daemon
+constexpr auto max_tracked_chunks = 65536;
+// retries of a failed replica invalidation and the delay between them
+constexpr auto invalidate_retries = 3;
+constexpr auto invalidate_retry_delay = 100; // in milliseconds
+// upper bound of files with hot chunks remembered per client
+constexpr auto client_max_hot_files = 1024;
+} // namespace replication
+
 namespace rocksdb {
 // Write-ahead logging of rocksdb
 constexpr auto use_write_ahead_log = false;
 } // namespace rocksdb
 
+namespace memory {
+// number of independently locked shards of the in-memory metadata backend
+constexpr auto shards = 64;
+/*
+ * Seconds between snapshots of the in-memory metadata backend to the metadata
+ * directory. A snapshot is also written on shutdown and loaded on startup,
+ * which allows restarting a daemon. 0 disables snapshots.
+ */
+constexpr auto snapshot_interval = 0;
+} // namespace memory
+
+namespace placement {
+/*
+ * Policy used to choose the file system for new files in federated mode. Can
+ * be overwritten with the LIBGKFS_PLACEMENT_POLICY environment variable.
+ * Valid values: local, capacity, roundrobin, load
+ */
+constexpr auto default_policy = "local";
+// seconds a chunk stat snapshot is used by capacity and load policies
+constexpr auto stat_refresh_interval = 5;
+// maximum number of directories remembered by the round robin policy
+constexpr auto max_tracked_dirs = 4096;
+} // namespace placement
+
 namespace stats {
-constexpr auto max_stats = 1000000; ///< How many stats will be stored
+// counters are sharded by thread, threads beyond this share shards
+constexpr auto shards = 16;
+// seconds between the snapshots used for the 1, 5, and 10 minute means, and
+// how many are kept (must cover 10 minutes)
+constexpr auto window_interval = 10;
+constexpr auto window_slots = 64;
+// chunks and files tracked for --enable-chunkstats, and how many of the
+// hottest are written to the stats file per interval
+constexpr auto hot_chunks_tracked = 4096;
+constexpr auto hot_files_tracked = 1024;
+constexpr auto hot_chunks_reported = 64;
+// hottest chunks returned by the daemon status RPC (see gkfs-top)
+constexpr auto hot_chunks_status = 8;
 constexpr auto prometheus_gateway = "127.0.0.1:9091";
 } // namespace stats
 
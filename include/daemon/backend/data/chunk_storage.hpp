@@ -35,10 +35,18 @@
 
 #include <common/common_defs.hpp>
 
+#include <atomic>
 #include <limits>
 #include <string>
 #include <memory>
+#include <set>
+#include <string_view>
 #include <system_error>
+#include <vector>
+
+extern "C" {
+#include <sys/uio.h>
+}
 
 /* Forward declarations */
 namespace spdlog {
@@ -47,6 +55,11 @@ class logger;
 
 namespace gkfs::data {
 
+class ContainerStore;
+
+constexpr auto file_backend = "file";
+constexpr auto container_backend = "container";
+
 struct ChunkStat {
     unsigned long chunk_size;
     unsigned long chunk_total;
@@ -72,6 +85,12 @@ private:
 
     std::string root_path_; //!< Path to GekkoFS root directory
     size_t chunksize_; //!< File system chunksize. TODO Why does that exist?
+    std::unique_ptr<ContainerStore>
+            container_; //!< Set if chunks are kept in container files
+    std::string trash_path_; //!< Directory of tombstones of removed files
+    mutable std::atomic<uint64_t> tombstone_seq_{0}; //!< Tombstone names
+    mutable std::set<std::string>
+            stuck_tombstones_; //!< Tombstones that cannot be reclaimed
 
     /**
      * @brief Converts an internal gkfs path under the root dir to the absolute
@@ -109,14 +128,34 @@ private:
     void
     init_chunk_space(const std::string& file_path) const;
 
+    /**
+     * @brief Reads a range of an open chunk file until size bytes are read or
+     * the end of the file is reached.
+     * @param fd File descriptor of the chunk file
+     * @param chunk_path Chunk file path for error messages
+     * @param buf Buffer to read to
+     * @param size Amount of bytes to read
+     * @param offset Offset where to read from the chunk file
+     * @return The amount of bytes read
+     * @throws ChunkStorageException with its error code
+     */
+    size_t
+    read_range(int fd, const std::string& chunk_path, char* buf, size_t size,
+               off64_t offset) const;
+
 public:
     /**
      * @brief Initializes the ChunkStorage object on daemon launch.
      * @param path Root directory where all data is placed on the local FS.
      * @param chunksize Used chunksize in this GekkoFS instance.
+     * @param backend Layout of chunks on the local FS. `file` keeps one file
+     * per chunk, `container` keeps chunks as extents in a few container files.
      * @throws ChunkStorageException on launch failure
      */
-    ChunkStorage(std::string& path, size_t chunksize);
+    ChunkStorage(std::string& path, size_t chunksize,
+                 std::string_view backend = file_backend);
+
+    ~ChunkStorage();
 
     /**
      * @brief Removes chunk directory with all its files which is a recursive
@@ -127,6 +166,29 @@ public:
     void
     destroy_chunk_space(const std::string& file_path) const;
 
+    /**
+     * @brief Moves the chunk directory of a file to a tombstone so that its
+     * chunk files can be reclaimed later by reclaim_tombstones(). This is a
+     * single rename, independent of the number of chunks. A file created
+     * under the same path afterwards starts with an empty chunk directory.
+     * @param file_path Chunk file path, e.g., /foo/bar
+     * @return true if a tombstone was created, false if there was nothing to
+     * reclaim or the chunks were removed right away (container backend)
+     * @throws ChunkStorageException
+     */
+    bool
+    tombstone_chunk_space(const std::string& file_path) const;
+
+    /**
+     * @brief Removes chunk files and emptied directories of tombstones.
+     * Tombstones with chunk files that cannot be removed are skipped.
+     * @param max_entries Maximum number of files and directories to remove
+     * @return The number of entries removed. Less than max_entries if no
+     * tombstones are left that can be reclaimed.
+     */
+    size_t
+    reclaim_tombstones(size_t max_entries) const;
+
     /**
      * @brief Writes a single chunk file and is usually called by an Argobots
      * tasklet.
@@ -142,6 +204,20 @@ public:
     write_chunk(const std::string& file_path, gkfs::rpc::chnk_id_t chunk_id,
                 const char* buf, size_t size, off64_t offset) const;
 
+    /**
+     * @brief Writes a list of buffers to a contiguous range of a single chunk
+     * file with one pwritev() call.
+     * @param file_path Chunk file path, e.g., /foo/bar
+     * @param chunk_id Number of chunk id
+     * @param iov Buffers to write, in file order
+     * @param offset Offset where to write the first buffer to the chunk file
+     * @return The amount of bytes written
+     * @throws ChunkStorageException with its error code
+     */
+    ssize_t
+    write_chunk(const std::string& file_path, gkfs::rpc::chnk_id_t chunk_id,
+                std::vector<struct iovec> iov, off64_t offset) const;
+
     /**
      * @brief Reads a single chunk file and is usually called by an Argobots
      * tasklet.
@@ -157,6 +233,38 @@ public:
     read_chunk(const std::string& file_path, gkfs::rpc::chnk_id_t chunk_id,
                char* buf, size_t size, off64_t offset) const;
 
+    /**
+     * @brief Reads only the data regions of a single chunk file, skipping
+     * holes found with SEEK_DATA/SEEK_HOLE. Holes in buf are left untouched.
+     * @param file_path Chunk file path, e.g., /foo/bar
+     * @param chunk_id Number of chunk id
+     * @param buf Buffer to read to from chunk
+     * @param size Amount of bytes to read to the chunk file
+     * @param offset Offset where to read from the chunk file
+     * @param extents Filled with the (offset in buf, size) pairs of data read
+     * @return The amount of data bytes read
+     * @throws ChunkStorageException with its error code
+     */
+    ssize_t
+    read_chunk_extents(const std::string& file_path,
+                       gkfs::rpc::chnk_id_t chunk_id, char* buf, size_t size,
+                       off64_t offset,
+                       std::vector<std::pair<size_t, size_t>>& extents) const;
+
+    /**
+     * @brief Maps a whole chunk file read-only into memory. The mapping shares
+     * the page cache with the chunk file and must be released with munmap().
+     * @param file_path Chunk file path, e.g., /foo/bar
+     * @param chunk_id Number of chunk id
+     * @param size Set to the size of the chunk file, i.e., of the mapping
+     * @return Start of the mapping or nullptr if the chunk file is empty
+     * @throws ChunkStorageException with its error code, ENOTSUP if chunks are
+     * kept in container files
+     */
+    void*
+    map_chunk(const std::string& file_path, gkfs::rpc::chnk_id_t chunk_id,
+              size_t& size) const;
+
     /**
      * @brief Delete all chunks starting with chunk a chunk id.
      * @param file_path Chunk file path, e.g., /foo/bar
@@ -178,6 +286,16 @@ public:
     truncate_chunk_file(const std::string& file_path,
                         gkfs::rpc::chnk_id_t chunk_id, off_t length);
 
+    /**
+     * @brief Removes a single chunk file. A missing chunk file is no error.
+     * @param file_path Chunk file path, e.g., /foo/bar
+     * @param chunk_id Number of chunk id
+     * @throws ChunkStorageException
+     */
+    void
+    remove_chunk(const std::string& file_path,
+                 gkfs::rpc::chnk_id_t chunk_id) const;
+
     /**
      * @brief Calls statfs on the chunk directory to get statistic on its used
      * storage space.
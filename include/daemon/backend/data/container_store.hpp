@@ -0,0 +1,288 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+/**
+ * @brief Declarations of the container chunk backend which stores chunks as
+ * extents inside a few large container files.
+ */
+
+#ifndef GEKKOFS_DAEMON_CONTAINER_STORE_HPP
+#define GEKKOFS_DAEMON_CONTAINER_STORE_HPP
+
+#include <common/common_defs.hpp>
+#include <daemon/backend/data/extent_allocator.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/uio.h>
+}
+
+/* Forward declarations */
+namespace spdlog {
+class logger;
+}
+
+namespace gkfs::data {
+
+/**
+ * @brief Location of a chunk within a container file.
+ */
+struct Extent {
+    uint32_t container; //!< container file index
+    uint64_t offset;    //!< byte offset within the container
+    uint64_t capacity;  //!< allocated bytes
+    uint64_t length;    //!< valid bytes of the chunk
+};
+
+/**
+ * @brief Stores all chunks of a daemon as extents in a fixed number of
+ * preallocated container files.
+ * @internal
+ * Chunks are spread over the containers by file path and chunk id. An extent
+ * is allocated with a power of two capacity that fits the highest written
+ * byte, starting at the container block size, and is moved to a larger extent
+ * when a write exceeds it. Bytes beyond the chunk length are never returned
+ * so that reused space does not leak old data. Gaps created by a write or
+ * truncate beyond the length are zeroed.
+ *
+ * The extent index is kept in memory and persisted in an append-only log next
+ * to the containers. The log is replayed and rewritten on startup, and
+ * rewritten by the compaction thread once it holds mostly stale records. Data
+ * and log are not synced, matching the guarantees of the per-file layout.
+ *
+ * Removed extents are punched out of their container to return the space to
+ * the node-local file system right away. The compaction thread additionally
+ * moves extents from the end of a container into free ranges further below
+ * and truncates the container once enough space below its end is free.
+ *
+ * Reads and writes hold `io_mutex_` shared while they access an extent.
+ * Operations that free or move extents hold it exclusively so that no
+ * in-flight I/O can touch a range that is reused by another chunk.
+ *
+ * The store is called from the chunk I/O tasklets, which cannot yield, so
+ * Argobots mutexes would only spin on the I/O execution stream instead of
+ * blocking it. Standard mutexes are used instead and the time they are held
+ * against these tasklets is bounded: a single extent of at most one chunk is
+ * moved per exclusive `io_mutex_` hold, the compaction scans the index in
+ * slices of `container_compaction_scan` entries, and the extent log is
+ * rewritten without holding `index_mutex_` during its I/O. The compaction
+ * runs on its own thread outside of the Argobots pools, so its pauses never
+ * occupy an execution stream.
+ * @endinternal
+ */
+class ContainerStore {
+private:
+    using chunk_key = std::pair<std::string, gkfs::rpc::chnk_id_t>;
+
+    std::shared_ptr<spdlog::logger> log_;
+    std::string dir_;  //!< directory holding containers and the extent log
+    size_t chunksize_; //!< upper bound of an extent's capacity
+
+    std::vector<int> fds_;                    //!< container file descriptors
+    std::vector<ExtentAllocator> allocators_; //!< free space per container
+    std::vector<uint64_t> preallocated_;      //!< fallocated container size
+    std::map<chunk_key, Extent> index_;       //!< extent index
+    int log_fd_{-1};                          //!< extent log
+    uint64_t log_records_{0};                 //!< records in the extent log
+    // records logged while the extent log is rewritten
+    std::string log_tail_;
+    uint64_t log_tail_records_{0};
+    bool log_tail_active_{false};
+
+    mutable std::mutex index_mutex_; //!< protects all members above
+    mutable std::shared_mutex io_mutex_;
+
+    std::thread compactor_;
+    std::mutex compactor_mutex_;
+    std::condition_variable compactor_cv_;
+    bool running_{true};
+
+    [[nodiscard]] std::string
+    container_path(uint32_t container) const;
+
+    [[nodiscard]] uint64_t
+    capacity_for(uint64_t size) const;
+
+    [[nodiscard]] uint32_t
+    container_for(const chunk_key& key) const;
+
+    /**
+     * @brief Allocates an extent and preallocates container space if needed.
+     * Caller holds index_mutex_.
+     * @throws ChunkStorageException
+     */
+    Extent
+    allocate(uint32_t container, uint64_t capacity);
+
+    /**
+     * @brief Punches an extent out of its container and returns it to the
+     * allocator. Caller holds io_mutex_ exclusively and index_mutex_.
+     */
+    void
+    release(const Extent& extent);
+
+    /**
+     * @brief Moves a chunk to a new extent that holds at least `size` bytes.
+     * Caller holds io_mutex_ exclusively and index_mutex_.
+     * @throws ChunkStorageException
+     */
+    void
+    relocate(std::map<chunk_key, Extent>::iterator it, uint64_t size);
+
+    /**
+     * @brief Copies the valid bytes of an extent to another one.
+     * @throws ChunkStorageException
+     */
+    void
+    copy(const Extent& from, const Extent& to) const;
+
+    /**
+     * @brief Zeroes a byte range of an extent. Caller holds index_mutex_.
+     * @throws ChunkStorageException
+     */
+    void
+    zero(const Extent& extent, uint64_t from, uint64_t to) const;
+
+    /**
+     * @brief Appends a record to the extent log. A null extent records a
+     * removal. Caller holds index_mutex_.
+     */
+    void
+    log_extent(const chunk_key& key, const Extent* extent);
+
+    /**
+     * @brief Loads the extent log, rebuilds the allocators, and rewrites the
+     * log without stale records.
+     * @throws ChunkStorageException
+     */
+    void
+    load_index();
+
+    /**
+     * @brief Writes all live records to a new extent log and replaces the old
+     * one. Caller does not hold index_mutex_.
+     * @throws ChunkStorageException
+     */
+    void
+    rewrite_log();
+
+    /**
+     * @brief Removes all extents in [first, last) of the index. Caller holds
+     * io_mutex_ exclusively and index_mutex_.
+     */
+    void
+    erase(std::map<chunk_key, Extent>::iterator first,
+          std::map<chunk_key, Extent>::iterator last);
+
+    void
+    compaction_loop();
+
+public:
+    /**
+     * @brief Opens or creates the containers and loads the extent index.
+     * @param dir Directory holding the containers
+     * @param chunksize File system chunksize
+     * @param log Logger of the data module
+     * @throws ChunkStorageException
+     */
+    ContainerStore(const std::string& dir, size_t chunksize,
+                   std::shared_ptr<spdlog::logger> log);
+
+    ~ContainerStore();
+
+    ContainerStore(const ContainerStore&) = delete;
+
+    ContainerStore&
+    operator=(const ContainerStore&) = delete;
+
+    /**
+     * @brief Writes a list of buffers to a contiguous range of a chunk.
+     * @return The amount of bytes written
+     * @throws ChunkStorageException
+     */
+    ssize_t
+    write(const std::string& file_path, gkfs::rpc::chnk_id_t chunk_id,
+          std::vector<struct iovec> iov, off64_t offset);
+
+    /**
+     * @brief Reads from a chunk. Reading at or beyond the chunk length returns
+     * 0 bytes.
+     * @return The amount of bytes read
+     * @throws ChunkStorageException with ENOENT if the chunk does not exist
+     */
+    ssize_t
+    read(const std::string& file_path, gkfs::rpc::chnk_id_t chunk_id, char* buf,
+         size_t size, off64_t offset) const;
+
+    /**
+     * @brief Removes all chunks of a file starting with a chunk id.
+     */
+    void
+    trim(const std::string& file_path, gkfs::rpc::chnk_id_t chunk_start);
+
+    /**
+     * @brief Sets the length of a chunk.
+     * @throws ChunkStorageException with ENOENT if the chunk does not exist
+     */
+    void
+    truncate(const std::string& file_path, gkfs::rpc::chnk_id_t chunk_id,
+             off_t length);
+
+    /**
+     * @brief Removes a single chunk. A missing chunk is no error.
+     */
+    void
+    remove(const std::string& file_path, gkfs::rpc::chnk_id_t chunk_id);
+
+    /**
+     * @brief Runs one compaction pass over all containers.
+     */
+    void
+    compact();
+
+    /**
+     * @brief Bytes that are free within the used part of the containers.
+     */
+    [[nodiscard]] uint64_t
+    free_bytes() const;
+};
+
+} // namespace gkfs::data
+
+#endif // GEKKOFS_DAEMON_CONTAINER_STORE_HPP
@@ -0,0 +1,119 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+/**
+ * @brief Free space management of a single container file used by the
+ * container chunk backend.
+ */
+
+#ifndef GEKKOFS_DAEMON_EXTENT_ALLOCATOR_HPP
+#define GEKKOFS_DAEMON_EXTENT_ALLOCATOR_HPP
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace gkfs::data {
+
+/**
+ * @brief Allocates byte ranges within a container file.
+ * @internal
+ * The container is used from offset 0 up to `end()`. Released ranges below the
+ * end are kept in a free list which is indexed by offset, to coalesce
+ * neighbors, and by size, for best-fit allocation. A released range that
+ * touches the end shrinks the used part of the container instead. New ranges
+ * are taken from the free list first and from the end otherwise.
+ *
+ * The class is not thread-safe.
+ * @endinternal
+ */
+class ExtentAllocator {
+private:
+    uint64_t end_{0}; //!< first byte that was never allocated
+    uint64_t free_bytes_{0};
+    std::map<uint64_t, uint64_t> free_by_offset_{}; //!< offset -> size
+    std::multimap<uint64_t, uint64_t> free_by_size_{}; //!< size -> offset
+
+    void
+    insert_free(uint64_t offset, uint64_t size);
+
+    void
+    erase_free(std::map<uint64_t, uint64_t>::iterator it);
+
+public:
+    /**
+     * @brief Allocates a range of the given size.
+     * @param size Bytes to allocate
+     * @return Offset of the range within the container
+     */
+    uint64_t
+    allocate(uint64_t size);
+
+    /**
+     * @brief Allocates a range from the free list only.
+     * @param size Bytes to allocate
+     * @param below Only ranges starting before this offset are considered
+     * @return Offset of the range or nothing if no free range fits
+     */
+    std::optional<uint64_t>
+    allocate_free(uint64_t size, uint64_t below);
+
+    /**
+     * @brief Returns a range to the allocator.
+     * @param offset Offset of the range
+     * @param size Size of the range
+     */
+    void
+    release(uint64_t offset, uint64_t size);
+
+    /**
+     * @brief Rebuilds the allocator state from the ranges in use, e.g., after
+     * the extent index was loaded from disk.
+     * @param used Ranges in use as offset and size pairs, in any order
+     */
+    void
+    rebuild(std::vector<std::pair<uint64_t, uint64_t>> used);
+
+    /**
+     * @brief Size of the used part of the container.
+     */
+    [[nodiscard]] uint64_t
+    end() const;
+
+    /**
+     * @brief Bytes in the free list, i.e., reclaimable by compaction.
+     */
+    [[nodiscard]] uint64_t
+    free_bytes() const;
+};
+
+} // namespace gkfs::data
+
+#endif // GEKKOFS_DAEMON_EXTENT_ALLOCATOR_HPP
@@ -37,6 +37,7 @@
 #include <daemon/backend/exceptions.hpp>
 #include <tuple>
 #include <daemon/backend/metadata/metadata_backend.hpp>
+#include <daemon/backend/metadata/memory_backend.hpp>
 #ifdef GKFS_ENABLE_ROCKSDB
 #include <daemon/backend/metadata/rocksdb_backend.hpp>
 #endif
@@ -49,6 +50,7 @@ namespace gkfs::metadata {
 
 constexpr auto rocksdb_backend = "rocksdb";
 constexpr auto parallax_backend = "parallaxdb";
+constexpr auto memory_backend = "memory";
 
 class MetadataDB {
 private:
@@ -166,6 +168,14 @@ public:
      */
     void
     iterate_all() const;
+
+    /**
+     * @brief Returns backend specific counters for monitoring, e.g., pending
+     * compactions and memtable size of RocksDB.
+     * @return vector of pair <name, value>
+     */
+    [[nodiscard]] std::vector<std::pair<std::string, uint64_t>>
+    properties() const;
 };
 
 } // namespace gkfs::metadata
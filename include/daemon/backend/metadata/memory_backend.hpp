@@ -0,0 +1,247 @@
+/*
+  Copyright 2018-2021, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2021, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#ifndef GEKKOFS_METADATA_MEMORYBACKEND_HPP
+#define GEKKOFS_METADATA_MEMORYBACKEND_HPP
+
+#include <daemon/backend/metadata/metadata_backend.hpp>
+#include <daemon/backend/exceptions.hpp>
+#include <config.hpp>
+
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace gkfs::metadata {
+
+/**
+ * In-memory metadata backend for file systems that are discarded at the end
+ * of a job. Entries are kept in a hash map that is split into shards with
+ * their own locks. Directory scans use a second, sharded index of the
+ * children of each directory which is ordered by name.
+ *
+ * Size updates are applied in place with the same semantics as
+ * MetadataMergeOperator, including inline data of small files.
+ *
+ * If gkfs::config::memory::snapshot_interval is set, all entries are written
+ * to a snapshot file in the given directory periodically and on shutdown, and
+ * loaded again on startup.
+ */
+class MemoryBackend : public MetadataBackend<MemoryBackend> {
+private:
+    struct entry_shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::string> entries;
+    };
+
+    struct dirent_shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::set<std::string>> children;
+    };
+
+    std::array<entry_shard, gkfs::config::memory::shards> entry_shards_;
+    std::array<dirent_shard, gkfs::config::memory::shards> dirent_shards_;
+
+    std::string snapshot_path_; //!< empty if snapshots are disabled
+    std::thread snapshotter_;
+    std::mutex snapshotter_mutex_;
+    std::condition_variable snapshotter_cv_;
+    bool running_{true};
+
+    entry_shard&
+    shard_of(const std::string& key);
+
+    const entry_shard&
+    shard_of(const std::string& key) const;
+
+    /**
+     * Adds a key to the children of its parent directory. Called while the
+     * key's entry shard is locked exclusively.
+     */
+    void
+    add_dirent(const std::string& key);
+
+    /**
+     * Removes a key from the children of its parent directory. Called while
+     * the key's entry shard is locked exclusively.
+     */
+    void
+    remove_dirent(const std::string& key);
+
+    /**
+     * Returns the metadata entries of the first-level children of a directory
+     * in name order.
+     * @param dir directory with trailing slash
+     * @return vector of pair <name, serialized metadata>
+     */
+    std::vector<std::pair<std::string, std::string>>
+    children_of(const std::string& dir) const;
+
+    void
+    load_snapshot();
+
+    void
+    write_snapshot() const;
+
+    void
+    snapshot_loop();
+
+public:
+    /**
+     * Creates an empty backend or loads the snapshot in the given directory
+     * if snapshots are enabled.
+     * @param path directory of the snapshot file
+     * @throws DBException if an existing snapshot cannot be read
+     */
+    explicit MemoryBackend(const std::string& path);
+
+    virtual ~MemoryBackend();
+
+    /**
+     * Gets the value for a key
+     * @param key
+     * @return value
+     * @throws NotFoundException if entry doesn't exist
+     */
+    std::string
+    get_impl(const std::string& key) const;
+
+    /**
+     * Puts an entry. Like a create merge operand, an existing entry is kept.
+     * @param key
+     * @param val
+     */
+    void
+    put_impl(const std::string& key, const std::string& val);
+
+    /**
+     * Puts an entry if it doesn't exist. The check and insert are atomic.
+     * @param key
+     * @param val
+     * @throws ExistsException if entry already exists
+     */
+    void
+    put_no_exist_impl(const std::string& key, const std::string& val);
+
+    /**
+     * Removes an entry. A missing entry is no error.
+     * @param key
+     */
+    void
+    remove_impl(const std::string& key);
+
+    /**
+     * checks for existence of an entry
+     * @param key
+     * @return true if exists
+     */
+    bool
+    exists_impl(const std::string& key);
+
+    /**
+     * Replaces an entry and allows to change its key. Both keys are locked
+     * for the duration of the update.
+     * @param old_key
+     * @param new_key
+     * @param val
+     */
+    void
+    update_impl(const std::string& old_key, const std::string& new_key,
+                const std::string& val);
+
+    /**
+     * Updates the size on the metadata, e.g., called before a write() call
+     * @param key
+     * @param io_size
+     * @param offset
+     * @param append
+     * @param bsize size of inline data in buf
+     * @param buf inline data of small files
+     * @return offset where the write operation should start. This is only used
+     * when append is set
+     * @throws NotFoundException if entry doesn't exist
+     */
+    off_t
+    increase_size_impl(const std::string& key, size_t io_size, off_t offset,
+                       bool append, size_t bsize, const std::string& buf = "");
+
+    /**
+     * Decreases the size on the metadata, e.g., called before a truncate()
+     * call
+     * @param key
+     * @param size
+     * @throws NotFoundException if entry doesn't exist
+     */
+    void
+    decrease_size_impl(const std::string& key, size_t size);
+
+    /**
+     * Return all the first-level entries of the directory @dir
+     *
+     * @return vector of pair <std::string name, bool is_dir>,
+     *         where name is the name of the entries and is_dir
+     *         is true in the case the entry is a directory.
+     */
+    std::vector<std::pair<std::string, bool>>
+    get_dirents_impl(const std::string& dir) const;
+
+    /**
+     * Return all the first-level entries of the directory @dir
+     *
+     * @return vector of pair <std::string name, bool is_dir - size - ctime>,
+     *         where name is the name of the entries and is_dir
+     *         is true in the case the entry is a directory.
+     */
+    std::vector<std::tuple<std::string, bool, size_t, time_t>>
+    get_dirents_extended_impl(const std::string& dir) const;
+
+    /**
+     * Prints all keys. This is for debug only.
+     */
+    void
+    iterate_all_impl() const;
+
+    /**
+     * Returns the number of entries
+     */
+    std::vector<std::pair<std::string, uint64_t>>
+    properties_impl() const;
+};
+
+} // namespace gkfs::metadata
+
+#endif // GEKKOFS_METADATA_MEMORYBACKEND_HPP
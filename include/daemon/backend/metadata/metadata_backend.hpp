@@ -33,6 +33,8 @@
 #include <spdlog/spdlog.h>
 #include <daemon/backend/exceptions.hpp>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 namespace gkfs::metadata {
 
@@ -75,6 +77,9 @@ public:
 
     virtual void
     iterate_all() const = 0;
+
+    virtual std::vector<std::pair<std::string, uint64_t>>
+    properties() const = 0;
 };
 
 template <typename T>
@@ -141,6 +146,11 @@ public:
     iterate_all() const {
         static_cast<T const&>(*this).iterate_all_impl();
     }
+
+    std::vector<std::pair<std::string, uint64_t>>
+    properties() const {
+        return static_cast<T const&>(*this).properties_impl();
+    }
 };
 
 } // namespace gkfs::metadata
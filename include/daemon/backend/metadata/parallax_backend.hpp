@@ -192,6 +192,12 @@ public:
      */
     void
     iterate_all_impl() const;
+
+    /**
+     * Parallax does not export counters. Returns no properties
+     */
+    std::vector<std::pair<std::string, uint64_t>>
+    properties_impl() const;
 };
 
 } // namespace gkfs::metadata
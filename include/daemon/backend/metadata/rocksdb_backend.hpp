@@ -176,6 +176,12 @@ public:
      */
     void
     iterate_all_impl() const;
+
+    /**
+     * Returns compaction and memtable counters of RocksDB
+     */
+    std::vector<std::pair<std::string, uint64_t>>
+    properties_impl() const;
 };
 
 } // namespace gkfs::metadata
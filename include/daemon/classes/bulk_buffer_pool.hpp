@@ -0,0 +1,182 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#ifndef GEKKOFS_DAEMON_BULK_BUFFER_POOL_HPP
+#define GEKKOFS_DAEMON_BULK_BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+extern "C" {
+#include <abt.h>
+#include <margo.h>
+}
+
+namespace gkfs::rpc {
+
+/**
+ * @brief A buffer that is registered with Mercury for bulk transfers.
+ */
+struct BulkBuffer {
+    hg_bulk_t handle; //!< bulk handle covering the whole buffer
+    void* data;       //!< start of the buffer
+    size_t size;      //!< size of the buffer, i.e., of its size class
+};
+
+/**
+ * @brief Daemon-wide pool of pre-registered bulk buffers for the data path.
+ * @internal
+ * Buffers come in power of two size classes between a minimum and a maximum
+ * size. A request is served from the smallest class that fits. Buffers are
+ * created lazily and kept after use, so that memory registration is paid once
+ * per buffer instead of once per RPC. The memory of all buffers is capped.
+ * When the cap is reached, idle buffers of other classes are freed to make
+ * room. If all memory is in use, the calling ULT waits until a buffer is
+ * returned.
+ *
+ * Requests larger than the largest class are not served by the pool and the
+ * caller allocates a buffer for this request only.
+ * @endinternal
+ */
+class BulkBufferPool {
+private:
+    margo_instance_id mid_;
+    size_t min_size_;
+    size_t max_size_;
+    size_t capacity_;
+    size_t allocated_{0}; //!< bytes of all buffers, idle or in use
+    size_t in_use_{0};    //!< bytes of buffers held by handlers
+
+    std::vector<std::vector<BulkBuffer*>> idle_; //!< idle buffers per class
+
+    ABT_mutex mutex_;
+    ABT_cond cond_;
+
+    [[nodiscard]] size_t
+    class_of(size_t size) const;
+
+    [[nodiscard]] size_t
+    class_size(size_t size_class) const;
+
+    /**
+     * @brief Frees one idle buffer of another class. Caller holds mutex_.
+     * @return False if there is no idle buffer to free
+     */
+    bool
+    evict(size_t keep_class);
+
+    void
+    destroy(BulkBuffer* buffer);
+
+public:
+    /**
+     * @brief Creates an empty pool.
+     * @param mid Margo instance the buffers are registered with
+     * @param min_size Size of the smallest class, rounded up to a power of two
+     * @param max_size Upper bound of the largest class
+     * @param capacity Maximum memory of all buffers in bytes
+     * @throws std::runtime_error if Argobots primitives cannot be created
+     */
+    BulkBufferPool(margo_instance_id mid, size_t min_size, size_t max_size,
+                   size_t capacity);
+
+    ~BulkBufferPool();
+
+    BulkBufferPool(const BulkBufferPool&) = delete;
+
+    BulkBufferPool&
+    operator=(const BulkBufferPool&) = delete;
+
+    /**
+     * @brief Takes a buffer of at least `size` bytes, waiting if needed.
+     * @param size Required size in bytes
+     * @return Buffer or nullptr if the size exceeds the largest class or the
+     * buffer could not be registered
+     */
+    BulkBuffer*
+    acquire(size_t size);
+
+    /**
+     * @brief Returns a buffer to the pool and wakes up waiting requests.
+     * @param buffer Buffer from acquire()
+     */
+    void
+    release(BulkBuffer* buffer);
+
+    /**
+     * @brief Memory of all buffers in the pool.
+     */
+    [[nodiscard]] size_t
+    allocated() const;
+
+    /**
+     * @brief Memory of the buffers currently held by RPC handlers.
+     */
+    [[nodiscard]] size_t
+    in_use() const;
+};
+
+/**
+ * @brief Holds a pool buffer for the duration of an RPC handler.
+ * @internal
+ * The lease takes an additional reference on the buffer's bulk handle. The
+ * handler thus owns and frees its handle as if it had created it with
+ * margo_bulk_create(), while the pool keeps the registration alive.
+ * @endinternal
+ */
+class BulkLease {
+private:
+    std::shared_ptr<BulkBufferPool> pool_;
+    BulkBuffer* buffer_{nullptr};
+
+public:
+    BulkLease(std::shared_ptr<BulkBufferPool> pool, size_t size);
+
+    ~BulkLease();
+
+    BulkLease(const BulkLease&) = delete;
+
+    BulkLease&
+    operator=(const BulkLease&) = delete;
+
+    explicit operator bool() const noexcept {
+        return buffer_ != nullptr;
+    }
+
+    [[nodiscard]] hg_bulk_t
+    handle() const;
+
+    [[nodiscard]] void*
+    data() const;
+};
+
+} // namespace gkfs::rpc
+
+#endif // GEKKOFS_DAEMON_BULK_BUFFER_POOL_HPP
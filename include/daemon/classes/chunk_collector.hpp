@@ -0,0 +1,124 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#ifndef GEKKOFS_DAEMON_CHUNK_COLLECTOR_HPP
+#define GEKKOFS_DAEMON_CHUNK_COLLECTOR_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+extern "C" {
+#include <abt.h>
+}
+
+namespace gkfs::data {
+
+class ChunkStorage;
+
+/**
+ * @brief Reclaims the chunk space of removed files in the background.
+ * @internal
+ * Removing a file only moves its chunk directory to a tombstone (see
+ * ChunkStorage::tombstone_chunk_space()), so remove requests no longer wait
+ * for a recursive delete of all chunk files. A single ULT on the I/O pool
+ * removes the tombstones' chunk files in batches and pauses between batches
+ * so that chunk I/O of clients is not starved on the I/O execution streams.
+ *
+ * Tombstones left by a previous daemon run are reclaimed on startup.
+ * @endinternal
+ */
+class ChunkCollector {
+private:
+    std::shared_ptr<ChunkStorage> storage_;
+    size_t batch_;
+    std::chrono::milliseconds interval_;
+
+    ABT_thread ult_{ABT_THREAD_NULL};
+    ABT_mutex mutex_;
+    ABT_cond cond_;
+    bool running_{true};
+    bool pending_{true}; //!< tombstones may exist, e.g., from a previous run
+    uint64_t reclaimed_{0};
+
+    static void
+    collect_ult(void* _arg);
+
+    /**
+     * @brief Removes tombstones in batches until none are left or the
+     * collector is stopped.
+     */
+    void
+    drain();
+
+public:
+    /**
+     * @brief Starts the collector ULT.
+     * @param storage Chunk storage holding the tombstones
+     * @param pool Argobots pool to run the collector ULT in
+     * @param batch Maximum number of files removed before pausing
+     * @param interval Pause between two batches
+     * @throws std::runtime_error if the ULT cannot be created
+     */
+    ChunkCollector(std::shared_ptr<ChunkStorage> storage, ABT_pool pool,
+                   size_t batch, std::chrono::milliseconds interval);
+
+    /**
+     * @brief Stops the collector ULT and waits for it to finish its current
+     * batch. Remaining tombstones are reclaimed by the next daemon run.
+     */
+    ~ChunkCollector();
+
+    /**
+     * @brief Wakes the collector after a tombstone was created.
+     */
+    void
+    notify();
+
+    /**
+     * @brief Number of chunk files and directories removed so far.
+     */
+    uint64_t
+    reclaimed();
+};
+
+/**
+ * @brief Removes all chunks of a file. If the chunk collector runs, the chunks
+ * are moved to a tombstone and reclaimed in the background, otherwise they are
+ * removed right away.
+ * @param path File path
+ * @throws ChunkStorageException
+ */
+void
+remove_chunk_space(const std::string& path);
+
+} // namespace gkfs::data
+
+#endif // GEKKOFS_DAEMON_CHUNK_COLLECTOR_HPP
@@ -0,0 +1,231 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#ifndef GEKKOFS_DAEMON_CHUNK_MAP_CACHE_HPP
+#define GEKKOFS_DAEMON_CHUNK_MAP_CACHE_HPP
+
+#include <common/common_defs.hpp>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+extern "C" {
+#include <abt.h>
+#include <margo.h>
+}
+
+namespace gkfs::data {
+
+/**
+ * @brief A chunk file mapped read-only and registered for bulk transfers.
+ * The mapping and its registration are released with the last reference.
+ */
+struct MappedChunk {
+    void* addr{nullptr};            //!< start of the mapping
+    size_t size{0};                 //!< size of the chunk file when mapped
+    hg_bulk_t handle{HG_BULK_NULL}; //!< read-only bulk handle of the mapping
+
+    MappedChunk() = default;
+
+    MappedChunk(const MappedChunk&) = delete;
+
+    MappedChunk&
+    operator=(const MappedChunk&) = delete;
+
+    ~MappedChunk();
+};
+
+/**
+ * @brief Bounded cache of mapped chunk files used to push read data to
+ * clients directly from the page cache.
+ * @internal
+ * Reads normally pread() chunk data into a bulk buffer and push it from
+ * there. With this cache, a chunk file is mapped once and the mapping itself
+ * is the bulk source, which saves the copy into the bulk buffer and the
+ * per-request buffer.
+ *
+ * Entries are keyed by (file, chunk) and evicted in LRU order once the mapped
+ * bytes exceed the capacity. Writes, truncates, and removes invalidate the
+ * affected chunks so that the next read maps the current file. Readers hold
+ * a reference to the mapping for the duration of the transfer, so eviction
+ * and invalidation never unmap memory that is being pushed. A mapping that
+ * was created while an invalidation happened is used once and not cached.
+ *
+ * Touching a mapping beyond the end of a shrunk chunk file raises SIGBUS.
+ * Each mapping therefore counts as a reader of its chunk until its last
+ * reference is gone. A truncate that cuts a chunk file stops new mappings of
+ * the chunk and waits until its readers have finished pushing before it
+ * shrinks the file (see ChunkShrinkGuard). Reads of the chunk in the meantime
+ * fall back to pread(). Removing chunk files is safe, mappings keep the
+ * unlinked file alive.
+ * @endinternal
+ */
+class ChunkMapCache {
+private:
+    using key_type = std::pair<std::string, gkfs::rpc::chnk_id_t>;
+
+    struct entry {
+        std::shared_ptr<MappedChunk> mapping;
+        std::list<key_type>::iterator lru_pos;
+    };
+
+    margo_instance_id mid_;
+    size_t capacity_;
+    size_t mapped_{0};
+    uint64_t epoch_{0}; //!< incremented by every invalidation
+    uint64_t hits_{0};
+    uint64_t misses_{0};
+
+    std::map<key_type, entry> entries_;
+    std::list<key_type> lru_; // most recently used first
+    mutable std::mutex mutex_;
+
+    // Readers and shrinking chunks are guarded by their own mutex because the
+    // last reference to a mapping can be dropped while mutex_ is held.
+    std::map<key_type, size_t> readers_;   //!< live mappings per chunk
+    std::map<key_type, size_t> shrinking_; //!< chunks that must not be mapped
+    ABT_mutex readers_mutex_;
+    ABT_cond readers_cond_;
+
+    /**
+     * @brief Removes an entry. Called under mutex_.
+     */
+    void
+    erase(std::map<key_type, entry>::iterator it);
+
+    /**
+     * @brief Called when the last reference to a mapping of a chunk is gone.
+     */
+    void
+    release(const key_type& key);
+
+public:
+    /**
+     * @brief Creates the cache.
+     * @param mid Margo instance the mappings are registered with
+     * @param capacity Maximum number of mapped bytes
+     */
+    ChunkMapCache(margo_instance_id mid, size_t capacity);
+
+    ~ChunkMapCache();
+
+    /**
+     * @brief Returns the mapping of a chunk file and maps it on a miss.
+     * @param path File path
+     * @param chunk_id Chunk id
+     * @return mapping or nullptr if the chunk file is empty, is being shrunk,
+     * or could not be registered
+     * @throws ChunkStorageException if the chunk file cannot be mapped, e.g.,
+     * ENOENT if it does not exist
+     */
+    std::shared_ptr<MappedChunk>
+    get(const std::string& path, gkfs::rpc::chnk_id_t chunk_id);
+
+    /**
+     * @brief Drops the mapping of a chunk after it was modified.
+     */
+    void
+    invalidate(const std::string& path, gkfs::rpc::chnk_id_t chunk_id);
+
+    /**
+     * @brief Drops the mappings of all chunks of a file starting with a chunk
+     * id, e.g., on truncate or remove.
+     */
+    void
+    invalidate_file(const std::string& path,
+                    gkfs::rpc::chnk_id_t chunk_start = 0);
+
+    /**
+     * @brief Stops new mappings of a chunk, drops its cached mapping, and
+     * waits until all readers have released their mappings of it. Must be
+     * called from a ULT.
+     */
+    void
+    begin_shrink(const std::string& path, gkfs::rpc::chnk_id_t chunk_id);
+
+    /**
+     * @brief Allows mapping a chunk again after begin_shrink().
+     */
+    void
+    end_shrink(const std::string& path, gkfs::rpc::chnk_id_t chunk_id);
+
+    size_t
+    mapped_bytes() const;
+
+    uint64_t
+    hits() const;
+
+    uint64_t
+    misses() const;
+};
+
+/**
+ * @brief Keeps a chunk from being mapped while its chunk file is shrunk. The
+ * constructor waits until no read pushes from a mapping of the chunk anymore.
+ * Does nothing if mapped reads are disabled. Must be created in a ULT.
+ */
+class ChunkShrinkGuard {
+private:
+    std::shared_ptr<ChunkMapCache> map_cache_;
+    std::string path_;
+    gkfs::rpc::chnk_id_t chunk_id_;
+
+public:
+    ChunkShrinkGuard(const std::string& path, gkfs::rpc::chnk_id_t chunk_id);
+
+    ~ChunkShrinkGuard();
+
+    ChunkShrinkGuard(const ChunkShrinkGuard&) = delete;
+
+    ChunkShrinkGuard&
+    operator=(const ChunkShrinkGuard&) = delete;
+};
+
+/**
+ * @brief Drops the mapping of a modified chunk if mapped reads are enabled.
+ */
+void
+invalidate_mapped_chunk(const std::string& path,
+                        gkfs::rpc::chnk_id_t chunk_id);
+
+/**
+ * @brief Drops the mappings of a file's chunks starting with a chunk id if
+ * mapped reads are enabled.
+ */
+void
+invalidate_mapped_file(const std::string& path,
+                       gkfs::rpc::chnk_id_t chunk_start = 0);
+
+} // namespace gkfs::data
+
+#endif // GEKKOFS_DAEMON_CHUNK_MAP_CACHE_HPP
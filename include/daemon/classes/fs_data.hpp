@@ -35,6 +35,7 @@
 #include <map>
 #include <functional> //std::hash
 #include <string_view>
+#include <vector>
 
 /* Forward declarations */
 namespace gkfs {
@@ -44,12 +45,19 @@ class MetadataDB;
 
 namespace data {
 class ChunkStorage;
+class ReplicaManager;
+class IoScheduler;
+class ChunkMapCache;
+class ChunkCollector;
 }
 
 /* Forward declarations */
 namespace utils {
 class Stats;
 }
+namespace trace {
+class writer;
+}
 
 namespace daemon {
 
@@ -73,6 +81,14 @@ private:
     std::string hosts_file_{};
     bool use_auto_sm_;
 
+    // Argobots execution streams
+    unsigned int io_xstreams_ = gkfs::config::rpc::daemon_io_xstreams;
+    unsigned int handler_xstreams_ =
+            gkfs::config::rpc::daemon_handler_xstreams;
+    bool io_private_pools_ = gkfs::config::rpc::daemon_io_private_pools;
+    std::vector<unsigned int> io_cpus_{};
+    unsigned long bulk_pool_size_ = gkfs::config::rpc::bulk_pool_size;
+
     // Database
     std::shared_ptr<gkfs::metadata::MetadataDB> mdb_;
     std::string dbbackend_;
@@ -82,6 +98,10 @@ private:
 
     // Storage backend
     std::shared_ptr<gkfs::data::ChunkStorage> storage_;
+    std::string chunk_backend_;
+    std::shared_ptr<gkfs::data::ChunkMapCache> chunk_map_cache_;
+    unsigned long chunk_map_cache_size_ = gkfs::config::data::map_cache_size;
+    std::shared_ptr<gkfs::data::ChunkCollector> chunk_collector_;
 
     // configurable metadata
     bool atime_state_;
@@ -100,6 +120,20 @@ private:
     // Prometheus
     std::string prometheus_gateway_ = gkfs::config::stats::prometheus_gateway;
 
+    // RPC tracing
+    std::shared_ptr<gkfs::trace::writer> tracer_;
+
+    // Hot chunk replication
+    std::shared_ptr<gkfs::data::ReplicaManager> replica_manager_;
+    unsigned int hot_chunk_replicas_ = 0;
+    unsigned int hot_chunk_threshold_ = gkfs::config::replication::threshold;
+
+    // Built-in I/O scheduler
+    std::shared_ptr<gkfs::data::IoScheduler> io_scheduler_;
+    unsigned int io_scheduler_window_ = gkfs::config::io_scheduler::window;
+    unsigned int io_scheduler_deadline_ =
+            gkfs::config::io_scheduler::deadline;
+
 public:
     static FsData*
     getInstance() {
@@ -165,6 +199,32 @@ public:
     void
     storage(const std::shared_ptr<gkfs::data::ChunkStorage>& storage);
 
+    std::string_view
+    chunk_backend() const;
+
+    void
+    chunk_backend(const std::string& chunk_backend);
+
+    const std::shared_ptr<gkfs::data::ChunkMapCache>&
+    chunk_map_cache() const;
+
+    void
+    chunk_map_cache(
+            const std::shared_ptr<gkfs::data::ChunkMapCache>& chunk_map_cache);
+
+    unsigned long
+    chunk_map_cache_size() const;
+
+    void
+    chunk_map_cache_size(unsigned long chunk_map_cache_size);
+
+    const std::shared_ptr<gkfs::data::ChunkCollector>&
+    chunk_collector() const;
+
+    void
+    chunk_collector(
+            const std::shared_ptr<gkfs::data::ChunkCollector>& chunk_collector);
+
     const std::string&
     rpc_protocol() const;
 
@@ -186,6 +246,36 @@ public:
     void
     use_auto_sm(bool use_auto_sm);
 
+    unsigned int
+    io_xstreams() const;
+
+    void
+    io_xstreams(unsigned int io_xstreams);
+
+    unsigned int
+    handler_xstreams() const;
+
+    void
+    handler_xstreams(unsigned int handler_xstreams);
+
+    bool
+    io_private_pools() const;
+
+    void
+    io_private_pools(bool io_private_pools);
+
+    const std::vector<unsigned int>&
+    io_cpus() const;
+
+    void
+    io_cpus(const std::vector<unsigned int>& io_cpus);
+
+    unsigned long
+    bulk_pool_size() const;
+
+    void
+    bulk_pool_size(unsigned long bulk_pool_size);
+
     void
     hosts_file(const std::string& lookup_file);
 
@@ -263,6 +353,49 @@ public:
 
     void
     prometheus_gateway(const std::string& prometheus_gateway_);
+
+    const std::shared_ptr<gkfs::trace::writer>&
+    tracer() const;
+
+    void
+    tracer(const std::shared_ptr<gkfs::trace::writer>& tracer);
+
+    const std::shared_ptr<gkfs::data::ReplicaManager>&
+    replica_manager() const;
+
+    void
+    replica_manager(
+            const std::shared_ptr<gkfs::data::ReplicaManager>& replica_manager);
+
+    unsigned int
+    hot_chunk_replicas() const;
+
+    void
+    hot_chunk_replicas(unsigned int hot_chunk_replicas);
+
+    unsigned int
+    hot_chunk_threshold() const;
+
+    void
+    hot_chunk_threshold(unsigned int hot_chunk_threshold);
+
+    const std::shared_ptr<gkfs::data::IoScheduler>&
+    io_scheduler() const;
+
+    void
+    io_scheduler(const std::shared_ptr<gkfs::data::IoScheduler>& io_scheduler);
+
+    unsigned int
+    io_scheduler_window() const;
+
+    void
+    io_scheduler_window(unsigned int io_scheduler_window);
+
+    unsigned int
+    io_scheduler_deadline() const;
+
+    void
+    io_scheduler_deadline(unsigned int io_scheduler_deadline);
 };
 
 
@@ -0,0 +1,252 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#ifndef GEKKOFS_DAEMON_REPLICA_MANAGER_HPP
+#define GEKKOFS_DAEMON_REPLICA_MANAGER_HPP
+
+#include <config.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gkfs::data {
+
+/**
+ * @brief Replicas of one chunk, i.e., the daemons holding a copy and the
+ * version the copies were created with.
+ */
+struct ReplicaSet {
+    uint64_t chunk_id;
+    uint64_t version;
+    std::vector<uint64_t> hosts;
+};
+
+/**
+ * @brief Keeps the state of hot chunk read replication on a daemon.
+ * @internal
+ * A daemon plays two roles. As the owner of a chunk (the daemon the chunk is
+ * hashed to), it watches the read rate of its chunks and decides when a chunk
+ * is pushed to its replica daemons. Each push is tagged with a version taken
+ * from a daemon-wide counter. The counter is seeded with the current time so
+ * that versions keep increasing across daemon restarts. A write, truncate, or
+ * remove of a replicated chunk invalidates it and returns the replica set so
+ * the caller can notify the replica daemons. The chunk is not replicated again
+ * until the replica daemons were notified.
+ *
+ * As a replica daemon, it remembers which foreign chunks it holds a valid copy
+ * of. A copy is only accepted if its version is not older than the last
+ * invalidation seen for that chunk, so a push that races with an invalidation
+ * can never resurrect stale data. Invalidated copies are remembered for at
+ * least one window for this purpose and pruned afterwards.
+ *
+ * Both roles track at most `max_tracked` chunks. Once the limit is reached,
+ * owned chunks that are not replicated and copies invalidated more than a
+ * window ago are pruned, at most once per window. New chunks are not tracked
+ * until there is room again.
+ *
+ * The class does not communicate. It is safe to be called concurrently from
+ * RPC handlers.
+ * @endinternal
+ */
+class ReplicaManager {
+private:
+    enum class State { none, pending, replicated, invalidating };
+
+    struct OwnedChunk {
+        std::chrono::steady_clock::time_point window_start;
+        unsigned int window_reads; //!< exact reads in the current window
+        State state;
+        uint64_t version;
+        std::vector<uint64_t> hosts;
+    };
+
+    struct ReplicaChunk {
+        uint64_t version;
+        bool valid;
+        std::chrono::steady_clock::time_point changed;
+    };
+
+    unsigned int replicas_;
+    unsigned int threshold_;
+    std::chrono::steady_clock::duration window_;
+    size_t max_tracked_;
+
+    std::map<std::string, std::map<uint64_t, OwnedChunk>> owned_;
+    std::map<std::string, std::map<uint64_t, ReplicaChunk>> copies_;
+    size_t owned_count_{0};
+    size_t copies_count_{0};
+    // the maps are scanned for prunable chunks at most once per window
+    std::chrono::steady_clock::time_point owned_pruned_{};
+    std::chrono::steady_clock::time_point copies_pruned_{};
+    uint64_t next_version_;
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief Drops all tracked chunks that are not replicated once the tracking
+     * limit is reached. Called under mutex_.
+     */
+    void
+    evict_cold_chunks(std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Drops copies that were invalidated more than a window ago once
+     * the tracking limit is reached. Called under mutex_.
+     */
+    void
+    evict_stale_copies(std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Returns the copy entry of a chunk, creating it if there is room.
+     * Called under mutex_.
+     * @return nullptr if the tracking limit is reached
+     */
+    ReplicaChunk*
+    find_or_add_copy(const std::string& path, uint64_t chunk_id,
+                     std::chrono::steady_clock::time_point now);
+
+public:
+    /**
+     * @brief Creates the replication state.
+     * @param replicas Number of replicas K per hot chunk
+     * @param threshold Number of reads within a window that make a chunk hot
+     * @param window Length of the window in which reads are counted
+     * @param max_tracked Upper bound of owned chunks and of copies tracked
+     */
+    ReplicaManager(unsigned int replicas, unsigned int threshold,
+                   std::chrono::steady_clock::duration window,
+                   size_t max_tracked =
+                           gkfs::config::replication::max_tracked_chunks);
+
+    unsigned int
+    replicas() const;
+
+    /**
+     * @brief Records a read of an owned chunk. Reads are counted here exactly,
+     * independent of the estimates of the chunk statistics.
+     * @param path File path
+     * @param chunk_id Chunk id
+     * @param hosts Daemons that would receive the replicas
+     * @return Version of the replication that has to be started now or 0 if
+     * the chunk is not (newly) hot
+     */
+    uint64_t
+    record_read(const std::string& path, uint64_t chunk_id,
+                const std::vector<uint64_t>& hosts);
+
+    /**
+     * @brief Marks a pending replication as done if the chunk was not
+     * invalidated in the meantime.
+     * @return true if the replicas are usable
+     */
+    bool
+    replication_done(const std::string& path, uint64_t chunk_id,
+                     uint64_t version);
+
+    /**
+     * @brief Resets a pending replication that failed so it may be retried.
+     */
+    void
+    replication_failed(const std::string& path, uint64_t chunk_id,
+                       uint64_t version);
+
+    /**
+     * @brief Returns the number of replicas an owned chunk has.
+     * @return 0 if the chunk is not replicated
+     */
+    unsigned int
+    replicated(const std::string& path, uint64_t chunk_id) const;
+
+    /**
+     * @brief Invalidates an owned chunk that was modified. The chunk stays
+     * invalidating until invalidation_done() is called for the returned set.
+     * @return Replica set to notify, hosts are empty if nothing to notify
+     */
+    ReplicaSet
+    invalidate(const std::string& path, uint64_t chunk_id);
+
+    /**
+     * @brief Invalidates all owned chunks of a file starting at a chunk id.
+     * @return Replica sets to notify
+     */
+    std::vector<ReplicaSet>
+    invalidate_from(const std::string& path, uint64_t chunk_start);
+
+    /**
+     * @brief Ends the invalidation of an owned chunk once its replica daemons
+     * were notified. The chunk may then become hot again.
+     */
+    void
+    invalidation_done(const std::string& path, uint64_t chunk_id,
+                      uint64_t version);
+
+    /**
+     * @brief Forgets all state of a removed file, both owned chunks and copies.
+     * @return Replica sets of owned chunks to notify
+     */
+    std::vector<ReplicaSet>
+    forget(const std::string& path);
+
+    /**
+     * @brief Checks if a pushed copy may be stored.
+     * @return false if the copy is older than a seen invalidation or if the
+     * tracking limit is reached
+     */
+    bool
+    accept_copy(const std::string& path, uint64_t chunk_id, uint64_t version);
+
+    /**
+     * @brief Marks a stored copy as valid unless it was invalidated while being
+     * stored.
+     * @return true if the copy is valid
+     */
+    bool
+    commit_copy(const std::string& path, uint64_t chunk_id, uint64_t version);
+
+    /**
+     * @brief Invalidates a copy held by this daemon unless it is newer than
+     * the invalidation.
+     */
+    void
+    drop_copy(const std::string& path, uint64_t chunk_id, uint64_t version);
+
+    /**
+     * @brief Returns the version of a valid copy held by this daemon.
+     * @return 0 if there is no valid copy
+     */
+    uint64_t
+    copy_version(const std::string& path, uint64_t chunk_id) const;
+};
+
+} // namespace gkfs::data
+
+#endif // GEKKOFS_DAEMON_REPLICA_MANAGER_HPP
@@ -31,11 +31,16 @@
 
 #include <daemon/daemon.hpp>
 
+#include <atomic>
+#include <map>
+#include <mutex>
+
 namespace gkfs {
 
 /* Forward declarations */
 namespace rpc {
 class Distributor;
+class BulkBufferPool;
 }
 
 
@@ -50,12 +55,22 @@ private:
     // contexts that were created at init time
     margo_instance_id server_rpc_mid_;
 
-    // Argobots I/O pools and execution streams
-    ABT_pool io_pool_;
+    // Argobots I/O pools and execution streams. Either a single pool shared by
+    // all I/O xstreams or one pool per xstream.
+    std::vector<ABT_pool> io_pools_;
+    mutable std::atomic<unsigned int> next_io_pool_{0};
     std::vector<ABT_xstream> io_streams_;
     std::string self_addr_str_;
     // Distributor
     std::shared_ptr<gkfs::rpc::Distributor> distributor_;
+    // Pre-registered buffers for data transfers
+    std::shared_ptr<gkfs::rpc::BulkBufferPool> bulk_pool_;
+
+    // Number of handlers running per RPC name. Entries are never removed.
+    std::map<std::string, std::atomic<uint64_t>> inflight_;
+    mutable std::mutex inflight_mutex_;
+    // Bytes of bulk transfers of running read and write handlers
+    std::atomic<uint64_t> bulk_inflight_{0};
 
 public:
     static RPCData*
@@ -77,11 +92,24 @@ public:
     void
     server_rpc_mid(margo_instance* server_rpc_mid);
 
+    /**
+     * @brief Returns the I/O pool a new task is pushed to. Pools are used in
+     * round robin if each I/O xstream has its own pool.
+     */
     ABT_pool
     io_pool() const;
 
+    const std::vector<ABT_pool>&
+    io_pools() const;
+
     void
-    io_pool(ABT_pool io_pool);
+    io_pools(const std::vector<ABT_pool>& io_pools);
+
+    /**
+     * @brief Returns the number of tasks queued or running in each I/O pool.
+     */
+    std::vector<size_t>
+    io_queue_lengths() const;
 
     std::vector<ABT_xstream>&
     io_streams();
@@ -100,6 +128,35 @@ public:
 
     void
     distributor(const std::shared_ptr<gkfs::rpc::Distributor>& distributor);
+
+    const std::shared_ptr<gkfs::rpc::BulkBufferPool>&
+    bulk_pool() const;
+
+    void
+    bulk_pool(const std::shared_ptr<gkfs::rpc::BulkBufferPool>& bulk_pool);
+
+    /**
+     * @brief Returns the counter of running handlers of an RPC. The reference
+     * stays valid, so handlers look it up once.
+     * @param rpc RPC name, e.g., gkfs::rpc::tag::write
+     */
+    std::atomic<uint64_t>&
+    inflight(const std::string& rpc);
+
+    /**
+     * @brief Returns the number of running handlers of each RPC.
+     */
+    std::vector<std::pair<std::string, uint64_t>>
+    inflight() const;
+
+    std::atomic<uint64_t>&
+    bulk_inflight();
+
+    /**
+     * @brief Returns the number of handlers waiting in the handler pool.
+     */
+    size_t
+    handler_queue_length() const;
 };
 
 } // namespace daemon
@@ -41,6 +41,8 @@ extern "C" {
 
 DECLARE_MARGO_RPC_HANDLER(rpc_srv_get_fs_config)
 
+DECLARE_MARGO_RPC_HANDLER(rpc_srv_get_daemon_status)
+
 DECLARE_MARGO_RPC_HANDLER(rpc_srv_create)
 
 DECLARE_MARGO_RPC_HANDLER(rpc_srv_stat)
@@ -76,4 +78,8 @@ DECLARE_MARGO_RPC_HANDLER(rpc_srv_truncate)
 
 DECLARE_MARGO_RPC_HANDLER(rpc_srv_get_chunk_stat)
 
+DECLARE_MARGO_RPC_HANDLER(rpc_srv_replicate_chunk)
+
+DECLARE_MARGO_RPC_HANDLER(rpc_srv_invalidate_replica)
+
 #endif // GKFS_DAEMON_RPC_DEFS_HPP
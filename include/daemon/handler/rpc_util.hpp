@@ -42,6 +42,8 @@ extern "C" {
 #include <margo.h>
 }
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 
 namespace gkfs::rpc {
@@ -167,6 +169,31 @@ cleanup_respond(hg_handle_t* handle, OutputType* output) {
     return ret;
 }
 
+/**
+ * @brief Adds to a counter of running work for the guard's lifetime, e.g.,
+ * a running RPC handler or the bytes it transfers.
+ */
+class inflight_guard {
+    std::atomic<uint64_t>& counter_;
+    uint64_t amount_;
+
+public:
+    explicit inflight_guard(std::atomic<uint64_t>& counter,
+                            uint64_t amount = 1)
+        : counter_(counter), amount_(amount) {
+        counter_.fetch_add(amount_, std::memory_order_relaxed);
+    }
+
+    ~inflight_guard() {
+        counter_.fetch_sub(amount_, std::memory_order_relaxed);
+    }
+
+    inflight_guard(const inflight_guard&) = delete;
+
+    inflight_guard&
+    operator=(const inflight_guard&) = delete;
+};
+
 } // namespace gkfs::rpc
 
 
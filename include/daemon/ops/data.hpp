@@ -43,8 +43,11 @@
 
 #include <daemon/daemon.hpp>
 #include <common/common_defs.hpp>
+#include <common/rpc/rpc_util.hpp>
 
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 extern "C" {
@@ -54,6 +57,8 @@ extern "C" {
 
 namespace gkfs::data {
 
+struct MappedChunk;
+
 /**
  * @brief Internal Exception for all general chunk operations.
  */
@@ -246,6 +251,7 @@ private:
     };                                //!< Struct for an chunk write operation
 
     std::vector<struct chunk_write_args> task_args_; //!< tasklet input structs
+    std::vector<bool> scheduled_; //!< writes handed to the I/O scheduler
     /**
      * @brief Exclusively used by the Argobots tasklet.
      * @param _arg Pointer to input struct of type <chunk_write_args>. Error
@@ -262,11 +268,24 @@ private:
 public:
     ChunkWriteOperation(const std::string& path, size_t n);
 
-    ~ChunkWriteOperation() = default;
+    /**
+     * @brief Calls abort_tasks() before the base class frees the eventuals.
+     */
+    ~ChunkWriteOperation();
+
+    /**
+     * @brief Cancels writes that have not started and waits for the others.
+     * Writes queued in the I/O scheduler cannot be cancelled and are waited
+     * for. Error paths must call this before freeing the buffers passed to
+     * write_nonblock().
+     */
+    void
+    abort_tasks();
 
     /**
      * @brief Write request called by RPC handler function and launches a
-     * non-blocking tasklet.
+     * non-blocking tasklet. If the built-in I/O scheduler is enabled, the write
+     * is queued there instead.
      * @param idx Number of non-blocking write for write RPC request
      * @param chunk_id The affected chunk id
      * @param bulk_buf_ptr The buffer to write for the chunk
@@ -302,7 +321,11 @@ private:
         size_t size;                  //!< size to read from chunk
         off64_t off;                  //!< offset for individual chunk
         ABT_eventual eventual;        //!< Attached eventual
-    };                                //!< Struct for an chunk read operation
+        std::vector<std::pair<size_t, size_t>>
+                extents; //!< data regions read, relative to buf
+        std::shared_ptr<MappedChunk>
+                mapping; //!< set if data is pushed from a mapped chunk file
+    };                   //!< Struct for an chunk read operation
 
     std::vector<struct chunk_read_args> task_args_; //!< tasklet input structs
     /**
@@ -327,6 +350,8 @@ public:
         hg_bulk_t local_bulk_handle;         //!< local bulk handle for PUSH
         std::vector<size_t>* local_offsets;  //!< offsets in local buffer
         std::vector<uint64_t>* chunk_ids;    //!< all chunk ids in this read
+        std::vector<gkfs::rpc::data_extent>*
+                extents; //!< filled with the data ranges in origin buffer
     }; //!< Struct to push read data to the client
 
     ChunkReadOperation(const std::string& path, size_t n);
@@ -349,7 +374,10 @@ public:
 
     /**
      * @brief Waits for all local I/O operations to finish and push buffers back
-     * to the daemon.
+     * to the daemon. Only data regions of the chunks are pushed. Holes smaller
+     * than gkfs::config::io::sparse_read_min_hole are zeroed and pushed along
+     * with the surrounding data. Chunks read through the chunk map cache are
+     * pushed from their mapping instead of the local bulk buffer.
      * @param args Bulk_args for push transfer
      * @return Pair for error code for success (0) or failure and read size
      */
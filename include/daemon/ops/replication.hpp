@@ -0,0 +1,82 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+/**
+ * @brief Daemon to daemon communication for hot chunk read replication. The
+ * replication state itself is kept by gkfs::data::ReplicaManager.
+ */
+
+#ifndef GEKKOFS_DAEMON_REPLICATION_HPP
+#define GEKKOFS_DAEMON_REPLICATION_HPP
+
+#include <daemon/classes/replica_manager.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gkfs::data {
+
+/**
+ * @brief Computes the daemons receiving the replicas of a chunk owned by
+ * `owner`. The number of replicas is capped at the number of other daemons.
+ * @param owner Daemon id of the chunk owner
+ * @param host_size Number of daemons
+ * @return Daemon ids of the replica set
+ */
+std::vector<uint64_t>
+replica_hosts(uint64_t owner, uint64_t host_size);
+
+/**
+ * @brief Pushes a chunk to its replica daemons in a separate Argobots ULT
+ * in the I/O pool. The outcome is reported to the ReplicaManager.
+ * @param path File path
+ * @param chunk_id Chunk id
+ * @param version Replication version returned by ReplicaManager::record_read
+ * @param hosts Daemons that receive the replicas
+ */
+void
+replicate_chunk_async(const std::string& path, uint64_t chunk_id,
+                      uint64_t version, const std::vector<uint64_t>& hosts);
+
+/**
+ * @brief Invalidates the replicas of modified chunks on their daemons in a
+ * separate Argobots ULT in the I/O pool. Returns without waiting for the
+ * replica daemons. Each set is reported to ReplicaManager::invalidation_done()
+ * once its daemons were notified, so the chunk is not replicated again
+ * meanwhile.
+ * @param path File path
+ * @param sets Replica sets to invalidate
+ */
+void
+invalidate_replicas(const std::string& path,
+                    const std::vector<ReplicaSet>& sets);
+
+} // namespace gkfs::data
+
+#endif // GEKKOFS_DAEMON_REPLICATION_HPP
@@ -0,0 +1,155 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#ifndef GEKKOFS_DAEMON_IO_SCHEDULER_HPP
+#define GEKKOFS_DAEMON_IO_SCHEDULER_HPP
+
+#include <common/common_defs.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include <abt.h>
+#include <sys/types.h>
+}
+
+namespace gkfs::data {
+
+/**
+ * @brief Built-in write scheduler used when AGIOS is not available.
+ * @internal
+ * Chunk writes are queued per chunk file instead of being handed to the I/O
+ * pool one tasklet at a time. The first request arriving at an idle chunk
+ * starts a dispatcher ULT on the I/O pool. The dispatcher waits until no new
+ * request arrived for `window` microseconds, but never longer than `deadline`
+ * microseconds after the first request of the batch. It then orders the batch
+ * by offset, merges adjacent ranges into a single pwritev() and overlapping
+ * ranges into a single buffer (later arrivals win), and completes the eventual
+ * of every request with its own size or a negative error code.
+ *
+ * While a dispatcher writes, new requests for its chunk are queued and served
+ * by the same dispatcher in a following batch. Thus, there is at most one
+ * dispatcher per chunk and writes to a chunk are applied in batch order.
+ *
+ * A ULT is used instead of a tasklet because the dispatcher must be able to
+ * wait for the window to close.
+ * @endinternal
+ */
+class IoScheduler {
+
+private:
+    struct write_request {
+        const char* buf;
+        size_t size;
+        off64_t offset;
+        ABT_eventual eventual;
+    };
+
+    using chunk_key = std::pair<std::string, gkfs::rpc::chnk_id_t>;
+
+    struct chunk_queue {
+        std::vector<write_request> pending;
+        std::chrono::steady_clock::time_point first_arrival;
+        std::chrono::steady_clock::time_point last_arrival;
+    };
+
+    struct dispatch_args {
+        IoScheduler* scheduler;
+        chunk_key key;
+    };
+
+    std::chrono::microseconds window_;
+    std::chrono::microseconds deadline_;
+
+    ABT_mutex queue_mutex_;
+    ABT_cond window_cond_; //!< never signaled, used for timed waits only
+    std::map<chunk_key, chunk_queue> queues_;
+
+    /**
+     * @brief Dispatcher ULT draining the queue of a single chunk.
+     * @param _arg Pointer to a heap allocated dispatch_args, freed by the ULT
+     */
+    static void
+    dispatch_ult(void* _arg);
+
+    /**
+     * @brief Writes a batch of requests to one chunk and sets their eventuals.
+     * @param key Chunk path and chunk id
+     * @param batch Requests in arrival order
+     */
+    void
+    write_batch(const chunk_key& key, std::vector<write_request>& batch);
+
+    /**
+     * @brief Blocks the calling ULT until the batch of the chunk is due.
+     * @param key Chunk path and chunk id
+     */
+    void
+    wait_for_window(const chunk_key& key);
+
+public:
+    /**
+     * @brief Creates the scheduler.
+     * @param window Maximum idle time between two requests of a batch
+     * @param deadline Maximum time the first request of a batch is held back
+     * @throws std::runtime_error if Argobots primitives cannot be created
+     */
+    IoScheduler(std::chrono::microseconds window,
+                std::chrono::microseconds deadline);
+
+    ~IoScheduler();
+
+    IoScheduler(const IoScheduler&) = delete;
+
+    IoScheduler&
+    operator=(const IoScheduler&) = delete;
+
+    /**
+     * @brief Queues a chunk write. Never blocks on I/O.
+     * @param path Chunk directory path, must outlive the request
+     * @param chunk_id Chunk id
+     * @param buf Buffer to write, must outlive the request
+     * @param size Bytes to write
+     * @param offset Offset within the chunk file
+     * @param eventual Set with the written size (ssize_t) or -errno
+     * @throws std::runtime_error if the dispatcher ULT cannot be created
+     */
+    void
+    write(const std::string& path, gkfs::rpc::chnk_id_t chunk_id,
+          const char* buf, size_t size, off64_t offset, ABT_eventual eventual);
+};
+
+} // namespace gkfs::data
+
+#endif // GEKKOFS_DAEMON_IO_SCHEDULER_HPP
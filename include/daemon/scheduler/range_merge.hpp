@@ -0,0 +1,79 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#ifndef GEKKOFS_DAEMON_RANGE_MERGE_HPP
+#define GEKKOFS_DAEMON_RANGE_MERGE_HPP
+
+#include <cstddef>
+#include <vector>
+
+extern "C" {
+#include <sys/types.h>
+}
+
+namespace gkfs::data {
+
+/**
+ * @brief A byte range of a single I/O request within one chunk file.
+ */
+struct io_range {
+    off64_t offset;
+    size_t size;
+};
+
+/**
+ * @brief A group of requests whose ranges touch or overlap and which are
+ * therefore served by a single disk operation.
+ */
+struct merged_range {
+    off64_t offset; //!< start of the merged range
+    size_t size;    //!< length of the merged range
+    std::vector<size_t>
+            members;  //!< input indices, ordered by offset and then arrival
+    bool overlapping; //!< true if at least two members share bytes
+};
+
+/**
+ * @brief Plans the disk operations for a batch of requests on the same chunk.
+ * @internal
+ * Requests are sorted by offset. Ties keep their arrival order. Consecutive
+ * requests are put into the same group as long as a request starts at or
+ * before the end of the group, i.e., adjacent and overlapping ranges are
+ * merged. Ranges separated by a gap are never merged as this would write bytes
+ * no request asked for.
+ * @endinternal
+ * @param ranges Requests in arrival order
+ * @return Groups in ascending offset order
+ */
+std::vector<merged_range>
+merge_ranges(const std::vector<io_range>& ranges);
+
+} // namespace gkfs::data
+
+#endif // GEKKOFS_DAEMON_RANGE_MERGE_HPP
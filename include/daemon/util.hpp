@@ -32,6 +32,9 @@
 #ifndef GEKKOFS_DAEMON_UTIL_HPP
 #define GEKKOFS_DAEMON_UTIL_HPP
 
+#include <string>
+#include <vector>
+
 namespace gkfs::utils {
 /**
  * @brief Registers the daemon's RPC address to the shared hosts file.
@@ -45,6 +48,32 @@ populate_hosts_file();
  */
 void
 destroy_hosts_file();
+
+/**
+ * @brief Parses a Linux CPU list, e.g., "0-3,8,10-11".
+ * @param cpu_list CPU list
+ * @return CPU ids in the order given
+ * @throws std::invalid_argument on a malformed list
+ */
+std::vector<unsigned int>
+parse_cpu_list(const std::string& cpu_list);
+
+/**
+ * @brief Returns the CPUs of a NUMA node as reported by sysfs.
+ * @param numa_node NUMA node id
+ * @return CPU ids, empty if the node does not exist
+ */
+std::vector<unsigned int>
+numa_node_cpus(int numa_node);
+
+/**
+ * @brief Returns the NUMA node of the block device a path is stored on, e.g.,
+ * the NVMe device holding the rootdir.
+ * @param path Path on a local file system
+ * @return NUMA node id or -1 if unknown
+ */
+int
+numa_node_of_path(const std::string& path);
 } // namespace gkfs::utils
 
 #endif // GEKKOFS_DAEMON_UTIL_HPP
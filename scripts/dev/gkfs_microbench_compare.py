@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""
+Compares two result files of gkfs_microbench, e.g., of a baseline commit and
+of a change, and flags benchmarks whose median time per operation changed by
+more than a threshold.
+
+    gkfs_microbench -o base.json      # on the baseline commit
+    gkfs_microbench -o change.json    # on the change
+    gkfs_microbench_compare.py base.json change.json
+
+Exits with status 1 if any benchmark is slower than the threshold allows.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return data["context"], {b["name"]: b for b in data["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare two gkfs_microbench result files")
+    parser.add_argument("baseline", help="results of the baseline")
+    parser.add_argument("contender", help="results to compare")
+    parser.add_argument("-t", "--threshold", type=float, default=10.0,
+                        help="tolerated slowdown in percent (default 10)")
+    args = parser.parse_args()
+
+    try:
+        base_ctx, base = load(args.baseline)
+        new_ctx, new = load(args.contender)
+    except (OSError, ValueError, KeyError) as e:
+        sys.exit(f"error: {e}")
+
+    print(f"baseline:  {base_ctx.get('version')} ({base_ctx.get('host')})")
+    print(f"contender: {new_ctx.get('version')} ({new_ctx.get('host')})\n")
+    print(f"{'BENCHMARK':<48} {'BASE NS/OP':>12} {'NEW NS/OP':>12} "
+          f"{'CHANGE':>8}")
+
+    regressions = 0
+    for name in sorted(set(base) | set(new)):
+        if name not in base or name not in new:
+            where = "baseline" if name in base else "contender"
+            print(f"{name:<48} only in {where}")
+            continue
+        before = base[name]["ns_per_op"]["median"]
+        after = new[name]["ns_per_op"]["median"]
+        change = (after - before) / before * 100.0 if before else 0.0
+        mark = ""
+        if change > args.threshold:
+            mark = "  SLOWER"
+            regressions += 1
+        elif change < -args.threshold:
+            mark = "  faster"
+        print(f"{name:<48} {before:>12.1f} {after:>12.1f} "
+              f"{change:>+7.1f}%{mark}")
+
+    if regressions:
+        print(f"\n{regressions} benchmark(s) slower by more than "
+              f"{args.threshold}%")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
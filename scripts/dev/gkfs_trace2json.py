@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+Merges GekkoFS RPC trace files of clients and daemons into a single file in
+the Chrome trace event format that can be opened in chrome://tracing or
+https://ui.perfetto.dev.
+
+Trace files are written by clients with LIBGKFS_TRACE_SAMPLING set and by
+daemons started with --trace-dir (see include/common/trace_util.hpp for the
+format). Spans of a daemon are linked to the client RPC span they serve with a
+flow arrow.
+
+    gkfs_trace2json.py -o trace.json /tmp/gkfs_*.trace
+"""
+
+import argparse
+import json
+import struct
+import sys
+from pathlib import Path
+
+HEADER = struct.Struct("<8s56s")
+RECORD = struct.Struct("<QQQQQII16s")
+MAGIC = b"GKFSTRC1"
+
+
+def read_trace(path):
+    """Returns the hostname and the span records of a trace file."""
+    data = Path(path).read_bytes()
+    if len(data) < HEADER.size:
+        raise ValueError(f"{path}: file too short")
+    magic, host = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise ValueError(f"{path}: not a GekkoFS trace file")
+    host = host.split(b"\0", 1)[0].decode(errors="replace")
+    # a partially written last record is ignored
+    end = HEADER.size + (len(data) - HEADER.size) // RECORD.size * RECORD.size
+    spans = []
+    for fields in RECORD.iter_unpack(data[HEADER.size:end]):
+        trace_id, span_id, parent_id, start, stop, pid, tid, name = fields
+        spans.append({
+            "trace_id": trace_id,
+            "span_id": span_id,
+            "parent_id": parent_id,
+            "start": start,
+            "end": stop,
+            "pid": pid,
+            "tid": tid,
+            "name": name.split(b"\0", 1)[0].decode(errors="replace"),
+        })
+    return host, spans
+
+
+def convert(paths, trace_filter=None):
+    events = []
+    spans = {}
+    # process ids of different nodes may collide, so every trace file gets
+    # its own process in the output
+    for process, path in enumerate(paths, start=1):
+        host, records = read_trace(path)
+        kind = "daemon" if "gkfs_daemon_" in Path(path).name else "client"
+        pid = records[0]["pid"] if records else 0
+        events.append({
+            "name": "process_name",
+            "ph": "M",
+            "pid": process,
+            "args": {"name": f"{kind} {host} ({pid})"},
+        })
+        for span in records:
+            if trace_filter is not None and span["trace_id"] != trace_filter:
+                continue
+            span["process"] = process
+            spans[span["span_id"]] = span
+
+    for span in spans.values():
+        events.append({
+            "name": span["name"],
+            "cat": "gkfs",
+            "ph": "X",
+            "ts": span["start"] / 1000,
+            "dur": max(span["end"] - span["start"], 0) / 1000,
+            "pid": span["process"],
+            "tid": span["tid"],
+            "args": {
+                "trace_id": f"{span['trace_id']:016x}",
+                "span_id": f"{span['span_id']:016x}",
+                "parent_id": f"{span['parent_id']:016x}",
+            },
+        })
+        parent = spans.get(span["parent_id"])
+        if parent is None or parent["process"] == span["process"]:
+            continue
+        # flow from the RPC span of the caller to the span serving it. The
+        # start must lie within the caller span, even if clocks are skewed.
+        ts = min(max(span["start"], parent["start"]), parent["end"])
+        flow = {"name": "rpc", "cat": "gkfs", "id": f"{span['span_id']:x}"}
+        events.append(dict(flow, ph="s", ts=ts / 1000,
+                           pid=parent["process"], tid=parent["tid"]))
+        events.append(dict(flow, ph="f", bp="e", ts=span["start"] / 1000,
+                           pid=span["process"], tid=span["tid"]))
+    return {"traceEvents": events, "displayTimeUnit": "ns"}
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Convert GekkoFS trace files to the Chrome trace format")
+    parser.add_argument("files", nargs="+", help="client and daemon traces")
+    parser.add_argument("-o", "--output", help="output file (default stdout)")
+    parser.add_argument("-t", "--trace-id",
+                        help="only convert the trace with this hex id")
+    args = parser.parse_args()
+
+    trace_filter = int(args.trace_id, 16) if args.trace_id else None
+    try:
+        result = convert(args.files, trace_filter)
+    except (OSError, ValueError) as e:
+        sys.exit(f"error: {e}")
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(result, f)
+    else:
+        json.dump(result, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
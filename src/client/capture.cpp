@@ -0,0 +1,264 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <client/capture.hpp>
+#include <client/open_file_map.hpp>
+#include <client/preload.hpp>
+#include <client/preload_context.hpp>
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+}
+
+namespace gkfs::capture {
+
+namespace {
+
+uint64_t
+iov_size(long iov, long iovcnt) {
+    auto vec = reinterpret_cast<const struct iovec*>(iov);
+    uint64_t size = 0;
+    for(long i = 0; vec != nullptr && i < iovcnt; i++) {
+        size += vec[i].iov_len;
+    }
+    return size;
+}
+
+bool
+fd_call(call& c, op o, long fd) {
+    if(!CTX->file_map()->exist(static_cast<int>(fd))) {
+        return false;
+    }
+    c.rec.op = static_cast<uint16_t>(o);
+    c.rec.fd = static_cast<int32_t>(fd);
+    return true;
+}
+
+bool
+resolve(long dirfd, long raw_path, std::string& path) {
+    if(raw_path == 0) {
+        return false;
+    }
+    // the application resolves the last component again during replay
+    return CTX->relativize_fd_path(static_cast<int>(dirfd),
+                                   reinterpret_cast<const char*>(raw_path),
+                                   path, 0, false) ==
+           gkfs::preload::RelativizeStatus::internal;
+}
+
+bool
+path_call(call& c, op o, long dirfd, long raw_path) {
+    if(!resolve(dirfd, raw_path, c.path)) {
+        return false;
+    }
+    c.rec.op = static_cast<uint16_t>(o);
+    c.rec.fd = -1;
+    return true;
+}
+
+bool
+dispatch(call& c, long syscall_number, long arg0, long arg1, long arg2,
+         long arg3, long arg4) {
+    auto& r = c.rec;
+    switch(syscall_number) {
+#ifdef SYS_open
+        case SYS_open:
+            r.flags = arg1;
+            r.mode = arg2;
+            return path_call(c, op::open, AT_FDCWD, arg0);
+#endif
+#ifdef SYS_creat
+        case SYS_creat:
+            r.flags = O_WRONLY | O_CREAT | O_TRUNC;
+            r.mode = arg1;
+            return path_call(c, op::open, AT_FDCWD, arg0);
+#endif
+        case SYS_openat:
+            r.flags = arg2;
+            r.mode = arg3;
+            return path_call(c, op::open, arg0, arg1);
+        case SYS_close:
+            return fd_call(c, op::close, arg0);
+        case SYS_read:
+            r.size = arg2;
+            return fd_call(c, op::read, arg0);
+        case SYS_readv:
+            r.size = iov_size(arg1, arg2);
+            return fd_call(c, op::read, arg0);
+        case SYS_pread64:
+            r.size = arg2;
+            r.offset = arg3;
+            return fd_call(c, op::pread, arg0);
+        case SYS_preadv:
+            r.size = iov_size(arg1, arg2);
+            r.offset = arg3;
+            return fd_call(c, op::pread, arg0);
+        case SYS_write:
+            r.size = arg2;
+            return fd_call(c, op::write, arg0);
+        case SYS_writev:
+            r.size = iov_size(arg1, arg2);
+            return fd_call(c, op::write, arg0);
+        case SYS_pwrite64:
+            r.size = arg2;
+            r.offset = arg3;
+            return fd_call(c, op::pwrite, arg0);
+        case SYS_pwritev:
+            r.size = iov_size(arg1, arg2);
+            r.offset = arg3;
+            return fd_call(c, op::pwrite, arg0);
+        case SYS_lseek:
+            r.offset = arg1;
+            r.flags = arg2;
+            return fd_call(c, op::lseek, arg0);
+#ifdef SYS_stat
+        case SYS_stat:
+            return path_call(c, op::stat, AT_FDCWD, arg0);
+#endif
+#ifdef SYS_lstat
+        case SYS_lstat:
+            r.flags = AT_SYMLINK_NOFOLLOW;
+            return path_call(c, op::stat, AT_FDCWD, arg0);
+#endif
+#ifdef STATX_TYPE
+        case SYS_statx:
+            r.flags = arg2;
+            return path_call(c, op::stat, arg0, arg1);
+#endif
+        case SYS_newfstatat:
+            r.flags = arg3;
+            return path_call(c, op::stat, arg0, arg1);
+        case SYS_fstat:
+            return fd_call(c, op::fstat, arg0);
+#ifdef SYS_unlink
+        case SYS_unlink:
+            return path_call(c, op::unlink, AT_FDCWD, arg0);
+#endif
+        case SYS_unlinkat:
+            return path_call(c, (arg2 & AT_REMOVEDIR) ? op::rmdir : op::unlink,
+                             arg0, arg1);
+#ifdef SYS_rmdir
+        case SYS_rmdir:
+            return path_call(c, op::rmdir, AT_FDCWD, arg0);
+#endif
+#ifdef SYS_mkdir
+        case SYS_mkdir:
+            r.mode = arg1;
+            return path_call(c, op::mkdir, AT_FDCWD, arg0);
+#endif
+        case SYS_mkdirat:
+            r.mode = arg2;
+            return path_call(c, op::mkdir, arg0, arg1);
+        case SYS_truncate:
+            r.offset = arg1;
+            return path_call(c, op::truncate, AT_FDCWD, arg0);
+        case SYS_ftruncate:
+            r.offset = arg1;
+            return fd_call(c, op::ftruncate, arg0);
+        case SYS_fsync:
+        case SYS_fdatasync:
+            return fd_call(c, op::fsync, arg0);
+#ifdef SYS_getdents
+        case SYS_getdents:
+#endif
+        case SYS_getdents64:
+            r.size = arg2;
+            return fd_call(c, op::getdents, arg0);
+#ifdef SYS_access
+        case SYS_access:
+            r.mode = arg1;
+            return path_call(c, op::access, AT_FDCWD, arg0);
+#endif
+        case SYS_faccessat:
+            r.mode = arg2;
+            return path_call(c, op::access, arg0, arg1);
+#ifdef SYS_faccessat2
+        case SYS_faccessat2:
+            r.mode = arg2;
+            r.flags = arg3;
+            return path_call(c, op::access, arg0, arg1);
+#endif
+#ifdef SYS_rename
+        case SYS_rename:
+            return resolve(AT_FDCWD, arg1, c.path2) &&
+                   path_call(c, op::rename, AT_FDCWD, arg0);
+#endif
+        case SYS_renameat:
+            return resolve(arg2, arg3, c.path2) &&
+                   path_call(c, op::rename, arg0, arg1);
+        case SYS_renameat2:
+            r.flags = arg4;
+            return resolve(arg2, arg3, c.path2) &&
+                   path_call(c, op::rename, arg0, arg1);
+        case SYS_dup:
+#ifdef SYS_dup2
+        case SYS_dup2:
+#endif
+        case SYS_dup3:
+            return fd_call(c, op::dup, arg0);
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+call
+begin(long syscall_number, long arg0, long arg1, long arg2, long arg3,
+      long arg4) {
+    call c{};
+    auto* capture = CTX->capture();
+    if(!capture) {
+        return c;
+    }
+    c.active = dispatch(c, syscall_number, arg0, arg1, arg2, arg3, arg4);
+    if(c.active) {
+        c.start = capture->elapsed();
+    }
+    return c;
+}
+
+void
+end(call& c, long result) {
+    if(!c.active) {
+        return;
+    }
+    auto* capture = CTX->capture();
+    if(!capture) {
+        return;
+    }
+    c.rec.start = c.start;
+    c.rec.duration = capture->elapsed() - c.start;
+    c.rec.result = result;
+    capture->add(c.rec, c.path, c.path2);
+    c.active = false;
+}
+
+} // namespace gkfs::capture
@@ -35,12 +35,16 @@
 #include <client/rpc/forward_metadata.hpp>
 #include <client/rpc/forward_data.hpp>
 #include <client/open_dir.hpp>
+#include <client/tracing.hpp>
 
 #include <common/path_util.hpp>
 #include <common/rpc/rpc_util.hpp>
+#include <common/rpc/placement.hpp>
 
 #include <iostream>
 #include <fstream>
+#include <optional>
+#include <cstring>
 extern "C" {
 #include <dirent.h> // used for file types in the getdents{,64}() functions
 #include <linux/kernel.h> // used for definition of alignment macros
@@ -103,7 +107,12 @@ static void clear_one_pathfs(std::string path){
 static void update_pathmeta(std::string path, size_t new_size, off_t offset, std::string& str_buf, bool is_append){
     if(CTX->pathmeta().count(path)){
         auto md = CTX->pathmeta()[path];
-        if(!md.use_buf()) return ;
+        if(!md.use_buf()) {
+            // keep the size current for reads that end in a trailing hole
+            md.size(max(md.size(), new_size));
+            CTX->pathmeta()[path] = md;
+            return;
+        }
         string ori_buf = md.buf();
         off_t off = is_append? md.size() : offset;
         if(new_size > gkfs::config::rpc::smallfilesize) {
@@ -127,6 +136,34 @@ static void add_one_pathfs(std::string path){
     }
 }
 
+/**
+ * Chooses the file system of a path that is created in federated mode and
+ * records it in pathfs. Only this client knows the placement: other clients,
+ * and this one after pathfs is cleared, locate the path via stat on the file
+ * systems as for any other path. Paths found by stat keep their file system.
+ * @param path
+ * @param mode
+ * @return true if a file system was recorded for the path
+ */
+static bool place_new_path(const std::string& path, mode_t mode) {
+    auto policy = CTX->placement_policy();
+    if(!policy || CTX->pathfs().count(path))
+        return false;
+    auto parent = gkfs::path::dirname(path);
+    if(policy->follows_parent() && parent != "/") {
+        if(!CTX->pathfs().count(parent))
+            gkfs::utils::get_metadata(parent);
+        if(CTX->pathfs().count(parent)) {
+            CTX->pathfs()[path] = CTX->pathfs()[parent];
+            return true;
+        }
+    }
+    CTX->pathfs()[path] = policy->place(path, S_ISDIR(mode));
+    LOG(DEBUG, "{}() '{}' placed on fs {} by policy '{}'", __func__, path,
+        CTX->pathfs()[path], policy->name());
+    return true;
+}
+
 /**
  * Checks if metadata for parent directory exists (can be disabled with
  * CREATE_CHECK_PARENTS). errno may be set
@@ -339,8 +376,11 @@ gkfs_create(const std::string& path, mode_t mode) {
         return -1;
     }
     add_one_pathfs(path);
+    auto placed = place_new_path(path, mode);
     auto err = gkfs::rpc::forward_create(path, mode);
     if(err) {
+        if(placed)
+            clear_one_pathfs(path);
         errno = err;
         return -1;
     }
@@ -778,6 +818,8 @@ gkfs_truncate(const std::string& path, off_t old_size, off_t new_size) {
         return -1;
     }
 
+    // the cached size must not make reads zero-fill beyond the new size
+    CTX->pathmeta().erase(path);
     err = gkfs::rpc::forward_truncate(path, old_size, new_size);
     if(err) {
         LOG(DEBUG, "Failed to truncate data");
@@ -912,6 +954,7 @@ gkfs_pwrite(std::shared_ptr<gkfs::filemap::OpenFile> file, const char* buf,
         errno = EISDIR;
         return -1;
     }
+    gkfs::trace::operation trace_op("pwrite");
     auto path = make_unique<string>(file->path());
     auto is_append = file->get_flag(gkfs::filemap::OpenFile_flags::append);
 
@@ -921,15 +964,20 @@ gkfs_pwrite(std::shared_ptr<gkfs::filemap::OpenFile> file, const char* buf,
     size_t new_size = is_append? count + md.size(): max(count + offset, md.size());
     if(md.use_buf() && new_size <= gkfs::config::rpc::smallfilesize) str_buf.assign(buf,count);
 
-    auto ret_offset = gkfs::rpc::forward_update_metadentry_size(
-            *path, count, offset, is_append, gkfs::rpc::encode_string(str_buf));
-    auto err = ret_offset.first;
-    if(err) {
-        LOG(ERROR, "update_metadentry_size() failed with err '{}'", err);
-        errno = err;
-        return -1;
-    }
+    // An append must know the offset that the daemon reserves for it before
+    // any data is sent. Otherwise, the size update is only posted here and
+    // collected after the data RPCs so that both round trips overlap.
+    std::optional<gkfs::rpc::pending_size_update> size_update;
     if(is_append) {
+        auto ret_offset = gkfs::rpc::forward_update_metadentry_size(
+                *path, count, offset, is_append,
+                gkfs::rpc::encode_string(str_buf));
+        auto err = ret_offset.first;
+        if(err) {
+            LOG(ERROR, "update_metadentry_size() failed with err '{}'", err);
+            errno = err;
+            return -1;
+        }
         // When append is set the EOF is set to the offset
         // forward_update_metadentry_size returns. This is because it is an
         // atomic operation on the server and reserves the space for this append
@@ -942,23 +990,38 @@ gkfs_pwrite(std::shared_ptr<gkfs::filemap::OpenFile> file, const char* buf,
             return -1;
         }
         offset = ret_offset.second;
+    } else {
+        size_update.emplace(gkfs::rpc::post_update_metadentry_size(
+                *path, count, offset, is_append,
+                gkfs::rpc::encode_string(str_buf)));
+    }
+    std::pair<int, ssize_t> ret_write{0, static_cast<ssize_t>(count)};
+    if(new_size > gkfs::config::rpc::smallfilesize) {
+        //写回
+        if(md.size()) {
+            auto write_back = gkfs::rpc::forward_write(*path, md.buf().c_str(),
+                                                       0, md.size());
+            if(write_back.first) {
+                ret_write = make_pair(write_back.first, 0);
+            } else if(write_back.second != md.size()) {
+                LOG(WARNING,
+                    "gkfs::rpc::forward_write() wrote '{}' bytes instead of '{}'",
+                    write_back.second, md.size());
+            }
+        }
+        if(!ret_write.first)
+            ret_write = gkfs::rpc::forward_write(*path, buf, offset, count);
     }
-    //写回
-    if(new_size > gkfs::config::rpc::smallfilesize && md.size()) {
-        auto write_back = gkfs::rpc::forward_write(*path, md.buf().c_str(), 0, md.size());
-        if(write_back.first) {
-            LOG(WARNING, "gkfs::rpc::forward_write() failed with err '{}'", err);
+    // the size update is always collected, even if the data transfer failed
+    if(size_update) {
+        auto err = size_update->wait().first;
+        if(err) {
+            LOG(ERROR, "update_metadentry_size() failed with err '{}'", err);
             errno = err;
             return -1;
         }
-        if(write_back.second != md.size()){
-            LOG(WARNING,
-            "gkfs::rpc::forward_write() wrote '{}' bytes instead of '{}'",
-            write_back.second, md.size());
-        }
-    } 
-    auto ret_write = (new_size <= gkfs::config::rpc::smallfilesize)? make_pair(0,(off_t)count) : gkfs::rpc::forward_write(*path, buf, offset, count);
-    err = ret_write.first;
+    }
+    auto err = ret_write.first;
     if(err) {
         LOG(WARNING, "gkfs::rpc::forward_write() failed with err '{}'", err);
         errno = err;
@@ -1089,12 +1152,8 @@ gkfs_pread(std::shared_ptr<gkfs::filemap::OpenFile> file, char* buf,
         errno = EISDIR;
         return -1;
     }
+    gkfs::trace::operation trace_op("pread");
 
-    // Zeroing buffer before read is only relevant for sparse files. Otherwise
-    // sparse regions contain invalid data.
-    if constexpr(gkfs::config::io::zero_buffer_before_read) {
-        memset(buf, 0, sizeof(char) * count);
-    }
     add_one_pathfs(file->path());
     auto md = CTX->pathmeta()[file->path()];
     pair<int, ssize_t> ret;
@@ -1106,6 +1165,18 @@ gkfs_pread(std::shared_ptr<gkfs::filemap::OpenFile> file, char* buf,
     }
     else{
         ret = gkfs::rpc::forward_read(file->path(), buf, offset, count);
+        // The daemons only report data up to the end of the last data range.
+        // A hole at the end of the range that lies within the file size,
+        // e.g., after a write beyond the end of the file, reads as zeros as
+        // well. The size is the one cached by add_one_pathfs() and updated by
+        // this client's writes, so no RPC is needed here.
+        auto size = static_cast<off64_t>(md.size());
+        if(!ret.first && static_cast<size_t>(ret.second) < count &&
+           size > offset + ret.second) {
+            auto read_end = min(size, static_cast<off64_t>(offset + count));
+            memset(buf + ret.second, 0, read_end - offset - ret.second);
+            ret.second = read_end - offset;
+        }
     }
     auto err = ret.first;
     if(err) {
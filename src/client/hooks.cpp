@@ -34,6 +34,7 @@
 #include <client/gkfs_functions.hpp>
 #include <client/path.hpp>
 #include <client/open_dir.hpp>
+#include <client/path_cache.hpp>
 
 #include <common/path_util.hpp>
 
@@ -53,6 +54,17 @@ with_errno(int ret) {
     return (ret < 0) ? -errno : ret;
 }
 
+/**
+ * Forgets resolved paths after the application changed the namespace outside
+ * of the mountdir, since a cached path may have been replaced by a link.
+ */
+inline long
+external_namespace_changed(long ret) {
+    if(const auto& cache = CTX->path_cache())
+        cache->clear();
+    return ret;
+}
+
 } // namespace
 
 namespace gkfs::hook {
@@ -350,8 +362,8 @@ hook_unlinkat(int dirfd, const char* cpath, int flags) {
                                                 flags);
 
         case gkfs::preload::RelativizeStatus::external:
-            return syscall_no_intercept_wrapper(SYS_unlinkat, dirfd,
-                                                resolved.c_str(), flags);
+            return external_namespace_changed(syscall_no_intercept_wrapper(
+                    SYS_unlinkat, dirfd, resolved.c_str(), flags));
 
         case gkfs::preload::RelativizeStatus::fd_not_a_dir:
             return -ENOTDIR;
@@ -390,8 +402,8 @@ hook_symlinkat(const char* oldname, int newdfd, const char* newname) {
                                                 newname);
 
         case gkfs::preload::RelativizeStatus::external:
-            return syscall_no_intercept_wrapper(SYS_symlinkat, oldname, newdfd,
-                                                newname_resolved.c_str());
+            return external_namespace_changed(syscall_no_intercept_wrapper(
+                    SYS_symlinkat, oldname, newdfd, newname_resolved.c_str()));
 
         case gkfs::preload::RelativizeStatus::fd_not_a_dir:
             return -ENOTDIR;
@@ -934,8 +946,8 @@ hook_renameat(int olddfd, const char* oldname, int newdfd, const char* newname,
             return -EINVAL;
     }
 
-    return syscall_no_intercept_wrapper(SYS_renameat2, olddfd, oldpath_pass,
-                                        newdfd, newpath_pass, flags);
+    return external_namespace_changed(syscall_no_intercept_wrapper(
+            SYS_renameat2, olddfd, oldpath_pass, newdfd, newpath_pass, flags));
 }
 
 int
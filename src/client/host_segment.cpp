@@ -0,0 +1,327 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS' POSIX interface.
+
+  GekkoFS' POSIX interface is free software: you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, either version 3 of the License,
+  or (at your option) any later version.
+
+  GekkoFS' POSIX interface is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with GekkoFS' POSIX interface.  If not, see
+  <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+
+#include <client/host_segment.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+extern "C" {
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t segment_magic = 0x474b46534853454dULL; // "GKFSHSEM"
+// a segment that stays empty for longer than this lost its writer
+constexpr time_t empty_segment_timeout = 10; // in seconds
+
+/*
+ * The header is followed by `length` bytes of payload. `state` is 0 while the
+ * segment is written and is set to the epoch (with release semantics) once the
+ * payload is complete.
+ */
+struct segment_header {
+    uint64_t magic;
+    uint64_t state;
+    uint64_t pid;
+    uint64_t length;
+    uint64_t checksum;
+};
+
+uint64_t
+fnv1a(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+string
+absolute_path(const string& path) {
+    if(!path.empty() && path[0] == '/')
+        return path;
+    char cwd[PATH_MAX];
+    if(getcwd(cwd, sizeof(cwd)) == nullptr)
+        return path;
+    return string(cwd) + "/" + path;
+}
+
+void
+put_u32(string& buf, uint32_t value) {
+    buf.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void
+put_string(string& buf, const string& value) {
+    put_u32(buf, static_cast<uint32_t>(value.size()));
+    buf.append(value);
+}
+
+string
+serialize(const gkfs::utils::HostTable& table) {
+    string buf;
+    put_u32(buf, static_cast<uint32_t>(table.hosts.size()));
+    for(const auto& [host, uri] : table.hosts) {
+        put_string(buf, host);
+        put_string(buf, uri);
+    }
+    put_u32(buf, static_cast<uint32_t>(table.fs_sizes.size()));
+    for(size_t i = 0; i < table.fs_sizes.size(); i++) {
+        put_u32(buf, table.fs_sizes[i]);
+        put_u32(buf, i < table.priorities.size() ? table.priorities[i] : 0);
+    }
+    return buf;
+}
+
+/// Bounds-checked reader of a serialized host table
+class payload_reader {
+    const char* pos_;
+    const char* end_;
+
+public:
+    payload_reader(const char* data, size_t size)
+        : pos_(data), end_(data + size) {}
+
+    bool
+    get_u32(uint32_t& value) {
+        if(static_cast<size_t>(end_ - pos_) < sizeof(value))
+            return false;
+        memcpy(&value, pos_, sizeof(value));
+        pos_ += sizeof(value);
+        return true;
+    }
+
+    bool
+    get_string(string& value) {
+        uint32_t size;
+        if(!get_u32(size) || static_cast<size_t>(end_ - pos_) < size)
+            return false;
+        value.assign(pos_, size);
+        pos_ += size;
+        return true;
+    }
+
+    bool
+    done() const {
+        return pos_ == end_;
+    }
+};
+
+optional<gkfs::utils::HostTable>
+deserialize(const char* data, size_t size) {
+    payload_reader in(data, size);
+    gkfs::utils::HostTable table;
+    uint32_t count;
+    if(!in.get_u32(count))
+        return {};
+    for(uint32_t i = 0; i < count; i++) {
+        string host, uri;
+        if(!in.get_string(host) || !in.get_string(uri))
+            return {};
+        table.hosts.emplace_back(move(host), move(uri));
+    }
+    if(!in.get_u32(count))
+        return {};
+    for(uint32_t i = 0; i < count; i++) {
+        uint32_t fs_size, priority;
+        if(!in.get_u32(fs_size) || !in.get_u32(priority))
+            return {};
+        table.fs_sizes.push_back(fs_size);
+        table.priorities.push_back(priority);
+    }
+    if(!in.done())
+        return {};
+    return table;
+}
+
+/**
+ * Checks whether an existing segment may be replaced: it is complete but was
+ * built from other files, or it was never completed because its writer died.
+ */
+bool
+is_stale(int fd, uint64_t epoch) {
+    struct stat st {};
+    if(fstat(fd, &st) != 0)
+        return false;
+    if(static_cast<size_t>(st.st_size) < sizeof(segment_header))
+        return time(nullptr) - st.st_ctime > empty_segment_timeout;
+
+    auto addr = mmap(nullptr, sizeof(segment_header), PROT_READ, MAP_SHARED,
+                     fd, 0);
+    if(addr == MAP_FAILED)
+        return false;
+    auto header = static_cast<const segment_header*>(addr);
+    auto state = __atomic_load_n(&header->state, __ATOMIC_ACQUIRE);
+    bool stale;
+    if(header->magic != segment_magic)
+        stale = true;
+    else if(state != 0)
+        stale = state != epoch;
+    else
+        stale = kill(static_cast<pid_t>(header->pid), 0) != 0 &&
+                errno == ESRCH;
+    munmap(addr, sizeof(segment_header));
+    return stale;
+}
+
+} // namespace
+
+namespace gkfs::utils {
+
+HostSegment::HostSegment(const string& hostfile, const string& hostconfigfile)
+    : hostfile_(absolute_path(hostfile)),
+      hostconfigfile_(absolute_path(hostconfigfile)) {
+    // the terminating null separates both paths
+    auto hash = fnv1a(hostfile_.c_str(), hostfile_.size() + 1);
+    hash = fnv1a(hostconfigfile_.c_str(), hostconfigfile_.size() + 1, hash);
+    char name[64];
+    snprintf(name, sizeof(name), "/gkfs-hosts-%u-%016llx",
+             static_cast<unsigned>(getuid()),
+             static_cast<unsigned long long>(hash));
+    name_ = name;
+}
+
+const string&
+HostSegment::name() const {
+    return name_;
+}
+
+uint64_t
+HostSegment::epoch() const {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(const auto& path : {hostfile_, hostconfigfile_}) {
+        struct stat st {};
+        if(stat(path.c_str(), &st) != 0)
+            return 0;
+        uint64_t identity[] = {static_cast<uint64_t>(st.st_dev),
+                               static_cast<uint64_t>(st.st_ino),
+                               static_cast<uint64_t>(st.st_size),
+                               static_cast<uint64_t>(st.st_mtim.tv_sec),
+                               static_cast<uint64_t>(st.st_mtim.tv_nsec)};
+        hash = fnv1a(identity, sizeof(identity), hash);
+    }
+    // 0 marks a segment that is being written
+    return hash ? hash : 1;
+}
+
+optional<HostTable>
+HostSegment::load(uint64_t epoch) const {
+    if(epoch == 0)
+        return {};
+    auto fd = shm_open(name_.c_str(), O_RDONLY, 0);
+    if(fd < 0)
+        return {};
+    struct stat st {};
+    if(fstat(fd, &st) != 0 ||
+       static_cast<size_t>(st.st_size) < sizeof(segment_header)) {
+        close(fd);
+        return {};
+    }
+    auto size = static_cast<size_t>(st.st_size);
+    auto addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED)
+        return {};
+
+    optional<HostTable> table;
+    auto header = static_cast<const segment_header*>(addr);
+    auto payload = static_cast<const char*>(addr) + sizeof(segment_header);
+    if(header->magic == segment_magic &&
+       __atomic_load_n(&header->state, __ATOMIC_ACQUIRE) == epoch &&
+       header->length <= size - sizeof(segment_header) &&
+       fnv1a(payload, header->length) == header->checksum) {
+        table = deserialize(payload, header->length);
+    }
+    munmap(addr, size);
+    return table;
+}
+
+bool
+HostSegment::publish(uint64_t epoch, const HostTable& table) const {
+    if(epoch == 0)
+        return false;
+    auto fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(fd < 0 && errno == EEXIST) {
+        auto old_fd = shm_open(name_.c_str(), O_RDONLY, 0);
+        if(old_fd < 0)
+            return false;
+        auto stale = is_stale(old_fd, epoch);
+        close(old_fd);
+        if(!stale)
+            return false;
+        // if another process replaces it at the same time, one of us fails
+        // to create the new segment and leaves it to the other
+        shm_unlink(name_.c_str());
+        fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if(fd < 0)
+        return false;
+
+    auto payload = serialize(table);
+    auto size = sizeof(segment_header) + payload.size();
+    if(ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        shm_unlink(name_.c_str());
+        return false;
+    }
+    auto addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED) {
+        shm_unlink(name_.c_str());
+        return false;
+    }
+    auto header = static_cast<segment_header*>(addr);
+    header->magic = segment_magic;
+    header->pid = static_cast<uint64_t>(getpid());
+    header->length = payload.size();
+    header->checksum = fnv1a(payload.data(), payload.size());
+    memcpy(static_cast<char*>(addr) + sizeof(segment_header), payload.data(),
+           payload.size());
+    __atomic_store_n(&header->state, epoch, __ATOMIC_RELEASE);
+    munmap(addr, size);
+    return true;
+}
+
+void
+HostSegment::remove() const {
+    shm_unlink(name_.c_str());
+}
+
+} // namespace gkfs::utils
@@ -30,7 +30,9 @@
 #include <client/intercept.hpp>
 #include <client/preload.hpp>
 #include <client/hooks.hpp>
+#include <client/capture.hpp>
 #include <client/logging.hpp>
+#include <client/rpc/registration_cache.hpp>
 
 #include <optional>
 #include <fmt/format.h>
@@ -41,6 +43,7 @@ extern "C" {
 #include <syscall.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/mman.h>
 #include <printf.h>
 }
 
@@ -65,6 +68,53 @@ get_current_syscall_info() {
 }
 
 
+/*
+ * invalidate_registrations -- drops cached RMA registrations of application
+ * buffers whose pages are unmapped or replaced by the given syscall. The
+ * syscall itself is still forwarded to the kernel.
+ */
+inline void
+invalidate_registrations(long syscall_number, long arg0, long arg1, long arg2,
+                         long arg3) {
+
+    auto reg_cache = CTX->reg_cache();
+    if(!reg_cache)
+        return;
+
+    size_t size = 0;
+    switch(syscall_number) {
+        case SYS_munmap:
+        case SYS_mremap:
+            size = static_cast<size_t>(arg1);
+            break;
+        case SYS_mmap:
+            if(arg3 & MAP_FIXED)
+                size = static_cast<size_t>(arg1);
+            break;
+        case SYS_madvise:
+            if(arg2 == MADV_DONTNEED || arg2 == MADV_REMOVE
+#ifdef MADV_FREE
+               || arg2 == MADV_FREE
+#endif
+            )
+                size = static_cast<size_t>(arg1);
+            break;
+        case SYS_brk: {
+            // shrinking the heap releases [new break, current break)
+            auto cur_brk = syscall_no_intercept_wrapper(SYS_brk, 0);
+            if(arg0 != 0 && arg0 < cur_brk)
+                size = static_cast<size_t>(cur_brk - arg0);
+            break;
+        }
+        default:
+            break;
+    }
+
+    if(size > 0 && reg_cache->invalidate(reinterpret_cast<void*>(arg0), size))
+        LOG(DEBUG, "Dropped buffer registrations in [{:#x}, {:#x})", arg0,
+            arg0 + static_cast<long>(size));
+}
+
 /*
  * hook_internal -- interception hook for internal syscalls
  *
@@ -428,6 +478,9 @@ hook(long syscall_number, long arg0, long arg1, long arg2, long arg3, long arg4,
                 gkfs::syscall::not_executed,
         syscall_number, args);
 
+    auto capture_call = gkfs::capture::begin(syscall_number, arg0, arg1, arg2,
+                                             arg3, arg4);
+
     switch(syscall_number) {
 
         case SYS_execve:
@@ -767,6 +820,17 @@ hook(long syscall_number, long arg0, long arg1, long arg2, long arg3, long arg4,
                     reinterpret_cast<void*>(arg2), static_cast<size_t>(arg4));
             break;
 
+        case SYS_munmap:
+        case SYS_mremap:
+        case SYS_mmap:
+        case SYS_madvise:
+        case SYS_brk:
+            invalidate_registrations(syscall_number, arg0, arg1, arg2, arg3);
+            ::save_current_syscall_info(gkfs::syscall::from_external_code |
+                                        gkfs::syscall::to_kernel |
+                                        gkfs::syscall::not_executed);
+            return gkfs::syscall::forward_to_kernel;
+
         default:
             // ignore any other syscalls, i.e.: pass them on to the kernel
             // (syscalls forwarded to the kernel that return are logged in
@@ -777,6 +841,8 @@ hook(long syscall_number, long arg0, long arg1, long arg2, long arg3, long arg4,
             return gkfs::syscall::forward_to_kernel;
     }
 
+    gkfs::capture::end(capture_call, *result);
+
     LOG(SYSCALL,
         gkfs::syscall::from_external_code | gkfs::syscall::to_hook |
                 gkfs::syscall::executed,
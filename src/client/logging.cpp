@@ -30,7 +30,14 @@
 #include <client/logging.hpp>
 #include <client/env.hpp>
 #include <client/make_array.hpp>
+#include <client/log_ring.hpp>
+#include <config.hpp>
+
+#include <mutex>
 #include <regex>
+#include <vector>
+
+#include <pthread.h>
 
 extern "C" {
 #include <date/tz.h>
@@ -75,8 +82,303 @@ split_str(const std::string& input, const std::string_view delimiter,
 }
 } // namespace
 
+namespace {
+
+// Set while a thread stores a record in its ring so that syscalls issued in
+// the process (e.g. clock_gettime() without vDSO) are not logged again
+thread_local bool in_async_logger = false;
+// Set in the flusher thread, which must never log itself
+thread_local bool is_flusher = false;
+thread_local uint32_t cached_tid = 0;
+
+uint32_t
+thread_id() {
+    if(cached_tid == 0) {
+        cached_tid = static_cast<uint32_t>(::syscall_no_intercept(SYS_gettid));
+    }
+    return cached_tid;
+}
+
+uint64_t
+now_ns() {
+    struct ::timespec ts {};
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull +
+           static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * Payload of a syscall record. The cstr arguments that existed when the
+ * syscall was logged are copied after it as null-terminated strings, since
+ * the memory they point to may be gone when the record is written out.
+ */
+struct syscall_record {
+    int32_t info;
+    uint16_t has_result;
+    uint16_t string_args; // bitmask of args copied after the record
+    int64_t number;
+    int64_t args[gkfs::syscall::MAX_ARGS];
+    int64_t result;
+};
+
+constexpr std::size_t max_string_arg = 1024;
+
+/**
+ * A log ring and whether a thread currently writes to it. Rings are handed
+ * over to new threads once their owner thread exits.
+ */
+struct ring_slot {
+    gkfs::log::ring_buffer ring;
+    std::atomic<bool> in_use{true};
+
+    explicit ring_slot(std::size_t capacity) : ring(capacity) {}
+};
+
+/**
+ * The ring of the calling thread. The slot is shared so that the thread can
+ * release it on exit even if the writer is already gone.
+ */
+struct thread_ring {
+    const void* owner = nullptr;
+    std::shared_ptr<ring_slot> slot;
+
+    ~thread_ring() {
+        if(slot) {
+            slot->in_use.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local thread_ring current_ring;
+
+} // namespace
+
 namespace gkfs::log {
 
+struct logger::async_writer {
+
+    const int fd;
+    const date::time_zone* const timezone;
+    const std::size_t ring_size;
+    const long interval_ms;
+
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<ring_slot>> rings;
+
+    // serializes draining the rings and writing out the records
+    std::mutex flush_mutex;
+    fmt::memory_buffer out;
+
+    std::atomic<bool> running{false};
+    pthread_t flusher{};
+
+    async_writer(int fd, const date::time_zone* timezone, std::size_t ring_size,
+                 long interval_ms)
+        : fd(fd), timezone(timezone), ring_size(ring_size),
+          interval_ms(interval_ms) {}
+
+    ring_buffer*
+    ring() {
+        if(current_ring.owner == this) {
+            return &current_ring.slot->ring;
+        }
+
+        std::shared_ptr<ring_slot> slot;
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            for(const auto& r : rings) {
+                bool expected = false;
+                if(r->in_use.compare_exchange_strong(expected, true)) {
+                    slot = r;
+                    break;
+                }
+            }
+            if(!slot) {
+                slot = std::make_shared<ring_slot>(ring_size);
+                rings.push_back(slot);
+            }
+        }
+
+        if(current_ring.slot) {
+            current_ring.slot->in_use.store(false, std::memory_order_release);
+        }
+        current_ring.owner = this;
+        current_ring.slot = std::move(slot);
+        return &current_ring.slot->ring;
+    }
+
+    void
+    render(const record_header& header, const char* payload) {
+
+        date::sys_time<std::chrono::microseconds> ts{
+                std::chrono::microseconds{header.timestamp / 1000}};
+        detail::format_timestamp_to(out, ts, timezone);
+
+        if(header.kind == record_kind::message) {
+            fmt::format_to(out, "[{}] [{}] ", header.tid,
+                           lookup_level_name(
+                                   static_cast<log_level>(header.level)));
+            out.append(payload, payload + header.length);
+            fmt::format_to(out, "\n");
+            return;
+        }
+
+        syscall_record rec;
+        std::memcpy(&rec, payload, sizeof(rec));
+
+        long args[syscall::MAX_ARGS];
+        const char* str = payload + sizeof(rec);
+        for(auto i = 0u; i < syscall::MAX_ARGS; ++i) {
+            args[i] = rec.args[i];
+            if(rec.string_args & (1u << i)) {
+                args[i] = reinterpret_cast<long>(str);
+                str += std::strlen(str) + 1;
+            }
+        }
+
+        detail::format_syscall_info_to(out, static_cast<syscall::info>(rec.info),
+                                       header.tid);
+        if(rec.has_result) {
+            syscall::decode(out, rec.number, args, rec.result);
+        } else {
+            syscall::decode(out, rec.number, args);
+        }
+        fmt::format_to(out, "\n");
+    }
+
+    void
+    write_out() {
+        std::size_t n = 0;
+        while(n < out.size()) {
+            const auto rv = ::syscall_no_intercept(SYS_write, fd,
+                                                   out.data() + n,
+                                                   out.size() - n);
+            if(::syscall_error_code(rv) != 0 || rv == 0) {
+                break;
+            }
+            n += rv;
+        }
+        out.clear();
+    }
+
+    void
+    flush() {
+        std::lock_guard<std::mutex> flush_lock(flush_mutex);
+
+        std::vector<std::shared_ptr<ring_slot>> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            snapshot = rings;
+        }
+
+        for(const auto& r : snapshot) {
+            r->ring.consume([this](const record_header& header,
+                                   const char* payload) {
+                render(header, payload);
+                if(out.size() > 64 * 1024) {
+                    write_out();
+                }
+            });
+
+            if(const auto dropped = r->ring.take_dropped()) {
+                detail::format_timestamp_to(
+                        out,
+                        date::sys_time<std::chrono::microseconds>{
+                                std::chrono::microseconds{now_ns() / 1000}},
+                        timezone);
+                fmt::format_to(out,
+                               "[flusher] [warning] log ring full: {} records "
+                               "dropped\n",
+                               dropped);
+            }
+        }
+
+        write_out();
+    }
+
+    static void*
+    flusher_main(void* arg) {
+        is_flusher = true;
+        auto* self = static_cast<async_writer*>(arg);
+        const struct ::timespec interval {
+            self->interval_ms / 1000, (self->interval_ms % 1000) * 1000000
+        };
+
+        while(self->running.load(std::memory_order_acquire)) {
+            ::syscall_no_intercept(SYS_nanosleep, &interval, nullptr);
+            self->flush();
+        }
+        return nullptr;
+    }
+
+    void
+    start() {
+        running.store(true, std::memory_order_release);
+        if(::pthread_create(&flusher, nullptr, flusher_main, this) != 0) {
+            running.store(false, std::memory_order_release);
+        }
+    }
+
+    void
+    stop() {
+        if(running.exchange(false)) {
+            ::pthread_join(flusher, nullptr);
+        }
+        flush();
+    }
+
+    // fork() only duplicates the calling thread: keep the locks consistent
+    // while forking and start a new flusher in the child, whose rings only
+    // contain records that the parent writes out itself
+    static void
+    prepare_fork() {
+        auto* self = writer();
+        if(!self) {
+            return;
+        }
+        // make sure the forking thread has a ring, as acquiring one in the
+        // child (e.g. to log the return of clone()) must not block
+        self->ring();
+        self->flush_mutex.lock();
+        self->rings_mutex.lock();
+    }
+
+    static void
+    parent_after_fork() {
+        if(auto* self = writer()) {
+            self->rings_mutex.unlock();
+            self->flush_mutex.unlock();
+        }
+    }
+
+    static void
+    child_after_fork() {
+        cached_tid = 0;
+        auto* self = writer();
+        if(!self) {
+            return;
+        }
+        for(const auto& r : self->rings) {
+            r->ring.reset();
+            if(r != current_ring.slot) {
+                r->in_use.store(false, std::memory_order_relaxed);
+            }
+        }
+        self->out.clear();
+        self->rings_mutex.unlock();
+        self->flush_mutex.unlock();
+        if(self->running.load()) {
+            self->start();
+        }
+    }
+
+    static async_writer*
+    writer() {
+        const auto& logger = get_global_logger();
+        return logger ? logger->async_.get() : nullptr;
+    }
+};
+
 struct opt_info {
     const char name_[32];
     const std::size_t length_;
@@ -280,7 +582,8 @@ process_log_filter(const std::string& log_filter) {
 
 #endif // GKFS_DEBUG_BUILD
 
-logger::logger(const std::string& opts, const std::string& path, bool trunc
+logger::logger(const std::string& opts, const std::string& path, bool trunc,
+               bool async
 #ifdef GKFS_DEBUG_BUILD
                ,
                const std::string& filter, int verbosity
@@ -349,6 +652,20 @@ logger::logger(const std::string& opts, const std::string& path, bool trunc
         timezone_ = nullptr;
     }
 
+    if(async) {
+        async_ = std::make_shared<async_writer>(
+                log_fd_, timezone_, gkfs::config::log::client_log_ring_size,
+                gkfs::config::log::client_log_flush_interval);
+        async_->start();
+
+        static std::once_flag atfork_flag;
+        std::call_once(atfork_flag, [] {
+            ::pthread_atfork(async_writer::prepare_fork,
+                             async_writer::parent_after_fork,
+                             async_writer::child_after_fork);
+        });
+    }
+
 #ifdef GKFS_ENABLE_LOGGING
     const auto log_hermes_message =
             [](const std::string& msg, hermes::log::level l, int severity,
@@ -427,9 +744,41 @@ logger::logger(const std::string& opts, const std::string& path, bool trunc
 }
 
 logger::~logger() {
+    if(async_) {
+        async_->stop();
+    }
     log_fd_ = ::syscall_no_intercept(SYS_close, log_fd_);
 }
 
+void
+logger::enqueue_message(log_level level, const char* msg,
+                        std::size_t length) {
+
+    if(is_flusher || in_async_logger) {
+        return;
+    }
+    in_async_logger = true;
+
+    auto* ring = async_->ring();
+    if(auto* header = ring->reserve(length)) {
+        header->kind = record_kind::message;
+        header->level = static_cast<uint16_t>(level);
+        header->tid = thread_id();
+        header->timestamp = now_ns();
+        std::memcpy(header + 1, msg, length);
+        ring->commit(header);
+    }
+
+    in_async_logger = false;
+}
+
+void
+logger::flush() {
+    if(async_) {
+        async_->flush();
+    }
+}
+
 void
 logger::log_syscall(syscall::info info, const long syscall_number,
                     const long args[6], std::optional<long> result) {
@@ -476,6 +825,64 @@ logger::log_syscall(syscall::info info, const long syscall_number,
 
 print_syscall:
 
+    if(async_) {
+        if(is_flusher || in_async_logger) {
+            return;
+        }
+        in_async_logger = true;
+
+        syscall_record rec{};
+        rec.info = static_cast<int32_t>(info);
+        rec.number = syscall_number;
+        rec.has_result = result.has_value();
+        rec.result = result.value_or(0);
+        std::copy(args, args + syscall::MAX_ARGS, rec.args);
+
+        // copy the strings passed to the syscall
+        std::size_t lengths[syscall::MAX_ARGS] = {};
+        std::size_t length = sizeof(rec);
+        const auto sc = syscall::lookup_by_number(syscall_number, args);
+        for(int i = 0; i < sc.num_args(); ++i) {
+            if(sc.args()[i].type() != syscall::arg::cstr || args[i] == 0) {
+                continue;
+            }
+            const auto* str = reinterpret_cast<const char*>(args[i]);
+            lengths[i] = ::strnlen(str, max_string_arg);
+            rec.string_args |= 1u << i;
+            length += lengths[i] + 1;
+        }
+
+        auto* ring = async_->ring();
+        if(auto* header = ring->reserve(length)) {
+            header->kind = record_kind::syscall;
+            header->tid = thread_id();
+            header->timestamp = now_ns();
+            auto* p = reinterpret_cast<char*>(header + 1);
+            std::memcpy(p, &rec, sizeof(rec));
+            p += sizeof(rec);
+            for(auto i = 0u; i < syscall::MAX_ARGS; ++i) {
+                if(rec.string_args & (1u << i)) {
+                    std::memcpy(p, reinterpret_cast<const char*>(args[i]),
+                                lengths[i]);
+                    p[lengths[i]] = '\0';
+                    p += lengths[i] + 1;
+                }
+            }
+            ring->commit(header);
+        }
+
+        in_async_logger = false;
+
+        // the process may be gone before the flusher runs again
+        if(syscall::may_not_return(syscall_number) ||
+           syscall::never_returns(syscall_number)) {
+            in_async_logger = true;
+            async_->flush();
+            in_async_logger = false;
+        }
+        return;
+    }
+
     static_buffer buffer;
 
     detail::format_timestamp_to(buffer, timezone_);
@@ -33,6 +33,9 @@
 #include <client/preload_util.hpp>
 #include <client/logging.hpp>
 
+#include <limits>
+#include <thread>
+
 extern "C" {
 #include <fcntl.h>
 }
@@ -45,23 +48,21 @@ OpenFile::OpenFile(const string& path, const int flags, FileType type)
     : type_(type), path_(path) {
     // set flags to OpenFile
     if(flags & O_CREAT)
-        flags_[gkfs::utils::to_underlying(OpenFile_flags::creat)] = true;
+        set_flag(OpenFile_flags::creat, true);
     if(flags & O_APPEND)
-        flags_[gkfs::utils::to_underlying(OpenFile_flags::append)] = true;
+        set_flag(OpenFile_flags::append, true);
     if(flags & O_TRUNC)
-        flags_[gkfs::utils::to_underlying(OpenFile_flags::trunc)] = true;
+        set_flag(OpenFile_flags::trunc, true);
     if(flags & O_RDONLY)
-        flags_[gkfs::utils::to_underlying(OpenFile_flags::rdonly)] = true;
+        set_flag(OpenFile_flags::rdonly, true);
     if(flags & O_WRONLY)
-        flags_[gkfs::utils::to_underlying(OpenFile_flags::wronly)] = true;
+        set_flag(OpenFile_flags::wronly, true);
     if(flags & O_RDWR)
-        flags_[gkfs::utils::to_underlying(OpenFile_flags::rdwr)] = true;
+        set_flag(OpenFile_flags::rdwr, true);
 
     pos_ = 0; // If O_APPEND flag is used, it will be used before each write.
 }
 
-OpenFileMap::OpenFileMap() : fd_idx(10000), fd_validation_needed(false) {}
-
 string
 OpenFile::path() const {
     return path_;
@@ -74,26 +75,24 @@ OpenFile::path(const string& path) {
 
 unsigned long
 OpenFile::pos() {
-    lock_guard<mutex> lock(pos_mutex_);
-    return pos_;
+    return pos_.load(memory_order_acquire);
 }
 
 void
 OpenFile::pos(unsigned long pos) {
-    lock_guard<mutex> lock(pos_mutex_);
-    OpenFile::pos_ = pos;
+    pos_.store(pos, memory_order_release);
 }
 
 bool
 OpenFile::get_flag(OpenFile_flags flag) {
-    lock_guard<mutex> lock(pos_mutex_);
-    return flags_[gkfs::utils::to_underlying(flag)];
+    return flags_[gkfs::utils::to_underlying(flag)].load(
+            memory_order_acquire);
 }
 
 void
 OpenFile::set_flag(OpenFile_flags flag, bool value) {
-    lock_guard<mutex> lock(flag_mutex_);
-    flags_[gkfs::utils::to_underlying(flag)] = value;
+    flags_[gkfs::utils::to_underlying(flag)].store(value,
+                                                   memory_order_release);
 }
 
 FileType
@@ -103,11 +102,90 @@ OpenFile::type() const {
 
 // OpenFileMap starts here
 
+OpenFileMap::OpenFileMap(size_t table_size)
+    : table_size_((table_size + 63) / 64 * 64),
+      slots_(new shared_ptr<OpenFile>[table_size_]),
+      used_(new atomic<uint64_t>[table_size_ / 64]), next_slot_(0),
+      overflow_size_(0),
+      overflow_fd_idx_(fd_base + static_cast<int>(table_size_)) {
+    for(size_t i = 0; i < table_size_ / 64; i++)
+        used_[i].store(0, memory_order_relaxed);
+}
+
+bool
+OpenFileMap::in_table(const int fd) const {
+    return fd >= fd_base && static_cast<size_t>(fd - fd_base) < table_size_;
+}
+
+bool
+OpenFileMap::slot_used(const size_t slot) const {
+    return (used_[slot / 64].load(memory_order_acquire) >> (slot % 64)) & 1;
+}
+
+/**
+ * Claims the next free slot after the last claimed one
+ * @return slot index, or table_size_ if the table is full
+ */
+size_t
+OpenFileMap::claim_slot() {
+    auto words = table_size_ / 64;
+    auto start = next_slot_.load(memory_order_relaxed) % table_size_;
+    auto start_word = start / 64;
+    auto start_mask = ~uint64_t(0) << (start % 64);
+    // the start word is visited twice: from the start slot upwards first and
+    // its lower slots last
+    for(size_t n = 0; n <= words; n++) {
+        auto w = (start_word + n) % words;
+        auto mask = n == 0       ? start_mask
+                    : n == words ? ~start_mask
+                                 : ~uint64_t(0);
+        auto word = used_[w].load(memory_order_relaxed);
+        uint64_t free;
+        while((free = ~word & mask) != 0) {
+            auto bit = static_cast<size_t>(__builtin_ctzll(free));
+            if(used_[w].compare_exchange_weak(word, word | (uint64_t(1) << bit),
+                                              memory_order_acq_rel,
+                                              memory_order_relaxed)) {
+                auto slot = w * 64 + bit;
+                next_slot_.store(slot + 1, memory_order_relaxed);
+                return slot;
+            }
+        }
+    }
+    return table_size_;
+}
+
+int
+OpenFileMap::add_overflow(std::shared_ptr<OpenFile> open_file) {
+    lock_guard<mutex> lock(overflow_mutex_);
+    int fd;
+    // skip fds that are still in use after the index wrapped around
+    do {
+        if(overflow_fd_idx_ == numeric_limits<int>::max()) {
+            LOG(WARNING, "File descriptor index exceeded ints max value. "
+                         "Setting it back to the end of the fd table");
+            overflow_fd_idx_ = fd_base + static_cast<int>(table_size_);
+        }
+        fd = overflow_fd_idx_++;
+    } while(overflow_.count(fd) != 0);
+    overflow_.emplace(fd, move(open_file));
+    overflow_size_.store(overflow_.size(), memory_order_release);
+    return fd;
+}
+
 shared_ptr<OpenFile>
 OpenFileMap::get(int fd) {
-    lock_guard<recursive_mutex> lock(files_mutex_);
-    auto f = files_.find(fd);
-    if(f == files_.end()) {
+    if(in_table(fd)) {
+        auto slot = static_cast<size_t>(fd - fd_base);
+        if(!slot_used(slot))
+            return nullptr;
+        return atomic_load_explicit(&slots_[slot], memory_order_acquire);
+    }
+    if(overflow_size_.load(memory_order_acquire) == 0)
+        return nullptr;
+    lock_guard<mutex> lock(overflow_mutex_);
+    auto f = overflow_.find(fd);
+    if(f == overflow_.end()) {
         return nullptr;
     } else {
         return f->second;
@@ -125,72 +203,71 @@ OpenFileMap::get_dir(int dirfd) {
 
 bool
 OpenFileMap::exist(const int fd) {
-    lock_guard<recursive_mutex> lock(files_mutex_);
-    auto f = files_.find(fd);
-    return !(f == files_.end());
+    if(in_table(fd))
+        return slot_used(static_cast<size_t>(fd - fd_base));
+    if(overflow_size_.load(memory_order_acquire) == 0)
+        return false;
+    lock_guard<mutex> lock(overflow_mutex_);
+    return overflow_.count(fd) != 0;
 }
 
-int
-OpenFileMap::safe_generate_fd_idx_() {
-    auto fd = generate_fd_idx();
-    /*
-     * Check if fd is still in use and generate another if yes
-     * Note that this can only happen once the all fd indices within the int has
-     * been used to the int::max Once this limit is exceeded, we set fd_idx back
-     * to 3 and begin anew. Only then, if a file was open for a long time will
-     * we have to generate another index.
-     *
-     * This situation can only occur when all fd indices have been given away
-     * once and we start again, in which case the fd_validation_needed flag is
-     * set. fd_validation is set to false, if
-     */
-    if(fd_validation_needed) {
-        while(exist(fd)) {
-            fd = generate_fd_idx();
-        }
-    }
-    return fd;
+/**
+ * Claims a given slot
+ * @return true if the slot was not claimed before
+ */
+bool
+OpenFileMap::claim(const size_t slot) {
+    auto bit = uint64_t(1) << (slot % 64);
+    return (used_[slot / 64].fetch_or(bit, memory_order_acq_rel) & bit) == 0;
 }
 
 int
 OpenFileMap::add(std::shared_ptr<OpenFile> open_file) {
-    auto fd = safe_generate_fd_idx_();
-    lock_guard<recursive_mutex> lock(files_mutex_);
-    files_.insert(make_pair(fd, open_file));
-    return fd;
+    auto slot = claim_slot();
+    if(slot == table_size_) {
+        LOG(DEBUG, "fd table full, using overflow map");
+        return add_overflow(move(open_file));
+    }
+    // the slot is empty as only the owner of a new claim fills an empty slot
+    atomic_store_explicit(&slots_[slot], move(open_file),
+                          memory_order_release);
+    return fd_base + static_cast<int>(slot);
 }
 
 bool
 OpenFileMap::remove(const int fd) {
-    lock_guard<recursive_mutex> lock(files_mutex_);
-    auto f = files_.find(fd);
-    if(f == files_.end()) {
-        return false;
+    if(in_table(fd)) {
+        auto slot = static_cast<size_t>(fd - fd_base);
+        // whoever takes the file out of the slot frees it and its claim. The
+        // slot stays empty until it is claimed again, so no file is lost.
+        auto old = atomic_exchange_explicit(
+                &slots_[slot], shared_ptr<OpenFile>{}, memory_order_acq_rel);
+        if(old == nullptr)
+            return false;
+        used_[slot / 64].fetch_and(~(uint64_t(1) << (slot % 64)),
+                                   memory_order_release);
+        return true;
     }
-    files_.erase(fd);
-    if(fd_validation_needed && files_.empty()) {
-        fd_validation_needed = false;
-        LOG(DEBUG, "fd_validation flag reset");
+    lock_guard<mutex> lock(overflow_mutex_);
+    if(overflow_.erase(fd) == 0) {
+        return false;
     }
+    overflow_size_.store(overflow_.size(), memory_order_release);
     return true;
 }
 
 int
 OpenFileMap::dup(const int oldfd) {
-    lock_guard<recursive_mutex> lock(files_mutex_);
     auto open_file = get(oldfd);
     if(open_file == nullptr) {
         errno = EBADF;
         return -1;
     }
-    auto newfd = safe_generate_fd_idx_();
-    files_.insert(make_pair(newfd, open_file));
-    return newfd;
+    return add(open_file);
 }
 
 int
 OpenFileMap::dup2(const int oldfd, const int newfd) {
-    lock_guard<recursive_mutex> lock(files_mutex_);
     auto open_file = get(oldfd);
     if(open_file == nullptr) {
         errno = EBADF;
@@ -198,45 +275,34 @@ OpenFileMap::dup2(const int oldfd, const int newfd) {
     }
     if(oldfd == newfd)
         return newfd;
-    // remove newfd if exists in filemap silently
-    if(exist(newfd)) {
-        remove(newfd);
+    // replace newfd silently if it exists in the filemap
+    if(in_table(newfd)) {
+        auto slot = static_cast<size_t>(newfd - fd_base);
+        for(;;) {
+            auto current =
+                    atomic_load_explicit(&slots_[slot], memory_order_acquire);
+            if(current != nullptr) {
+                // replace the open file. Fails if it was removed meanwhile.
+                if(atomic_compare_exchange_strong_explicit(
+                           &slots_[slot], &current, open_file,
+                           memory_order_acq_rel, memory_order_acquire))
+                    return newfd;
+                continue;
+            }
+            // an empty slot may only be filled with a new claim
+            if(claim(slot)) {
+                atomic_store_explicit(&slots_[slot], open_file,
+                                      memory_order_release);
+                return newfd;
+            }
+            // the slot is being filled by add() or freed by remove()
+            this_thread::yield();
+        }
     }
-    // to prevent duplicate fd idx in the future. First three fd are reservered
-    // by os streams that we do not overwrite
-    if(get_fd_idx() < newfd && newfd != 0 && newfd != 1 && newfd != 2)
-        fd_validation_needed = true;
-    files_.insert(make_pair(newfd, open_file));
+    lock_guard<mutex> lock(overflow_mutex_);
+    overflow_[newfd] = open_file;
+    overflow_size_.store(overflow_.size(), memory_order_release);
     return newfd;
 }
 
-/**
- * Generate new file descriptor index to be used as an fd within one process
- * @return fd_idx
- */
-int
-OpenFileMap::generate_fd_idx() {
-    // We need a mutex here for thread safety
-    std::lock_guard<std::mutex> inode_lock(fd_idx_mutex);
-    if(fd_idx == std::numeric_limits<int>::max()) {
-        LOG(WARNING,
-            "File descriptor index exceeded ints max value. Setting it back to 100000");
-        /*
-         * Setting fd_idx back to 3 could have the effect that fd are given
-         * twice for different path. This must not happen. Instead a flag is set
-         * which tells can tell the OpenFileMap that it should check if this fd
-         * is really safe to use.
-         */
-        fd_idx = 100000;
-        fd_validation_needed = true;
-    }
-    return fd_idx++;
-}
-
-int
-OpenFileMap::get_fd_idx() {
-    std::lock_guard<std::mutex> inode_lock(fd_idx_mutex);
-    return fd_idx;
-}
-
-} // namespace gkfs::filemap
\ No newline at end of file
+} // namespace gkfs::filemap
@@ -28,6 +28,7 @@
 */
 
 #include <client/path.hpp>
+#include <client/path_cache.hpp>
 #include <client/preload.hpp>
 #include <client/logging.hpp>
 #include <client/env.hpp>
@@ -50,6 +51,46 @@ namespace gkfs::path {
 
 static const string excluded_paths[2] = {"sys/", "proc/"};
 
+namespace {
+
+/**
+ * Returns true if an absolute path has no empty, "." or ".." components and
+ * no trailing separator. Such a path is canonical unless one of its components
+ * is a symbolic link.
+ */
+bool
+is_normalized(const string& path) {
+    if(path.size() < 2 || path.back() == path::separator)
+        return false;
+    for(string::size_type pos = 0; pos < path.size(); ++pos) {
+        if(path[pos] != path::separator)
+            continue;
+        auto next = pos + 1;
+        if(path[next] == path::separator)
+            return false;
+        if(path[next] == '.') {
+            // skip "." or ".." and check that the component ends there
+            if(next + 1 < path.size() && path[next + 1] == '.')
+                ++next;
+            if(next + 1 == path.size() || path[next + 1] == path::separator)
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns true if `path` is `mountdir` or lies below it.
+ */
+bool
+has_mountdir_prefix(const string& path, const string& mountdir) {
+    return path.compare(0, mountdir.size(), mountdir) == 0 &&
+           (path.size() == mountdir.size() ||
+            path[mountdir.size()] == path::separator);
+}
+
+} // namespace
+
 /** Match components in path
  *
  * Returns the number of consecutive components at start of `path`
@@ -123,6 +164,32 @@ resolve(const string& path, string& resolved, bool resolve_last_link) {
         }
     }
 
+    const auto& cache = CTX->path_cache();
+    auto generation = CTX->cwd_generation();
+
+    /*
+     * Fast paths that need neither allocations nor system calls. Components
+     * below the mountdir are never looked up, so a normalized path with the
+     * mountdir as prefix is internal. A normalized path that the cache knows
+     * is canonical (i.e., has no links) and that is not below the mountdir is
+     * external.
+     */
+    if(is_normalized(path)) {
+        if(has_mountdir_prefix(path, CTX->mountdir())) {
+            resolved = path;
+            resolved.erase(1, CTX->mountdir().size());
+            LOG(DEBUG, "internal: \"{}\"", resolved);
+            return true;
+        }
+        PathCache::kind type;
+        if(cache && cache->lookup(path, generation, type) &&
+           type != PathCache::kind::link) {
+            resolved = path;
+            LOG(DEBUG, "external (cached): \"{}\"", resolved);
+            return false;
+        }
+    }
+
     struct stat st {};
     const ::vector<string>& mnt_components = CTX->mountdir_components();
     unsigned int matched_components =
@@ -192,36 +259,55 @@ resolve(const string& path, string& resolved, bool resolve_last_link) {
                             mnt_components.at(matched_components)) == 0) {
                 ++matched_components;
             }
-            if(lstat(resolved.c_str(), &st) < 0) {
+            PathCache::kind type;
+            string link_target;
+            bool cached = cache && cache->lookup(resolved, generation, type,
+                                                 &link_target);
+            if(!cached) {
+                if(lstat(resolved.c_str(), &st) < 0) {
 
-                LOG(DEBUG, "path \"{}\" does not exist", resolved);
+                    LOG(DEBUG, "path \"{}\" does not exist", resolved);
 
-                resolved.append(path, end, string::npos);
-                return false;
+                    resolved.append(path, end, string::npos);
+                    return false;
+                }
+                type = S_ISLNK(st.st_mode)   ? PathCache::kind::link
+                       : S_ISDIR(st.st_mode) ? PathCache::kind::directory
+                                             : PathCache::kind::other;
+                if(cache && type != PathCache::kind::link)
+                    cache->insert(resolved, generation, type);
             }
-            if(S_ISLNK(st.st_mode)) {
+            if(type == PathCache::kind::link) {
                 if(!resolve_last_link && end == path.size()) {
                     continue;
                 }
-                auto link_resolved = ::unique_ptr<char[]>(new char[PATH_MAX]);
-                if(realpath(resolved.c_str(), link_resolved.get()) == nullptr) {
-
-                    LOG(ERROR,
-                        "Failed to get realpath for link \"{}\". "
-                        "Error: {}",
-                        resolved, ::strerror(errno));
-
-                    resolved.append(path, end, string::npos);
-                    return false;
+                if(!cached) {
+                    auto link_resolved =
+                            ::unique_ptr<char[]>(new char[PATH_MAX]);
+                    if(realpath(resolved.c_str(), link_resolved.get()) ==
+                       nullptr) {
+
+                        LOG(ERROR,
+                            "Failed to get realpath for link \"{}\". "
+                            "Error: {}",
+                            resolved, ::strerror(errno));
+
+                        resolved.append(path, end, string::npos);
+                        return false;
+                    }
+                    link_target = link_resolved.get();
+                    if(cache)
+                        cache->insert(resolved, generation, type, link_target);
                 }
                 // substituute resolved with new link path
-                resolved = link_resolved.get();
+                resolved = link_target;
                 matched_components = match_components(
                         resolved, resolved_components, mnt_components);
                 // set matched counter to value coherent with the new path
                 last_slash_pos = resolved.find_last_of(path::separator);
                 continue;
-            } else if((!S_ISDIR(st.st_mode)) && (end != path.size())) {
+            } else if(type != PathCache::kind::directory &&
+                      end != path.size()) {
                 resolved.append(path, end, string::npos);
                 return false;
             }
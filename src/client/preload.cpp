@@ -33,11 +33,27 @@
 #include <client/rpc/forward_management.hpp>
 #include <client/preload_util.hpp>
 #include <client/intercept.hpp>
+#include <client/env.hpp>
+#include <client/rpc/forward_data.hpp>
+#include <client/rpc/registration_cache.hpp>
+#include <client/host_segment.hpp>
+#include <client/path_cache.hpp>
 
 #include <common/rpc/distributor.hpp>
+#include <common/rpc/placement.hpp>
+#include <common/env_util.hpp>
 #include <common/common_defs.hpp>
+#include <common/trace_util.hpp>
+#include <common/capture_util.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <optional>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <libsyscall_intercept_hook_point.h>
 
 #include <hermes.hpp>
 
@@ -219,24 +235,60 @@ init_environment() {
         exit_error_msg(EXIT_FAILURE,
                        "Failed to connect to hosts: "s + e.what());
     }
-    //向registry请求融合后
-    request_registry();
-
     vector<pair<string, string>> hosts{};
     pair<vector<unsigned int>,vector<unsigned int>> hosts_config{};
-    try {
-        LOG(INFO, "Loading peer addresses...");
-        hosts = gkfs::utils::read_hosts_file();//name , proto://url，此时已经把上下文rpc通信协议变量设置好了
-    } catch(const std::exception& e) {
-        exit_error_msg(EXIT_FAILURE,
-                       "Failed to load hosts addresses: "s + e.what());
-    }   
-    try {
-        LOG(INFO, "Loading system config...");
-        hosts_config = gkfs::utils::read_hosts_config_file();
-    } catch(const std::exception& e) {
-        exit_error_msg(EXIT_FAILURE,
-                       "Failed to load system config: "s + e.what());
+
+    /*
+     * The first process on a node publishes the parsed hosts files in a
+     * shared segment that later processes map instead. The segment only exists
+     * if both files exist, i.e., there is nothing left to request from the
+     * registry.
+     */
+    auto use_segment = gkfs::env::get_var(gkfs::env::HOST_SEGMENT,
+                                          gkfs::config::host_segment_default);
+    std::transform(use_segment.begin(), use_segment.end(), use_segment.begin(),
+                   ::tolower);
+    gkfs::utils::HostSegment segment(
+            gkfs::env::get_var(gkfs::env::HOSTS_FILE,
+                               gkfs::config::hostfile_path),
+            gkfs::env::get_var(gkfs::env::HOSTS_CONFIG_FILE,
+                               gkfs::config::hostfile_config_path));
+    optional<gkfs::utils::HostTable> shared_table{};
+    if(use_segment == "on")
+        shared_table = segment.load(segment.epoch());
+
+    if(shared_table) {
+        LOG(INFO, "Loaded {} hosts from shared segment '{}'",
+            shared_table->hosts.size(), segment.name());
+        hosts = std::move(shared_table->hosts);
+        hosts_config = {std::move(shared_table->fs_sizes),
+                        std::move(shared_table->priorities)};
+    } else {
+        //向registry请求融合后
+        request_registry();
+
+        auto epoch = segment.epoch();
+        try {
+            LOG(INFO, "Loading peer addresses...");
+            hosts = gkfs::utils::read_hosts_file();//name , proto://url，此时已经把上下文rpc通信协议变量设置好了
+        } catch(const std::exception& e) {
+            exit_error_msg(EXIT_FAILURE,
+                           "Failed to load hosts addresses: "s + e.what());
+        }
+        try {
+            LOG(INFO, "Loading system config...");
+            hosts_config = gkfs::utils::read_hosts_config_file();
+        } catch(const std::exception& e) {
+            exit_error_msg(EXIT_FAILURE,
+                           "Failed to load system config: "s + e.what());
+        }
+        // do not publish if the files changed while they were read
+        if(use_segment == "on" && epoch == segment.epoch() &&
+           segment.publish(epoch, {hosts, hosts_config.first,
+                                   hosts_config.second})) {
+            LOG(INFO, "Published hosts in shared segment '{}'",
+                segment.name());
+        }
     }
     CTX->hostsconfig(hosts_config.first);
     //std::cout<< "here to print hc" <<std::endl;
@@ -277,8 +329,111 @@ init_environment() {
             CTX->local_host_id(), CTX->hostsconfig(),&(CTX->pathfs()), CTX->local_fs_id());
 #endif
     CTX->distributor(distributor);
+
+    /* Setup placement policy for new files in federated mode */
+    if(CTX->hostsconfig().size() > 1) {
+        auto policy_name = gkfs::env::get_var(
+                gkfs::env::PLACEMENT_POLICY,
+                gkfs::config::placement::default_policy);
+        auto fetcher = []() {
+            std::vector<gkfs::rpc::FsLoad> loads{};
+            auto [err, fs_stats] = gkfs::rpc::forward_get_fs_chunk_stat();
+            if(err)
+                return loads;
+            for(const auto& fs_stat : fs_stats)
+                loads.push_back({fs_stat.chunk_total, fs_stat.chunk_free,
+                                 fs_stat.queue_depth});
+            return loads;
+        };
+        std::shared_ptr<gkfs::rpc::PlacementPolicy> policy =
+                gkfs::rpc::make_placement_policy(policy_name,
+                                                 CTX->local_fs_id(),
+                                                 CTX->hostsconfig(), fetcher);
+        if(!policy) {
+            LOG(WARNING, "Unknown placement policy '{}'. Using '{}'",
+                policy_name, gkfs::config::placement::default_policy);
+            policy = gkfs::rpc::make_placement_policy(
+                    gkfs::config::placement::default_policy,
+                    CTX->local_fs_id(), CTX->hostsconfig(), fetcher);
+        }
+        LOG(INFO, "Placing new files with policy '{}'", policy->name());
+        CTX->placement_policy(policy);
+    }
 #endif
 
+    /* Setup cache of exposed application buffers */
+    auto reg_cache_entries = std::stoul(gkfs::env::get_var(
+            gkfs::env::REG_CACHE_ENTRIES,
+            std::to_string(gkfs::config::rpc::client_reg_cache_entries)));
+    if(reg_cache_entries > 0) {
+        CTX->reg_cache(std::make_shared<
+                       gkfs::rpc::RegistrationCache<hermes::exposed_memory>>(
+                reg_cache_entries,
+                gkfs::config::rpc::client_reg_cache_size * 1024ul * 1024ul));
+        LOG(INFO, "Caching up to {} buffer registrations", reg_cache_entries);
+    }
+
+    /* Setup cache of resolved paths outside of the mountdir */
+    auto path_cache_entries = std::stoul(gkfs::env::get_var(
+            gkfs::env::PATH_CACHE_ENTRIES,
+            std::to_string(gkfs::config::path_cache_entries)));
+    auto path_cache_ttl = std::stoul(
+            gkfs::env::get_var(gkfs::env::PATH_CACHE_TTL,
+                               std::to_string(gkfs::config::path_cache_ttl)));
+    if(path_cache_entries > 0) {
+        CTX->path_cache(std::make_shared<gkfs::path::PathCache>(
+                path_cache_entries, std::chrono::milliseconds(path_cache_ttl)));
+        LOG(INFO, "Caching up to {} resolved paths for {} ms",
+            path_cache_entries, path_cache_ttl);
+    }
+
+    /* Setup RPC tracing of a sample of read and write operations */
+    auto trace_sampling =
+            std::stod(gkfs::env::get_var(gkfs::env::TRACE_SAMPLING, "0"));
+    if(trace_sampling > 0) {
+        auto trace_path = fmt::format(
+                "{}/gkfs_client_{}_{}.trace",
+                gkfs::env::get_var(gkfs::env::TRACE_DIR,
+                                   gkfs::config::log::trace_dir),
+                CTX->get_hostname(), ::getpid());
+        // ::open() is intercepted, which turns the fd into an internal one
+        int fd = ::open(trace_path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0600);
+        if(fd == -1) {
+            LOG(ERROR, "Failed to open trace file '{}'. Tracing disabled",
+                trace_path);
+        } else {
+            CTX->tracer(std::make_shared<gkfs::trace::writer>(
+                                fd,
+                                [](int fd, const void* buf, size_t count) {
+                                    return syscall_no_intercept(SYS_write, fd,
+                                                                buf, count);
+                                }),
+                        trace_sampling);
+            LOG(INFO, "Tracing {:.2f}% of operations to '{}'",
+                trace_sampling * 100, trace_path);
+        }
+    }
+
+    /* Setup capture of GekkoFS-bound syscalls for gkfs_replay */
+    auto capture_dir = gkfs::env::get_var(gkfs::env::CAPTURE_DIR);
+    if(!capture_dir.empty()) {
+        auto capture_path = fmt::format("{}/gkfs_client_{}_{}.capture",
+                                        capture_dir, CTX->get_hostname(),
+                                        ::getpid());
+        int fd = ::open(capture_path.c_str(), O_CREAT | O_WRONLY | O_TRUNC,
+                        0600);
+        if(fd == -1) {
+            LOG(ERROR, "Failed to open capture file '{}'. Capture disabled",
+                capture_path);
+        } else {
+            CTX->capture(std::make_shared<gkfs::capture::writer>(
+                    fd, [](int fd, const void* buf, size_t count) {
+                        return syscall_no_intercept(SYS_write, fd, buf, count);
+                    }));
+            LOG(INFO, "Capturing syscalls to '{}'", capture_path);
+        }
+    }
+
     //printf("%ld",(unsigned int)(&(CTX->pathfs())));
     LOG(INFO, "Retrieving file system configuration...");
 
@@ -314,6 +469,7 @@ init_preload() {
     // The original errno value will be restored after initialization to not
     // leak internal error codes
     auto oerrno = errno;
+    auto init_start = std::chrono::steady_clock::now();
 
     CTX->enable_interception();
     gkfs::preload::start_self_interception();
@@ -346,6 +502,10 @@ init_preload() {
 #endif
 
     gkfs::preload::start_interception();
+    LOG(INFO, "Client initialized in {} ms",
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - init_start)
+                .count());
     errno = oerrno;
 
 }
@@ -359,11 +519,36 @@ destroy_preload() {
     destroy_forwarding_mapper();
 #endif
 
+    LOG(INFO, "Looked up {} of {} daemon addresses",
+        CTX->hosts().resolved(), CTX->hosts().size());
     CTX->clear_hosts();
     LOG(DEBUG, "Peer information deleted");
     //register work flow to registry
     gkfs::preload::register_registry();
 
+    // registrations must be released before the RPC engine is shut down
+    if(auto reg_cache = CTX->reg_cache()) {
+        auto stats = reg_cache->stats();
+        auto lookups = stats.hits + stats.misses;
+        LOG(INFO,
+            "Registration cache: {} hits, {} misses ({:.1f}% hit rate), "
+            "{} evictions, {} invalidations",
+            stats.hits, stats.misses,
+            lookups ? 100.0 * stats.hits / lookups : 0.0, stats.evictions,
+            stats.invalidations);
+        CTX->reg_cache(nullptr);
+    }
+
+    if(const auto& path_cache = CTX->path_cache()) {
+        auto stats = path_cache->stats();
+        LOG(INFO, "Path cache: {} hits, {} misses, {} entries", stats.hits,
+            stats.misses, path_cache->size());
+    }
+
+    // writes out the remaining spans and captured syscalls
+    CTX->tracer(nullptr);
+    CTX->stop_capture();
+
     ld_network_service.reset();
     LOG(DEBUG, "RPC subsystem shut down");
 
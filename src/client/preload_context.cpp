@@ -33,6 +33,10 @@
 #include <client/open_file_map.hpp>
 #include <client/open_dir.hpp>
 #include <client/path.hpp>
+#include <client/rpc/registration_cache.hpp>
+#include <client/path_cache.hpp>
+#include <common/trace_util.hpp>
+#include <common/capture_util.hpp>
 
 #include <common/env_util.hpp>
 #include <common/path_util.hpp>
@@ -59,7 +63,8 @@ decltype(PreloadContext::MAX_USER_FDS) constexpr PreloadContext::MAX_USER_FDS;
 
 PreloadContext::PreloadContext()
     : ofm_(std::make_shared<gkfs::filemap::OpenFileMap>()),
-      fs_conf_(std::make_shared<FsConfig>()) {
+      fs_conf_(std::make_shared<FsConfig>()),
+      hosts_(std::make_shared<gkfs::rpc::EndpointTable<hermes::endpoint>>()) {
 
     internal_fds_.set();
     internal_fds_must_relocate_ = true;
@@ -94,7 +99,11 @@ PreloadContext::init_logging() {
 
     const bool log_trunc = (!trunc_val.empty() && trunc_val[0] != '0');
 
-    gkfs::log::create_global_logger(log_opts, log_output, log_trunc
+    const std::string async_val = gkfs::env::get_var(gkfs::env::LOG_ASYNC);
+
+    const bool log_async = (!async_val.empty() && async_val[0] != '0');
+
+    gkfs::log::create_global_logger(log_opts, log_output, log_trunc, log_async
 #ifdef GKFS_DEBUG_BUILD
                                     ,
                                     log_filter, log_verbosity
@@ -123,6 +132,7 @@ PreloadContext::mountdir_components() const {
 void
 PreloadContext::cwd(const std::string& path) {
     cwd_ = path;
+    cwd_generation_.fetch_add(1, std::memory_order_release);
 }
 
 const std::string&
@@ -130,14 +140,20 @@ PreloadContext::cwd() const {
     return cwd_;
 }
 
-const std::vector<hermes::endpoint>&
+uint64_t
+PreloadContext::cwd_generation() const {
+    return cwd_generation_.load(std::memory_order_acquire);
+}
+
+const gkfs::rpc::EndpointTable<hermes::endpoint>&
 PreloadContext::hosts() const {
-    return hosts_;
+    return *hosts_;
 }
 
 void
-PreloadContext::hosts(const std::vector<hermes::endpoint>& endpoints) {
-    hosts_ = endpoints;
+PreloadContext::hosts(
+        std::shared_ptr<gkfs::rpc::EndpointTable<hermes::endpoint>> hosts) {
+    hosts_ = std::move(hosts);
 }
 
 const hermes::endpoint
@@ -182,7 +198,8 @@ PreloadContext::pathmeta() {
 
 void
 PreloadContext::clear_hosts() {
-    hosts_.clear();
+    // stops background lookups of the previous table
+    hosts_ = std::make_shared<gkfs::rpc::EndpointTable<hermes::endpoint>>();
 }
 
 uint64_t
@@ -329,6 +346,73 @@ PreloadContext::distributor() const {
     return distributor_;
 }
 
+void
+PreloadContext::placement_policy(
+        std::shared_ptr<gkfs::rpc::PlacementPolicy> policy) {
+    placement_policy_ = policy;
+}
+
+std::shared_ptr<gkfs::rpc::PlacementPolicy>
+PreloadContext::placement_policy() const {
+    return placement_policy_;
+}
+
+void
+PreloadContext::reg_cache(
+        std::shared_ptr<gkfs::rpc::RegistrationCache<hermes::exposed_memory>>
+                reg_cache) {
+    reg_cache_ = reg_cache;
+}
+
+std::shared_ptr<gkfs::rpc::RegistrationCache<hermes::exposed_memory>>
+PreloadContext::reg_cache() const {
+    return reg_cache_;
+}
+
+void
+PreloadContext::path_cache(std::shared_ptr<gkfs::path::PathCache> path_cache) {
+    path_cache_ = path_cache;
+}
+
+const std::shared_ptr<gkfs::path::PathCache>&
+PreloadContext::path_cache() const {
+    return path_cache_;
+}
+
+void
+PreloadContext::tracer(std::shared_ptr<gkfs::trace::writer> tracer,
+                       double sampling) {
+    tracer_ = tracer;
+    trace_sampling_ = sampling;
+}
+
+const std::shared_ptr<gkfs::trace::writer>&
+PreloadContext::tracer() const {
+    return tracer_;
+}
+
+double
+PreloadContext::trace_sampling() const {
+    return trace_sampling_;
+}
+
+void
+PreloadContext::capture(std::shared_ptr<gkfs::capture::writer> capture) {
+    capture_ = std::move(capture);
+    active_capture_.store(capture_.get(), std::memory_order_release);
+}
+
+gkfs::capture::writer*
+PreloadContext::capture() const {
+    return active_capture_.load(std::memory_order_acquire);
+}
+
+void
+PreloadContext::stop_capture() {
+    if(auto capture = active_capture_.exchange(nullptr))
+        capture->flush();
+}
+
 const std::shared_ptr<FsConfig>&
 PreloadContext::fs_conf() const {
     return fs_conf_;
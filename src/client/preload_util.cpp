@@ -40,6 +40,7 @@
 #include <hermes.hpp>
 
 #include <fstream>
+#include <mutex>
 #include <sstream>
 #include <regex>
 #include <csignal>
@@ -47,12 +48,26 @@
 
 extern "C" {
 #include <sys/sysmacros.h>
+#include <pthread.h>
 }
 
 using namespace std;
 
 namespace {
 
+// endpoints being resolved in the background, see connect_to_hosts()
+weak_ptr<gkfs::rpc::EndpointTable<hermes::endpoint>> background_lookups;
+
+/**
+ * Stops background lookups before fork() so that the child does not inherit
+ * a host whose lookup is in progress in a thread that does not exist there.
+ */
+void
+stop_background_lookups() {
+    if(auto endpoints = background_lookups.lock())
+        endpoints->stop();
+}
+
 /**
  * Looks up a host endpoint via Hermes
  * @param uri
@@ -458,17 +473,19 @@ read_hosts_config_file() {
     return {hcfile,fspriority};
 }
 /**
- * Connects to daemons and lookup Mercury URI addresses via Hermes
+ * Sets up the endpoints of all daemons. Mercury URI addresses are looked up via
+ * Hermes on first use of a daemon. Unless disabled with
+ * LIBGKFS_LOOKUP_PARALLELISM=0, all addresses are additionally resolved in the
+ * background with a bounded number of lookups in flight.
  * @param hosts vector<pair<hostname, Mercury URI address>>
- * @throws std::runtime_error through lookup_endpoint()
  */
 void
 connect_to_hosts(const vector<pair<string, string>>& hosts) {
     auto local_hostname = gkfs::rpc::get_my_hostname(true);
     bool local_host_found = false;
 
-    std::vector<hermes::endpoint> addrs;
-    addrs.resize(hosts.size());
+    std::vector<std::string> uris;
+    uris.reserve(hosts.size());
 
     vector<uint64_t> host_ids(hosts.size());
     // populate vector with [0, ..., host_size - 1]
@@ -480,24 +497,7 @@ connect_to_hosts(const vector<pair<string, string>>& hosts) {
             CTX->local_host_id(id);
             local_host_found = true;
         }
-    }
-    /*
-     * Shuffle hosts to balance addr lookups to all hosts
-     * Too many concurrent lookups send to same host
-     * could overwhelm the server,
-     * returning error when addr lookup
-     */
-    ::random_device rd; // obtain a random number from hardware
-    ::mt19937 g(rd());  // seed the random generator
-    ::shuffle(host_ids.begin(), host_ids.end(), g); // Shuffle hosts vector
-    // lookup addresses and put abstract server addresses into rpc_addresses
-
-    for(const auto& id : host_ids) {
-        const auto& hostname = hosts.at(id).first;
-        const auto& uri = hosts.at(id).second;
-       //std::cout<< "id:"<< id<<" hostname + uri" << hostname<<" " << uri<<std::endl;
-        addrs[id] = lookup_endpoint(uri);
-        LOG(DEBUG, "Found peer: {}", addrs[id].to_string());
+        uris.push_back(hosts.at(id).second);
     }
 
     if(!local_host_found) {
@@ -513,7 +513,50 @@ connect_to_hosts(const vector<pair<string, string>>& hosts) {
             break;
         }
     }
-    CTX->hosts(addrs);
+
+    auto endpoints =
+            std::make_shared<gkfs::rpc::EndpointTable<hermes::endpoint>>(
+                    uris, [](const std::string& uri) {
+                        try {
+                            auto endp = lookup_endpoint(uri);
+                            LOG(DEBUG, "Found peer: {}", endp.to_string());
+                            return endp;
+                        } catch(const std::exception& e) {
+                            LOG(ERROR, "{}", e.what());
+                            throw;
+                        }
+                    });
+    CTX->hosts(endpoints);
+
+    auto max_in_flight = std::stoul(gkfs::env::get_var(
+            gkfs::env::LOOKUP_PARALLELISM,
+            std::to_string(gkfs::config::rpc::client_lookup_parallelism)));
+    if(max_in_flight == 0) {
+        LOG(INFO, "Looking up {} daemon addresses on first use", uris.size());
+        return;
+    }
+    /*
+     * Shuffle hosts to balance addr lookups to all hosts
+     * Too many concurrent lookups send to same host
+     * could overwhelm the server,
+     * returning error when addr lookup. The local host is looked up first as
+     * it is most likely used first.
+     */
+    ::random_device rd; // obtain a random number from hardware
+    ::mt19937 g(rd());  // seed the random generator
+    ::shuffle(host_ids.begin(), host_ids.end(), g); // Shuffle hosts vector
+    std::vector<size_t> order{CTX->local_host_id()};
+    for(const auto& host_id : host_ids)
+        if(host_id != CTX->local_host_id())
+            order.push_back(host_id);
+    LOG(INFO, "Looking up {} daemon addresses with up to {} lookups in flight",
+        uris.size(), max_in_flight);
+    static std::once_flag atfork_registered;
+    std::call_once(atfork_registered, [] {
+        pthread_atfork(stop_background_lookups, nullptr, nullptr);
+    });
+    background_lookups = endpoints;
+    endpoints->resolve_all(max_in_flight, std::move(order));
 }
 
 /**
@@ -30,15 +30,202 @@
 #include <client/preload_util.hpp>
 #include <client/rpc/forward_data.hpp>
 #include <client/rpc/rpc_types.hpp>
+#include <client/rpc/registration_cache.hpp>
 #include <client/logging.hpp>
+#include <client/tracing.hpp>
 
 #include <common/rpc/distributor.hpp>
+#include <common/rpc/rpc_util.hpp>
 #include <common/arithmetic/arithmetic.hpp>
 
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 
 using namespace std;
 
+namespace {
+
+/*
+ * Chunks that daemons reported as replicated, i.e., path -> chunk id -> number
+ * of replicas. Reads of these chunks are spread across their replica set.
+ * Files are kept in least recently used order, the front being the most
+ * recent, so that only the coldest file is dropped once the limit is reached.
+ */
+struct hot_file {
+    map<uint64_t, unsigned int> chunks;
+    list<string>::iterator lru_pos;
+};
+mutex hot_chunks_mutex;
+list<string> hot_files_lru;
+unordered_map<string, hot_file> hot_chunks;
+
+unsigned int
+hot_chunk_replicas(const string& path, uint64_t chunk_id) {
+    lock_guard<mutex> lock(hot_chunks_mutex);
+    auto file = hot_chunks.find(path);
+    if(file == hot_chunks.end())
+        return 0;
+    hot_files_lru.splice(hot_files_lru.begin(), hot_files_lru,
+                         file->second.lru_pos);
+    auto it = file->second.chunks.find(chunk_id);
+    return it == file->second.chunks.end() ? 0 : it->second;
+}
+
+void
+remember_hot_chunks(const string& path, const vector<uint64_t>& chunk_ids,
+                    unsigned int replicas) {
+    lock_guard<mutex> lock(hot_chunks_mutex);
+    auto file = hot_chunks.find(path);
+    if(file == hot_chunks.end()) {
+        if(hot_chunks.size() >=
+           gkfs::config::replication::client_max_hot_files) {
+            hot_chunks.erase(hot_files_lru.back());
+            hot_files_lru.pop_back();
+        }
+        hot_files_lru.push_front(path);
+        file = hot_chunks.emplace(path, hot_file{{}, hot_files_lru.begin()})
+                       .first;
+    } else {
+        hot_files_lru.splice(hot_files_lru.begin(), hot_files_lru,
+                             file->second.lru_pos);
+    }
+    for(auto chunk_id : chunk_ids)
+        file->second.chunks[chunk_id] = replicas;
+}
+
+void
+forget_hot_chunks(const string& path) {
+    lock_guard<mutex> lock(hot_chunks_mutex);
+    auto file = hot_chunks.find(path);
+    if(file == hot_chunks.end())
+        return;
+    hot_files_lru.erase(file->second.lru_pos);
+    hot_chunks.erase(file);
+}
+
+/**
+ * @brief Exposes an application buffer for RMA. If the registration cache is
+ * enabled, a buffer that was exposed before with the same size and mode is
+ * not registered again.
+ * @throws std::exception if the buffer cannot be exposed
+ */
+hermes::exposed_memory
+expose_buffer(void* buf, size_t size, hermes::access_mode mode) {
+    auto reg_cache = CTX->reg_cache();
+    if(reg_cache) {
+        auto cached = reg_cache->lookup(buf, size, static_cast<int>(mode));
+        if(cached)
+            return *cached;
+    }
+    std::vector<hermes::mutable_buffer> bufseq{
+            hermes::mutable_buffer{buf, size},
+    };
+    auto memory = ld_network_service->expose(bufseq, mode);
+    if(reg_cache)
+        reg_cache->insert(buf, size, static_cast<int>(mode), memory);
+    return memory;
+}
+
+// A contiguous part of a read. Its chunks are either read from their owners
+// or it is a single chunk read from a replica.
+struct read_interval {
+    off64_t offset;
+    size_t size;
+    // daemon of the replica, -1 if read from the owners
+    int64_t replica_host;
+};
+
+// A read RPC sent to a single daemon
+struct read_request {
+    uint64_t host;
+    // interval of chunk ids the daemon looks for its chunks in
+    uint64_t chunk_start;
+    uint64_t chunk_end;
+    // offset of the read in the first chunk of the interval
+    uint64_t chunk_offset;
+    // chunks read by the daemon
+    vector<uint64_t> chunks;
+    uint64_t total_chunk_size;
+    // chunk id if only this chunk is read, -1 otherwise
+    int64_t replica_chunk;
+    // index of the read_interval the request belongs to
+    size_t interval;
+};
+
+/**
+ * @brief Selects the daemon a chunk is read from. A replicated chunk is read
+ * from the local daemon if it holds a replica. Otherwise, clients are spread
+ * across the owner and its replicas.
+ * @param owner Daemon id of the chunk owner relative to its file system
+ * @param fs_base Id of the first daemon of the file system
+ * @param fs_size Number of daemons of the file system
+ * @return Daemon id
+ */
+uint64_t
+select_replica(const string& path, uint64_t chunk_id, uint64_t owner,
+               uint64_t fs_base, uint64_t fs_size) {
+    auto replicas = hot_chunk_replicas(path, chunk_id);
+    if(replicas == 0)
+        return owner + fs_base;
+    auto local = CTX->local_host_id();
+    if(owner + fs_base == local)
+        return local;
+    for(unsigned int r = 1; r <= replicas; r++) {
+        auto host = gkfs::rpc::locate_replica(owner, r, fs_size) + fs_base;
+        if(host == local)
+            return host;
+    }
+    auto sel = (local + chunk_id) % (replicas + 1);
+    if(sel == 0)
+        return owner + fs_base;
+    return gkfs::rpc::locate_replica(owner, sel, fs_size) + fs_base;
+}
+
+/**
+ * @brief Adds the RPCs that read an interval. Its chunks are grouped by the
+ * daemon they are read from so that each daemon reads them with one RPC.
+ */
+void
+add_read_requests(const string& path, const read_interval& iv, size_t idx,
+                  vector<read_request>& requests) {
+    using namespace gkfs::utils::arithmetic;
+    auto chnk_start = block_index(iv.offset, gkfs::config::rpc::chunksize);
+    auto chnk_end = block_index(iv.offset + iv.size - 1,
+                                gkfs::config::rpc::chunksize);
+    // index of the request of each daemon
+    map<uint64_t, size_t> host_requests{};
+    for(auto chnk_id = chnk_start; chnk_id <= chnk_end; chnk_id++) {
+        auto host = iv.replica_host >= 0
+                            ? static_cast<uint64_t>(iv.replica_host)
+                            : CTX->distributor()->locate_data(path, chnk_id);
+        // first and last chunk may only be read partially
+        uint64_t chnk_size = gkfs::config::rpc::chunksize;
+        if(chnk_id == chnk_start)
+            chnk_size -= block_overrun(iv.offset, gkfs::config::rpc::chunksize);
+        if(chnk_id == chnk_end &&
+           !is_aligned(iv.offset + iv.size, gkfs::config::rpc::chunksize))
+            chnk_size -= block_underrun(iv.offset + iv.size,
+                                        gkfs::config::rpc::chunksize);
+        auto it = host_requests.find(host);
+        if(it == host_requests.end()) {
+            it = host_requests.emplace(host, requests.size()).first;
+            requests.push_back(
+                    {host, chnk_start, chnk_end,
+                     block_overrun(iv.offset, gkfs::config::rpc::chunksize),
+                     {}, 0,
+                     iv.replica_host >= 0 ? static_cast<int64_t>(chnk_id) : -1,
+                     idx});
+        }
+        requests[it->second].chunks.push_back(chnk_id);
+        requests[it->second].total_chunk_size += chnk_size;
+    }
+}
+
+} // namespace
+
 namespace gkfs::rpc {
 
 /*
@@ -63,6 +250,9 @@ forward_write(const string& path, const void* buf, const off64_t offset,
 
     assert(write_size > 0);
 
+    // the daemons invalidate the replicas of all written chunks
+    forget_hot_chunks(path);
+
     // Calculate chunkid boundaries and numbers so that daemons know in
     // which interval to look for chunks
     auto chnk_start = block_index(offset, gkfs::config::rpc::chunksize);
@@ -101,18 +291,14 @@ forward_write(const string& path, const void* buf, const off64_t offset,
         }
     }
 
-    // some helper variables for async RPC
-    std::vector<hermes::mutable_buffer> bufseq{
-            hermes::mutable_buffer{const_cast<void*>(buf), write_size},
-    };
-
     // expose user buffers so that they can serve as RDMA data sources
-    // (these are automatically "unexposed" when the destructor is called)
+    // (these are "unexposed" when the destructor of the last copy is called,
+    // which may be the registration cache)
     hermes::exposed_memory local_buffers;
 
     try {
-        local_buffers = ld_network_service->expose(
-                bufseq, hermes::access_mode::read_only);
+        local_buffers = expose_buffer(const_cast<void*>(buf), write_size,
+                                      hermes::access_mode::read_only);
 
     } catch(const std::exception& ex) {
         LOG(ERROR, "Failed to expose buffers for RMA");
@@ -120,6 +306,8 @@ forward_write(const string& path, const void* buf, const off64_t offset,
     }
 
     std::vector<hermes::rpc_handle<gkfs::rpc::write_data>> handles;
+    // spans of the RPCs if the operation is traced, one per handle
+    std::vector<gkfs::trace::span> spans;
 
     // Issue non-blocking RPC requests and wait for the result later
     //
@@ -145,7 +333,12 @@ forward_write(const string& path, const void* buf, const off64_t offset,
                                                gkfs::config::rpc::chunksize);
         }
 
-        auto endp = CTX->hosts().at(target);
+        auto endp = CTX->hosts().get(target);
+        if(!endp) {
+            LOG(ERROR, "Failed to look up host for path \"{}\" [peer: {}]",
+                path, target);
+            return make_pair(EHOSTUNREACH, 0);
+        }
         unsigned int diff = 0;
         for(unsigned int server = 0; server<CTX->distributor()->locate_fs(path); server++){
             diff += CTX->hostsconfig().at(server);
@@ -155,6 +348,7 @@ forward_write(const string& path, const void* buf, const off64_t offset,
 
             LOG(DEBUG, "Sending RPC ...");
 
+            auto span = gkfs::trace::rpc_span("rpc:write");
             gkfs::rpc::write_data::input in(
                     path,
                     // first offset in targets is the chunk with
@@ -168,7 +362,7 @@ forward_write(const string& path, const void* buf, const off64_t offset,
                     // chunk end id of this write
                     chnk_end,
                     // total size to write
-                    total_chunk_size, local_buffers);
+                    total_chunk_size, local_buffers, span.rpc_context());
 
             // TODO(amiranda): add a post() with RPC_TIMEOUT to hermes so that
             // we can retry for RPC_TRIES (see old commits with margo)
@@ -176,7 +370,8 @@ forward_write(const string& path, const void* buf, const off64_t offset,
             // returning one result and a broadcast(endpoint_set) returning a
             // result_set. When that happens we can remove the .at(0) :/
             handles.emplace_back(
-                    ld_network_service->post<gkfs::rpc::write_data>(endp, in));
+                    ld_network_service->post<gkfs::rpc::write_data>(*endp, in));
+            spans.push_back(std::move(span));
 
             LOG(DEBUG,
                 "host: {}, path: \"{}\", chunks: {}, size: {}, offset: {}",
@@ -203,6 +398,7 @@ forward_write(const string& path, const void* buf, const off64_t offset,
             // XXX We might need a timeout here to not wait forever for an
             // output that never comes?
             auto out = h.get().at(0);
+            spans[idx].end();
 
             if(out.err() != 0) {
                 LOG(ERROR, "Daemon reported error: {}", out.err());
@@ -251,105 +447,103 @@ forward_read(const string& path, void* buf, const off64_t offset,
     auto chnk_end =
             block_index((offset + read_size - 1), gkfs::config::rpc::chunksize);
 
-    // Collect all chunk ids within count that have the same destination so
-    // that those are send in one rpc bulk transfer
-    std::map<uint64_t, std::vector<uint64_t>> target_chnks{};
-    // contains the recipient ids, used to access the target_chnks map.
-    // First idx is chunk with potential offset
-    std::vector<uint64_t> targets{};
-    // targets for the first and last chunk as they need special treatment
-    uint64_t chnk_start_target = 0;
-    uint64_t chnk_end_target = 0;
-
+    // daemons of the file system of this path
+    auto fs = CTX->distributor()->locate_fs(path);
+    uint64_t fs_base = 0;
+    for(unsigned int server = 0; server < fs; server++)
+        fs_base += CTX->hostsconfig().at(server);
+    uint64_t fs_size = CTX->hostsconfig().at(fs);
+
+    // Chunks are read from their owners, which read all their chunks with one
+    // RPC. A chunk that is read from a replica is cut out of the read and
+    // sent to the replica alone. The rest of the read is still grouped per
+    // owner.
+    std::vector<read_interval> intervals{};
+    off64_t interval_start = offset;
     for(uint64_t chnk_id = chnk_start; chnk_id <= chnk_end; chnk_id++) {
         auto target = CTX->distributor()->locate_data(path, chnk_id);
-
-        if(target_chnks.count(target) == 0) {
-            target_chnks.insert(
-                    std::make_pair(target, std::vector<uint64_t>{chnk_id}));
-            targets.push_back(target);
-        } else {
-            target_chnks[target].push_back(chnk_id);
-        }
-
-        // set first and last chnk targets
-        if(chnk_id == chnk_start) {
-            chnk_start_target = target;
-        }
-
-        if(chnk_id == chnk_end) {
-            chnk_end_target = target;
-        }
+        auto source = select_replica(path, chnk_id, target - fs_base, fs_base,
+                                     fs_size);
+        if(source == target)
+            continue;
+        auto chnk_begin = max(offset, static_cast<off64_t>(
+                                              chnk_id *
+                                              gkfs::config::rpc::chunksize));
+        auto chnk_finish =
+                min(static_cast<off64_t>(offset + read_size),
+                    static_cast<off64_t>((chnk_id + 1) *
+                                         gkfs::config::rpc::chunksize));
+        if(chnk_begin > interval_start)
+            intervals.push_back({interval_start,
+                                 static_cast<size_t>(chnk_begin -
+                                                     interval_start),
+                                 -1});
+        intervals.push_back({chnk_begin,
+                             static_cast<size_t>(chnk_finish - chnk_begin),
+                             static_cast<int64_t>(source)});
+        interval_start = chnk_finish;
     }
-
-    // some helper variables for async RPCs
-    std::vector<hermes::mutable_buffer> bufseq{
-            hermes::mutable_buffer{buf, read_size},
-    };
+    if(interval_start < static_cast<off64_t>(offset + read_size))
+        intervals.push_back(
+                {interval_start,
+                 static_cast<size_t>(offset + read_size - interval_start),
+                 -1});
 
     // expose user buffers so that they can serve as RDMA data targets
-    // (these are automatically "unexposed" when the destructor is called)
-    hermes::exposed_memory local_buffers;
-
+    // (these are "unexposed" when the destructor of the last copy is called,
+    // which may be the registration cache). Without replicas, the whole
+    // buffer is a single interval.
+    std::vector<hermes::exposed_memory> local_buffers{};
+    std::vector<read_request> requests{};
     try {
-        local_buffers = ld_network_service->expose(
-                bufseq, hermes::access_mode::write_only);
-
+        for(size_t idx = 0; idx < intervals.size(); idx++) {
+            local_buffers.push_back(expose_buffer(
+                    static_cast<char*>(buf) + (intervals[idx].offset - offset),
+                    intervals[idx].size, hermes::access_mode::write_only));
+            add_read_requests(path, intervals[idx], idx, requests);
+        }
     } catch(const std::exception& ex) {
         LOG(ERROR, "Failed to expose buffers for RMA");
         return make_pair(EBUSY, 0);
     }
 
     std::vector<hermes::rpc_handle<gkfs::rpc::read_data>> handles;
+    // spans of the RPCs if the operation is traced, one per handle
+    std::vector<gkfs::trace::span> spans;
 
     // Issue non-blocking RPC requests and wait for the result later
     //
     // TODO(amiranda): This could be simplified by adding a vector of inputs
     // to async_engine::broadcast(). This would allow us to avoid manually
     // looping over handles as we do below
-    for(const auto& target : targets) {
+    for(const auto& req : requests) {
 
-        // total chunk_size for target
-        auto total_chunk_size =
-                target_chnks[target].size() * gkfs::config::rpc::chunksize;
-
-        // receiver of first chunk must subtract the offset from first chunk
-        if(target == chnk_start_target) {
-            total_chunk_size -=
-                    block_overrun(offset, gkfs::config::rpc::chunksize);
+        auto endp = CTX->hosts().get(req.host);
+        if(!endp) {
+            LOG(ERROR, "Failed to look up host for path \"{}\" [peer: {}]",
+                path, req.host);
+            return make_pair(EHOSTUNREACH, 0);
         }
-
-        // receiver of last chunk must subtract
-        if(target == chnk_end_target &&
-           !is_aligned(offset + read_size, gkfs::config::rpc::chunksize)) {
-            total_chunk_size -= block_underrun(offset + read_size,
-                                               gkfs::config::rpc::chunksize);
-        }
-
-        auto endp = CTX->hosts().at(target);
-        unsigned int diff = 0;
-        for(unsigned int server = 0; server<CTX->distributor()->locate_fs(path); server++){
-            diff += CTX->hostsconfig().at(server);
-        }
-        diff = diff > target? target:diff;
         try {
 
             LOG(DEBUG, "Sending RPC ...");
 
+            auto span = gkfs::trace::rpc_span("rpc:read");
             gkfs::rpc::read_data::input in(
                     path,
-                    // first offset in targets is the chunk with
-                    // a potential offset
-                    block_overrun(offset, gkfs::config::rpc::chunksize), target - diff,
-                    CTX->hostsconfig().at(CTX->distributor()->locate_fs(path)),
+                    // offset of the read in the first chunk of the
+                    // interval
+                    req.chunk_offset, req.host - fs_base, fs_size,
                     // number of chunks handled by that destination
-                    target_chnks[target].size(),
-                    // chunk start id of this write
-                    chnk_start,
-                    // chunk end id of this write
-                    chnk_end,
-                    // total size to write
-                    total_chunk_size, local_buffers);
+                    req.chunks.size(),
+                    // chunk start id of this interval
+                    req.chunk_start,
+                    // chunk end id of this interval
+                    req.chunk_end,
+                    // total size to read
+                    req.total_chunk_size, local_buffers[req.interval],
+                    // single chunk that may be read from a replica
+                    req.replica_chunk, span.rpc_context());
 
             // TODO(amiranda): add a post() with RPC_TIMEOUT to hermes so that
             // we can retry for RPC_TRIES (see old commits with margo)
@@ -357,23 +551,25 @@ forward_read(const string& path, void* buf, const off64_t offset,
             // returning one result and a broadcast(endpoint_set) returning a
             // result_set. When that happens we can remove the .at(0) :/
             handles.emplace_back(
-                    ld_network_service->post<gkfs::rpc::read_data>(endp, in));
+                    ld_network_service->post<gkfs::rpc::read_data>(*endp, in));
+            spans.push_back(std::move(span));
 
             LOG(DEBUG,
-                "host: {}, path: {}, chunk_start: {}, chunk_end: {}, chunks: {}, size: {}, offset: {}",
-                target, path, chnk_start, chnk_end, in.chunk_n(),
-                total_chunk_size, in.offset());
+                "host: {}, path: {}, chunk_start: {}, chunk_end: {}, chunks: {}, size: {}, offset: {}, replica_chunk: {}",
+                req.host, path, req.chunk_start, req.chunk_end, in.chunk_n(),
+                req.total_chunk_size, in.offset(), req.replica_chunk);
 
             LOG(TRACE_READS,
                 "read {} host: {}, path: {}, chunk_start: {}, chunk_end: {}",
-                CTX->get_hostname(), target, path, chnk_start, chnk_end);
+                CTX->get_hostname(), req.host, path, req.chunk_start,
+                req.chunk_end);
 
 
         } catch(const std::exception& ex) {
             LOG(ERROR,
                 "Unable to send non-blocking rpc for path \"{}\" "
                 "[peer: {}]",
-                path, target);
+                path, req.host);
             return make_pair(EBUSY, 0);
         }
     }
@@ -382,29 +578,50 @@ forward_read(const string& path, void* buf, const off64_t offset,
     // which is the read size. All potential outputs are served to free
     // resources regardless of errors, although an errorcode is set.
     auto err = 0;
-    ssize_t out_size = 0;
+    auto stale = false;
     std::size_t idx = 0;
+    // data ranges in buf written by the daemons. The rest are holes.
+    std::vector<gkfs::rpc::data_extent> extents{};
 
     for(const auto& h : handles) {
         try {
             // XXX We might need a timeout here to not wait forever for an
             // output that never comes?
             auto out = h.get().at(0);
+            spans[idx].end();
 
-            if(out.err() != 0) {
+            if(out.err() == ESTALE) {
+                LOG(DEBUG, "Replica of chunk {} on daemon {} is stale",
+                    requests[idx].replica_chunk, requests[idx].host);
+                stale = true;
+            } else if(out.err() != 0) {
                 LOG(ERROR, "Daemon reported error: {}", out.err());
                 err = out.err();
+            } else if(out.replicas() > 0 && requests[idx].replica_chunk < 0) {
+                remember_hot_chunks(path, requests[idx].chunks,
+                                    out.replicas());
             }
 
-            out_size += static_cast<size_t>(out.io_size());
+            // daemons report extents relative to the interval's buffer
+            auto buf_offset = static_cast<uint64_t>(
+                    intervals[requests[idx].interval].offset - offset);
+            for(auto extent : gkfs::rpc::decode_extents(out.extents())) {
+                extent.offset += buf_offset;
+                extents.push_back(extent);
+            }
 
         } catch(const std::exception& ex) {
             LOG(ERROR, "Failed to get rpc output for path \"{}\" [peer: {}]",
-                path, targets[idx]);
+                path, requests[idx].host);
             err = EIO;
         }
         idx++;
     }
+    // A replica was invalidated in the meantime. Read again from the owners.
+    if(!err && stale) {
+        forget_hot_chunks(path);
+        return forward_read(path, buf, offset, read_size);
+    }
     /*
      * Typically file systems return the size even if only a part of it was
      * read. In our case, we do not keep track which daemon fully read its
@@ -412,8 +629,21 @@ forward_read(const string& path, void* buf, const off64_t offset,
      */
     if(err)
         return make_pair(err, 0);
-    else
-        return make_pair(0, out_size);
+    /*
+     * Zero the holes between the data ranges. The read size is the end of the
+     * last data range as holes before it read as zeros. Anything after it is
+     * beyond the end of the file or a trailing hole, which only the file size
+     * tells apart. gkfs_pread() zeroes the latter using the cached size.
+     */
+    gkfs::rpc::merge_extents(extents);
+    uint64_t data_end = 0;
+    for(const auto& extent : extents) {
+        if(extent.offset > data_end)
+            memset(static_cast<char*>(buf) + data_end, 0,
+                   extent.offset - data_end);
+        data_end = extent.offset + extent.size;
+    }
+    return make_pair(0, static_cast<ssize_t>(data_end));
 }
 
 /**
@@ -451,7 +681,12 @@ forward_truncate(const std::string& path, size_t current_size,
 
     for(const auto& host : hosts) {
 
-        auto endp = CTX->hosts().at(host);
+        auto endp = CTX->hosts().get(host);
+        if(!endp) {
+            LOG(ERROR, "Failed to look up host: {}", host);
+            err = EIO;
+            break; // We need to gather all responses so we can't return here
+        }
 
         try {
             LOG(DEBUG, "Sending RPC ...");
@@ -464,7 +699,7 @@ forward_truncate(const std::string& path, size_t current_size,
             // returning one result and a broadcast(endpoint_set) returning a
             // result_set. When that happens we can remove the .at(0) :/
             handles.emplace_back(
-                    ld_network_service->post<gkfs::rpc::trunc_data>(endp, in));
+                    ld_network_service->post<gkfs::rpc::trunc_data>(*endp, in));
 
         } catch(const std::exception& ex) {
             // TODO(amiranda): we should cancel all previously posted requests
@@ -495,19 +730,27 @@ forward_truncate(const std::string& path, size_t current_size,
 }
 
 /**
- * Send an RPC request to chunk stat all hosts
- * @return pair<error code, rpc::ChunkStat>
+ * Send an RPC to all hosts of all file systems to collect their chunk stats.
+ * Stats are accumulated per file system, i.e., the vector is indexed by the
+ * file system id used in the hosts config.
+ * @return error code, per file system chunk stats
  */
-pair<int, ChunkStat>
-forward_get_chunk_stat() {
+std::pair<int, std::vector<ChunkStat>>
+forward_get_fs_chunk_stat() {
 
     std::vector<hermes::rpc_handle<gkfs::rpc::chunk_stat>> handles;
 
     auto err = 0;
 
-    for(const auto& endp : CTX->hosts()) {
+    for(size_t host = 0; host < CTX->hosts().size(); host++) {
+        const auto endp = CTX->hosts().get(host);
+        if(!endp) {
+            LOG(ERROR, "Failed to look up host: {}", host);
+            err = EHOSTUNREACH;
+            break; // We need to gather all responses so we can't return here
+        }
         try {
-            LOG(DEBUG, "Sending RPC to host: {}", endp.to_string());
+            LOG(DEBUG, "Sending RPC to host: {}", endp->to_string());
 
             gkfs::rpc::chunk_stat::input in(0);
 
@@ -517,24 +760,31 @@ forward_get_chunk_stat() {
             // returning one result and a broadcast(endpoint_set) returning a
             // result_set. When that happens we can remove the .at(0) :/
             handles.emplace_back(
-                    ld_network_service->post<gkfs::rpc::chunk_stat>(endp, in));
+                    ld_network_service->post<gkfs::rpc::chunk_stat>(*endp, in));
 
         } catch(const std::exception& ex) {
             // TODO(amiranda): we should cancel all previously posted requests
             // here, unfortunately, Hermes does not support it yet :/
-            LOG(ERROR, "Failed to send request to host: {}", endp.to_string());
+            LOG(ERROR, "Failed to send request to host: {}", endp->to_string());
             err = EBUSY;
             break; // We need to gather all responses so we can't return here
         }
     }
 
-    unsigned long chunk_size = gkfs::config::rpc::chunksize;
-    unsigned long chunk_total = 0;
-    unsigned long chunk_free = 0;
+    const unsigned long chunk_size = gkfs::config::rpc::chunksize;
+    // hosts are ordered by file system, i.e., the hosts of fs 0 come first
+    const auto& hostsconfig = CTX->hostsconfig();
+    std::vector<ChunkStat> fs_stats(hostsconfig.size(),
+                                    ChunkStat{chunk_size, 0, 0, 0});
+    unsigned int fs = 0;
+    unsigned int fs_end = hostsconfig.at(0);
 
     // wait for RPC responses
     for(std::size_t i = 0; i < handles.size(); ++i) {
 
+        while(i >= fs_end && fs + 1 < hostsconfig.size())
+            fs_end += hostsconfig[++fs];
+
         gkfs::rpc::chunk_stat::output out{};
 
         try {
@@ -546,22 +796,43 @@ forward_get_chunk_stat() {
                 err = out.err();
                 LOG(ERROR,
                     "Host '{}' reported err code '{}' during stat chunk.",
-                    CTX->hosts().at(i).to_string(), err);
+                    CTX->hosts().uri(i), err);
                 // we don't break here to ensure all responses are processed
                 continue;
             }
             assert(out.chunk_size() == chunk_size);
-            chunk_total += out.chunk_total();
-            chunk_free += out.chunk_free();
+            fs_stats[fs].chunk_total += out.chunk_total();
+            fs_stats[fs].chunk_free += out.chunk_free();
+            fs_stats[fs].queue_depth += out.queue_depth();
         } catch(const std::exception& ex) {
             LOG(ERROR, "Failed to get RPC output from host: {}", i);
             err = EBUSY;
         }
     }
     if(err)
-        return make_pair(err, ChunkStat{});
+        return make_pair(err, std::vector<ChunkStat>{});
     else
-        return make_pair(0, ChunkStat{chunk_size, chunk_total, chunk_free});
+        return make_pair(0, fs_stats);
+}
+
+/**
+ * Send an RPC to all hosts to collect their chunk stats
+ * @return error code, chunk stats accumulated over all hosts
+ */
+std::pair<int, ChunkStat>
+forward_get_chunk_stat() {
+
+    auto [err, fs_stats] = forward_get_fs_chunk_stat();
+    if(err)
+        return make_pair(err, ChunkStat{});
+
+    ChunkStat stat{gkfs::config::rpc::chunksize, 0, 0, 0};
+    for(const auto& fs_stat : fs_stats) {
+        stat.chunk_total += fs_stat.chunk_total;
+        stat.chunk_free += fs_stat.chunk_free;
+        stat.queue_depth += fs_stat.queue_depth;
+    }
+    return make_pair(0, stat);
 }
 
 } // namespace gkfs::rpc
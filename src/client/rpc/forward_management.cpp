@@ -42,7 +42,11 @@ namespace gkfs::rpc {
 bool
 forward_get_fs_config() {
 
-    auto endp = CTX->hosts().at(CTX->local_host_id());
+    auto endp = CTX->hosts().get(CTX->local_host_id());
+    if(!endp) {
+        LOG(ERROR, "Failed to look up the local daemon");
+        return false;
+    }
     gkfs::rpc::fs_config::output out;
 
     try {
@@ -52,7 +56,7 @@ forward_get_fs_config() {
         // TODO(amiranda): hermes will eventually provide a post(endpoint)
         // returning one result and a broadcast(endpoint_set) returning a
         // result_set. When that happens we can remove the .at(0) :/
-        out = ld_network_service->post<gkfs::rpc::fs_config>(endp).get().at(0);
+        out = ld_network_service->post<gkfs::rpc::fs_config>(*endp).get().at(0);
     } catch(const std::exception& ex) {
         LOG(ERROR, "Retrieving fs configurations from daemon");
         return false;
@@ -33,6 +33,7 @@
 #include <client/preload_util.hpp>
 #include <client/open_dir.hpp>
 #include <client/rpc/rpc_types.hpp>
+#include <client/tracing.hpp>
 
 #include <common/rpc/rpc_util.hpp>
 #include <common/rpc/distributor.hpp>
@@ -66,7 +67,10 @@ struct forward_statfs_args{
 int
 forward_create(const std::string& path, const mode_t mode) {
 
-    auto endp = CTX->hosts().at(CTX->distributor()->locate_file_metadata(path));
+    auto endp =
+            CTX->hosts().get(CTX->distributor()->locate_file_metadata(path));
+    if(!endp)
+        return EHOSTUNREACH;
     //std::cout<<"create "<<CTX->distributor()->locate_file_metadata(path)<<std::endl;
     try {
         LOG(DEBUG, "Sending RPC ...");
@@ -75,7 +79,7 @@ forward_create(const std::string& path, const mode_t mode) {
         // TODO(amiranda): hermes will eventually provide a post(endpoint)
         // returning one result and a broadcast(endpoint_set) returning a
         // result_set. When that happens we can remove the .at(0) :/
-        auto out = ld_network_service->post<gkfs::rpc::create>(endp, path, mode)
+        auto out = ld_network_service->post<gkfs::rpc::create>(*endp, path, mode)
                            .get()
                            .at(0);
         LOG(DEBUG, "Got response success: {}", out.err());
@@ -100,11 +104,15 @@ forward_getSuccessResponseThread(void* data){
     int hostid = prefix_num + (CTX->distributor()->locate(statfs_args->path,hostsize_single));
     //std::cout<<"trying to find the target at prefix = "<< prefix_num << " with pos= "<< hostid - prefix_num<<std::endl;
 
-    auto endp = CTX->hosts().at(hostid);
-  
+    auto endp = CTX->hosts().get(hostid);
+    if(!endp) {
+        statfs_args->result = EHOSTUNREACH;
+        pthread_exit(NULL);
+    }
+
     try {
             //cout<<"--forward_getResponseThread() -Sending RPC--"<<endl;
-            auto out = ld_network_service->post<gkfs::rpc::stat>(endp, statfs_args->path)
+            auto out = ld_network_service->post<gkfs::rpc::stat>(*endp, statfs_args->path)
                             .get()
                             .at(0);
             LOG(DEBUG, "Got response success: {}", out.err());
@@ -193,7 +201,10 @@ forward_stat(const std::string& path, string& attr) {
 
         //cout<<"--forward_stat()->OLD -start--"<<endl;
 
-        auto endp = CTX->hosts().at(CTX->distributor()->locate_file_metadata(path));
+        auto endp = CTX->hosts().get(
+                CTX->distributor()->locate_file_metadata(path));
+        if(!endp)
+            return EHOSTUNREACH;
 
         try {
             //cout<<"--forward_stat() -Sending RPC--"<<endl;
@@ -203,7 +214,7 @@ forward_stat(const std::string& path, string& attr) {
             // TODO(amiranda): hermes will eventually provide a post(endpoint)
             // returning one result and a broadcast(endpoint_set) returning a
             // result_set. When that happens we can remove the .at(0) :/
-            auto out = ld_network_service->post<gkfs::rpc::stat>(endp, path)
+            auto out = ld_network_service->post<gkfs::rpc::stat>(*endp, path)
                             .get()
                             .at(0);
             // cout<<"--Got response success:" <<out.err()<<"--"<<endl;
@@ -237,7 +248,10 @@ forward_stat(const std::string& path, string& attr) {
 int
 forward_remove(const std::string& path) {
 
-    auto endp = CTX->hosts().at(CTX->distributor()->locate_file_metadata(path));
+    auto endp =
+            CTX->hosts().get(CTX->distributor()->locate_file_metadata(path));
+    if(!endp)
+        return EHOSTUNREACH;
     int64_t size = 0;
     uint32_t mode = 0;
 
@@ -253,7 +267,7 @@ forward_remove(const std::string& path) {
         // returning one result and a broadcast(endpoint_set) returning a
         // result_set. When that happens we can remove the .at(0) :/
         auto out =
-                ld_network_service->post<gkfs::rpc::remove_metadata>(endp, path)
+                ld_network_service->post<gkfs::rpc::remove_metadata>(*endp, path)
                         .get()
                         .at(0);
 
@@ -274,20 +288,23 @@ forward_remove(const std::string& path) {
 
 
     std::vector<hermes::rpc_handle<gkfs::rpc::remove_data>> handles;
+    auto err = 0;
 
     // Small files
     if(static_cast<std::size_t>(size / gkfs::config::rpc::chunksize) <
        CTX->hosts().size()) {
         const auto metadata_host_id =
                 CTX->distributor()->locate_file_metadata(path);
-        const auto endp_metadata = CTX->hosts().at(metadata_host_id);
+        const auto endp_metadata = CTX->hosts().get(metadata_host_id);
+        if(!endp_metadata)
+            return EHOSTUNREACH;
 
         try {
-            LOG(DEBUG, "Sending RPC to host: {}", endp_metadata.to_string());
+            LOG(DEBUG, "Sending RPC to host: {}", endp_metadata->to_string());
             gkfs::rpc::remove_data::input in(path);
             handles.emplace_back(
                     ld_network_service->post<gkfs::rpc::remove_data>(
-                            endp_metadata, in));
+                            *endp_metadata, in));
 
             uint64_t chnk_start = 0;
             uint64_t chnk_end = size / gkfs::config::rpc::chunksize;
@@ -304,13 +321,18 @@ forward_remove(const std::string& path) {
                     if(chnk_host_id == metadata_host_id)
                         continue;
                 }
-                const auto endp_chnk = CTX->hosts().at(chnk_host_id);
+                const auto endp_chnk = CTX->hosts().get(chnk_host_id);
+                if(!endp_chnk) {
+                    LOG(ERROR, "Failed to look up host: {}", chnk_host_id);
+                    err = EHOSTUNREACH;
+                    break; // we need to gather responses from already sent RPCs
+                }
 
-                LOG(DEBUG, "Sending RPC to host: {}", endp_chnk.to_string());
+                LOG(DEBUG, "Sending RPC to host: {}", endp_chnk->to_string());
 
                 handles.emplace_back(
                         ld_network_service->post<gkfs::rpc::remove_data>(
-                                endp_chnk, in));
+                                *endp_chnk, in));
             }
         } catch(const std::exception& ex) {
             LOG(ERROR,
@@ -318,9 +340,15 @@ forward_remove(const std::string& path) {
             return EBUSY;
         }
     } else { // "Big" files
-        for(const auto& endp : CTX->hosts()) {
+        for(size_t host = 0; host < CTX->hosts().size(); host++) {
+            const auto endp = CTX->hosts().get(host);
+            if(!endp) {
+                LOG(ERROR, "Failed to look up host: {}", host);
+                err = EHOSTUNREACH;
+                break; // we need to gather responses from already sent RPCs
+            }
             try {
-                LOG(DEBUG, "Sending RPC to host: {}", endp.to_string());
+                LOG(DEBUG, "Sending RPC to host: {}", endp->to_string());
 
                 gkfs::rpc::remove_data::input in(path);
 
@@ -332,7 +360,7 @@ forward_remove(const std::string& path) {
                 // happens we can remove the .at(0) :/
 
                 handles.emplace_back(
-                        ld_network_service->post<gkfs::rpc::remove_data>(endp,
+                        ld_network_service->post<gkfs::rpc::remove_data>(*endp,
                                                                          in));
 
             } catch(const std::exception& ex) {
@@ -341,13 +369,12 @@ forward_remove(const std::string& path) {
                 // :/
                 LOG(ERROR,
                     "Failed to forward non-blocking rpc request to host: {}",
-                    endp.to_string());
+                    endp->to_string());
                 return EBUSY;
             }
         }
     }
     // wait for RPC responses
-    auto err = 0;
     for(const auto& h : handles) {
         try {
             // XXX We might need a timeout here to not wait forever for an
@@ -376,7 +403,10 @@ forward_remove(const std::string& path) {
 int
 forward_decr_size(const std::string& path, size_t length) {
 
-    auto endp = CTX->hosts().at(CTX->distributor()->locate_file_metadata(path));
+    auto endp =
+            CTX->hosts().get(CTX->distributor()->locate_file_metadata(path));
+    if(!endp)
+        return EHOSTUNREACH;
 
     try {
         LOG(DEBUG, "Sending RPC ...");
@@ -386,7 +416,7 @@ forward_decr_size(const std::string& path, size_t length) {
         // returning one result and a broadcast(endpoint_set) returning a
         // result_set. When that happens we can remove the .at(0) :/
         auto out = ld_network_service
-                           ->post<gkfs::rpc::decr_size>(endp, path, length)
+                           ->post<gkfs::rpc::decr_size>(*endp, path, length)
                            .get()
                            .at(0);
 
@@ -413,7 +443,10 @@ forward_update_metadentry(
         const string& path, const gkfs::metadata::Metadata& md,
         const gkfs::metadata::MetadentryUpdateFlags& md_flags) {
 
-    auto endp = CTX->hosts().at(CTX->distributor()->locate_file_metadata(path));
+    auto endp =
+            CTX->hosts().get(CTX->distributor()->locate_file_metadata(path));
+    if(!endp)
+        return EHOSTUNREACH;
 
     try {
         LOG(DEBUG, "Sending RPC ...");
@@ -424,7 +457,7 @@ forward_update_metadentry(
         // result_set. When that happens we can remove the .at(0) :/
         auto out = ld_network_service
                            ->post<gkfs::rpc::update_metadentry>(
-                                   endp, path,
+                                   *endp, path,
                                    (md_flags.link_count ? md.link_count() : 0),
                                    /* mode */ 0,
                                    /* uid */ 0,
@@ -470,7 +503,9 @@ forward_rename(const string& oldpath, const string& newpath,
                const gkfs::metadata::Metadata& md) {
 
     auto endp =
-            CTX->hosts().at(CTX->distributor()->locate_file_metadata(oldpath));
+            CTX->hosts().get(CTX->distributor()->locate_file_metadata(oldpath));
+    if(!endp)
+        return EHOSTUNREACH;
 
     try {
         LOG(DEBUG, "Sending RPC ...");
@@ -481,7 +516,7 @@ forward_rename(const string& oldpath, const string& newpath,
         // result_set. When that happens we can remove the .at(0) :/
         auto out = ld_network_service
                            ->post<gkfs::rpc::update_metadentry>(
-                                   endp, oldpath, (md.link_count()),
+                                   *endp, oldpath, (md.link_count()),
                                    /* mode */ 0,
                                    /* uid */ 0,
                                    /* gid */ 0, md.size(),
@@ -517,7 +552,9 @@ forward_rename(const string& oldpath, const string& newpath,
     // returning one result and a broadcast(endpoint_set) returning a
     // result_set. When that happens we can remove the .at(0) :/
     auto endp2 =
-            CTX->hosts().at(CTX->distributor()->locate_file_metadata(newpath));
+            CTX->hosts().get(CTX->distributor()->locate_file_metadata(newpath));
+    if(!endp2)
+        return EHOSTUNREACH;
 
     try {
         LOG(DEBUG, "Sending RPC ...");
@@ -528,7 +565,7 @@ forward_rename(const string& oldpath, const string& newpath,
         // result_set. When that happens we can remove the .at(0) :/
 
         auto out = ld_network_service
-                           ->post<gkfs::rpc::create>(endp2, newpath, md2.mode())
+                           ->post<gkfs::rpc::create>(*endp2, newpath, md2.mode())
                            .get()
                            .at(0);
         LOG(DEBUG, "Got response success: {}", out.err());
@@ -549,7 +586,7 @@ forward_rename(const string& oldpath, const string& newpath,
         // Update new file with target link = oldpath
         auto out =
                 ld_network_service
-                        ->post<gkfs::rpc::mk_symlink>(endp2, newpath, oldpath)
+                        ->post<gkfs::rpc::mk_symlink>(*endp2, newpath, oldpath)
                         .get()
                         .at(0);
 
@@ -571,7 +608,7 @@ forward_rename(const string& oldpath, const string& newpath,
         // returning one result and a broadcast(endpoint_set) returning a
         // result_set. When that happens we can remove the .at(0) :/
         auto out = ld_network_service
-                           ->post<gkfs::rpc::mk_symlink>(endp, oldpath, newpath)
+                           ->post<gkfs::rpc::mk_symlink>(*endp, oldpath, newpath)
                            .get()
                            .at(0);
 
@@ -587,32 +624,34 @@ forward_rename(const string& oldpath, const string& newpath,
 
 #endif
 
-/**
- * Send an RPC request for an update to the file size.
- * This is called during a write() call or similar
- * @param path
- * @param size
- * @param offset
- * @param append_flag
- * @return pair<error code, size after update>
- */
+struct pending_size_update::impl {
+    hermes::rpc_handle<gkfs::rpc::update_metadentry_size> handle;
+    gkfs::trace::span span;
+};
+
+pending_size_update::pending_size_update(std::unique_ptr<impl> impl)
+    : impl_(std::move(impl)) {}
+
+pending_size_update::~pending_size_update() = default;
+
+pending_size_update::pending_size_update(pending_size_update&&) noexcept =
+        default;
+
+pending_size_update&
+pending_size_update::operator=(pending_size_update&&) noexcept = default;
+
 pair<int, off64_t>
-forward_update_metadentry_size(const string& path, const size_t size,
-                               const off64_t offset, const bool append_flag, const std::string& buf) {
-    auto endp = CTX->hosts().at(CTX->distributor()->locate_file_metadata(path));
+pending_size_update::wait() {
+    // posting already failed
+    if(!impl_)
+        return make_pair(EBUSY, 0);
     try {
-        LOG(DEBUG, "Sending RPC ...");
-        // TODO(amiranda): add a post() with RPC_TIMEOUT to hermes so that we
-        // can retry for RPC_TRIES (see old commits with margo)
         // TODO(amiranda): hermes will eventually provide a post(endpoint)
         // returning one result and a broadcast(endpoint_set) returning a
         // result_set. When that happens we can remove the .at(0) :/
-        auto out = ld_network_service
-                           ->post<gkfs::rpc::update_metadentry_size>(
-                                   endp, path, size, offset,
-                                   bool_to_merc_bool(append_flag), buf)
-                           .get()
-                           .at(0);
+        auto out = impl_->handle.get().at(0);
+        impl_->span.end();
+        impl_.reset();
 
         LOG(DEBUG, "Got response success: {}", out.err());
 
@@ -622,10 +661,65 @@ forward_update_metadentry_size(const string& path, const size_t size,
             return make_pair(0, out.ret_size());
     } catch(const std::exception& ex) {
         LOG(ERROR, "while getting rpc output");
+        impl_.reset();
         return make_pair(EBUSY, 0);
     }
 }
 
+/**
+ * Send an RPC request for an update to the file size without waiting for
+ * the response. The caller collects it with pending_size_update::wait().
+ * @param path
+ * @param size
+ * @param offset
+ * @param append_flag
+ * @param buf
+ * @return handle of the outstanding size update
+ */
+pending_size_update
+post_update_metadentry_size(const string& path, const size_t size,
+                            const off64_t offset, const bool append_flag,
+                            const std::string& buf) {
+    auto endp =
+            CTX->hosts().get(CTX->distributor()->locate_file_metadata(path));
+    if(!endp)
+        return pending_size_update(nullptr);
+    try {
+        LOG(DEBUG, "Sending RPC ...");
+        auto span = gkfs::trace::rpc_span("rpc:update_size");
+        // TODO(amiranda): add a post() with RPC_TIMEOUT to hermes so that we
+        // can retry for RPC_TRIES (see old commits with margo)
+        auto handle = ld_network_service
+                              ->post<gkfs::rpc::update_metadentry_size>(
+                                      *endp, path, size, offset,
+                                      bool_to_merc_bool(append_flag), buf,
+                                      span.rpc_context());
+        return pending_size_update(
+                std::unique_ptr<pending_size_update::impl>(
+                        new pending_size_update::impl{std::move(handle),
+                                                      std::move(span)}));
+    } catch(const std::exception& ex) {
+        LOG(ERROR, "while posting rpc");
+        return pending_size_update(nullptr);
+    }
+}
+
+/**
+ * Send an RPC request for an update to the file size.
+ * This is called during a write() call or similar
+ * @param path
+ * @param size
+ * @param offset
+ * @param append_flag
+ * @return pair<error code, size after update>
+ */
+pair<int, off64_t>
+forward_update_metadentry_size(const string& path, const size_t size,
+                               const off64_t offset, const bool append_flag, const std::string& buf) {
+    return post_update_metadentry_size(path, size, offset, append_flag, buf)
+            .wait();
+}
+
 /**
  * Send an RPC request to get the current file size.
  * This is called during a lseek() call
@@ -635,7 +729,10 @@ forward_update_metadentry_size(const string& path, const size_t size,
 pair<int, off64_t>
 forward_get_metadentry_size(const std::string& path) {
 
-    auto endp = CTX->hosts().at(CTX->distributor()->locate_file_metadata(path));
+    auto endp =
+            CTX->hosts().get(CTX->distributor()->locate_file_metadata(path));
+    if(!endp)
+        return make_pair(EHOSTUNREACH, 0);
 
     try {
         LOG(DEBUG, "Sending RPC ...");
@@ -645,7 +742,7 @@ forward_get_metadentry_size(const std::string& path) {
         // returning one result and a broadcast(endpoint_set) returning a
         // result_set. When that happens we can remove the .at(0) :/
         auto out = ld_network_service
-                           ->post<gkfs::rpc::get_metadentry_size>(endp, path)
+                           ->post<gkfs::rpc::get_metadentry_size>(*endp, path)
                            .get()
                            .at(0);
 
@@ -711,14 +808,20 @@ forward_get_dirents(const string& path) {
     for(std::size_t i = 0; i < targets.size(); ++i) {
 
         // Setup rpc input parameters for each host
-        auto endp = CTX->hosts().at(targets[i]);
+        auto endp = CTX->hosts().get(targets[i]);
+        if(!endp) {
+            LOG(ERROR, "{}() Failed to look up host: '{}'", __func__,
+                targets[i]);
+            err = EHOSTUNREACH;
+            break; // we need to gather responses from already sent RPCS
+        }
 
         gkfs::rpc::get_dirents::input in(path, exposed_buffers[i]);
 
         try {
             LOG(DEBUG, "{}() Sending RPC to host: '{}'", __func__, targets[i]);
             handles.emplace_back(
-                    ld_network_service->post<gkfs::rpc::get_dirents>(endp, in));
+                    ld_network_service->post<gkfs::rpc::get_dirents>(*endp, in));
         } catch(const std::exception& ex) {
             LOG(ERROR,
                 "{}() Unable to send non-blocking get_dirents() on {} [peer: {}] err '{}'",
@@ -855,14 +958,16 @@ forward_get_dirents_single(const string& path, int server) {
     // send RPCs
     std::vector<hermes::rpc_handle<gkfs::rpc::get_dirents_extended>> handles;
 
-    auto endp = CTX->hosts().at(targets[i]);
+    auto endp = CTX->hosts().get(targets[i]);
+    if(!endp)
+        return make_pair(EHOSTUNREACH, output);
 
     gkfs::rpc::get_dirents_extended::input in(path, exposed_buffers[0]);
 
     try {
         LOG(DEBUG, "{}() Sending RPC to host: '{}'", __func__, targets[i]);
         handles.emplace_back(
-                ld_network_service->post<gkfs::rpc::get_dirents_extended>(endp,
+                ld_network_service->post<gkfs::rpc::get_dirents_extended>(*endp,
                                                                           in));
     } catch(const std::exception& ex) {
         LOG(ERROR,
@@ -945,7 +1050,10 @@ forward_get_dirents_single(const string& path, int server) {
 int
 forward_mk_symlink(const std::string& path, const std::string& target_path) {
 
-    auto endp = CTX->hosts().at(CTX->distributor()->locate_file_metadata(path));
+    auto endp =
+            CTX->hosts().get(CTX->distributor()->locate_file_metadata(path));
+    if(!endp)
+        return EHOSTUNREACH;
 
     try {
         LOG(DEBUG, "Sending RPC ...");
@@ -956,7 +1064,7 @@ forward_mk_symlink(const std::string& path, const std::string& target_path) {
         // result_set. When that happens we can remove the .at(0) :/
         auto out =
                 ld_network_service
-                        ->post<gkfs::rpc::mk_symlink>(endp, path, target_path)
+                        ->post<gkfs::rpc::mk_symlink>(*endp, path, target_path)
                         .get()
                         .at(0);
 
@@ -0,0 +1,70 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS' POSIX interface.
+
+  GekkoFS' POSIX interface is free software: you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, either version 3 of the License,
+  or (at your option) any later version.
+
+  GekkoFS' POSIX interface is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with GekkoFS' POSIX interface.  If not, see
+  <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: LGPL-3.0-or-later
+*/
+
+#include <client/tracing.hpp>
+#include <client/preload.hpp>
+#include <client/preload_context.hpp>
+
+namespace {
+
+// root span of the sampled operation of this thread, if any
+thread_local const gkfs::trace::span* current_operation = nullptr;
+
+} // namespace
+
+namespace gkfs::trace {
+
+operation::operation(const char* name) {
+    if(current_operation) {
+        return;
+    }
+    const auto& tracer = CTX->tracer();
+    if(!tracer || !sample(CTX->trace_sampling())) {
+        return;
+    }
+    span_ = span(tracer.get(), name, new_id(), 0);
+    current_operation = &span_;
+}
+
+operation::~operation() {
+    if(current_operation == &span_) {
+        current_operation = nullptr;
+    }
+}
+
+span
+rpc_span(const char* name) {
+    if(!current_operation) {
+        return {};
+    }
+    return span(CTX->tracer().get(), name, current_operation->trace_id(),
+                current_operation->id());
+}
+
+} // namespace gkfs::trace
@@ -0,0 +1,164 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <common/capture_util.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace gkfs::capture {
+
+namespace {
+
+thread_local uint32_t thread_id = 0;
+
+uint64_t
+clock_ns(clockid_t clock) {
+    struct timespec ts {};
+    ::clock_gettime(clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull +
+           static_cast<uint64_t>(ts.tv_nsec);
+}
+
+constexpr const char* op_names[] = {
+        "open",   "close", "read",     "write",     "pread",
+        "pwrite", "lseek", "stat",     "fstat",     "unlink",
+        "rmdir",  "mkdir", "truncate", "ftruncate", "fsync",
+        "getdents", "access", "rename", "dup"};
+
+static_assert(sizeof(op_names) / sizeof(op_names[0]) ==
+                      static_cast<size_t>(op::count),
+              "every operation needs a name");
+
+} // namespace
+
+const char*
+op_name(op o) {
+    auto i = static_cast<size_t>(o);
+    return i < static_cast<size_t>(op::count) ? op_names[i] : "unknown";
+}
+
+writer::writer(int fd, write_fn write)
+    : fd_(fd), write_(write), start_(clock_ns(CLOCK_MONOTONIC)) {
+    buffer_.reserve(buffer_bytes);
+    file_header header{};
+    std::memcpy(header.magic, file_magic, sizeof(header.magic));
+    ::gethostname(header.host, sizeof(header.host) - 1);
+    header.pid = static_cast<uint32_t>(::getpid());
+    header.start_time = clock_ns(CLOCK_REALTIME);
+    write_out(&header, sizeof(header));
+}
+
+writer::~writer() {
+    flush();
+}
+
+uint64_t
+writer::elapsed() const {
+    return clock_ns(CLOCK_MONOTONIC) - start_;
+}
+
+void
+writer::write_out(const void* data, size_t size) {
+    auto p = static_cast<const char*>(data);
+    while(size > 0) {
+        auto n = write_(fd_, p, size);
+        if(n <= 0) {
+            // capturing is best effort, drop what cannot be written
+            return;
+        }
+        p += n;
+        size -= n;
+    }
+}
+
+void
+writer::flush_locked() {
+    if(!buffer_.empty()) {
+        write_out(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+}
+
+void
+writer::add(record r, const std::string& path, const std::string& path2) {
+    if(thread_id == 0) {
+        thread_id = static_cast<uint32_t>(::syscall(SYS_gettid));
+    }
+    r.tid = thread_id;
+    r.path_len = static_cast<uint16_t>(std::min<size_t>(path.size(), 0xffff));
+    r.path2_len =
+            static_cast<uint16_t>(std::min<size_t>(path2.size(), 0xffff));
+    auto size = sizeof(r) + r.path_len + r.path2_len;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(buffer_.size() + size > buffer_bytes) {
+        flush_locked();
+    }
+    auto pos = buffer_.size();
+    buffer_.resize(pos + size);
+    std::memcpy(buffer_.data() + pos, &r, sizeof(r));
+    std::memcpy(buffer_.data() + pos + sizeof(r), path.data(), r.path_len);
+    std::memcpy(buffer_.data() + pos + sizeof(r) + r.path_len, path2.data(),
+                r.path2_len);
+}
+
+void
+writer::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flush_locked();
+}
+
+reader::reader(const std::string& path) : in_(path, std::ios::binary) {
+    if(!in_) {
+        throw std::runtime_error("Failed to open capture file '" + path +
+                                 "'");
+    }
+    if(!in_.read(reinterpret_cast<char*>(&header_), sizeof(header_)) ||
+       std::memcmp(header_.magic, file_magic, sizeof(file_magic)) != 0) {
+        throw std::runtime_error("'" + path + "' is not a capture file");
+    }
+    header_.host[sizeof(header_.host) - 1] = '\0';
+}
+
+bool
+reader::next(entry& e) {
+    if(!in_.read(reinterpret_cast<char*>(&e.rec), sizeof(e.rec))) {
+        return false;
+    }
+    e.path.resize(e.rec.path_len);
+    e.path2.resize(e.rec.path2_len);
+    return static_cast<bool>(in_.read(&e.path[0], e.rec.path_len)) &&
+           static_cast<bool>(in_.read(&e.path2[0], e.rec.path2_len));
+}
+
+} // namespace gkfs::capture
@@ -321,5 +321,10 @@ GuidedDistributor::locate_directory_metadata(const string& path) const {
     return all_hosts_;
 }
 
+host_t
+locate_replica(host_t owner, unsigned int replica, unsigned int hosts_size) {
+    return (owner + replica) % hosts_size;
+}
+
 } // namespace rpc
 } // namespace gkfs
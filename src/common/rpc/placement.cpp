@@ -0,0 +1,186 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#include <common/rpc/placement.hpp>
+#include <config.hpp>
+
+using namespace std;
+
+namespace gkfs::rpc {
+
+namespace {
+
+string
+parent_dir(const string& path) {
+    auto pos = path.find_last_of('/');
+    if(pos == 0 || pos == string::npos)
+        return "/";
+    return path.substr(0, pos);
+}
+
+} // namespace
+
+LocalFirstPolicy::LocalFirstPolicy(unsigned int localfs) : localfs_(localfs) {}
+
+string
+LocalFirstPolicy::name() const {
+    return "local";
+}
+
+bool
+LocalFirstPolicy::follows_parent() const {
+    return false;
+}
+
+unsigned int
+LocalFirstPolicy::place(const string& path, bool is_dir) {
+    return localfs_;
+}
+
+DirRoundRobinPolicy::DirRoundRobinPolicy(unsigned int fs_count,
+                                         unsigned int start)
+    : fs_count_(fs_count), next_(start) {}
+
+string
+DirRoundRobinPolicy::name() const {
+    return "roundrobin";
+}
+
+bool
+DirRoundRobinPolicy::follows_parent() const {
+    return true;
+}
+
+unsigned int
+DirRoundRobinPolicy::place(const string& path, bool is_dir) {
+    auto dir = is_dir ? path : parent_dir(path);
+    lock_guard<mutex> lock(mutex_);
+    auto it = dirs_.find(dir);
+    if(it != dirs_.end())
+        return it->second;
+    if(dirs_.size() >= gkfs::config::placement::max_tracked_dirs)
+        dirs_.clear();
+    auto fs = next_++ % fs_count_;
+    dirs_.emplace(dir, fs);
+    return fs;
+}
+
+LoadBasedPolicy::LoadBasedPolicy(
+        unsigned int localfs, fs_load_fetcher_t fetcher,
+        std::chrono::steady_clock::duration refresh_interval)
+    : localfs_(localfs), fetcher_(move(fetcher)),
+      refresh_interval_(refresh_interval) {}
+
+bool
+LoadBasedPolicy::follows_parent() const {
+    return true;
+}
+
+unsigned int
+LoadBasedPolicy::place(const string& path, bool is_dir) {
+    lock_guard<mutex> lock(mutex_);
+    auto now = chrono::steady_clock::now();
+    if(loads_.empty() || now - last_refresh_ >= refresh_interval_) {
+        loads_ = fetcher_();
+        last_refresh_ = now;
+    }
+    // no stats available, e.g., a daemon did not respond
+    if(loads_.empty())
+        return localfs_;
+    return choose(loads_);
+}
+
+unsigned int
+CapacityAwarePolicy::choose(vector<FsLoad>& loads) {
+    // the local file system wins ties
+    unsigned int best = localfs_ < loads.size() ? localfs_ : 0;
+    for(unsigned int fs = 0; fs < loads.size(); fs++) {
+        if(loads[fs].chunk_free > loads[best].chunk_free)
+            best = fs;
+    }
+    return best;
+}
+
+string
+CapacityAwarePolicy::name() const {
+    return "capacity";
+}
+
+LoadAwarePolicy::LoadAwarePolicy(
+        unsigned int localfs, vector<unsigned int> hosts_size,
+        fs_load_fetcher_t fetcher,
+        std::chrono::steady_clock::duration refresh_interval)
+    : LoadBasedPolicy(localfs, move(fetcher), refresh_interval),
+      hosts_size_(move(hosts_size)) {}
+
+unsigned int
+LoadAwarePolicy::choose(vector<FsLoad>& loads) {
+    auto per_daemon = [&](unsigned int fs) {
+        auto daemons = fs < hosts_size_.size() && hosts_size_[fs] > 0
+                               ? hosts_size_[fs]
+                               : 1u;
+        return static_cast<double>(loads[fs].queue_depth) / daemons;
+    };
+    // the local file system wins ties
+    unsigned int best = localfs_ < loads.size() ? localfs_ : 0;
+    for(unsigned int fs = 0; fs < loads.size(); fs++) {
+        if(per_daemon(fs) < per_daemon(best))
+            best = fs;
+    }
+    loads[best].queue_depth++;
+    return best;
+}
+
+string
+LoadAwarePolicy::name() const {
+    return "load";
+}
+
+unique_ptr<PlacementPolicy>
+make_placement_policy(const string& name, unsigned int localfs,
+                      const vector<unsigned int>& hosts_size,
+                      fs_load_fetcher_t fetcher) {
+    auto interval = chrono::seconds(
+            gkfs::config::placement::stat_refresh_interval);
+    if(name == "local")
+        return make_unique<LocalFirstPolicy>(localfs);
+    if(name == "roundrobin")
+        // start at the local file system so single-directory workloads keep
+        // their locality
+        return make_unique<DirRoundRobinPolicy>(hosts_size.size(), localfs);
+    if(name == "capacity")
+        return make_unique<CapacityAwarePolicy>(localfs, move(fetcher),
+                                                interval);
+    if(name == "load")
+        return make_unique<LoadAwarePolicy>(localfs, hosts_size, move(fetcher),
+                                            interval);
+    return nullptr;
+}
+
+} // namespace gkfs::rpc
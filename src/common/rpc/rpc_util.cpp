@@ -35,6 +35,8 @@ extern "C" {
 #include <netdb.h>
 }
 
+#include <algorithm>
+#include <cstdlib>
 #include <system_error>
 
 using namespace std;
@@ -112,6 +114,117 @@ decode_string(string& input) {
     return result;
 }
 
+/**
+ * Sorts extents by offset and merges overlapping and adjacent extents
+ * @param extents
+ */
+void
+merge_extents(vector<data_extent>& extents) {
+    if(extents.empty())
+        return;
+    sort(extents.begin(), extents.end(),
+         [](const data_extent& a, const data_extent& b) {
+             return a.offset < b.offset;
+         });
+    size_t last = 0;
+    for(size_t i = 1; i < extents.size(); i++) {
+        auto& prev = extents[last];
+        if(extents[i].offset <= prev.offset + prev.size) {
+            prev.size = max(prev.size,
+                            extents[i].offset + extents[i].size - prev.offset);
+        } else {
+            extents[++last] = extents[i];
+        }
+    }
+    extents.resize(last + 1);
+}
+
+/**
+ * Encodes extents as "offset:size;offset:size" after merging them
+ * @return
+ */
+string
+encode_extents(vector<data_extent> extents) {
+    merge_extents(extents);
+    string result{};
+    for(const auto& extent : extents) {
+        if(!result.empty())
+            result.push_back(';');
+        result += to_string(extent.offset);
+        result.push_back(':');
+        result += to_string(extent.size);
+    }
+    return result;
+}
+
+/**
+ * Decodes extents encoded with encode_extents(). Malformed entries are ignored
+ * @return
+ */
+vector<data_extent>
+decode_extents(const string& input) {
+    vector<data_extent> extents{};
+    const char* pos = input.c_str();
+    while(*pos != '\0') {
+        char* end = nullptr;
+        auto offset = strtoull(pos, &end, 10);
+        if(end == pos || *end != ':')
+            break;
+        pos = end + 1;
+        auto size = strtoull(pos, &end, 10);
+        if(end == pos)
+            break;
+        extents.push_back({offset, size});
+        pos = (*end == ';') ? end + 1 : end;
+    }
+    return extents;
+}
+
+/**
+ * Encodes status entries as "value name" lines. Line breaks in names are
+ * replaced
+ * @return
+ */
+string
+encode_status(const vector<status_entry>& entries) {
+    string result{};
+    for(const auto& [name, value] : entries) {
+        result += to_string(value);
+        result.push_back(' ');
+        auto pos = result.size();
+        result += name;
+        replace(result.begin() + pos, result.end(), '\n', ' ');
+        result.push_back('\n');
+    }
+    return result;
+}
+
+/**
+ * Decodes status entries encoded with encode_status(). Malformed lines are
+ * ignored
+ * @return
+ */
+vector<status_entry>
+decode_status(const string& input) {
+    vector<status_entry> entries{};
+    size_t pos = 0;
+    while(pos < input.size()) {
+        auto end = input.find('\n', pos);
+        if(end == string::npos)
+            end = input.size();
+        auto space = input.find(' ', pos);
+        if(space != string::npos && space > pos && space < end) {
+            char* num_end = nullptr;
+            auto value = strtoull(input.c_str() + pos, &num_end, 10);
+            if(num_end == input.c_str() + space)
+                entries.emplace_back(input.substr(space + 1, end - space - 1),
+                                     value);
+        }
+        pos = end + 1;
+    }
+    return entries;
+}
+
 
 #ifdef GKFS_ENABLE_UNUSED_FUNCTIONS
 string
@@ -29,11 +29,20 @@
 
 #include <common/statistics/stats.hpp>
 
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
 using namespace std;
 
 namespace gkfs::utils {
 
-#ifdef GKFS_ENABLE_PROMETHEUS
+namespace {
+// threads are assigned to shards round-robin on their first update
+std::atomic<std::size_t> next_shard{0};
+thread_local std::size_t thread_shard = std::numeric_limits<std::size_t>::max();
+} // namespace
+
 static std::string
 GetHostName() {
     char hostname[1024];
@@ -43,7 +52,6 @@ GetHostName() {
     }
     return hostname;
 }
-#endif
 
 void
 Stats::setup_Prometheus(const std::string& gateway_ip,
@@ -76,6 +84,13 @@ Stats::setup_Prometheus(const std::string& gateway_ip,
                 Summary::Quantiles{});
     }
 
+    auto& merge_counter = BuildCounter()
+                                  .Name("IO_SCHEDULER")
+                                  .Help("Writes merged by the I/O scheduler")
+                                  .Register(*registry);
+    merge_requests_prometheus = &merge_counter.Add({{"type", "requests"}});
+    merge_disk_ops_prometheus = &merge_counter.Add({{"type", "disk_ops"}});
+
     gateway->RegisterCollectable(registry);
 #endif /// GKFS_ENABLE_PROMETHEUS
 }
@@ -83,24 +98,26 @@ Stats::setup_Prometheus(const std::string& gateway_ip,
 Stats::Stats(bool enable_chunkstats, bool enable_prometheus,
              const std::string& stats_file,
              const std::string& prometheus_gateway)
-    : enable_prometheus_(enable_prometheus),
-      enable_chunkstats_(enable_chunkstats) {
+    : num_shards_(gkfs::config::stats::shards),
+      shards_(new Shard[gkfs::config::stats::shards]),
+      enable_prometheus_(enable_prometheus),
+      enable_chunkstats_(enable_chunkstats),
+      chunk_reads(enable_chunkstats ? gkfs::config::stats::hot_chunks_tracked
+                                    : 0),
+      chunk_writes(enable_chunkstats ? gkfs::config::stats::hot_chunks_tracked
+                                     : 0),
+      file_reads(enable_chunkstats ? gkfs::config::stats::hot_files_tracked
+                                   : 0),
+      file_writes(enable_chunkstats ? gkfs::config::stats::hot_files_tracked
+                                    : 0),
+      hostname_(GetHostName()) {
 
     // Init clocks
-    start = std::chrono::steady_clock::now();
-
-    // To simplify the control we add an element into the different maps
-    // Statistaclly will be negligible... and we get a faster flow
-
-    for(auto e : all_IopsOp) {
-        iops_mean[e] = 0;
-        time_iops[e].push_back(std::chrono::steady_clock::now());
-    }
+    start = clock::now();
 
-    for(auto e : all_SizeOp) {
-        size_mean[e] = 0;
-        time_size[e].push_back(pair(std::chrono::steady_clock::now(), 0.0));
-    }
+    // the first window starts with the server
+    windows[0].taken = start;
+    windows[0].valid = true;
 
 #ifdef GKFS_ENABLE_PROMETHEUS
     auto pos_separator = prometheus_gateway.find(':');
@@ -126,62 +143,140 @@ Stats::~Stats() {
 
 void
 Stats::add_read(const std::string& path, unsigned long long chunk) {
-    chunk_reads[pair(path, chunk)]++;
+    const std::lock_guard<std::mutex> lock(chunk_stats_mutex);
+    file_reads.add(path);
+    chunk_reads.add(pair(path, chunk));
 }
 
 void
 Stats::add_write(const std::string& path, unsigned long long chunk) {
-    chunk_writes[pair(path, chunk)]++;
+    const std::lock_guard<std::mutex> lock(chunk_stats_mutex);
+    file_writes.add(path);
+    chunk_writes.add(pair(path, chunk));
+}
+
+void
+Stats::add_write_merge(unsigned long long requests,
+                       unsigned long long disk_ops) {
+    merge_batches++;
+    merge_requests += requests;
+    merge_disk_ops += disk_ops;
+#ifdef GKFS_ENABLE_PROMETHEUS
+    if(enable_prometheus_) {
+        merge_requests_prometheus->Increment(requests);
+        merge_disk_ops_prometheus->Increment(disk_ops);
+    }
+#endif
 }
 
 
 void
 Stats::output_map(std::ofstream& output) {
-    // Ordering
-    map<unsigned int, std::set<pair<std::string, unsigned long long>>>
-            order_write;
+    const auto n = gkfs::config::stats::hot_chunks_reported;
+
+    const std::lock_guard<std::mutex> lock(chunk_stats_mutex);
+
+    auto chunkMap = [&](const std::string& caption, const std::string& op,
+                        SpaceSaving<ChunkKey, ChunkKeyHash>& chunks) {
+        output << caption << std::endl;
+        for(const auto& [key, count] : chunks.take_interval(n)) {
+            output << "hot " << op << " " << hostname_
+                   << " path: " << key.first
+                   << ", chunk_start: " << key.second
+                   << ", chunk_end: " << key.second << ", count: " << count
+                   << std::endl;
+        }
+    };
 
-    map<unsigned int, std::set<pair<std::string, unsigned long long>>>
-            order_read;
+    auto fileMap = [&](const std::string& caption,
+                       SpaceSaving<std::string>& files) {
+        output << caption << std::endl;
+        for(const auto& [path, count] : files.take_interval(n)) {
+            output << count << " -- " << path << std::endl;
+        }
+    };
 
-    for(const auto& i : chunk_reads) {
-        order_read[i.second].insert(i.first);
-    }
+    chunkMap("READ CHUNK MAP", "read", chunk_reads);
+    chunkMap("WRITE CHUNK MAP", "write", chunk_writes);
+    fileMap("READ FILE MAP", file_reads);
+    fileMap("WRITE FILE MAP", file_writes);
+}
 
-    for(const auto& i : chunk_writes) {
-        order_write[i.second].insert(i.first);
+Stats::Shard&
+Stats::shard() {
+    if(thread_shard == std::numeric_limits<std::size_t>::max()) {
+        thread_shard = next_shard.fetch_add(1, std::memory_order_relaxed);
     }
+    return shards_[thread_shard % num_shards_];
+}
 
-    auto chunkMap =
-            [](std::string caption,
-               map<unsigned int,
-                   std::set<pair<std::string, unsigned long long>>>& order,
-               std::ofstream& output) {
-                output << caption << std::endl;
-                for(auto k : order) {
-                    output << k.first << " -- ";
-                    for(auto v : k.second) {
-                        output << v.first << " // " << v.second << endl;
-                    }
-                }
-            };
-
-    chunkMap("READ CHUNK MAP", order_read, output);
-    chunkMap("WRITE CHUNK MAP", order_write, output);
+Stats::Snapshot
+Stats::totals() const {
+    Snapshot snap;
+    snap.taken = clock::now();
+    snap.valid = true;
+    for(std::size_t i = 0; i < num_shards_; i++) {
+        for(std::size_t op = 0; op < num_IopsOp; op++) {
+            snap.iops[op] +=
+                    shards_[i].iops[op].load(std::memory_order_relaxed);
+        }
+        for(std::size_t op = 0; op < num_SizeOp; op++) {
+            snap.size[op] +=
+                    shards_[i].size[op].load(std::memory_order_relaxed);
+        }
+    }
+    return snap;
 }
 
 void
-Stats::add_value_iops(enum IopsOp iop) {
-    iops_mean[iop]++;
-    auto now = std::chrono::steady_clock::now();
+Stats::sample_windows() {
+    const auto now = clock::now();
+    if(now - windows[last_window].taken <
+       std::chrono::seconds(gkfs::config::stats::window_interval)) {
+        return;
+    }
+    last_window = (last_window + 1) % windows.size();
+    windows[last_window] = totals();
+}
 
-    const std::lock_guard<std::mutex> lock(time_iops_mutex);
-    if((now - time_iops[iop].front()) > std::chrono::duration(10s)) {
-        time_iops[iop].pop_front();
-    } else if(time_iops[iop].size() >= gkfs::config::stats::max_stats)
-        time_iops[iop].pop_front();
+const Stats::Snapshot&
+Stats::window_start(clock::time_point now, std::chrono::seconds window) const {
+    // oldest snapshot within the window, or, if that is too recent to give
+    // a meaningful mean (e.g., nobody sampled for a while), the newest one
+    // before the window
+    const Snapshot* inside = nullptr;
+    const Snapshot* before = nullptr;
+    for(const auto& w : windows) {
+        if(!w.valid) {
+            continue;
+        }
+        if(w.taken >= now - window) {
+            if(!inside || w.taken < inside->taken) {
+                inside = &w;
+            }
+        } else if(!before || w.taken > before->taken) {
+            before = &w;
+        }
+    }
+    const auto min_span =
+            std::chrono::seconds(gkfs::config::stats::window_interval);
+    if(inside && (now - inside->taken >= min_span || !before)) {
+        return *inside;
+    }
+    return before ? *before : windows[0];
+}
 
-    time_iops[iop].push_back(std::chrono::steady_clock::now());
+void
+Stats::add_value_iops(enum IopsOp iop, clock::time_point started) {
+    auto& s = shard();
+    const auto op = static_cast<std::size_t>(iop);
+    s.iops[op].fetch_add(1, std::memory_order_relaxed);
+    if(started != clock::time_point{}) {
+        s.latency[op].record(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        clock::now() - started)
+                        .count());
+    }
 #ifdef GKFS_ENABLE_PROMETHEUS
     if(enable_prometheus_) {
         iops_prometheus[iop]->Increment();
@@ -190,25 +285,19 @@ Stats::add_value_iops(enum IopsOp iop) {
 }
 
 void
-Stats::add_value_size(enum SizeOp iop, unsigned long long value) {
-    auto now = std::chrono::steady_clock::now();
-    size_mean[iop] += value;
-    const std::lock_guard<std::mutex> lock(size_iops_mutex);
-    if((now - time_size[iop].front().first) > std::chrono::duration(10s)) {
-        time_size[iop].pop_front();
-    } else if(time_size[iop].size() >= gkfs::config::stats::max_stats)
-        time_size[iop].pop_front();
-
-    time_size[iop].push_back(pair(std::chrono::steady_clock::now(), value));
+Stats::add_value_size(enum SizeOp iop, unsigned long long value,
+                      clock::time_point started) {
+    shard().size[static_cast<std::size_t>(iop)].fetch_add(
+            value, std::memory_order_relaxed);
 #ifdef GKFS_ENABLE_PROMETHEUS
     if(enable_prometheus_) {
         size_prometheus[iop]->Observe(value);
     }
 #endif
     if(iop == SizeOp::read_size)
-        add_value_iops(IopsOp::iops_read);
+        add_value_iops(IopsOp::iops_read, started);
     else if(iop == SizeOp::write_size)
-        add_value_iops(IopsOp::iops_write);
+        add_value_iops(IopsOp::iops_write, started);
 }
 
 /**
@@ -218,20 +307,22 @@ Stats::add_value_size(enum SizeOp iop, unsigned long long value) {
  */
 double
 Stats::get_mean(enum SizeOp sop) {
-    auto now = std::chrono::steady_clock::now();
+    auto now = clock::now();
     auto duration =
             std::chrono::duration_cast<std::chrono::seconds>(now - start);
-    double value = static_cast<double>(size_mean[sop]) /
+    double value = static_cast<double>(
+                           totals().size[static_cast<std::size_t>(sop)]) /
                    static_cast<double>(duration.count());
     return value;
 }
 
 double
 Stats::get_mean(enum IopsOp iop) {
-    auto now = std::chrono::steady_clock::now();
+    auto now = clock::now();
     auto duration =
             std::chrono::duration_cast<std::chrono::seconds>(now - start);
-    double value = static_cast<double>(iops_mean[iop]) /
+    double value = static_cast<double>(
+                           totals().iops[static_cast<std::size_t>(iop)]) /
                    static_cast<double>(duration.count());
     return value;
 }
@@ -240,28 +331,24 @@ Stats::get_mean(enum IopsOp iop) {
 std::vector<double>
 Stats::get_four_means(enum SizeOp sop) {
     std::vector<double> results = {0, 0, 0, 0};
-    auto now = std::chrono::steady_clock::now();
-    const std::lock_guard<std::mutex> lock(size_iops_mutex);
-    for(auto e : time_size[sop]) {
-        auto duration =
-                std::chrono::duration_cast<std::chrono::minutes>(now - e.first)
-                        .count();
-        if(duration > 10)
-            break;
-
-        results[3] += e.second;
-        if(duration > 5)
-            continue;
-        results[2] += e.second;
-        if(duration > 1)
-            continue;
-        results[1] += e.second;
+    const auto op = static_cast<std::size_t>(sop);
+    const auto current = totals();
+
+    const std::lock_guard<std::mutex> lock(windows_mutex);
+    sample_windows();
+    const std::array<std::chrono::minutes, 3> spans = {
+            std::chrono::minutes(1), std::chrono::minutes(5),
+            std::chrono::minutes(10)};
+    for(std::size_t i = 0; i < spans.size(); i++) {
+        const auto& w = window_start(current.taken, spans[i]);
+        const std::chrono::duration<double> elapsed = current.taken - w.taken;
+        if(elapsed.count() > 0) {
+            // Mean in MB/s
+            results[i + 1] = static_cast<double>(current.size[op] - w.size[op]) /
+                             elapsed.count() / (1024.0 * 1024.0);
+        }
     }
-    // Mean in MB/s
     results[0] = get_mean(sop) / (1024.0 * 1024.0);
-    results[3] /= 10 * 60 * (1024.0 * 1024.0);
-    results[2] /= 5 * 60 * (1024.0 * 1024.0);
-    results[1] /= 60 * (1024.0 * 1024.0);
 
     return results;
 }
@@ -270,32 +357,72 @@ Stats::get_four_means(enum SizeOp sop) {
 std::vector<double>
 Stats::get_four_means(enum IopsOp iop) {
     std::vector<double> results = {0, 0, 0, 0};
-    auto now = std::chrono::steady_clock::now();
-    const std::lock_guard<std::mutex> lock(time_iops_mutex);
-    for(auto e : time_iops[iop]) {
-        auto duration =
-                std::chrono::duration_cast<std::chrono::minutes>(now - e)
-                        .count();
-        if(duration > 10)
-            break;
-
-        results[3]++;
-        if(duration > 5)
-            continue;
-        results[2]++;
-        if(duration > 1)
-            continue;
-        results[1]++;
+    const auto op = static_cast<std::size_t>(iop);
+    const auto current = totals();
+
+    const std::lock_guard<std::mutex> lock(windows_mutex);
+    sample_windows();
+    const std::array<std::chrono::minutes, 3> spans = {
+            std::chrono::minutes(1), std::chrono::minutes(5),
+            std::chrono::minutes(10)};
+    for(std::size_t i = 0; i < spans.size(); i++) {
+        const auto& w = window_start(current.taken, spans[i]);
+        const std::chrono::duration<double> elapsed = current.taken - w.taken;
+        if(elapsed.count() > 0) {
+            results[i + 1] =
+                    static_cast<double>(current.iops[op] - w.iops[op]) /
+                    elapsed.count();
+        }
     }
-
     results[0] = get_mean(iop);
-    results[3] /= 10 * 60;
-    results[2] /= 5 * 60;
-    results[1] /= 60;
 
     return results;
 }
 
+LatencyHistogram::counts
+Stats::get_latency(enum IopsOp iop) {
+    LatencyHistogram::counts counts{};
+    for(std::size_t i = 0; i < num_shards_; i++) {
+        shards_[i].latency[static_cast<std::size_t>(iop)].add_to(counts);
+    }
+    return counts;
+}
+
+std::vector<std::pair<std::string, uint64_t>>
+Stats::status(std::size_t hot_chunks) {
+    std::vector<std::pair<std::string, uint64_t>> entries{};
+    const auto current = totals();
+    auto name = [](std::string label) {
+        std::transform(label.begin(), label.end(), label.begin(), ::tolower);
+        return label;
+    };
+    for(auto e : all_IopsOp) {
+        const auto op = static_cast<std::size_t>(e);
+        entries.emplace_back("ops/" + name(IopsOp_s[op]), current.iops[op]);
+        entries.emplace_back("p99_ns/" + name(IopsOp_s[op]),
+                             LatencyHistogram::value_at(get_latency(e), 99));
+    }
+    for(auto e : all_SizeOp) {
+        const auto op = static_cast<std::size_t>(e);
+        entries.emplace_back("bytes/" + name(SizeOp_s[op]), current.size[op]);
+    }
+    if(!enable_chunkstats_) {
+        return entries;
+    }
+    const std::lock_guard<std::mutex> lock(chunk_stats_mutex);
+    for(const auto& [key, count] : chunk_reads.top(hot_chunks)) {
+        entries.emplace_back(
+                "hot_read/" + std::to_string(key.second) + "/" + key.first,
+                count);
+    }
+    for(const auto& [key, count] : chunk_writes.top(hot_chunks)) {
+        entries.emplace_back(
+                "hot_write/" + std::to_string(key.second) + "/" + key.first,
+                count);
+    }
+    return entries;
+}
+
 void
 Stats::dump(std::ofstream& of) {
     for(auto e : all_IopsOp) {
@@ -308,6 +435,21 @@ Stats::dump(std::ofstream& of) {
         }
         of << std::endl;
     }
+    for(auto e : all_IopsOp) {
+        const auto counts = get_latency(e);
+        if(LatencyHistogram::value_at(counts, 100) == 0) {
+            continue;
+        }
+        of << "Stats " << IopsOp_s[static_cast<int>(e)]
+           << " latency us (p50, p90, p99, p99.9, max) \t\t";
+        for(auto p : {50.0, 90.0, 99.0, 99.9, 100.0}) {
+            of << std::setprecision(4) << std::setw(9)
+               << static_cast<double>(LatencyHistogram::value_at(counts, p)) /
+                          1000.0
+               << " - ";
+        }
+        of << std::endl;
+    }
     for(auto e : all_SizeOp) {
         auto tmp = get_four_means(e);
 
@@ -318,6 +460,15 @@ Stats::dump(std::ofstream& of) {
         }
         of << std::endl;
     }
+    if(merge_batches > 0) {
+        unsigned long long requests = merge_requests;
+        unsigned long long disk_ops = merge_disk_ops;
+        of << "Stats IO_SCHEDULER (batches, requests, disk ops, ratio) \t\t"
+           << merge_batches << " - " << requests << " - " << disk_ops << " - "
+           << std::setprecision(4)
+           << static_cast<double>(requests) / static_cast<double>(disk_ops)
+           << std::endl;
+    }
     of << std::endl;
 }
 void
@@ -346,6 +497,8 @@ Stats::output(std::chrono::seconds d, std::string file_output) {
         while(running && a < d) {
             a += 1s;
             std::this_thread::sleep_for(1s);
+            const std::lock_guard<std::mutex> lock(windows_mutex);
+            sample_windows();
         }
     }
 }
@@ -0,0 +1,228 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <common/trace_util.hpp>
+
+#include <cstring>
+#include <ctime>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace gkfs::trace {
+
+namespace {
+
+thread_local uint64_t rng_state = 0;
+thread_local uint32_t thread_id = 0;
+uint32_t process_id = 0;
+
+// xorshift64*, seeded per thread
+uint64_t
+next_random() {
+    if(rng_state == 0) {
+        rng_state = now() ^ (static_cast<uint64_t>(::getpid()) << 32) ^
+                    reinterpret_cast<uintptr_t>(&rng_state);
+        if(rng_state == 0) {
+            rng_state = 0x9e3779b97f4a7c15ull;
+        }
+    }
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545f4914f6cdd1dull;
+}
+
+void
+set_ids(record& r) {
+    if(thread_id == 0) {
+        thread_id = static_cast<uint32_t>(::syscall(SYS_gettid));
+    }
+    if(process_id == 0) {
+        process_id = static_cast<uint32_t>(::getpid());
+    }
+    r.pid = process_id;
+    r.tid = thread_id;
+}
+
+} // namespace
+
+uint64_t
+now() {
+    struct timespec ts {};
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull +
+           static_cast<uint64_t>(ts.tv_nsec);
+}
+
+uint64_t
+new_id() {
+    uint64_t id;
+    do {
+        id = next_random();
+    } while(id == 0);
+    return id;
+}
+
+bool
+sample(double rate) {
+    if(rate <= 0.0) {
+        return false;
+    }
+    if(rate >= 1.0) {
+        return true;
+    }
+    // compare the top 53 bits to the rate
+    return static_cast<double>(next_random() >> 11) <
+           rate * static_cast<double>(uint64_t{1} << 53);
+}
+
+writer::writer(int fd, write_fn write) : fd_(fd), write_(write) {
+    buffer_.reserve(buffer_records);
+    file_header header{};
+    std::memcpy(header.magic, file_magic, sizeof(header.magic));
+    ::gethostname(header.host, sizeof(header.host) - 1);
+    write_out(&header, sizeof(header));
+}
+
+writer::~writer() {
+    flush();
+}
+
+void
+writer::write_out(const void* data, size_t size) {
+    auto p = static_cast<const char*>(data);
+    while(size > 0) {
+        auto n = write_(fd_, p, size);
+        if(n <= 0) {
+            // tracing is best effort, drop what cannot be written
+            return;
+        }
+        p += n;
+        size -= n;
+    }
+}
+
+void
+writer::flush_locked() {
+    if(!buffer_.empty()) {
+        write_out(buffer_.data(), buffer_.size() * sizeof(record));
+        buffer_.clear();
+    }
+}
+
+void
+writer::add(const record& r) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer_.push_back(r);
+    if(buffer_.size() >= buffer_records) {
+        flush_locked();
+    }
+}
+
+void
+writer::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flush_locked();
+}
+
+span::span(writer* w, const char* name, uint64_t trace_id, uint64_t parent_id,
+           uint64_t start) {
+    if(w == nullptr || trace_id == 0) {
+        return;
+    }
+    writer_ = w;
+    record_.trace_id = trace_id;
+    record_.span_id = new_id();
+    record_.parent_id = parent_id;
+    record_.start = start != 0 ? start : now();
+    std::strncpy(record_.name, name, sizeof(record_.name));
+}
+
+span::span(span&& other) noexcept
+    : writer_(other.writer_), record_(other.record_) {
+    other.writer_ = nullptr;
+}
+
+span&
+span::operator=(span&& other) noexcept {
+    if(this != &other) {
+        end();
+        writer_ = other.writer_;
+        record_ = other.record_;
+        other.writer_ = nullptr;
+    }
+    return *this;
+}
+
+span::~span() {
+    end();
+}
+
+context
+span::rpc_context() const {
+    if(!active()) {
+        return {};
+    }
+    return {record_.trace_id, record_.span_id, now()};
+}
+
+span
+span::child(const char* name) const {
+    if(!active()) {
+        return {};
+    }
+    return span(writer_, name, record_.trace_id, record_.span_id);
+}
+
+void
+span::end(uint64_t time) {
+    if(!active()) {
+        return;
+    }
+    record_.end = time != 0 ? time : now();
+    set_ids(record_);
+    writer_->add(record_);
+    writer_ = nullptr;
+}
+
+span
+handler_span(writer* w, const char* name, const context& rpc) {
+    if(w == nullptr || !rpc) {
+        return {};
+    }
+    auto start = now();
+    // clocks of different nodes may disagree, which must not result in a
+    // negative queue time
+    if(rpc.send_time != 0 && rpc.send_time < start) {
+        span queue(w, "queue", rpc.trace_id, rpc.span_id, rpc.send_time);
+        queue.end(start);
+    }
+    return span(w, name, rpc.trace_id, rpc.span_id, start);
+}
+
+} // namespace gkfs::trace
@@ -33,9 +33,12 @@
 #include <daemon/backend/data/data_module.hpp>
 #include <daemon/backend/data/chunk_storage.hpp>
 #include <daemon/backend/data/file_handle.hpp>
+#include <daemon/backend/data/container_store.hpp>
 #include <common/path_util.hpp>
+#include <config.hpp>
 
 #include <cerrno>
+#include <chrono>
 
 #include <filesystem>
 #include <spdlog/spdlog.h>
@@ -43,7 +46,9 @@
 extern "C" {
 #include <sys/statfs.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
+#include <limits.h>
 }
 
 namespace fs = std::filesystem;
@@ -98,7 +103,8 @@ ChunkStorage::init_chunk_space(const string& file_path) const {
 
 // public functions
 
-ChunkStorage::ChunkStorage(string& path, const size_t chunksize)
+ChunkStorage::ChunkStorage(string& path, const size_t chunksize,
+                           string_view backend)
     : root_path_(path), chunksize_(chunksize) {
     /* Get logger instance and set it for data module and chunk storage */
     GKFS_DATA_MOD->log(spdlog::get(GKFS_DATA_MOD->LOGGER_NAME));
@@ -113,12 +119,42 @@ ChunkStorage::ChunkStorage(string& path, const size_t chunksize)
                 __func__, root_path_);
         throw ChunkStorageException(EPERM, err_str);
     }
-    log_->debug("{}() Chunk storage initialized with path: '{}'", __func__,
-                root_path_);
+    if(backend == container_backend) {
+        container_ = make_unique<ContainerStore>(root_path_, chunksize_, log_);
+    } else if(backend != file_backend) {
+        throw ChunkStorageException(
+                EINVAL, fmt::format("{}() Unknown chunk backend '{}'",
+                                    __func__, backend));
+    } else {
+        // tombstones must be on the same file system to be renamed into
+        trash_path_ = (fs::path(root_path_).parent_path() /
+                       gkfs::config::data::trash_dir)
+                              .native();
+        std::error_code ec;
+        fs::create_directories(trash_path_, ec);
+        if(ec)
+            throw ChunkStorageException(
+                    ec.value(),
+                    fmt::format("{}() Failed to create tombstone directory "
+                                "'{}': '{}'",
+                                __func__, trash_path_, ec.message()));
+        // tombstones left by a previous run must not be overwritten
+        tombstone_seq_ = chrono::duration_cast<chrono::microseconds>(
+                                 chrono::system_clock::now().time_since_epoch())
+                                 .count();
+    }
+    log_->debug("{}() Chunk storage initialized with path: '{}' backend: '{}'",
+                __func__, root_path_, backend);
 }
 
+ChunkStorage::~ChunkStorage() = default;
+
 void
 ChunkStorage::destroy_chunk_space(const string& file_path) const {
+    if(container_) {
+        container_->trim(file_path, 0);
+        return;
+    }
     auto chunk_dir = absolute(get_chunks_dir(file_path));
     try {
         // Note: remove_all does not throw an error when path doesn't exist.
@@ -133,6 +169,77 @@ ChunkStorage::destroy_chunk_space(const string& file_path) const {
     }
 }
 
+bool
+ChunkStorage::tombstone_chunk_space(const string& file_path) const {
+    if(container_) {
+        container_->trim(file_path, 0);
+        return false;
+    }
+    auto chunk_dir = absolute(get_chunks_dir(file_path));
+    while(true) {
+        auto tombstone = fmt::format("{}/{}", trash_path_, tombstone_seq_++);
+        if(rename(chunk_dir.c_str(), tombstone.c_str()) == 0) {
+            log_->debug("{}() Moved '{}' to tombstone '{}'", __func__,
+                        chunk_dir, tombstone);
+            return true;
+        }
+        if(errno == ENOENT)
+            return false;
+        if(errno != EEXIST && errno != ENOTEMPTY) {
+            auto err_str = fmt::format(
+                    "{}() Failed to move chunk directory to tombstone. Path: '{}', Error: '{}'",
+                    __func__, chunk_dir, ::strerror(errno));
+            throw ChunkStorageException(errno, err_str);
+        }
+    }
+}
+
+/**
+ * @internal
+ * Only one caller, the daemon's chunk collector, is expected at a time. Only
+ * removed entries are counted so that the caller stops once no progress is
+ * made. A tombstone with a chunk file that cannot be removed is skipped from
+ * then on, it is retried by the next daemon run.
+ * @endinternal
+ */
+size_t
+ChunkStorage::reclaim_tombstones(size_t max_entries) const {
+    if(container_)
+        return 0;
+    size_t removed = 0;
+    const fs::directory_iterator end;
+    std::error_code ec;
+    for(fs::directory_iterator tombstone(trash_path_, ec);
+        !ec && tombstone != end && removed < max_entries;
+        tombstone.increment(ec)) {
+        if(stuck_tombstones_.count(tombstone->path().native()))
+            continue;
+        std::error_code chunk_ec;
+        auto stuck = false;
+        for(fs::directory_iterator chunk_file(tombstone->path(), chunk_ec);
+            !chunk_ec && chunk_file != end && removed < max_entries;
+            chunk_file.increment(chunk_ec)) {
+            if(unlink(chunk_file->path().c_str()) == 0) {
+                removed++;
+            } else if(errno != ENOENT) {
+                log_->warn(
+                        "{}() Failed to remove chunk file, skipping tombstone. File: '{}', Error: '{}'",
+                        __func__, chunk_file->path().native(),
+                        ::strerror(errno));
+                stuck = true;
+                break;
+            }
+        }
+        if(stuck) {
+            stuck_tombstones_.insert(tombstone->path().native());
+            continue;
+        }
+        if(removed < max_entries && rmdir(tombstone->path().c_str()) == 0)
+            removed++;
+    }
+    return removed;
+}
+
 /**
  * @internal
  * Refer to
@@ -146,6 +253,10 @@ ChunkStorage::write_chunk(const string& file_path,
                           size_t size, off64_t offset) const {
 
     assert((offset + size) <= chunksize_);
+    if(container_)
+        return container_->write(
+                file_path, chunk_id,
+                {iovec{const_cast<char*>(buf), size}}, offset);
     // may throw ChunkStorageException on failure
     init_chunk_space(file_path);
 
@@ -184,6 +295,73 @@ ChunkStorage::write_chunk(const string& file_path,
     return wrote_total;
 }
 
+/**
+ * @internal
+ * A short pwritev() continues with the remaining part of the buffer list.
+ * @endinternal
+ */
+ssize_t
+ChunkStorage::write_chunk(const string& file_path,
+                          gkfs::rpc::chnk_id_t chunk_id,
+                          vector<struct iovec> iov, off64_t offset) const {
+
+    size_t size{};
+    for(const auto& v : iov)
+        size += v.iov_len;
+    assert((offset + size) <= chunksize_);
+    if(container_)
+        return container_->write(file_path, chunk_id, std::move(iov), offset);
+    // may throw ChunkStorageException on failure
+    init_chunk_space(file_path);
+
+    auto chunk_path = absolute(get_chunk_path(file_path, chunk_id));
+
+    FileHandle fh(open(chunk_path.c_str(), O_WRONLY | O_CREAT, 0640),
+                  chunk_path);
+    if(!fh.valid()) {
+        auto err_str = fmt::format(
+                "{}() Failed to open chunk file for write. File: '{}', Error: '{}'",
+                __func__, chunk_path, ::strerror(errno));
+        throw ChunkStorageException(errno, err_str);
+    }
+
+    size_t wrote_total{};
+    size_t iov_idx{};
+
+    while(wrote_total != size) {
+        auto iov_cnt = static_cast<int>(
+                min(iov.size() - iov_idx, static_cast<size_t>(IOV_MAX)));
+        auto wrote = pwritev(fh.native(), iov.data() + iov_idx, iov_cnt,
+                             offset + wrote_total);
+
+        if(wrote < 0) {
+            // retry if a signal or anything else has interrupted the write
+            // system call
+            if(errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+                continue;
+            auto err_str = fmt::format(
+                    "{}() Failed to write chunk file. File: '{}', size: '{}', offset: '{}', Error: '{}'",
+                    __func__, chunk_path, size, offset, ::strerror(errno));
+            throw ChunkStorageException(errno, err_str);
+        }
+        wrote_total += wrote;
+        // skip fully written buffers and trim a partially written one
+        auto left = static_cast<size_t>(wrote);
+        while(iov_idx < iov.size() && left >= iov[iov_idx].iov_len) {
+            left -= iov[iov_idx].iov_len;
+            iov_idx++;
+        }
+        if(left > 0) {
+            iov[iov_idx].iov_base =
+                    static_cast<char*>(iov[iov_idx].iov_base) + left;
+            iov[iov_idx].iov_len -= left;
+        }
+    }
+
+    // file is closed via the file handle's destructor.
+    return wrote_total;
+}
+
 /**
  * @internal
  * Refer to
@@ -195,6 +373,8 @@ ssize_t
 ChunkStorage::read_chunk(const string& file_path, gkfs::rpc::chnk_id_t chunk_id,
                          char* buf, size_t size, off64_t offset) const {
     assert((offset + size) <= chunksize_);
+    if(container_)
+        return container_->read(file_path, chunk_id, buf, size, offset);
     auto chunk_path = absolute(get_chunk_path(file_path, chunk_id));
 
     FileHandle fh(open(chunk_path.c_str(), O_RDONLY), chunk_path);
@@ -204,11 +384,125 @@ ChunkStorage::read_chunk(const string& file_path, gkfs::rpc::chnk_id_t chunk_id,
                 __func__, chunk_path, ::strerror(errno));
         throw ChunkStorageException(errno, err_str);
     }
+    // file is closed via the file handle's destructor.
+    return read_range(fh.native(), chunk_path, buf, size, offset);
+}
+
+/**
+ * @internal
+ * Data regions are found with lseek(SEEK_DATA/SEEK_HOLE) and read one by one.
+ * If the local file system does not support these, the whole file is reported
+ * as data by the kernel and one extent is read. Reads beyond the end of the
+ * chunk file return no extent, like holes.
+ * @endinternal
+ */
+ssize_t
+ChunkStorage::read_chunk_extents(const string& file_path,
+                                 gkfs::rpc::chnk_id_t chunk_id, char* buf,
+                                 size_t size, off64_t offset,
+                                 vector<pair<size_t, size_t>>& extents) const {
+    assert((offset + size) <= chunksize_);
+    extents.clear();
+    if(container_) {
+        auto read = container_->read(file_path, chunk_id, buf, size, offset);
+        if(read > 0)
+            extents.emplace_back(0, static_cast<size_t>(read));
+        return read;
+    }
+    auto chunk_path = absolute(get_chunk_path(file_path, chunk_id));
+
+    FileHandle fh(open(chunk_path.c_str(), O_RDONLY), chunk_path);
+    if(!fh.valid()) {
+        auto err_str = fmt::format(
+                "{}() Failed to open chunk file for read. File: '{}', Error: '{}'",
+                __func__, chunk_path, ::strerror(errno));
+        throw ChunkStorageException(errno, err_str);
+    }
+    auto end = offset + static_cast<off64_t>(size);
+    auto pos = offset;
+    size_t read_total = 0;
+    while(pos < end) {
+        auto data = lseek64(fh.native(), pos, SEEK_DATA);
+        if(data < 0) {
+            // ENXIO: no data after pos
+            if(errno == ENXIO)
+                break;
+            auto err_str = fmt::format(
+                    "Failed to seek data in chunk file. File: '{}', offset: '{}', Error: '{}'",
+                    chunk_path, pos, ::strerror(errno));
+            throw ChunkStorageException(errno, err_str);
+        }
+        if(data >= end)
+            break;
+        auto hole = lseek64(fh.native(), data, SEEK_HOLE);
+        if(hole < 0) {
+            auto err_str = fmt::format(
+                    "Failed to seek hole in chunk file. File: '{}', offset: '{}', Error: '{}'",
+                    chunk_path, data, ::strerror(errno));
+            throw ChunkStorageException(errno, err_str);
+        }
+        auto len = static_cast<size_t>(min(hole, end) - data);
+        auto read = read_range(fh.native(), chunk_path, buf + (data - offset),
+                               len, data);
+        if(read > 0)
+            extents.emplace_back(static_cast<size_t>(data - offset), read);
+        read_total += read;
+        // chunk file was truncated concurrently
+        if(read < len)
+            break;
+        pos = data + static_cast<off64_t>(len);
+    }
+    return read_total;
+}
+
+void*
+ChunkStorage::map_chunk(const string& file_path, gkfs::rpc::chnk_id_t chunk_id,
+                        size_t& size) const {
+    size = 0;
+    if(container_)
+        throw ChunkStorageException(
+                ENOTSUP, "Chunks in container files cannot be mapped");
+    auto chunk_path = absolute(get_chunk_path(file_path, chunk_id));
+
+    FileHandle fh(open(chunk_path.c_str(), O_RDONLY), chunk_path);
+    if(!fh.valid()) {
+        auto err_str = fmt::format(
+                "{}() Failed to open chunk file for mapping. File: '{}', Error: '{}'",
+                __func__, chunk_path, ::strerror(errno));
+        throw ChunkStorageException(errno, err_str);
+    }
+    struct stat st {};
+    if(fstat(fh.native(), &st) != 0) {
+        auto err_str = fmt::format(
+                "{}() Failed to stat chunk file. File: '{}', Error: '{}'",
+                __func__, chunk_path, ::strerror(errno));
+        throw ChunkStorageException(errno, err_str);
+    }
+    if(st.st_size == 0)
+        return nullptr;
+    auto* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                      MAP_SHARED, fh.native(), 0);
+    if(addr == MAP_FAILED) {
+        auto err_str = fmt::format(
+                "{}() Failed to map chunk file. File: '{}', Error: '{}'",
+                __func__, chunk_path, ::strerror(errno));
+        throw ChunkStorageException(errno, err_str);
+    }
+    // the pages are pushed to the client right away
+    madvise(addr, static_cast<size_t>(st.st_size), MADV_WILLNEED);
+    size = static_cast<size_t>(st.st_size);
+    // the mapping stays valid after the file handle is closed
+    return addr;
+}
+
+size_t
+ChunkStorage::read_range(int fd, const string& chunk_path, char* buf,
+                         size_t size, off64_t offset) const {
     size_t read_total = 0;
     ssize_t read = 0;
 
     do {
-        read = pread64(fh.native(), buf + read_total, size - read_total,
+        read = pread64(fd, buf + read_total, size - read_total,
                        offset + read_total);
         if(read == 0) {
             /*
@@ -242,7 +536,6 @@ ChunkStorage::read_chunk(const string& file_path, gkfs::rpc::chnk_id_t chunk_id,
         read_total += read;
     } while(read_total != size);
 
-    // file is closed via the file handle's destructor.
     return read_total;
 }
 
@@ -261,7 +554,10 @@ ChunkStorage::read_chunk(const string& file_path, gkfs::rpc::chnk_id_t chunk_id,
 void
 ChunkStorage::trim_chunk_space(const string& file_path,
                                gkfs::rpc::chnk_id_t chunk_start) {
-
+    if(container_) {
+        container_->trim(file_path, chunk_start);
+        return;
+    }
     auto chunk_dir = absolute(get_chunks_dir(file_path));
     const fs::directory_iterator end;
     auto err_flag = false;
@@ -290,9 +586,13 @@ ChunkStorage::trim_chunk_space(const string& file_path,
 void
 ChunkStorage::truncate_chunk_file(const string& file_path,
                                   gkfs::rpc::chnk_id_t chunk_id, off_t length) {
-    auto chunk_path = absolute(get_chunk_path(file_path, chunk_id));
     assert(length > 0 &&
            static_cast<gkfs::rpc::chnk_id_t>(length) <= chunksize_);
+    if(container_) {
+        container_->truncate(file_path, chunk_id, length);
+        return;
+    }
+    auto chunk_path = absolute(get_chunk_path(file_path, chunk_id));
     auto ret = truncate(chunk_path.c_str(), length);
     if(ret == -1) {
         auto err_str = fmt::format(
@@ -302,6 +602,23 @@ ChunkStorage::truncate_chunk_file(const string& file_path,
     }
 }
 
+void
+ChunkStorage::remove_chunk(const string& file_path,
+                           gkfs::rpc::chnk_id_t chunk_id) const {
+    if(container_) {
+        container_->remove(file_path, chunk_id);
+        return;
+    }
+    auto chunk_path = absolute(get_chunk_path(file_path, chunk_id));
+    auto ret = unlink(chunk_path.c_str());
+    if(ret == -1 && errno != ENOENT) {
+        auto err_str = fmt::format(
+                "Failed to remove chunk file. File: '{}', Error: '{}'",
+                chunk_path, ::strerror(errno));
+        throw ChunkStorageException(errno, err_str);
+    }
+}
+
 /**
  * @internal
  * Return ChunkStat with following fields:
@@ -327,6 +644,9 @@ ChunkStorage::chunk_stat() const {
                        static_cast<unsigned long long>(sfs.f_blocks);
     auto bytes_free = static_cast<unsigned long long>(sfs.f_bsize) *
                       static_cast<unsigned long long>(sfs.f_bavail);
+    // space that is free within the containers can be reused as well
+    if(container_)
+        bytes_free += container_->free_bytes();
     return {chunksize_, bytes_total / chunksize_, bytes_free / chunksize_};
 }
 
@@ -0,0 +1,692 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+/**
+ * @brief Definitions of the container chunk backend.
+ */
+
+#include <daemon/backend/data/container_store.hpp>
+#include <daemon/backend/data/chunk_storage.hpp>
+#include <config.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <optional>
+
+#include <spdlog/spdlog.h>
+
+extern "C" {
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/falloc.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+using namespace std;
+
+namespace gkfs::data {
+
+namespace {
+
+constexpr auto log_name = "extents.log";
+
+enum class log_op : uint8_t { put = 1, remove = 2 };
+
+template <typename T>
+void
+append_pod(string& buf, T value) {
+    buf.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool
+read_pod(const string& buf, size_t& pos, T& value) {
+    if(pos + sizeof(T) > buf.size())
+        return false;
+    ::memcpy(&value, buf.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+/**
+ * @brief Serializes one extent log record.
+ * @internal
+ * Layout: op (u8), container (u32), chunk id (u64), offset (u64), capacity
+ * (u64), length (u64), path length (u32), path bytes.
+ * @endinternal
+ */
+void
+append_record(string& buf, log_op op, const string& path,
+              gkfs::rpc::chnk_id_t chunk_id, const Extent& extent) {
+    append_pod(buf, static_cast<uint8_t>(op));
+    append_pod(buf, extent.container);
+    append_pod(buf, static_cast<uint64_t>(chunk_id));
+    append_pod(buf, extent.offset);
+    append_pod(buf, extent.capacity);
+    append_pod(buf, extent.length);
+    append_pod(buf, static_cast<uint32_t>(path.size()));
+    buf.append(path);
+}
+
+void
+write_all(int fd, const string& buf) {
+    size_t wrote_total = 0;
+    while(wrote_total != buf.size()) {
+        auto wrote = ::write(fd, buf.data() + wrote_total,
+                             buf.size() - wrote_total);
+        if(wrote < 0) {
+            if(errno == EINTR || errno == EAGAIN)
+                continue;
+            throw ChunkStorageException(
+                    errno, fmt::format("Failed to write extent log: '{}'",
+                                       ::strerror(errno)));
+        }
+        wrote_total += wrote;
+    }
+}
+
+void
+pread_all(int fd, char* buf, size_t size, uint64_t offset) {
+    size_t read_total = 0;
+    while(read_total != size) {
+        auto read = pread64(fd, buf + read_total, size - read_total,
+                            offset + read_total);
+        if(read < 0) {
+            if(errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+                continue;
+            throw ChunkStorageException(
+                    errno, fmt::format("Failed to read container: '{}'",
+                                       ::strerror(errno)));
+        }
+        // the extent lies within the container, so this is a sparse tail
+        if(read == 0) {
+            ::memset(buf + read_total, 0, size - read_total);
+            break;
+        }
+        read_total += read;
+    }
+}
+
+void
+pwritev_all(int fd, vector<struct iovec>& iov, uint64_t offset) {
+    size_t iov_idx = 0;
+    uint64_t pos = offset;
+    while(iov_idx < iov.size()) {
+        auto iov_cnt = static_cast<int>(
+                min(iov.size() - iov_idx, static_cast<size_t>(IOV_MAX)));
+        auto wrote = pwritev(fd, iov.data() + iov_idx, iov_cnt, pos);
+        if(wrote < 0) {
+            if(errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+                continue;
+            throw ChunkStorageException(
+                    errno, fmt::format("Failed to write container: '{}'",
+                                       ::strerror(errno)));
+        }
+        pos += wrote;
+        auto left = static_cast<size_t>(wrote);
+        while(iov_idx < iov.size() && left >= iov[iov_idx].iov_len) {
+            left -= iov[iov_idx].iov_len;
+            iov_idx++;
+        }
+        if(left > 0) {
+            iov[iov_idx].iov_base =
+                    static_cast<char*>(iov[iov_idx].iov_base) + left;
+            iov[iov_idx].iov_len -= left;
+        }
+    }
+}
+
+uint64_t
+round_up(uint64_t value, uint64_t step) {
+    return ((value + step - 1) / step) * step;
+}
+
+} // namespace
+
+// private functions
+
+string
+ContainerStore::container_path(uint32_t container) const {
+    return fmt::format("{}/container.{}", dir_, container);
+}
+
+uint64_t
+ContainerStore::capacity_for(uint64_t size) const {
+    uint64_t capacity = gkfs::config::data::container_block_size;
+    while(capacity < size)
+        capacity <<= 1;
+    return min(capacity, static_cast<uint64_t>(chunksize_));
+}
+
+uint32_t
+ContainerStore::container_for(const chunk_key& key) const {
+    return static_cast<uint32_t>((hash<string>{}(key.first) + key.second) %
+                                 fds_.size());
+}
+
+Extent
+ContainerStore::allocate(uint32_t container, uint64_t capacity) {
+    auto& allocator = allocators_[container];
+    auto offset = allocator.allocate(capacity);
+    auto end = offset + capacity;
+    if(end > preallocated_[container]) {
+        auto size = round_up(end, gkfs::config::data::container_grow_size);
+        auto fd = fds_[container];
+        auto err = fallocate(fd, 0, preallocated_[container],
+                             size - preallocated_[container]);
+        if(err != 0 && errno == EOPNOTSUPP)
+            err = ftruncate(fd, size);
+        if(err != 0) {
+            auto err_no = errno;
+            allocator.release(offset, capacity);
+            throw ChunkStorageException(
+                    err_no,
+                    fmt::format("{}() Failed to grow container '{}': '{}'",
+                                __func__, container_path(container),
+                                ::strerror(err_no)));
+        }
+        preallocated_[container] = size;
+    }
+    return Extent{container, offset, capacity, 0};
+}
+
+void
+ContainerStore::release(const Extent& extent) {
+    auto fd = fds_[extent.container];
+    // return the space to the file system, old data reads as zeros afterwards
+    if(fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, extent.offset,
+                 extent.capacity) != 0)
+        log_->trace("{}() Failed to punch hole in container '{}': '{}'",
+                    __func__, extent.container, ::strerror(errno));
+    auto& allocator = allocators_[extent.container];
+    allocator.release(extent.offset, extent.capacity);
+    // shrink the container if its tail is no longer used
+    auto size = round_up(allocator.end(),
+                         gkfs::config::data::container_grow_size);
+    if(size < preallocated_[extent.container] &&
+       ftruncate(fd, size) == 0)
+        preallocated_[extent.container] = size;
+}
+
+void
+ContainerStore::relocate(map<chunk_key, Extent>::iterator it, uint64_t size) {
+    auto& old_extent = it->second;
+    auto new_extent = allocate(old_extent.container, capacity_for(size));
+    new_extent.length = old_extent.length;
+    try {
+        copy(old_extent, new_extent);
+    } catch(const ChunkStorageException& e) {
+        allocators_[new_extent.container].release(new_extent.offset,
+                                                  new_extent.capacity);
+        throw;
+    }
+    release(old_extent);
+    old_extent = new_extent;
+    log_extent(it->first, &old_extent);
+}
+
+void
+ContainerStore::copy(const Extent& from, const Extent& to) const {
+    if(from.length == 0)
+        return;
+    vector<char> buf(from.length);
+    pread_all(fds_[from.container], buf.data(), buf.size(), from.offset);
+    vector<struct iovec> iov{{buf.data(), buf.size()}};
+    pwritev_all(fds_[to.container], iov, to.offset);
+}
+
+void
+ContainerStore::zero(const Extent& extent, uint64_t from, uint64_t to) const {
+    assert(from <= to && to <= extent.capacity);
+    if(from == to)
+        return;
+    auto fd = fds_[extent.container];
+    if(fallocate(fd, FALLOC_FL_ZERO_RANGE | FALLOC_FL_KEEP_SIZE,
+                 extent.offset + from, to - from) == 0)
+        return;
+    vector<char> zeros(to - from, 0);
+    vector<struct iovec> iov{{zeros.data(), zeros.size()}};
+    pwritev_all(fd, iov, extent.offset + from);
+}
+
+void
+ContainerStore::log_extent(const chunk_key& key, const Extent* extent) {
+    string buf{};
+    if(extent)
+        append_record(buf, log_op::put, key.first, key.second, *extent);
+    else
+        append_record(buf, log_op::remove, key.first, key.second, Extent{});
+    try {
+        write_all(log_fd_, buf);
+        log_records_++;
+    } catch(const ChunkStorageException& e) {
+        // the in-memory index stays valid, only a restart would lose it
+        log_->error("{}() {}", __func__, e.what());
+    }
+    if(log_tail_active_) {
+        log_tail_.append(buf);
+        log_tail_records_++;
+    }
+}
+
+void
+ContainerStore::load_index() {
+    auto log_path = fmt::format("{}/{}", dir_, log_name);
+    string buf{};
+    {
+        ifstream in(log_path, ios::binary);
+        if(in)
+            buf.assign(istreambuf_iterator<char>(in),
+                       istreambuf_iterator<char>());
+    }
+    size_t pos = 0;
+    uint32_t containers = gkfs::config::data::container_count;
+    while(pos < buf.size()) {
+        uint8_t op{};
+        uint64_t chunk_id{};
+        uint32_t path_len{};
+        Extent extent{};
+        if(!read_pod(buf, pos, op) || !read_pod(buf, pos, extent.container) ||
+           !read_pod(buf, pos, chunk_id) ||
+           !read_pod(buf, pos, extent.offset) ||
+           !read_pod(buf, pos, extent.capacity) ||
+           !read_pod(buf, pos, extent.length) ||
+           !read_pod(buf, pos, path_len) || pos + path_len > buf.size()) {
+            log_->warn("{}() Ignoring truncated record at the end of '{}'",
+                       __func__, log_path);
+            break;
+        }
+        chunk_key key{buf.substr(pos, path_len), chunk_id};
+        pos += path_len;
+        if(op == static_cast<uint8_t>(log_op::put)) {
+            index_[key] = extent;
+            containers = max(containers, extent.container + 1);
+        } else {
+            index_.erase(key);
+        }
+    }
+
+    // open containers, including ones of a previous run with more of them
+    vector<vector<pair<uint64_t, uint64_t>>> used(containers);
+    for(const auto& [key, extent] : index_)
+        used[extent.container].emplace_back(extent.offset, extent.capacity);
+    allocators_.resize(containers);
+    for(uint32_t c = 0; c < containers; c++) {
+        auto path = container_path(c);
+        auto fd = open(path.c_str(), O_RDWR | O_CREAT, 0640);
+        if(fd < 0)
+            throw ChunkStorageException(
+                    errno, fmt::format("{}() Failed to open container '{}': '{}'",
+                                       __func__, path, ::strerror(errno)));
+        fds_.push_back(fd);
+        struct stat st {};
+        fstat(fd, &st);
+        preallocated_.push_back(static_cast<uint64_t>(st.st_size));
+        allocators_[c].rebuild(std::move(used[c]));
+    }
+    log_->debug("{}() Loaded '{}' extents in '{}' containers", __func__,
+                index_.size(), containers);
+    rewrite_log();
+}
+
+/**
+ * @internal
+ * The live records are serialized under index_mutex_, but written and synced
+ * without it. Records logged meanwhile are collected in log_tail_ and appended
+ * to the new log under index_mutex_ right before it replaces the old one.
+ * @endinternal
+ */
+void
+ContainerStore::rewrite_log() {
+    auto log_path = fmt::format("{}/{}", dir_, log_name);
+    auto tmp_path = log_path + ".tmp";
+    string buf{};
+    uint64_t records = 0;
+    {
+        lock_guard<mutex> lock(index_mutex_);
+        for(const auto& [key, extent] : index_)
+            append_record(buf, log_op::put, key.first, key.second, extent);
+        records = index_.size();
+        log_tail_.clear();
+        log_tail_records_ = 0;
+        log_tail_active_ = true;
+    }
+    auto stop_tail = [this] {
+        lock_guard<mutex> lock(index_mutex_);
+        log_tail_active_ = false;
+        log_tail_.clear();
+    };
+    auto fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0640);
+    if(fd < 0) {
+        auto err_no = errno;
+        stop_tail();
+        throw ChunkStorageException(
+                err_no, fmt::format("{}() Failed to create '{}': '{}'",
+                                    __func__, tmp_path, ::strerror(err_no)));
+    }
+    try {
+        write_all(fd, buf);
+    } catch(const ChunkStorageException& e) {
+        close(fd);
+        stop_tail();
+        throw;
+    }
+    fsync(fd);
+
+    lock_guard<mutex> lock(index_mutex_);
+    log_tail_active_ = false;
+    try {
+        write_all(fd, log_tail_);
+    } catch(const ChunkStorageException& e) {
+        close(fd);
+        log_tail_.clear();
+        throw;
+    }
+    records += log_tail_records_;
+    log_tail_.clear();
+    close(fd);
+    if(rename(tmp_path.c_str(), log_path.c_str()) != 0)
+        throw ChunkStorageException(
+                errno, fmt::format("{}() Failed to replace '{}': '{}'",
+                                   __func__, log_path, ::strerror(errno)));
+    if(log_fd_ >= 0)
+        close(log_fd_);
+    log_fd_ = open(log_path.c_str(), O_WRONLY | O_APPEND);
+    if(log_fd_ < 0)
+        throw ChunkStorageException(
+                errno, fmt::format("{}() Failed to open '{}': '{}'", __func__,
+                                   log_path, ::strerror(errno)));
+    log_records_ = records;
+}
+
+void
+ContainerStore::erase(map<chunk_key, Extent>::iterator first,
+                      map<chunk_key, Extent>::iterator last) {
+    for(auto it = first; it != last; ++it) {
+        release(it->second);
+        log_extent(it->first, nullptr);
+    }
+    index_.erase(first, last);
+}
+
+void
+ContainerStore::compaction_loop() {
+    const auto interval =
+            chrono::seconds(gkfs::config::data::container_compaction_interval);
+    unique_lock<mutex> lock(compactor_mutex_);
+    while(!compactor_cv_.wait_for(lock, interval,
+                                  [this] { return !running_; })) {
+        try {
+            compact();
+        } catch(const exception& e) {
+            log_->error("{}() Compaction failed: '{}'", __func__, e.what());
+        }
+    }
+}
+
+// public functions
+
+ContainerStore::ContainerStore(const string& dir, size_t chunksize,
+                               shared_ptr<spdlog::logger> log)
+    : log_(std::move(log)), dir_(dir), chunksize_(chunksize) {
+    try {
+        load_index();
+    } catch(const ChunkStorageException& e) {
+        for(auto fd : fds_)
+            close(fd);
+        throw;
+    }
+    compactor_ = thread([this] { compaction_loop(); });
+    log_->debug("{}() Container store initialized with '{}' containers in '{}'",
+                __func__, fds_.size(), dir_);
+}
+
+ContainerStore::~ContainerStore() {
+    {
+        lock_guard<mutex> lock(compactor_mutex_);
+        running_ = false;
+    }
+    compactor_cv_.notify_all();
+    if(compactor_.joinable())
+        compactor_.join();
+    for(auto fd : fds_)
+        close(fd);
+    if(log_fd_ >= 0)
+        close(log_fd_);
+}
+
+ssize_t
+ContainerStore::write(const string& file_path, gkfs::rpc::chnk_id_t chunk_id,
+                      vector<struct iovec> iov, off64_t offset) {
+    uint64_t size = 0;
+    for(const auto& v : iov)
+        size += v.iov_len;
+    uint64_t end = offset + size;
+    assert(end <= chunksize_);
+    chunk_key key{file_path, chunk_id};
+
+    while(true) {
+        {
+            shared_lock<shared_mutex> io_lock(io_mutex_);
+            optional<Extent> extent{};
+            {
+                lock_guard<mutex> lock(index_mutex_);
+                auto it = index_.find(key);
+                auto created = false;
+                if(it == index_.end()) {
+                    it = index_.emplace(key, allocate(container_for(key),
+                                                      capacity_for(end)))
+                                 .first;
+                    created = true;
+                }
+                auto& e = it->second;
+                if(e.capacity >= end) {
+                    // never expose what a previous owner left in the gap
+                    if(static_cast<uint64_t>(offset) > e.length)
+                        zero(e, e.length, offset);
+                    if(end > e.length || created) {
+                        e.length = max(e.length, end);
+                        log_extent(key, &e);
+                    }
+                    extent = e;
+                }
+            }
+            if(extent) {
+                pwritev_all(fds_[extent->container], iov,
+                            extent->offset + offset);
+                return static_cast<ssize_t>(size);
+            }
+        }
+        // the extent is too small and is moved while no I/O is in flight
+        unique_lock<shared_mutex> io_lock(io_mutex_);
+        lock_guard<mutex> lock(index_mutex_);
+        auto it = index_.find(key);
+        if(it != index_.end() && it->second.capacity < end)
+            relocate(it, end);
+    }
+}
+
+ssize_t
+ContainerStore::read(const string& file_path, gkfs::rpc::chnk_id_t chunk_id,
+                     char* buf, size_t size, off64_t offset) const {
+    assert(offset + size <= chunksize_);
+    shared_lock<shared_mutex> io_lock(io_mutex_);
+    Extent extent{};
+    {
+        lock_guard<mutex> lock(index_mutex_);
+        auto it = index_.find(chunk_key{file_path, chunk_id});
+        if(it == index_.end())
+            throw ChunkStorageException(
+                    ENOENT,
+                    fmt::format("{}() Chunk '{}' of file '{}' does not exist",
+                                __func__, chunk_id, file_path));
+        extent = it->second;
+    }
+    if(static_cast<uint64_t>(offset) >= extent.length)
+        return 0;
+    auto read_size = min(static_cast<uint64_t>(size), extent.length - offset);
+    pread_all(fds_[extent.container], buf, read_size, extent.offset + offset);
+    return static_cast<ssize_t>(read_size);
+}
+
+void
+ContainerStore::trim(const string& file_path,
+                     gkfs::rpc::chnk_id_t chunk_start) {
+    unique_lock<shared_mutex> io_lock(io_mutex_);
+    lock_guard<mutex> lock(index_mutex_);
+    auto first = index_.lower_bound(chunk_key{file_path, chunk_start});
+    auto last = index_.upper_bound(chunk_key{
+            file_path, numeric_limits<gkfs::rpc::chnk_id_t>::max()});
+    erase(first, last);
+}
+
+void
+ContainerStore::truncate(const string& file_path,
+                         gkfs::rpc::chnk_id_t chunk_id, off_t length) {
+    assert(length >= 0 && static_cast<uint64_t>(length) <= chunksize_);
+    unique_lock<shared_mutex> io_lock(io_mutex_);
+    lock_guard<mutex> lock(index_mutex_);
+    auto it = index_.find(chunk_key{file_path, chunk_id});
+    if(it == index_.end())
+        throw ChunkStorageException(
+                ENOENT,
+                fmt::format("{}() Chunk '{}' of file '{}' does not exist",
+                            __func__, chunk_id, file_path));
+    auto new_length = static_cast<uint64_t>(length);
+    if(new_length > it->second.capacity)
+        relocate(it, new_length);
+    auto& e = it->second;
+    if(new_length > e.length)
+        zero(e, e.length, new_length);
+    e.length = new_length;
+    log_extent(it->first, &e);
+}
+
+void
+ContainerStore::remove(const string& file_path, gkfs::rpc::chnk_id_t chunk_id) {
+    unique_lock<shared_mutex> io_lock(io_mutex_);
+    lock_guard<mutex> lock(index_mutex_);
+    auto it = index_.find(chunk_key{file_path, chunk_id});
+    if(it != index_.end())
+        erase(it, next(it));
+}
+
+/**
+ * @internal
+ * Extents are moved one at a time, highest offset first, into the best
+ * fitting free range below them. I/O is only blocked while a single extent is
+ * moved. The pass ends for a container once no extent can be moved down.
+ * @endinternal
+ */
+void
+ContainerStore::compact() {
+    for(uint32_t c = 0; c < fds_.size(); c++) {
+        {
+            lock_guard<mutex> lock(index_mutex_);
+            const auto& allocator = allocators_[c];
+            if(allocator.free_bytes() == 0 ||
+               allocator.free_bytes() <
+                       gkfs::config::data::container_compaction_ratio *
+                               allocator.end())
+                continue;
+        }
+        // the index is scanned in slices so that chunk I/O is not blocked for
+        // the whole scan. Extents changed meanwhile are checked when moved.
+        vector<pair<uint64_t, chunk_key>> candidates{};
+        optional<chunk_key> resume{};
+        while(true) {
+            lock_guard<mutex> lock(index_mutex_);
+            auto it = resume ? index_.lower_bound(*resume) : index_.begin();
+            for(size_t scanned = 0;
+                it != index_.end() &&
+                scanned < gkfs::config::data::container_compaction_scan;
+                ++it, ++scanned) {
+                if(it->second.container == c)
+                    candidates.emplace_back(it->second.offset, it->first);
+            }
+            if(it == index_.end())
+                break;
+            resume = it->first;
+        }
+        sort(candidates.rbegin(), candidates.rend());
+        size_t moved = 0;
+        for(const auto& [offset, key] : candidates) {
+            unique_lock<shared_mutex> io_lock(io_mutex_);
+            lock_guard<mutex> lock(index_mutex_);
+            auto it = index_.find(key);
+            if(it == index_.end() || it->second.container != c)
+                continue;
+            auto& extent = it->second;
+            auto target = allocators_[c].allocate_free(extent.capacity,
+                                                       extent.offset);
+            if(!target)
+                break;
+            Extent moved_extent = extent;
+            moved_extent.offset = *target;
+            try {
+                copy(extent, moved_extent);
+            } catch(const ChunkStorageException& e) {
+                allocators_[c].release(*target, moved_extent.capacity);
+                throw;
+            }
+            release(extent);
+            extent = moved_extent;
+            log_extent(key, &extent);
+            moved++;
+        }
+        log_->debug("{}() Moved '{}' extents in container '{}'", __func__,
+                    moved, c);
+    }
+    bool stale_log = false;
+    {
+        lock_guard<mutex> lock(index_mutex_);
+        stale_log = log_records_ > 2 * index_.size() + 1024;
+    }
+    if(stale_log)
+        rewrite_log();
+}
+
+uint64_t
+ContainerStore::free_bytes() const {
+    lock_guard<mutex> lock(index_mutex_);
+    uint64_t bytes = 0;
+    for(uint32_t c = 0; c < allocators_.size(); c++)
+        bytes += allocators_[c].free_bytes() +
+                 (preallocated_[c] - min(preallocated_[c],
+                                         allocators_[c].end()));
+    return bytes;
+}
+
+} // namespace gkfs::data
@@ -0,0 +1,134 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#include <daemon/backend/data/extent_allocator.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+namespace gkfs::data {
+
+void
+ExtentAllocator::insert_free(uint64_t offset, uint64_t size) {
+    free_by_offset_.emplace(offset, size);
+    free_by_size_.emplace(size, offset);
+    free_bytes_ += size;
+}
+
+void
+ExtentAllocator::erase_free(map<uint64_t, uint64_t>::iterator it) {
+    auto range = free_by_size_.equal_range(it->second);
+    for(auto s = range.first; s != range.second; ++s) {
+        if(s->second == it->first) {
+            free_by_size_.erase(s);
+            break;
+        }
+    }
+    free_bytes_ -= it->second;
+    free_by_offset_.erase(it);
+}
+
+uint64_t
+ExtentAllocator::allocate(uint64_t size) {
+    auto offset = allocate_free(size, end_);
+    if(offset)
+        return *offset;
+    auto start = end_;
+    end_ += size;
+    return start;
+}
+
+optional<uint64_t>
+ExtentAllocator::allocate_free(uint64_t size, uint64_t below) {
+    // best fit: smallest free range that holds the request
+    for(auto s = free_by_size_.lower_bound(size); s != free_by_size_.end();
+        ++s) {
+        if(s->second >= below)
+            continue;
+        auto offset = s->second;
+        auto free_size = s->first;
+        erase_free(free_by_offset_.find(offset));
+        if(free_size > size)
+            insert_free(offset + size, free_size - size);
+        return offset;
+    }
+    return {};
+}
+
+void
+ExtentAllocator::release(uint64_t offset, uint64_t size) {
+    assert(offset + size <= end_);
+    // coalesce with the free neighbors
+    auto next = free_by_offset_.lower_bound(offset);
+    if(next != free_by_offset_.end() && offset + size == next->first) {
+        size += next->second;
+        erase_free(next);
+    }
+    auto prev = free_by_offset_.lower_bound(offset);
+    if(prev != free_by_offset_.begin()) {
+        --prev;
+        if(prev->first + prev->second == offset) {
+            offset = prev->first;
+            size += prev->second;
+            erase_free(prev);
+        }
+    }
+    if(offset + size == end_)
+        end_ = offset;
+    else
+        insert_free(offset, size);
+}
+
+void
+ExtentAllocator::rebuild(vector<pair<uint64_t, uint64_t>> used) {
+    end_ = 0;
+    free_bytes_ = 0;
+    free_by_offset_.clear();
+    free_by_size_.clear();
+    sort(used.begin(), used.end());
+    for(const auto& [offset, size] : used) {
+        if(offset > end_)
+            insert_free(end_, offset - end_);
+        end_ = max(end_, offset + size);
+    }
+}
+
+uint64_t
+ExtentAllocator::end() const {
+    return end_;
+}
+
+uint64_t
+ExtentAllocator::free_bytes() const {
+    return free_bytes_;
+}
+
+} // namespace gkfs::data
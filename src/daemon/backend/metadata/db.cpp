@@ -45,7 +45,7 @@ namespace gkfs::metadata {
 /**
  * Factory to create DB instances
  * @param path where KV store data is stored
- * @param id parallax or rocksdb (default) backend
+ * @param id parallax, memory, or rocksdb (default) backend
  */
 struct MetadataDBFactory {
     static std::unique_ptr<AbstractMetadataBackend>
@@ -68,6 +68,14 @@ struct MetadataDBFactory {
                                             metadata_path);
             return std::make_unique<RocksDBBackend>(metadata_path);
 #endif
+        } else if(id == gkfs::metadata::memory_backend) {
+            auto metadata_path =
+                    fmt::format("{}/{}", path, gkfs::metadata::memory_backend);
+            fs::create_directories(metadata_path);
+            GKFS_METADATA_MOD->log()->trace(
+                    "Using in-memory metadata with snapshot directory '{}'",
+                    metadata_path);
+            return std::make_unique<MemoryBackend>(metadata_path);
         }
         GKFS_METADATA_MOD->log()->error("No valid metadata backend selected");
         exit(EXIT_FAILURE);
@@ -185,4 +193,9 @@ MetadataDB::iterate_all() const {
     backend_->iterate_all();
 }
 
+std::vector<std::pair<std::string, uint64_t>>
+MetadataDB::properties() const {
+    return backend_->properties();
+}
+
 } // namespace gkfs::metadata
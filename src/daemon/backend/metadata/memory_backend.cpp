@@ -0,0 +1,418 @@
+/*
+  Copyright 2018-2021, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2021, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#include <daemon/backend/metadata/memory_backend.hpp>
+#include <daemon/backend/metadata/metadata_module.hpp>
+
+#include <common/metadata.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+extern "C" {
+#include <sys/stat.h>
+}
+
+namespace gkfs::metadata {
+
+namespace {
+
+constexpr auto snapshot_file = "memory.snapshot";
+
+/**
+ * Splits a key into its parent directory with trailing slash and its name,
+ * e.g., /foo/bar into /foo/ and bar.
+ * @return false for the root directory which has no parent
+ */
+bool
+split_key(const std::string& key, std::string& parent, std::string& name) {
+    auto pos = key.find_last_of('/');
+    if(key.size() <= 1 || pos == std::string::npos)
+        return false;
+    parent = key.substr(0, pos + 1);
+    name = key.substr(pos + 1);
+    return true;
+}
+
+/**
+ * Sets the new file size and inline data as MetadataMergeOperator does after
+ * applying all operands.
+ */
+void
+finish_size_update(Metadata& md, size_t fsize, bool use_buf,
+                   std::string& inline_data) {
+    if(fsize > gkfs::config::rpc::smallfilesize) {
+        use_buf = false;
+        inline_data.resize(0);
+    } else
+        inline_data.resize(fsize);
+    md.size(fsize);
+    md.buf(inline_data);
+    md.use_buf(use_buf);
+}
+
+} // namespace
+
+MemoryBackend::entry_shard&
+MemoryBackend::shard_of(const std::string& key) {
+    return entry_shards_[std::hash<std::string>{}(key) % entry_shards_.size()];
+}
+
+const MemoryBackend::entry_shard&
+MemoryBackend::shard_of(const std::string& key) const {
+    return entry_shards_[std::hash<std::string>{}(key) % entry_shards_.size()];
+}
+
+void
+MemoryBackend::add_dirent(const std::string& key) {
+    std::string parent, name;
+    if(!split_key(key, parent, name))
+        return;
+    auto& shard = dirent_shards_[std::hash<std::string>{}(parent) %
+                                 dirent_shards_.size()];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.children[parent].insert(std::move(name));
+}
+
+void
+MemoryBackend::remove_dirent(const std::string& key) {
+    std::string parent, name;
+    if(!split_key(key, parent, name))
+        return;
+    auto& shard = dirent_shards_[std::hash<std::string>{}(parent) %
+                                 dirent_shards_.size()];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.children.find(parent);
+    if(it == shard.children.end())
+        return;
+    it->second.erase(name);
+    if(it->second.empty())
+        shard.children.erase(it);
+}
+
+/**
+ * @internal
+ * The names are copied first so that the directory's index shard is not
+ * locked while the entries are looked up. Children removed in between are
+ * skipped.
+ * @endinternal
+ */
+std::vector<std::pair<std::string, std::string>>
+MemoryBackend::children_of(const std::string& dir) const {
+    std::vector<std::string> names;
+    {
+        const auto& shard = dirent_shards_[std::hash<std::string>{}(dir) %
+                                           dirent_shards_.size()];
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.children.find(dir);
+        if(it == shard.children.end())
+            return {};
+        names.assign(it->second.begin(), it->second.end());
+    }
+    std::vector<std::pair<std::string, std::string>> children;
+    children.reserve(names.size());
+    for(auto& name : names) {
+        auto key = dir + name;
+        const auto& shard = shard_of(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if(it != shard.entries.end())
+            children.emplace_back(std::move(name), it->second);
+    }
+    return children;
+}
+
+void
+MemoryBackend::load_snapshot() {
+    std::ifstream in(snapshot_path_, std::ios::binary);
+    if(!in)
+        return;
+    uint32_t key_len, val_len;
+    std::string key, val;
+    size_t count = 0;
+    while(in.read(reinterpret_cast<char*>(&key_len), sizeof(key_len))) {
+        key.resize(key_len);
+        if(!in.read(key.data(), key_len) ||
+           !in.read(reinterpret_cast<char*>(&val_len), sizeof(val_len)))
+            break;
+        val.resize(val_len);
+        if(!in.read(val.data(), val_len))
+            break;
+        shard_of(key).entries[key] = val;
+        add_dirent(key);
+        count++;
+    }
+    if(!in.eof())
+        throw DBException(fmt::format("Failed to read metadata snapshot '{}'",
+                                      snapshot_path_));
+    GKFS_METADATA_MOD->log()->info("{}() Loaded '{}' entries from '{}'",
+                                   __func__, count, snapshot_path_);
+}
+
+/**
+ * @internal
+ * Shards are copied one after another, i.e., the snapshot is not a consistent
+ * point in time across shards. It is written to a temporary file first so
+ * that a crash during a snapshot leaves the previous one intact.
+ * @endinternal
+ */
+void
+MemoryBackend::write_snapshot() const {
+    auto tmp_path = snapshot_path_ + ".tmp";
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    for(const auto& shard : entry_shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        for(const auto& [key, val] : shard.entries) {
+            auto key_len = static_cast<uint32_t>(key.size());
+            auto val_len = static_cast<uint32_t>(val.size());
+            out.write(reinterpret_cast<const char*>(&key_len), sizeof(key_len));
+            out.write(key.data(), key_len);
+            out.write(reinterpret_cast<const char*>(&val_len), sizeof(val_len));
+            out.write(val.data(), val_len);
+        }
+    }
+    out.close();
+    if(!out || std::rename(tmp_path.c_str(), snapshot_path_.c_str()) != 0)
+        throw DBException(fmt::format("Failed to write metadata snapshot '{}'",
+                                      snapshot_path_));
+}
+
+void
+MemoryBackend::snapshot_loop() {
+    const auto interval =
+            std::chrono::seconds(gkfs::config::memory::snapshot_interval);
+    std::unique_lock<std::mutex> lock(snapshotter_mutex_);
+    while(!snapshotter_cv_.wait_for(lock, interval,
+                                    [this] { return !running_; })) {
+        try {
+            write_snapshot();
+        } catch(const DBException& e) {
+            GKFS_METADATA_MOD->log()->error("{}() {}", __func__, e.what());
+        }
+    }
+}
+
+MemoryBackend::MemoryBackend(const std::string& path) {
+    if constexpr(gkfs::config::memory::snapshot_interval > 0) {
+        snapshot_path_ = fmt::format("{}/{}", path, snapshot_file);
+        load_snapshot();
+        snapshotter_ = std::thread([this] { snapshot_loop(); });
+    }
+}
+
+MemoryBackend::~MemoryBackend() {
+    if(!snapshotter_.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(snapshotter_mutex_);
+        running_ = false;
+    }
+    snapshotter_cv_.notify_all();
+    snapshotter_.join();
+    try {
+        write_snapshot();
+    } catch(const DBException& e) {
+        GKFS_METADATA_MOD->log()->error("{}() {}", __func__, e.what());
+    }
+}
+
+std::string
+MemoryBackend::get_impl(const std::string& key) const {
+    const auto& shard = shard_of(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if(it == shard.entries.end())
+        throw NotFoundException(fmt::format("NotFound: {}", key));
+    return it->second;
+}
+
+void
+MemoryBackend::put_impl(const std::string& key, const std::string& val) {
+    auto& shard = shard_of(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if(shard.entries.emplace(key, val).second)
+        add_dirent(key);
+}
+
+void
+MemoryBackend::put_no_exist_impl(const std::string& key,
+                                 const std::string& val) {
+    auto& shard = shard_of(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if(!shard.entries.emplace(key, val).second)
+        throw ExistsException(key);
+    add_dirent(key);
+}
+
+void
+MemoryBackend::remove_impl(const std::string& key) {
+    auto& shard = shard_of(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if(shard.entries.erase(key) > 0)
+        remove_dirent(key);
+}
+
+bool
+MemoryBackend::exists_impl(const std::string& key) {
+    const auto& shard = shard_of(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.entries.count(key) > 0;
+}
+
+void
+MemoryBackend::update_impl(const std::string& old_key,
+                           const std::string& new_key,
+                           const std::string& val) {
+    auto& old_shard = shard_of(old_key);
+    auto& new_shard = shard_of(new_key);
+    std::unique_lock<std::shared_mutex> old_lock(old_shard.mutex,
+                                                 std::defer_lock);
+    std::unique_lock<std::shared_mutex> new_lock(new_shard.mutex,
+                                                 std::defer_lock);
+    if(&old_shard == &new_shard)
+        old_lock.lock();
+    else
+        std::lock(old_lock, new_lock);
+    if(old_shard.entries.erase(old_key) > 0)
+        remove_dirent(old_key);
+    new_shard.entries[new_key] = val;
+    add_dirent(new_key);
+}
+
+/**
+ * @internal
+ * Applies a single increase size operand as MetadataMergeOperator::FullMergeV2
+ * does. Appends get the current file size as their starting offset directly
+ * as the entry is locked during the update.
+ * @endinternal
+ */
+off_t
+MemoryBackend::increase_size_impl(const std::string& key, size_t io_size,
+                                  off_t offset, bool append, size_t bsize,
+                                  const std::string& buf) {
+    auto& shard = shard_of(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if(it == shard.entries.end())
+        throw NotFoundException(fmt::format("NotFound: {}", key));
+    Metadata md{it->second};
+    size_t fsize = md.size();
+    bool use_buf = md.use_buf();
+    std::string inline_data{};
+    if(use_buf)
+        inline_data = md.buf();
+    inline_data.resize(gkfs::config::rpc::smallfilesize);
+    off_t out_offset = -1;
+    if(append) {
+        out_offset = static_cast<off_t>(fsize);
+        fsize += io_size;
+        if(use_buf && fsize <= gkfs::config::rpc::smallfilesize)
+            inline_data.replace(out_offset, bsize, buf.substr(0, bsize));
+    } else {
+        fsize = std::max(io_size + offset, fsize);
+        if(use_buf && fsize <= gkfs::config::rpc::smallfilesize)
+            inline_data.replace(offset, bsize, buf.substr(0, bsize));
+    }
+    finish_size_update(md, fsize, use_buf, inline_data);
+    it->second = md.serialize();
+    return out_offset;
+}
+
+void
+MemoryBackend::decrease_size_impl(const std::string& key, size_t size) {
+    auto& shard = shard_of(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if(it == shard.entries.end())
+        throw NotFoundException(fmt::format("NotFound: {}", key));
+    Metadata md{it->second};
+    std::string inline_data{};
+    if(md.use_buf())
+        inline_data = md.buf();
+    inline_data.resize(gkfs::config::rpc::smallfilesize);
+    finish_size_update(md, size, md.use_buf(), inline_data);
+    it->second = md.serialize();
+}
+
+std::vector<std::pair<std::string, bool>>
+MemoryBackend::get_dirents_impl(const std::string& dir) const {
+    std::vector<std::pair<std::string, bool>> entries;
+    for(auto& [name, val] : children_of(dir)) {
+        Metadata md(val);
+#ifdef HAS_RENAME
+        // Remove entries with negative blocks (rename)
+        if(md.blocks() == -1) {
+            continue;
+        }
+#endif // HAS_RENAME
+        entries.emplace_back(std::move(name), S_ISDIR(md.mode()));
+    }
+    return entries;
+}
+
+std::vector<std::tuple<std::string, bool, size_t, time_t>>
+MemoryBackend::get_dirents_extended_impl(const std::string& dir) const {
+    std::vector<std::tuple<std::string, bool, size_t, time_t>> entries;
+    for(auto& [name, val] : children_of(dir)) {
+        Metadata md(val);
+#ifdef HAS_RENAME
+        // Remove entries with negative blocks (rename)
+        if(md.blocks() == -1) {
+            continue;
+        }
+#endif // HAS_RENAME
+        entries.emplace_back(std::forward_as_tuple(
+                std::move(name), S_ISDIR(md.mode()), md.size(), md.ctime()));
+    }
+    return entries;
+}
+
+void
+MemoryBackend::iterate_all_impl() const {
+    for(const auto& shard : entry_shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        for(const auto& entry : shard.entries)
+            std::cout << entry.first << std::endl;
+    }
+}
+
+std::vector<std::pair<std::string, uint64_t>>
+MemoryBackend::properties_impl() const {
+    uint64_t entries = 0;
+    for(const auto& shard : entry_shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        entries += shard.entries.size();
+    }
+    return {{"entries", entries}};
+}
+
+} // namespace gkfs::metadata
@@ -532,5 +532,10 @@ ParallaxBackend::get_dirents_extended_impl(const std::string& dir) const {
 void
 ParallaxBackend::iterate_all_impl() const {}
 
+std::vector<std::pair<std::string, uint64_t>>
+ParallaxBackend::properties_impl() const {
+    return {};
+}
+
 
 } // namespace gkfs::metadata
@@ -383,6 +383,26 @@ RocksDBBackend::iterate_all_impl() const {
     }
 }
 
+/**
+ * Reads integer properties of the database that show whether compactions
+ * fall behind
+ * @return
+ */
+std::vector<std::pair<std::string, uint64_t>>
+RocksDBBackend::properties_impl() const {
+    static const std::string names[] = {
+            "compaction-pending", "num-running-compactions",
+            "estimate-pending-compaction-bytes", "num-running-flushes",
+            "cur-size-all-mem-tables", "estimate-num-keys"};
+    std::vector<std::pair<std::string, uint64_t>> props{};
+    for(const auto& name : names) {
+        uint64_t value = 0;
+        if(db_->GetIntProperty("rocksdb." + name, &value))
+            props.emplace_back(name, value);
+    }
+    return props;
+}
+
 /**
  * Used for setting KV store settings
  */
@@ -0,0 +1,203 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#include <daemon/classes/bulk_buffer_pool.hpp>
+
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace std;
+
+namespace gkfs::rpc {
+
+namespace {
+
+constexpr size_t buffer_alignment = 4096;
+
+} // namespace
+
+size_t
+BulkBufferPool::class_of(size_t size) const {
+    size_t size_class = 0;
+    for(auto class_bytes = min_size_; class_bytes < size; class_bytes <<= 1)
+        size_class++;
+    return size_class;
+}
+
+size_t
+BulkBufferPool::class_size(size_t size_class) const {
+    return min_size_ << size_class;
+}
+
+bool
+BulkBufferPool::evict(size_t keep_class) {
+    // largest idle buffers first as they free the most memory
+    for(auto c = idle_.size(); c-- > 0;) {
+        if(c == keep_class || idle_[c].empty())
+            continue;
+        auto* buffer = idle_[c].back();
+        idle_[c].pop_back();
+        allocated_ -= buffer->size;
+        destroy(buffer);
+        return true;
+    }
+    return false;
+}
+
+void
+BulkBufferPool::destroy(BulkBuffer* buffer) {
+    margo_bulk_free(buffer->handle);
+    ::free(buffer->data);
+    delete buffer;
+}
+
+BulkBufferPool::BulkBufferPool(margo_instance_id mid, size_t min_size,
+                               size_t max_size, size_t capacity)
+    : mid_(mid), min_size_(1), max_size_(max_size), capacity_(capacity) {
+    while(min_size_ < min_size)
+        min_size_ <<= 1;
+    size_t classes = 1;
+    while(class_size(classes) <= max_size_)
+        classes++;
+    idle_.resize(classes);
+    if(ABT_mutex_create(&mutex_) != ABT_SUCCESS)
+        throw runtime_error("Failed to create bulk buffer pool mutex");
+    if(ABT_cond_create(&cond_) != ABT_SUCCESS) {
+        ABT_mutex_free(&mutex_);
+        throw runtime_error("Failed to create bulk buffer pool condition");
+    }
+}
+
+BulkBufferPool::~BulkBufferPool() {
+    for(auto& buffers : idle_) {
+        for(auto* buffer : buffers)
+            destroy(buffer);
+    }
+    ABT_cond_free(&cond_);
+    ABT_mutex_free(&mutex_);
+}
+
+BulkBuffer*
+BulkBufferPool::acquire(size_t size) {
+    auto size_class = class_of(size);
+    if(size_class >= idle_.size() || class_size(size_class) > capacity_)
+        return nullptr;
+    auto bytes = class_size(size_class);
+
+    ABT_mutex_lock(mutex_);
+    while(true) {
+        auto& idle = idle_[size_class];
+        if(!idle.empty()) {
+            auto* buffer = idle.back();
+            idle.pop_back();
+            in_use_ += buffer->size;
+            ABT_mutex_unlock(mutex_);
+            return buffer;
+        }
+        if(allocated_ + bytes <= capacity_)
+            break;
+        if(!evict(size_class))
+            ABT_cond_wait(cond_, mutex_);
+    }
+    // reserve the memory and register the buffer outside of the lock
+    allocated_ += bytes;
+    in_use_ += bytes;
+    ABT_mutex_unlock(mutex_);
+
+    auto* buffer = new BulkBuffer{HG_BULK_NULL, nullptr, bytes};
+    hg_size_t hg_size = bytes;
+    if(posix_memalign(&buffer->data, buffer_alignment, bytes) == 0 &&
+       margo_bulk_create(mid_, 1, &buffer->data, &hg_size, HG_BULK_READWRITE,
+                         &buffer->handle) == HG_SUCCESS)
+        return buffer;
+
+    ::free(buffer->data);
+    delete buffer;
+    ABT_mutex_lock(mutex_);
+    allocated_ -= bytes;
+    in_use_ -= bytes;
+    ABT_cond_broadcast(cond_);
+    ABT_mutex_unlock(mutex_);
+    return nullptr;
+}
+
+void
+BulkBufferPool::release(BulkBuffer* buffer) {
+    ABT_mutex_lock(mutex_);
+    idle_[class_of(buffer->size)].push_back(buffer);
+    in_use_ -= buffer->size;
+    // waiters may need another class and can evict this buffer now
+    ABT_cond_broadcast(cond_);
+    ABT_mutex_unlock(mutex_);
+}
+
+size_t
+BulkBufferPool::allocated() const {
+    ABT_mutex_lock(mutex_);
+    auto allocated = allocated_;
+    ABT_mutex_unlock(mutex_);
+    return allocated;
+}
+
+size_t
+BulkBufferPool::in_use() const {
+    ABT_mutex_lock(mutex_);
+    auto in_use = in_use_;
+    ABT_mutex_unlock(mutex_);
+    return in_use;
+}
+
+BulkLease::BulkLease(shared_ptr<BulkBufferPool> pool, size_t size)
+    : pool_(std::move(pool)) {
+    if(!pool_)
+        return;
+    buffer_ = pool_->acquire(size);
+    // the handler's reference, released with its margo_bulk_free()
+    if(buffer_ && margo_bulk_ref_incr(buffer_->handle) != HG_SUCCESS) {
+        pool_->release(buffer_);
+        buffer_ = nullptr;
+    }
+}
+
+BulkLease::~BulkLease() {
+    if(buffer_)
+        pool_->release(buffer_);
+}
+
+hg_bulk_t
+BulkLease::handle() const {
+    return buffer_->handle;
+}
+
+void*
+BulkLease::data() const {
+    return buffer_->data;
+}
+
+} // namespace gkfs::rpc
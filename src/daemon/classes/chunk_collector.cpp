@@ -0,0 +1,150 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#include <daemon/classes/chunk_collector.hpp>
+#include <daemon/classes/fs_data.hpp>
+#include <daemon/backend/data/chunk_storage.hpp>
+
+#include <stdexcept>
+
+extern "C" {
+#include <time.h>
+}
+
+using namespace std;
+
+namespace gkfs::data {
+
+ChunkCollector::ChunkCollector(shared_ptr<ChunkStorage> storage, ABT_pool pool,
+                               size_t batch, chrono::milliseconds interval)
+    : storage_(std::move(storage)), batch_(batch), interval_(interval) {
+    if(ABT_mutex_create(&mutex_) != ABT_SUCCESS)
+        throw runtime_error("Failed to create chunk collector mutex");
+    if(ABT_cond_create(&cond_) != ABT_SUCCESS) {
+        ABT_mutex_free(&mutex_);
+        throw runtime_error("Failed to create chunk collector condition");
+    }
+    auto abt_err = ABT_thread_create(pool, collect_ult, this,
+                                     ABT_THREAD_ATTR_NULL, &ult_);
+    if(abt_err != ABT_SUCCESS) {
+        ABT_cond_free(&cond_);
+        ABT_mutex_free(&mutex_);
+        throw runtime_error(fmt::format(
+                "Failed to create chunk collector ULT with abt_err '{}'",
+                abt_err));
+    }
+}
+
+ChunkCollector::~ChunkCollector() {
+    ABT_mutex_lock(mutex_);
+    running_ = false;
+    ABT_cond_signal(cond_);
+    ABT_mutex_unlock(mutex_);
+    ABT_thread_join(ult_);
+    ABT_thread_free(&ult_);
+    ABT_cond_free(&cond_);
+    ABT_mutex_free(&mutex_);
+}
+
+void
+ChunkCollector::collect_ult(void* _arg) {
+    auto* collector = static_cast<ChunkCollector*>(_arg);
+    while(true) {
+        ABT_mutex_lock(collector->mutex_);
+        while(collector->running_ && !collector->pending_)
+            ABT_cond_wait(collector->cond_, collector->mutex_);
+        if(!collector->running_) {
+            ABT_mutex_unlock(collector->mutex_);
+            return;
+        }
+        collector->pending_ = false;
+        ABT_mutex_unlock(collector->mutex_);
+        collector->drain();
+    }
+}
+
+void
+ChunkCollector::drain() {
+    while(true) {
+        size_t removed = 0;
+        try {
+            removed = storage_->reclaim_tombstones(batch_);
+        } catch(const exception& e) {
+            GKFS_DATA->spdlogger()->error("{}() Failed to reclaim chunks: '{}'",
+                                          __func__, e.what());
+        }
+        ABT_mutex_lock(mutex_);
+        reclaimed_ += removed;
+        if(removed < batch_ || !running_) {
+            ABT_mutex_unlock(mutex_);
+            return;
+        }
+        // ABT_cond_timedwait expects an absolute CLOCK_REALTIME time
+        struct timespec ts {};
+        clock_gettime(CLOCK_REALTIME, &ts);
+        auto ns = chrono::duration_cast<chrono::nanoseconds>(interval_).count() +
+                  ts.tv_nsec;
+        ts.tv_sec += ns / 1000000000L;
+        ts.tv_nsec = ns % 1000000000L;
+        // notifications do not shorten the pause, only stopping does
+        while(running_ &&
+              ABT_cond_timedwait(cond_, mutex_, &ts) != ABT_ERR_COND_TIMEDOUT)
+            ;
+        ABT_mutex_unlock(mutex_);
+    }
+}
+
+void
+ChunkCollector::notify() {
+    ABT_mutex_lock(mutex_);
+    pending_ = true;
+    ABT_cond_signal(cond_);
+    ABT_mutex_unlock(mutex_);
+}
+
+uint64_t
+ChunkCollector::reclaimed() {
+    ABT_mutex_lock(mutex_);
+    auto reclaimed = reclaimed_;
+    ABT_mutex_unlock(mutex_);
+    return reclaimed;
+}
+
+void
+remove_chunk_space(const string& path) {
+    const auto& collector = GKFS_DATA->chunk_collector();
+    if(!collector) {
+        GKFS_DATA->storage()->destroy_chunk_space(path);
+        return;
+    }
+    if(GKFS_DATA->storage()->tombstone_chunk_space(path))
+        collector->notify();
+}
+
+} // namespace gkfs::data
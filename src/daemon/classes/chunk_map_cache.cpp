@@ -0,0 +1,241 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#include <daemon/classes/chunk_map_cache.hpp>
+#include <daemon/classes/fs_data.hpp>
+#include <daemon/backend/data/chunk_storage.hpp>
+
+#include <stdexcept>
+
+extern "C" {
+#include <sys/mman.h>
+}
+
+using namespace std;
+
+namespace gkfs::data {
+
+MappedChunk::~MappedChunk() {
+    if(handle != HG_BULK_NULL)
+        margo_bulk_free(handle);
+    if(addr != nullptr)
+        munmap(addr, size);
+}
+
+ChunkMapCache::ChunkMapCache(margo_instance_id mid, size_t capacity)
+    : mid_(mid), capacity_(capacity) {
+    if(ABT_mutex_create(&readers_mutex_) != ABT_SUCCESS)
+        throw runtime_error("Failed to create chunk map cache mutex");
+    if(ABT_cond_create(&readers_cond_) != ABT_SUCCESS) {
+        ABT_mutex_free(&readers_mutex_);
+        throw runtime_error("Failed to create chunk map cache condition");
+    }
+}
+
+ChunkMapCache::~ChunkMapCache() {
+    // unmapping releases readers, which must not happen under mutex_
+    map<key_type, entry> entries;
+    {
+        lock_guard<mutex> lock(mutex_);
+        entries.swap(entries_);
+        lru_.clear();
+    }
+    entries.clear();
+    ABT_cond_free(&readers_cond_);
+    ABT_mutex_free(&readers_mutex_);
+}
+
+void
+ChunkMapCache::erase(map<key_type, entry>::iterator it) {
+    mapped_ -= it->second.mapping->size;
+    lru_.erase(it->second.lru_pos);
+    entries_.erase(it);
+}
+
+void
+ChunkMapCache::release(const key_type& key) {
+    ABT_mutex_lock(readers_mutex_);
+    auto it = readers_.find(key);
+    if(--it->second == 0) {
+        readers_.erase(it);
+        ABT_cond_broadcast(readers_cond_);
+    }
+    ABT_mutex_unlock(readers_mutex_);
+}
+
+shared_ptr<MappedChunk>
+ChunkMapCache::get(const string& path, gkfs::rpc::chnk_id_t chunk_id) {
+    key_type key{path, chunk_id};
+    uint64_t epoch;
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if(it != entries_.end()) {
+            hits_++;
+            lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+            return it->second.mapping;
+        }
+        misses_++;
+        epoch = epoch_;
+    }
+    // the mapping counts as a reader of the chunk from here on
+    ABT_mutex_lock(readers_mutex_);
+    if(shrinking_.count(key) != 0) {
+        ABT_mutex_unlock(readers_mutex_);
+        return nullptr;
+    }
+    readers_[key]++;
+    ABT_mutex_unlock(readers_mutex_);
+    shared_ptr<MappedChunk> mapping(new MappedChunk,
+                                    [this, key](MappedChunk* mapping) {
+                                        delete mapping;
+                                        release(key);
+                                    });
+    // map and register outside of the lock
+    mapping->addr =
+            GKFS_DATA->storage()->map_chunk(path, chunk_id, mapping->size);
+    if(mapping->addr == nullptr)
+        return nullptr;
+    auto ret = margo_bulk_create(mid_, 1, &mapping->addr, &mapping->size,
+                                 HG_BULK_READ_ONLY, &mapping->handle);
+    if(ret != HG_SUCCESS) {
+        mapping->handle = HG_BULK_NULL;
+        GKFS_DATA->spdlogger()->warn(
+                "ChunkMapCache::{}() Failed to register mapping of chunk '{}' of file '{}'",
+                __func__, chunk_id, path);
+        return nullptr;
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    // the chunk may have changed while it was mapped
+    if(epoch != epoch_ || mapping->size > capacity_)
+        return mapping;
+    auto it = entries_.find(key);
+    if(it != entries_.end()) {
+        // mapped concurrently by another reader
+        lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+        return it->second.mapping;
+    }
+    while(!lru_.empty() && mapped_ + mapping->size > capacity_)
+        erase(entries_.find(lru_.back()));
+    lru_.push_front(key);
+    entries_.emplace(key, entry{mapping, lru_.begin()});
+    mapped_ += mapping->size;
+    return mapping;
+}
+
+void
+ChunkMapCache::invalidate(const string& path, gkfs::rpc::chnk_id_t chunk_id) {
+    lock_guard<mutex> lock(mutex_);
+    epoch_++;
+    auto it = entries_.find({path, chunk_id});
+    if(it != entries_.end())
+        erase(it);
+}
+
+void
+ChunkMapCache::invalidate_file(const string& path,
+                               gkfs::rpc::chnk_id_t chunk_start) {
+    lock_guard<mutex> lock(mutex_);
+    epoch_++;
+    auto it = entries_.lower_bound({path, chunk_start});
+    while(it != entries_.end() && it->first.first == path)
+        erase(it++);
+}
+
+void
+ChunkMapCache::begin_shrink(const string& path,
+                            gkfs::rpc::chnk_id_t chunk_id) {
+    key_type key{path, chunk_id};
+    ABT_mutex_lock(readers_mutex_);
+    shrinking_[key]++;
+    ABT_mutex_unlock(readers_mutex_);
+    // drop the cache's own reference and keep racing mappings out of it
+    invalidate(path, chunk_id);
+    ABT_mutex_lock(readers_mutex_);
+    while(readers_.count(key) != 0)
+        ABT_cond_wait(readers_cond_, readers_mutex_);
+    ABT_mutex_unlock(readers_mutex_);
+}
+
+void
+ChunkMapCache::end_shrink(const string& path, gkfs::rpc::chnk_id_t chunk_id) {
+    ABT_mutex_lock(readers_mutex_);
+    auto it = shrinking_.find({path, chunk_id});
+    if(--it->second == 0)
+        shrinking_.erase(it);
+    ABT_mutex_unlock(readers_mutex_);
+}
+
+size_t
+ChunkMapCache::mapped_bytes() const {
+    lock_guard<mutex> lock(mutex_);
+    return mapped_;
+}
+
+uint64_t
+ChunkMapCache::hits() const {
+    lock_guard<mutex> lock(mutex_);
+    return hits_;
+}
+
+uint64_t
+ChunkMapCache::misses() const {
+    lock_guard<mutex> lock(mutex_);
+    return misses_;
+}
+
+ChunkShrinkGuard::ChunkShrinkGuard(const string& path,
+                                   gkfs::rpc::chnk_id_t chunk_id)
+    : map_cache_(GKFS_DATA->chunk_map_cache()), path_(path),
+      chunk_id_(chunk_id) {
+    if(map_cache_)
+        map_cache_->begin_shrink(path_, chunk_id_);
+}
+
+ChunkShrinkGuard::~ChunkShrinkGuard() {
+    if(map_cache_)
+        map_cache_->end_shrink(path_, chunk_id_);
+}
+
+void
+invalidate_mapped_chunk(const string& path, gkfs::rpc::chnk_id_t chunk_id) {
+    const auto& map_cache = GKFS_DATA->chunk_map_cache();
+    if(map_cache)
+        map_cache->invalidate(path, chunk_id);
+}
+
+void
+invalidate_mapped_file(const string& path, gkfs::rpc::chnk_id_t chunk_start) {
+    const auto& map_cache = GKFS_DATA->chunk_map_cache();
+    if(map_cache)
+        map_cache->invalidate_file(path, chunk_start);
+}
+
+} // namespace gkfs::data
@@ -70,6 +70,48 @@ FsData::storage(const std::shared_ptr<gkfs::data::ChunkStorage>& storage) {
     storage_ = storage;
 }
 
+std::string_view
+FsData::chunk_backend() const {
+    return chunk_backend_;
+}
+
+void
+FsData::chunk_backend(const std::string& chunk_backend) {
+    FsData::chunk_backend_ = chunk_backend;
+}
+
+const std::shared_ptr<gkfs::data::ChunkMapCache>&
+FsData::chunk_map_cache() const {
+    return chunk_map_cache_;
+}
+
+void
+FsData::chunk_map_cache(
+        const std::shared_ptr<gkfs::data::ChunkMapCache>& chunk_map_cache) {
+    FsData::chunk_map_cache_ = chunk_map_cache;
+}
+
+unsigned long
+FsData::chunk_map_cache_size() const {
+    return chunk_map_cache_size_;
+}
+
+void
+FsData::chunk_map_cache_size(unsigned long chunk_map_cache_size) {
+    FsData::chunk_map_cache_size_ = chunk_map_cache_size;
+}
+
+const std::shared_ptr<gkfs::data::ChunkCollector>&
+FsData::chunk_collector() const {
+    return chunk_collector_;
+}
+
+void
+FsData::chunk_collector(
+        const std::shared_ptr<gkfs::data::ChunkCollector>& chunk_collector) {
+    FsData::chunk_collector_ = chunk_collector;
+}
+
 const std::string&
 FsData::rootdir() const {
     return rootdir_;
@@ -160,6 +202,56 @@ FsData::use_auto_sm(bool use_auto_sm) {
     use_auto_sm_ = use_auto_sm;
 }
 
+unsigned int
+FsData::io_xstreams() const {
+    return io_xstreams_;
+}
+
+void
+FsData::io_xstreams(unsigned int io_xstreams) {
+    FsData::io_xstreams_ = io_xstreams;
+}
+
+unsigned int
+FsData::handler_xstreams() const {
+    return handler_xstreams_;
+}
+
+void
+FsData::handler_xstreams(unsigned int handler_xstreams) {
+    FsData::handler_xstreams_ = handler_xstreams;
+}
+
+bool
+FsData::io_private_pools() const {
+    return io_private_pools_;
+}
+
+void
+FsData::io_private_pools(bool io_private_pools) {
+    FsData::io_private_pools_ = io_private_pools;
+}
+
+const std::vector<unsigned int>&
+FsData::io_cpus() const {
+    return io_cpus_;
+}
+
+void
+FsData::io_cpus(const std::vector<unsigned int>& io_cpus) {
+    FsData::io_cpus_ = io_cpus;
+}
+
+unsigned long
+FsData::bulk_pool_size() const {
+    return bulk_pool_size_;
+}
+
+void
+FsData::bulk_pool_size(unsigned long bulk_pool_size) {
+    FsData::bulk_pool_size_ = bulk_pool_size;
+}
+
 bool
 FsData::atime_state() const {
     return atime_state_;
@@ -286,4 +378,76 @@ FsData::prometheus_gateway(const std::string& prometheus_gateway) {
     FsData::prometheus_gateway_ = prometheus_gateway;
 }
 
+const std::shared_ptr<gkfs::trace::writer>&
+FsData::tracer() const {
+    return tracer_;
+}
+
+void
+FsData::tracer(const std::shared_ptr<gkfs::trace::writer>& tracer) {
+    FsData::tracer_ = tracer;
+}
+
+const std::shared_ptr<gkfs::data::ReplicaManager>&
+FsData::replica_manager() const {
+    return replica_manager_;
+}
+
+void
+FsData::replica_manager(
+        const std::shared_ptr<gkfs::data::ReplicaManager>& replica_manager) {
+    FsData::replica_manager_ = replica_manager;
+}
+
+unsigned int
+FsData::hot_chunk_replicas() const {
+    return hot_chunk_replicas_;
+}
+
+void
+FsData::hot_chunk_replicas(unsigned int hot_chunk_replicas) {
+    FsData::hot_chunk_replicas_ = hot_chunk_replicas;
+}
+
+unsigned int
+FsData::hot_chunk_threshold() const {
+    return hot_chunk_threshold_;
+}
+
+void
+FsData::hot_chunk_threshold(unsigned int hot_chunk_threshold) {
+    FsData::hot_chunk_threshold_ = hot_chunk_threshold;
+}
+
+const std::shared_ptr<gkfs::data::IoScheduler>&
+FsData::io_scheduler() const {
+    return io_scheduler_;
+}
+
+void
+FsData::io_scheduler(
+        const std::shared_ptr<gkfs::data::IoScheduler>& io_scheduler) {
+    FsData::io_scheduler_ = io_scheduler;
+}
+
+unsigned int
+FsData::io_scheduler_window() const {
+    return io_scheduler_window_;
+}
+
+void
+FsData::io_scheduler_window(unsigned int io_scheduler_window) {
+    FsData::io_scheduler_window_ = io_scheduler_window;
+}
+
+unsigned int
+FsData::io_scheduler_deadline() const {
+    return io_scheduler_deadline_;
+}
+
+void
+FsData::io_scheduler_deadline(unsigned int io_scheduler_deadline) {
+    FsData::io_scheduler_deadline_ = io_scheduler_deadline;
+}
+
 } // namespace gkfs::daemon
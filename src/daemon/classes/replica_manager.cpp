@@ -0,0 +1,331 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#include <daemon/classes/replica_manager.hpp>
+#include <config.hpp>
+
+using namespace std;
+
+namespace gkfs::data {
+
+ReplicaManager::ReplicaManager(unsigned int replicas, unsigned int threshold,
+                               chrono::steady_clock::duration window,
+                               size_t max_tracked)
+    : replicas_(replicas), threshold_(threshold), window_(window),
+      max_tracked_(max_tracked),
+      next_version_(chrono::duration_cast<chrono::nanoseconds>(
+                            chrono::system_clock::now().time_since_epoch())
+                            .count()) {}
+
+void
+ReplicaManager::evict_cold_chunks(chrono::steady_clock::time_point now) {
+    // chunks in use are not evictable, do not rescan them on every read
+    if(now - owned_pruned_ < window_)
+        return;
+    owned_pruned_ = now;
+    for(auto file = owned_.begin(); file != owned_.end();) {
+        auto& chunks = file->second;
+        for(auto it = chunks.begin(); it != chunks.end();) {
+            if(it->second.state == State::none) {
+                it = chunks.erase(it);
+                owned_count_--;
+            } else
+                ++it;
+        }
+        if(chunks.empty())
+            file = owned_.erase(file);
+        else
+            ++file;
+    }
+}
+
+void
+ReplicaManager::evict_stale_copies(chrono::steady_clock::time_point now) {
+    if(now - copies_pruned_ < window_)
+        return;
+    copies_pruned_ = now;
+    for(auto file = copies_.begin(); file != copies_.end();) {
+        auto& chunks = file->second;
+        for(auto it = chunks.begin(); it != chunks.end();) {
+            // a push older than the invalidation cannot be in flight anymore
+            if(!it->second.valid && now - it->second.changed > window_) {
+                it = chunks.erase(it);
+                copies_count_--;
+            } else
+                ++it;
+        }
+        if(chunks.empty())
+            file = copies_.erase(file);
+        else
+            ++file;
+    }
+}
+
+ReplicaManager::ReplicaChunk*
+ReplicaManager::find_or_add_copy(const string& path, uint64_t chunk_id,
+                                 chrono::steady_clock::time_point now) {
+    auto file = copies_.find(path);
+    if(file != copies_.end()) {
+        auto it = file->second.find(chunk_id);
+        if(it != file->second.end())
+            return &it->second;
+    }
+    if(copies_count_ >= max_tracked_) {
+        evict_stale_copies(now);
+        if(copies_count_ >= max_tracked_)
+            return nullptr;
+    }
+    copies_count_++;
+    return &copies_[path]
+                    .emplace(chunk_id, ReplicaChunk{0, false, now})
+                    .first->second;
+}
+
+unsigned int
+ReplicaManager::replicas() const {
+    return replicas_;
+}
+
+uint64_t
+ReplicaManager::record_read(const string& path, uint64_t chunk_id,
+                            const vector<uint64_t>& hosts) {
+    if(hosts.empty())
+        return 0;
+    auto now = chrono::steady_clock::now();
+    lock_guard<mutex> lock(mutex_);
+    auto file = owned_.find(path);
+    map<uint64_t, OwnedChunk>::iterator it;
+    if(file == owned_.end() ||
+       (it = file->second.find(chunk_id)) == file->second.end()) {
+        if(owned_count_ >= max_tracked_) {
+            evict_cold_chunks(now);
+            if(owned_count_ >= max_tracked_)
+                return 0;
+        }
+        it = owned_[path]
+                     .emplace(chunk_id, OwnedChunk{now, 0, State::none, 0, {}})
+                     .first;
+        owned_count_++;
+    }
+    auto& chunk = it->second;
+    if(now - chunk.window_start > window_) {
+        chunk.window_start = now;
+        chunk.window_reads = 0;
+    }
+    chunk.window_reads++;
+    if(chunk.state != State::none || chunk.window_reads < threshold_)
+        return 0;
+    chunk.state = State::pending;
+    chunk.version = ++next_version_;
+    chunk.hosts = hosts;
+    return chunk.version;
+}
+
+bool
+ReplicaManager::replication_done(const string& path, uint64_t chunk_id,
+                                 uint64_t version) {
+    lock_guard<mutex> lock(mutex_);
+    auto file = owned_.find(path);
+    if(file == owned_.end())
+        return false;
+    auto it = file->second.find(chunk_id);
+    if(it == file->second.end() || it->second.version != version ||
+       it->second.state != State::pending)
+        return false;
+    it->second.state = State::replicated;
+    return true;
+}
+
+void
+ReplicaManager::replication_failed(const string& path, uint64_t chunk_id,
+                                   uint64_t version) {
+    lock_guard<mutex> lock(mutex_);
+    auto file = owned_.find(path);
+    if(file == owned_.end())
+        return;
+    auto it = file->second.find(chunk_id);
+    if(it != file->second.end() && it->second.version == version &&
+       it->second.state == State::pending) {
+        it->second.state = State::none;
+        it->second.window_start = chrono::steady_clock::now();
+    }
+}
+
+unsigned int
+ReplicaManager::replicated(const string& path, uint64_t chunk_id) const {
+    lock_guard<mutex> lock(mutex_);
+    auto file = owned_.find(path);
+    if(file == owned_.end())
+        return 0;
+    auto it = file->second.find(chunk_id);
+    if(it == file->second.end() || it->second.state != State::replicated)
+        return 0;
+    return it->second.hosts.size();
+}
+
+ReplicaSet
+ReplicaManager::invalidate(const string& path, uint64_t chunk_id) {
+    lock_guard<mutex> lock(mutex_);
+    ReplicaSet set{chunk_id, 0, {}};
+    auto file = owned_.find(path);
+    if(file == owned_.end())
+        return set;
+    auto it = file->second.find(chunk_id);
+    // an ongoing invalidation already covers this modification
+    if(it == file->second.end() || it->second.state == State::none ||
+       it->second.state == State::invalidating)
+        return set;
+    // a pending push may already have reached some hosts
+    it->second.state = State::invalidating;
+    it->second.version = ++next_version_;
+    set.version = it->second.version;
+    set.hosts = it->second.hosts;
+    return set;
+}
+
+vector<ReplicaSet>
+ReplicaManager::invalidate_from(const string& path, uint64_t chunk_start) {
+    lock_guard<mutex> lock(mutex_);
+    vector<ReplicaSet> sets{};
+    auto file = owned_.find(path);
+    if(file == owned_.end())
+        return sets;
+    for(auto it = file->second.lower_bound(chunk_start);
+        it != file->second.end(); ++it) {
+        if(it->second.state == State::none ||
+           it->second.state == State::invalidating)
+            continue;
+        it->second.state = State::invalidating;
+        it->second.version = ++next_version_;
+        sets.push_back({it->first, it->second.version, it->second.hosts});
+    }
+    return sets;
+}
+
+void
+ReplicaManager::invalidation_done(const string& path, uint64_t chunk_id,
+                                  uint64_t version) {
+    lock_guard<mutex> lock(mutex_);
+    auto file = owned_.find(path);
+    if(file == owned_.end())
+        return;
+    auto it = file->second.find(chunk_id);
+    if(it != file->second.end() && it->second.version == version &&
+       it->second.state == State::invalidating) {
+        it->second.state = State::none;
+        it->second.hosts.clear();
+        it->second.window_start = chrono::steady_clock::now();
+        it->second.window_reads = 0;
+    }
+}
+
+vector<ReplicaSet>
+ReplicaManager::forget(const string& path) {
+    auto now = chrono::steady_clock::now();
+    lock_guard<mutex> lock(mutex_);
+    vector<ReplicaSet> sets{};
+    auto file = owned_.find(path);
+    if(file != owned_.end()) {
+        for(auto& [chunk_id, chunk] : file->second) {
+            if(chunk.state == State::pending ||
+               chunk.state == State::replicated)
+                sets.push_back({chunk_id, ++next_version_, move(chunk.hosts)});
+        }
+        owned_count_ -= file->second.size();
+        owned_.erase(file);
+    }
+    // keep the versions of copies so that late pushes are still rejected
+    auto copies = copies_.find(path);
+    if(copies != copies_.end()) {
+        for(auto& [chunk_id, copy] : copies->second) {
+            copy.valid = false;
+            copy.changed = now;
+        }
+    }
+    return sets;
+}
+
+bool
+ReplicaManager::accept_copy(const string& path, uint64_t chunk_id,
+                            uint64_t version) {
+    auto now = chrono::steady_clock::now();
+    lock_guard<mutex> lock(mutex_);
+    auto copy = find_or_add_copy(path, chunk_id, now);
+    if(!copy || version < copy->version)
+        return false;
+    // the old copy is overwritten and must not be read meanwhile
+    copy->version = version;
+    copy->valid = false;
+    copy->changed = now;
+    return true;
+}
+
+bool
+ReplicaManager::commit_copy(const string& path, uint64_t chunk_id,
+                            uint64_t version) {
+    lock_guard<mutex> lock(mutex_);
+    auto file = copies_.find(path);
+    if(file == copies_.end())
+        return false;
+    auto it = file->second.find(chunk_id);
+    if(it == file->second.end() || it->second.version != version)
+        return false;
+    it->second.valid = true;
+    return true;
+}
+
+void
+ReplicaManager::drop_copy(const string& path, uint64_t chunk_id,
+                          uint64_t version) {
+    auto now = chrono::steady_clock::now();
+    lock_guard<mutex> lock(mutex_);
+    // without room, a late push can only be stored after stale copies were
+    // pruned, and the owner does not announce it as its chunk is invalidated
+    auto copy = find_or_add_copy(path, chunk_id, now);
+    // invalidations are sent asynchronously and may overtake a newer push
+    if(!copy || version < copy->version)
+        return;
+    copy->version = version;
+    copy->valid = false;
+    copy->changed = now;
+}
+
+uint64_t
+ReplicaManager::copy_version(const string& path, uint64_t chunk_id) const {
+    lock_guard<mutex> lock(mutex_);
+    auto file = copies_.find(path);
+    if(file == copies_.end())
+        return 0;
+    auto it = file->second.find(chunk_id);
+    if(it == file->second.end() || !it->second.valid)
+        return 0;
+    return it->second.version;
+}
+
+} // namespace gkfs::data
@@ -48,12 +48,28 @@ RPCData::server_rpc_mid(margo_instance* server_rpc_mid) {
 
 ABT_pool
 RPCData::io_pool() const {
-    return io_pool_;
+    if(io_pools_.size() == 1)
+        return io_pools_.front();
+    return io_pools_[next_io_pool_.fetch_add(1, memory_order_relaxed) %
+                     io_pools_.size()];
+}
+
+const vector<ABT_pool>&
+RPCData::io_pools() const {
+    return io_pools_;
 }
 
 void
-RPCData::io_pool(ABT_pool io_pool) {
-    RPCData::io_pool_ = io_pool;
+RPCData::io_pools(const vector<ABT_pool>& io_pools) {
+    RPCData::io_pools_ = io_pools;
+}
+
+vector<size_t>
+RPCData::io_queue_lengths() const {
+    vector<size_t> lengths(io_pools_.size());
+    for(size_t i = 0; i < io_pools_.size(); i++)
+        ABT_pool_get_total_size(io_pools_[i], &lengths[i]);
+    return lengths;
 }
 
 vector<ABT_xstream>&
@@ -87,6 +103,49 @@ RPCData::distributor(
     distributor_ = distributor;
 }
 
+const std::shared_ptr<gkfs::rpc::BulkBufferPool>&
+RPCData::bulk_pool() const {
+    return bulk_pool_;
+}
+
+void
+RPCData::bulk_pool(
+        const std::shared_ptr<gkfs::rpc::BulkBufferPool>& bulk_pool) {
+    bulk_pool_ = bulk_pool;
+}
+
+std::atomic<uint64_t>&
+RPCData::inflight(const std::string& rpc) {
+    lock_guard<mutex> lock(inflight_mutex_);
+    return inflight_[rpc];
+}
+
+vector<pair<string, uint64_t>>
+RPCData::inflight() const {
+    lock_guard<mutex> lock(inflight_mutex_);
+    vector<pair<string, uint64_t>> counts{};
+    counts.reserve(inflight_.size());
+    for(const auto& [rpc, count] : inflight_)
+        counts.emplace_back(rpc, count.load(memory_order_relaxed));
+    return counts;
+}
+
+std::atomic<uint64_t>&
+RPCData::bulk_inflight() {
+    return bulk_inflight_;
+}
+
+size_t
+RPCData::handler_queue_length() const {
+    ABT_pool pool = ABT_POOL_NULL;
+    size_t length = 0;
+    if(server_rpc_mid_ == nullptr ||
+       margo_get_handler_pool(server_rpc_mid_, &pool) != 0)
+        return 0;
+    ABT_pool_get_size(pool, &length);
+    return length;
+}
+
 
 } // namespace daemon
 } // namespace gkfs
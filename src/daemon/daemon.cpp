@@ -40,10 +40,16 @@
 #include <common/rpc/rpc_types.hpp>
 #include <common/rpc/rpc_util.hpp>
 #include <common/statistics/stats.hpp>
+#include <common/trace_util.hpp>
 
 #include <daemon/env.hpp>
 #include <daemon/handler/rpc_defs.hpp>
 #include <daemon/ops/metadentry.hpp>
+#include <daemon/classes/replica_manager.hpp>
+#include <daemon/classes/bulk_buffer_pool.hpp>
+#include <daemon/classes/chunk_map_cache.hpp>
+#include <daemon/classes/chunk_collector.hpp>
+#include <daemon/scheduler/io_scheduler.hpp>
 #include <daemon/backend/metadata/db.hpp>
 #include <daemon/backend/data/chunk_storage.hpp>
 #include <daemon/util.hpp>
@@ -62,7 +68,9 @@
 
 extern "C" {
 #include <unistd.h>
+#include <fcntl.h>
 #include <cstdlib>
+#include <cstring>
 }
 
 using namespace std;
@@ -81,48 +89,89 @@ struct cli_options {
     string hosts_file;
     string rpc_protocol;
     string dbbackend;
+    string chunk_backend;
+    string chunk_map_cache;
     string parallax_size;
     string stats_file;
+    string trace_dir;
     string prometheus_gateway;
+    string io_xstreams;
+    string handler_xstreams;
+    string io_pools;
+    string io_cpus;
+    string numa_node;
+    string bulk_pool_size;
+    string hot_chunk_replicas;
+    string hot_chunk_threshold;
+    string io_scheduler_window;
+    string io_scheduler_deadline;
 };
 
 /**
  * @brief Initializes the Argobots execution streams for non-blocking I/O
  * @internal
- * The corresponding execution streams are defined in
- * gkfs::config::rpc::daemon_io_xstreams. A FIFO thread pool accomodates these
- * execution streams. Argobots tasklets are created from these pools during I/O
- * operations.
+ * The number of execution streams defaults to
+ * gkfs::config::rpc::daemon_io_xstreams and can be set with --io-xstreams.
+ * Argobots tasklets are created from the I/O pools during I/O operations.
+ *
+ * Two pool topologies are available. By default, a single FIFO pool is shared
+ * by all execution streams. With private pools, each execution stream has its
+ * own pool which it serves first. Its scheduler also lists the pools of all
+ * other execution streams in order, so that an idle execution stream steals
+ * tasks from its neighbors. This avoids contention on a single pool when
+ * many execution streams are used.
+ *
+ * If CPUs are given, the execution streams are bound to them in round robin.
+ * Only memory that the I/O tasks allocate and touch first is placed on the
+ * NUMA node of these CPUs. Bulk buffers are allocated by the RPC handlers and
+ * are not placed explicitly.
  * @endinternal
  */
 void
 init_io_tasklet_pool() {
-    static_assert(gkfs::config::rpc::daemon_io_xstreams >= 0,
-                  "Daemon IO Execution streams must be higher than 0!");
-    unsigned int xstreams_num = gkfs::config::rpc::daemon_io_xstreams;
+    unsigned int xstreams_num = GKFS_DATA->io_xstreams();
+    auto pools_num = GKFS_DATA->io_private_pools() ? xstreams_num : 1;
 
-    // retrieve the pool of the just created scheduler
-    ABT_pool pool;
-    auto ret = ABT_pool_create_basic(ABT_POOL_FIFO_WAIT, ABT_POOL_ACCESS_MPMC,
-                                     ABT_TRUE, &pool);
-    if(ret != ABT_SUCCESS) {
-        throw runtime_error("Failed to create I/O tasks pool");
+    vector<ABT_pool> pools(pools_num);
+    for(auto& pool : pools) {
+        auto ret = ABT_pool_create_basic(
+                ABT_POOL_FIFO_WAIT, ABT_POOL_ACCESS_MPMC, ABT_TRUE, &pool);
+        if(ret != ABT_SUCCESS) {
+            throw runtime_error("Failed to create I/O tasks pool");
+        }
     }
 
-    // create all subsequent xstream and the associated scheduler, all tapping
-    // into the same pool
+    // create all subsequent xstream and the associated scheduler. Each
+    // scheduler starts with its own pool and continues with the following ones
+    const auto& cpus = GKFS_DATA->io_cpus();
     vector<ABT_xstream> xstreams(xstreams_num);
+    vector<ABT_pool> sched_pools(pools_num);
     for(unsigned int i = 0; i < xstreams_num; ++i) {
-        ret = ABT_xstream_create_basic(ABT_SCHED_BASIC_WAIT, 1, &pool,
-                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        for(unsigned int p = 0; p < pools_num; ++p)
+            sched_pools[p] = pools[(i + p) % pools_num];
+        auto ret = ABT_xstream_create_basic(
+                ABT_SCHED_BASIC_WAIT, static_cast<int>(pools_num),
+                sched_pools.data(), ABT_SCHED_CONFIG_NULL, &xstreams[i]);
         if(ret != ABT_SUCCESS) {
             throw runtime_error(
                     "Failed to create task execution streams for I/O operations");
         }
+        if(!cpus.empty()) {
+            auto cpu = cpus[i % cpus.size()];
+            if(ABT_xstream_set_cpubind(xstreams[i], static_cast<int>(cpu)) !=
+               ABT_SUCCESS)
+                GKFS_DATA->spdlogger()->warn(
+                        "{}() Failed to bind I/O xstream {} to CPU {}",
+                        __func__, i, cpu);
+        }
     }
+    GKFS_DATA->spdlogger()->info(
+            "{}() Started {} I/O xstreams with {} pools{}", __func__,
+            xstreams_num, pools_num,
+            cpus.empty() ? "" : fmt::format(" bound to {} CPUs", cpus.size()));
 
     RPC_DATA->io_streams(xstreams);
-    RPC_DATA->io_pool(pool);
+    RPC_DATA->io_pools(pools);
 }
 
 /**
@@ -137,6 +186,8 @@ void
 register_server_rpcs(margo_instance_id mid) {
     MARGO_REGISTER(mid, gkfs::rpc::tag::fs_config, void, rpc_config_out_t,
                    rpc_srv_get_fs_config);
+    MARGO_REGISTER(mid, gkfs::rpc::tag::daemon_status, void,
+                   rpc_daemon_status_out_t, rpc_srv_get_daemon_status);
     MARGO_REGISTER(mid, gkfs::rpc::tag::create, rpc_mk_node_in_t, rpc_err_out_t,
                    rpc_srv_create);
     MARGO_REGISTER(mid, gkfs::rpc::tag::stat, rpc_path_only_in_t,
@@ -168,11 +219,17 @@ register_server_rpcs(margo_instance_id mid) {
     MARGO_REGISTER(mid, gkfs::rpc::tag::write, rpc_write_data_in_t,
                    rpc_data_out_t, rpc_srv_write);
     MARGO_REGISTER(mid, gkfs::rpc::tag::read, rpc_read_data_in_t,
-                   rpc_data_out_t, rpc_srv_read);
+                   rpc_read_data_out_t, rpc_srv_read);
     MARGO_REGISTER(mid, gkfs::rpc::tag::truncate, rpc_trunc_in_t, rpc_err_out_t,
                    rpc_srv_truncate);
     MARGO_REGISTER(mid, gkfs::rpc::tag::get_chunk_stat, rpc_chunk_stat_in_t,
                    rpc_chunk_stat_out_t, rpc_srv_get_chunk_stat);
+    MARGO_REGISTER(mid, gkfs::rpc::tag::replicate_chunk,
+                   rpc_replicate_chunk_in_t, rpc_err_out_t,
+                   rpc_srv_replicate_chunk);
+    MARGO_REGISTER(mid, gkfs::rpc::tag::invalidate_replica,
+                   rpc_invalidate_replica_in_t, rpc_err_out_t,
+                   rpc_srv_invalidate_replica);
 }
 
 /**
@@ -192,7 +249,7 @@ init_rpc_server() {
     // Start Margo (this will also initialize Argobots and Mercury internally)
     auto margo_config = fmt::format(
             R"({{ "use_progress_thread" : true, "rpc_thread_count" : {} }})",
-            gkfs::config::rpc::daemon_handler_xstreams);
+            GKFS_DATA->handler_xstreams());
     struct margo_init_info args = {nullptr};
     args.json_config = margo_config.c_str();
     args.hg_init_info = &hg_options;
@@ -300,6 +357,19 @@ init_environment() {
                 GKFS_DATA->enable_chunkstats(), GKFS_DATA->enable_prometheus(),
                 GKFS_DATA->stats_file(), GKFS_DATA->prometheus_gateway()));
 
+    // Initialize hot chunk replication
+    if(GKFS_DATA->hot_chunk_replicas() > 0) {
+        GKFS_DATA->spdlogger()->debug(
+                "{}() Initializing hot chunk replication with '{}' replicas",
+                __func__, GKFS_DATA->hot_chunk_replicas());
+        GKFS_DATA->replica_manager(
+                std::make_shared<gkfs::data::ReplicaManager>(
+                        GKFS_DATA->hot_chunk_replicas(),
+                        GKFS_DATA->hot_chunk_threshold(),
+                        std::chrono::seconds(
+                                gkfs::config::replication::window)));
+    }
+
     // Initialize data backend
     auto chunk_storage_path = fmt::format("{}/{}", GKFS_DATA->rootdir(),
                                           gkfs::config::data::chunk_dir);
@@ -308,7 +378,8 @@ init_environment() {
     fs::create_directories(chunk_storage_path);
     try {
         GKFS_DATA->storage(std::make_shared<gkfs::data::ChunkStorage>(
-                chunk_storage_path, gkfs::config::rpc::chunksize));
+                chunk_storage_path, gkfs::config::rpc::chunksize,
+                GKFS_DATA->chunk_backend()));
     } catch(const std::exception& e) {
         GKFS_DATA->spdlogger()->error(
                 "{}() Failed to initialize storage backend: {}", __func__,
@@ -327,6 +398,27 @@ init_environment() {
         throw;
     }
 
+    // Bulk buffers are registered with the RPC server's Margo instance
+    if(GKFS_DATA->bulk_pool_size() > 0) {
+        GKFS_DATA->spdlogger()->debug(
+                "{}() Initializing bulk buffer pool with '{}' MiB", __func__,
+                GKFS_DATA->bulk_pool_size());
+        RPC_DATA->bulk_pool(std::make_shared<gkfs::rpc::BulkBufferPool>(
+                RPC_DATA->server_rpc_mid(), gkfs::config::rpc::chunksize,
+                gkfs::config::rpc::bulk_pool_max_buffer,
+                GKFS_DATA->bulk_pool_size() * 1024 * 1024));
+    }
+
+    // Mappings of chunk files are registered with the RPC server as well
+    if(GKFS_DATA->chunk_map_cache_size() > 0) {
+        GKFS_DATA->spdlogger()->debug(
+                "{}() Initializing chunk map cache with '{}' MiB", __func__,
+                GKFS_DATA->chunk_map_cache_size());
+        GKFS_DATA->chunk_map_cache(std::make_shared<gkfs::data::ChunkMapCache>(
+                RPC_DATA->server_rpc_mid(),
+                GKFS_DATA->chunk_map_cache_size() * 1024 * 1024));
+    }
+
     // Init Argobots ESs to drive IO
     try {
         GKFS_DATA->spdlogger()->debug("{}() Initializing I/O pool", __func__);
@@ -338,6 +430,37 @@ init_environment() {
         throw;
     }
 
+    // Chunks of removed files are reclaimed by a ULT in the I/O pool
+    try {
+        GKFS_DATA->chunk_collector(std::make_shared<gkfs::data::ChunkCollector>(
+                GKFS_DATA->storage(), RPC_DATA->io_pool(),
+                gkfs::config::data::gc_batch,
+                std::chrono::milliseconds(gkfs::config::data::gc_interval)));
+    } catch(const std::exception& e) {
+        GKFS_DATA->spdlogger()->error(
+                "{}() Failed to start chunk collector: {}", __func__, e.what());
+        throw;
+    }
+
+    // Init the built-in I/O scheduler which dispatches on the I/O pool
+    if(GKFS_DATA->io_scheduler_window() > 0) {
+        GKFS_DATA->spdlogger()->debug(
+                "{}() Initializing I/O scheduler with window '{}us' and deadline '{}us'",
+                __func__, GKFS_DATA->io_scheduler_window(),
+                GKFS_DATA->io_scheduler_deadline());
+        try {
+            GKFS_DATA->io_scheduler(std::make_shared<gkfs::data::IoScheduler>(
+                    std::chrono::microseconds(GKFS_DATA->io_scheduler_window()),
+                    std::chrono::microseconds(
+                            GKFS_DATA->io_scheduler_deadline())));
+        } catch(const std::exception& e) {
+            GKFS_DATA->spdlogger()->error(
+                    "{}() Failed to initialize I/O scheduler: {}", __func__,
+                    e.what());
+            throw;
+        }
+    }
+
     // TODO set metadata configurations. these have to go into a user
     // configurable file that is parsed here
     GKFS_DATA->atime_state(gkfs::config::metadata::use_atime);
@@ -395,12 +518,21 @@ destroy_enviroment() {
     GKFS_DATA->spdlogger()->debug("{}() Removing mount directory", __func__);
     std::error_code ecode;
     fs::remove_all(GKFS_DATA->mountdir(), ecode);
+    if(GKFS_DATA->chunk_collector()) {
+        GKFS_DATA->spdlogger()->debug(
+                "{}() Stopping chunk collector after reclaiming '{}' entries",
+                __func__, GKFS_DATA->chunk_collector()->reclaimed());
+        // the collector ULT must finish before the I/O streams can be joined
+        GKFS_DATA->chunk_collector(nullptr);
+    }
     GKFS_DATA->spdlogger()->debug("{}() Freeing I/O executions streams",
                                   __func__);
     for(unsigned int i = 0; i < RPC_DATA->io_streams().size(); i++) {
         ABT_xstream_join(RPC_DATA->io_streams().at(i));
         ABT_xstream_free(&RPC_DATA->io_streams().at(i));
     }
+    // all dispatchers have finished with their execution streams
+    GKFS_DATA->io_scheduler(nullptr);
 
     if(!GKFS_DATA->hosts_file().empty()) {
         GKFS_DATA->spdlogger()->debug("{}() Removing hosts file", __func__);
@@ -412,6 +544,10 @@ destroy_enviroment() {
         }
     }
 
+    // buffers are deregistered once the last handler returns its lease
+    RPC_DATA->bulk_pool(nullptr);
+    GKFS_DATA->chunk_map_cache(nullptr);
+
     if(RPC_DATA->server_rpc_mid() != nullptr) {
         GKFS_DATA->spdlogger()->debug("{}() Finalizing margo RPC server",
                                       __func__);
@@ -430,6 +566,8 @@ destroy_enviroment() {
         fs::remove_all(GKFS_DATA->rootdir(), ecode);
     }
     GKFS_DATA->close_stats();
+    // writes out the remaining spans
+    GKFS_DATA->tracer(nullptr);
 }
 
 /**
@@ -559,6 +697,7 @@ parse_input(const cli_options& opts, const CLI::App& desc) {
     auto rootdir_path = fs::path(rootdir);
     if(desc.count("--rootdir-suffix")) {
         if(opts.rootdir_suffix == gkfs::config::data::chunk_dir ||
+           opts.rootdir_suffix == gkfs::config::data::trash_dir ||
            opts.rootdir_suffix == gkfs::config::metadata::dir)
             throw runtime_error(fmt::format(
                     "rootdir_suffix '{}' is reserved and not allowed.",
@@ -589,6 +728,49 @@ parse_input(const cli_options& opts, const CLI::App& desc) {
     fs::create_directories(rootdir_path);
     GKFS_DATA->rootdir(rootdir_path.native());
 
+    /*
+     * Argobots execution streams and their placement
+     */
+    if(desc.count("--io-xstreams")) {
+        auto io_xstreams = stoul(opts.io_xstreams);
+        if(io_xstreams == 0)
+            throw runtime_error("At least one I/O xstream is required.");
+        GKFS_DATA->io_xstreams(io_xstreams);
+    }
+    if(desc.count("--handler-xstreams")) {
+        GKFS_DATA->handler_xstreams(stoul(opts.handler_xstreams));
+    }
+    if(desc.count("--io-pools")) {
+        if(opts.io_pools != "shared" && opts.io_pools != "private")
+            throw runtime_error(fmt::format(
+                    "Given I/O pool topology '{}' not supported. Available: {{shared, private}}",
+                    opts.io_pools));
+        GKFS_DATA->io_private_pools(opts.io_pools == "private");
+    }
+    if(desc.count("--bulk-pool-size")) {
+        GKFS_DATA->bulk_pool_size(stoul(opts.bulk_pool_size));
+    }
+    if(desc.count("--io-cpus")) {
+        GKFS_DATA->io_cpus(gkfs::utils::parse_cpu_list(opts.io_cpus));
+    } else if(desc.count("--numa-node")) {
+        // "auto" uses the NUMA node of the device holding the rootdir
+        auto numa_node = opts.numa_node == "auto"
+                                 ? gkfs::utils::numa_node_of_path(
+                                           rootdir_path.native())
+                                 : stoi(opts.numa_node);
+        auto cpus = gkfs::utils::numa_node_cpus(numa_node);
+        if(cpus.empty()) {
+            GKFS_DATA->spdlogger()->warn(
+                    "{}() NUMA node '{}' unknown. I/O xstreams are not bound.",
+                    __func__, opts.numa_node);
+        } else {
+            GKFS_DATA->spdlogger()->info(
+                    "{}() I/O xstreams are bound to the CPUs of NUMA node {}",
+                    __func__, numa_node);
+            GKFS_DATA->io_cpus(cpus);
+        }
+    }
+
     if(desc.count("--metadir")) {
         auto metadir = opts.metadir;
 
@@ -624,7 +806,8 @@ parse_input(const cli_options& opts, const CLI::App& desc) {
 
     if(desc.count("--dbbackend")) {
         if(opts.dbbackend == gkfs::metadata::rocksdb_backend ||
-           opts.dbbackend == gkfs::metadata::parallax_backend) {
+           opts.dbbackend == gkfs::metadata::parallax_backend ||
+           opts.dbbackend == gkfs::metadata::memory_backend) {
 #ifndef GKFS_ENABLE_PARALLAX
             if(opts.dbbackend == gkfs::metadata::parallax_backend) {
                 throw runtime_error(fmt::format(
@@ -651,6 +834,28 @@ parse_input(const cli_options& opts, const CLI::App& desc) {
     } else
         GKFS_DATA->dbbackend(gkfs::metadata::rocksdb_backend);
 
+    if(desc.count("--chunkbackend")) {
+        if(opts.chunk_backend != gkfs::data::file_backend &&
+           opts.chunk_backend != gkfs::data::container_backend) {
+            throw runtime_error(fmt::format(
+                    "chunkbackend '{}' is not valid. Consult `--help`",
+                    opts.chunk_backend));
+        }
+        GKFS_DATA->chunk_backend(opts.chunk_backend);
+    } else
+        GKFS_DATA->chunk_backend(gkfs::data::file_backend);
+
+    if(desc.count("--chunk-map-cache")) {
+        GKFS_DATA->chunk_map_cache_size(stoul(opts.chunk_map_cache));
+        if(GKFS_DATA->chunk_map_cache_size() > 0 &&
+           GKFS_DATA->chunk_backend() != gkfs::data::file_backend) {
+            GKFS_DATA->spdlogger()->warn(
+                    "{}() --chunk-map-cache is ignored with chunk backend '{}'",
+                    __func__, GKFS_DATA->chunk_backend());
+            GKFS_DATA->chunk_map_cache_size(0);
+        }
+    }
+
     if(desc.count("--parallaxsize")) { // Size in GB
         GKFS_DATA->parallax_size_md(stoi(opts.parallax_size));
     }
@@ -668,6 +873,37 @@ parse_input(const cli_options& opts, const CLI::App& desc) {
         GKFS_DATA->spdlogger()->info("{}() Chunk statistic collection enabled",
                                      __func__);
     }
+    if(desc.count("--hot-chunk-threshold")) {
+        GKFS_DATA->hot_chunk_threshold(stoul(opts.hot_chunk_threshold));
+    }
+    if(desc.count("--io-scheduler-window")) {
+#ifdef GKFS_ENABLE_AGIOS
+        GKFS_DATA->spdlogger()->warn(
+                "{}() --io-scheduler-window is ignored as AGIOS schedules I/O requests",
+                __func__);
+#else
+        GKFS_DATA->io_scheduler_window(stoul(opts.io_scheduler_window));
+#endif
+    }
+    if(desc.count("--io-scheduler-deadline")) {
+        GKFS_DATA->io_scheduler_deadline(stoul(opts.io_scheduler_deadline));
+    }
+    if(GKFS_DATA->io_scheduler_window() > 0) {
+        GKFS_DATA->spdlogger()->info(
+                "{}() I/O scheduler enabled with a window of {}us and a deadline of {}us",
+                __func__, GKFS_DATA->io_scheduler_window(),
+                GKFS_DATA->io_scheduler_deadline());
+    }
+    if(desc.count("--hot-chunk-replicas")) {
+        GKFS_DATA->hot_chunk_replicas(stoul(opts.hot_chunk_replicas));
+        if(GKFS_DATA->hot_chunk_replicas() > 0) {
+            GKFS_DATA->spdlogger()->info(
+                    "{}() Hot chunk replication enabled with {} replicas and a threshold of {} reads in {}s",
+                    __func__, GKFS_DATA->hot_chunk_replicas(),
+                    GKFS_DATA->hot_chunk_threshold(),
+                    gkfs::config::replication::window);
+        }
+    }
 
 #ifdef GKFS_ENABLE_PROMETHEUS
     if(desc.count("--enable-prometheus")) {
@@ -709,6 +945,28 @@ parse_input(const cli_options& opts, const CLI::App& desc) {
         GKFS_DATA->spdlogger()->debug("{}() Statistics output disabled",
                                       __func__);
     }
+
+    if(desc.count("--trace-dir")) {
+        auto trace_path = fmt::format("{}/gkfs_daemon_{}_{}.trace",
+                                      opts.trace_dir,
+                                      gkfs::rpc::get_my_hostname(true),
+                                      getpid());
+        auto fd = ::open(trace_path.c_str(), O_CREAT | O_WRONLY | O_TRUNC,
+                         0600);
+        if(fd == -1) {
+            GKFS_DATA->spdlogger()->warn(
+                    "{}() Failed to open trace file '{}': {}. Tracing disabled",
+                    __func__, trace_path, strerror(errno));
+        } else {
+            GKFS_DATA->tracer(std::make_shared<gkfs::trace::writer>(
+                    fd, [](int fd, const void* buf, size_t count) -> long {
+                        return ::write(fd, buf, count);
+                    }));
+            GKFS_DATA->spdlogger()->info(
+                    "{}() RPC traces are written to file '{}'", __func__,
+                    trace_path);
+        }
+    }
 }
 
 /**
@@ -762,6 +1020,29 @@ main(int argc, const char* argv[]) {
                 "--auto-sm",
                 "Enables intra-node communication (IPCs) via the `na+sm` (shared memory) protocol, "
                 "instead of using the RPC protocol. (Default off)");
+    desc.add_option(
+                "--io-xstreams", opts.io_xstreams,
+                "Number of Argobots execution streams for I/O tasks. (Default 8)");
+    desc.add_option(
+                "--handler-xstreams", opts.handler_xstreams,
+                "Number of Argobots execution streams for RPC handlers. (Default 4)");
+    desc.add_option(
+                "--io-pools", opts.io_pools,
+                "I/O task pool topology. Available: {shared, private}\n"
+                "shared: all I/O xstreams use one pool. private: each I/O xstream has its own pool "
+                "and steals tasks from the others when idle. (Default shared)");
+    desc.add_option(
+                "--bulk-pool-size", opts.bulk_pool_size,
+                "Memory in MiB for pre-registered bulk buffers that are reused by read and write "
+                "requests. Requests wait for a buffer if all memory is in use. 0 disables the pool. "
+                "(Default 1024)");
+    desc.add_option(
+                "--io-cpus", opts.io_cpus,
+                "Binds the I/O xstreams to the given CPUs in round robin, e.g., '0-15,32-47'.");
+    desc.add_option(
+                "--numa-node", opts.numa_node,
+                "Binds the I/O xstreams to the CPUs of a NUMA node. 'auto' selects the node of the "
+                "storage device holding the rootdir. Ignored if --io-cpus is given.");
     desc.add_flag(
                 "--clean-rootdir",
                 "Cleans Rootdir >before< launching the deamon");
@@ -770,9 +1051,20 @@ main(int argc, const char* argv[]) {
                 "Cleans Rootdir >after< the deamon finishes");
     desc.add_option(
                 "--dbbackend,-d", opts.dbbackend,
-                "Metadata database backend to use. Available: {rocksdb, parallaxdb}\n"
+                "Metadata database backend to use. Available: {rocksdb, parallaxdb, memory}\n"
                 "RocksDB is default if not set. Parallax support is experimental.\n"
-                "Note, parallaxdb creates a file called rocksdbx with 8GB created in metadir.");
+                "Note, parallaxdb creates a file called rocksdbx with 8GB created in metadir.\n"
+                "memory keeps metadata in memory only and is lost when the daemon stops.");
+    desc.add_option(
+                "--chunkbackend", opts.chunk_backend,
+                "Layout of data chunks in the rootdir. Available: {file, container}\n"
+                "'file' (default) stores each chunk in its own file. 'container' stores chunks\n"
+                "as extents in a few preallocated container files.");
+    desc.add_option(
+                "--chunk-map-cache", opts.chunk_map_cache,
+                "Memory in MiB for read-only mappings of chunk files. Reads push data directly from\n"
+                "the mapped page cache instead of copying it into a bulk buffer. Only with the\n"
+                "'file' chunk backend. 0 disables mapped reads. (Default 0)");
     desc.add_option("--parallaxsize", opts.parallax_size,
                     "parallaxdb - metadata file size in GB (default 8GB), "
                     "used only with new files");
@@ -784,9 +1076,27 @@ main(int argc, const char* argv[]) {
                 "--enable-chunkstats",
                 "Enables collection of data chunk statistics in I/O operations."
                 "Output requires either the --output-stats or --enable-prometheus argument.");
+    desc.add_option(
+                "--hot-chunk-replicas", opts.hot_chunk_replicas,
+                "Replicates chunks that are read frequently to the given number of other daemons "
+                "to spread their reads. (Default 0, disabled)");
+    desc.add_option(
+                "--hot-chunk-threshold", opts.hot_chunk_threshold,
+                "Number of reads of a chunk within 10s that trigger its replication. (Default 64)");
+    desc.add_option(
+                "--io-scheduler-window", opts.io_scheduler_window,
+                "Merges writes to the same chunk that arrive within the given time in microseconds "
+                "before writing them. Not available with AGIOS. (Default 0, disabled)");
+    desc.add_option(
+                "--io-scheduler-deadline", opts.io_scheduler_deadline,
+                "Maximum time in microseconds a write is held back by the I/O scheduler. (Default 2000)");
     desc.add_option(
                 "--output-stats", opts.stats_file,
                 "Creates a thread that outputs the server stats each 10s to the specified file.");
+    desc.add_option(
+                "--trace-dir", opts.trace_dir,
+                "Writes spans of traced client RPCs to a file in the given directory. "
+                "Clients choose which operations are traced (see LIBGKFS_TRACE_SAMPLING).");
                     
     #ifdef GKFS_ENABLE_PROMETHEUS
     desc.add_flag(
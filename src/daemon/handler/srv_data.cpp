@@ -38,11 +38,15 @@
 #include <daemon/handler/rpc_util.hpp>
 #include <daemon/backend/data/chunk_storage.hpp>
 #include <daemon/ops/data.hpp>
+#include <daemon/ops/replication.hpp>
+#include <daemon/classes/bulk_buffer_pool.hpp>
+#include <daemon/classes/chunk_map_cache.hpp>
 
 #include <common/rpc/rpc_types.hpp>
 #include <common/rpc/distributor.hpp>
 #include <common/arithmetic/arithmetic.hpp>
 #include <common/statistics/stats.hpp>
+#include <common/trace_util.hpp>
 
 #ifdef GKFS_ENABLE_AGIOS
 #include <daemon/scheduler/agios.hpp>
@@ -91,6 +95,9 @@ namespace {
  */
 hg_return_t
 rpc_srv_write(hg_handle_t handle) {
+    const auto started = gkfs::utils::Stats::clock::now();
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::write);
+    const gkfs::rpc::inflight_guard running(inflight);
     /*
      * 1. Setup
      */
@@ -111,6 +118,11 @@ rpc_srv_write(hg_handle_t handle) {
     auto hgi = margo_get_info(handle);
     auto mid = margo_hg_info_get_instance(hgi);
     auto bulk_size = margo_bulk_get_size(in.bulk_handle);
+    const gkfs::rpc::inflight_guard transferring(RPC_DATA->bulk_inflight(),
+                                                 bulk_size);
+    auto trace_span = gkfs::trace::handler_span(
+            GKFS_DATA->tracer().get(), "handler:write",
+            {in.trace_id, in.span_id, in.send_time});
     GKFS_DATA->spdlogger()->debug(
             "{}() path: '{}' chunk_start '{}' chunk_end '{}' chunk_n '{}' total_chunk_size '{}' bulk_size: '{}' offset: '{}'",
             __func__, in.path, in.chunk_start, in.chunk_end, in.chunk_n,
@@ -163,26 +175,37 @@ rpc_srv_write(hg_handle_t handle) {
      */
     void* bulk_buf;                          // buffer for bulk transfer
     vector<char*> bulk_buf_ptrs(in.chunk_n); // buffer-chunk offsets
-    // create bulk handle and allocated memory for buffer with buf_sizes
-    // information
-    ret = margo_bulk_create(mid, 1, nullptr, &in.total_chunk_size,
-                            HG_BULK_READWRITE, &bulk_handle);
-    if(ret != HG_SUCCESS) {
-        GKFS_DATA->spdlogger()->error("{}() Failed to create bulk handle",
-                                      __func__);
-        return gkfs::rpc::cleanup_respond(&handle, &in, &out,
-                                          static_cast<hg_bulk_t*>(nullptr));
-    }
-    // access the internally allocated memory buffer and put it into buf_ptrs
-    uint32_t actual_count;
-    ret = margo_bulk_access(bulk_handle, 0, in.total_chunk_size,
-                            HG_BULK_READWRITE, 1, &bulk_buf,
-                            &in.total_chunk_size, &actual_count);
-    if(ret != HG_SUCCESS || actual_count != 1) {
-        GKFS_DATA->spdlogger()->error(
-                "{}() Failed to access allocated buffer from bulk handle",
-                __func__);
-        return gkfs::rpc::cleanup_respond(&handle, &in, &out, &bulk_handle);
+    // take a pre-registered buffer from the pool. The lease adds a reference
+    // to the pooled bulk handle which is dropped when bulk_handle is freed.
+    gkfs::rpc::BulkLease bulk_lease{RPC_DATA->bulk_pool(),
+                                    in.total_chunk_size};
+    if(bulk_lease) {
+        bulk_handle = bulk_lease.handle();
+        bulk_buf = bulk_lease.data();
+    } else {
+        // no pool or transfer too large for it: create bulk handle and
+        // allocate memory for buffer with buf_sizes information
+        ret = margo_bulk_create(mid, 1, nullptr, &in.total_chunk_size,
+                                HG_BULK_READWRITE, &bulk_handle);
+        if(ret != HG_SUCCESS) {
+            GKFS_DATA->spdlogger()->error("{}() Failed to create bulk handle",
+                                          __func__);
+            return gkfs::rpc::cleanup_respond(
+                    &handle, &in, &out, static_cast<hg_bulk_t*>(nullptr));
+        }
+        // access the internally allocated memory buffer and put it into
+        // buf_ptrs
+        uint32_t actual_count;
+        ret = margo_bulk_access(bulk_handle, 0, in.total_chunk_size,
+                                HG_BULK_READWRITE, 1, &bulk_buf,
+                                &in.total_chunk_size, &actual_count);
+        if(ret != HG_SUCCESS || actual_count != 1) {
+            GKFS_DATA->spdlogger()->error(
+                    "{}() Failed to access allocated buffer from bulk handle",
+                    __func__);
+            return gkfs::rpc::cleanup_respond(&handle, &in, &out,
+                                              &bulk_handle);
+        }
     }
     auto const host_id = in.host_id;
     [[maybe_unused]] auto const host_size = in.host_size;
@@ -256,15 +279,19 @@ rpc_srv_write(hg_handle_t handle) {
             else
                 offset_transfer_size = static_cast<size_t>(
                         gkfs::config::rpc::chunksize - in.offset);
+            auto pull_span = trace_span.child("bulk_pull");
             ret = margo_bulk_transfer(mid, HG_BULK_PULL, hgi->addr,
                                       in.bulk_handle, 0, bulk_handle, 0,
                                       offset_transfer_size);
+            pull_span.end();
             if(ret != HG_SUCCESS) {
                 GKFS_DATA->spdlogger()->error(
                         "{}() Failed to pull data from client for chunk {} (startchunk {}; endchunk {}",
                         __func__, chnk_id_file, in.chunk_start,
                         in.chunk_end - 1);
                 out.err = EBUSY;
+                // earlier chunks may still be written from bulk_buf
+                chunk_op.abort_tasks();
                 return gkfs::rpc::cleanup_respond(&handle, &in, &out,
                                                   &bulk_handle);
             }
@@ -292,15 +319,19 @@ rpc_srv_write(hg_handle_t handle) {
                     in.total_chunk_size, chnk_size_left_host, origin_offset,
                     local_offset, transfer_size);
             // RDMA the data to here
+            auto pull_span = trace_span.child("bulk_pull");
             ret = margo_bulk_transfer(mid, HG_BULK_PULL, hgi->addr,
                                       in.bulk_handle, origin_offset,
                                       bulk_handle, local_offset, transfer_size);
+            pull_span.end();
             if(ret != HG_SUCCESS) {
                 GKFS_DATA->spdlogger()->error(
                         "{}() Failed to pull data from client. file {} chunk {} (startchunk {}; endchunk {})",
                         __func__, in.path, chnk_id_file, in.chunk_start,
                         (in.chunk_end - 1));
                 out.err = EBUSY;
+                // earlier chunks may still be written from bulk_buf
+                chunk_op.abort_tasks();
                 return gkfs::rpc::cleanup_respond(&handle, &in, &out,
                                                   &bulk_handle);
             }
@@ -320,6 +351,7 @@ rpc_srv_write(hg_handle_t handle) {
             // fails, something is really wrong
             GKFS_DATA->spdlogger()->error("{}() while write_nonblock err '{}'",
                                           __func__, e.what());
+            chunk_op.abort_tasks();
             return gkfs::rpc::cleanup_respond(&handle, &in, &out, &bulk_handle);
         }
         // next chunk
@@ -334,10 +366,27 @@ rpc_srv_write(hg_handle_t handle) {
     /*
      * 4. Read task results and accumulate in out.io_size
      */
+    auto io_span = trace_span.child("io_wait");
     auto write_result = chunk_op.wait_for_tasks();
+    io_span.end();
     out.err = write_result.first;
     out.io_size = write_result.second;
 
+#ifndef GKFS_ENABLE_FORWARDING
+    // Replicas of written chunks are stale. They are no longer announced to
+    // clients and are dropped on the replica daemons in the background.
+    if(GKFS_DATA->replica_manager()) {
+        vector<gkfs::data::ReplicaSet> stale_replicas{};
+        for(uint64_t i = 0; i < chnk_id_curr; i++) {
+            auto set = GKFS_DATA->replica_manager()->invalidate(
+                    in.path, chnk_ids_host[i]);
+            if(!set.hosts.empty())
+                stale_replicas.emplace_back(move(set));
+        }
+        gkfs::data::invalidate_replicas(in.path, stale_replicas);
+    }
+#endif
+
     // Sanity check to see if all data has been written
     if(in.total_chunk_size != out.io_size) {
         GKFS_DATA->spdlogger()->warn(
@@ -354,8 +403,9 @@ rpc_srv_write(hg_handle_t handle) {
             gkfs::rpc::cleanup_respond(&handle, &in, &out, &bulk_handle);
     if(GKFS_DATA->enable_stats()) {
         GKFS_DATA->stats()->add_value_size(
-                gkfs::utils::Stats::SizeOp::write_size, bulk_size);
+                gkfs::utils::Stats::SizeOp::write_size, bulk_size, started);
     }
+    trace_span.end();
     return handler_ret;
 }
 
@@ -394,11 +444,14 @@ rpc_srv_write(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_read(hg_handle_t handle) {
+    const auto started = gkfs::utils::Stats::clock::now();
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::read);
+    const gkfs::rpc::inflight_guard running(inflight);
     /*
      * 1. Setup
      */
     rpc_read_data_in_t in{};
-    rpc_data_out_t out{};
+    rpc_read_data_out_t out{};
     hg_bulk_t bulk_handle = nullptr;
     // Set default out for error
     out.err = EIO;
@@ -413,6 +466,11 @@ rpc_srv_read(hg_handle_t handle) {
     auto hgi = margo_get_info(handle);
     auto mid = margo_hg_info_get_instance(hgi);
     auto bulk_size = margo_bulk_get_size(in.bulk_handle);
+    const gkfs::rpc::inflight_guard transferring(RPC_DATA->bulk_inflight(),
+                                                 bulk_size);
+    auto trace_span = gkfs::trace::handler_span(
+            GKFS_DATA->tracer().get(), "handler:read",
+            {in.trace_id, in.span_id, in.send_time});
 
     GKFS_DATA->spdlogger()->debug(
             "{}() path: '{}' chunk_start '{}' chunk_end '{}' chunk_n '{}' total_chunk_size '{}' bulk_size: '{}' offset: '{}'",
@@ -465,30 +523,48 @@ rpc_srv_read(hg_handle_t handle) {
      */
     void* bulk_buf;                          // buffer for bulk transfer
     vector<char*> bulk_buf_ptrs(in.chunk_n); // buffer-chunk offsets
-    // create bulk handle and allocated memory for buffer with buf_sizes
-    // information
-    ret = margo_bulk_create(mid, 1, nullptr, &in.total_chunk_size,
-                            HG_BULK_READWRITE, &bulk_handle);
-    if(ret != HG_SUCCESS) {
-        GKFS_DATA->spdlogger()->error("{}() Failed to create bulk handle",
-                                      __func__);
-        return gkfs::rpc::cleanup_respond(&handle, &in, &out,
-                                          static_cast<hg_bulk_t*>(nullptr));
-    }
-    // access the internally allocated memory buffer and put it into buf_ptrs
-    uint32_t actual_count;
-    ret = margo_bulk_access(bulk_handle, 0, in.total_chunk_size,
-                            HG_BULK_READWRITE, 1, &bulk_buf,
-                            &in.total_chunk_size, &actual_count);
-    if(ret != HG_SUCCESS || actual_count != 1) {
-        GKFS_DATA->spdlogger()->error(
-                "{}() Failed to access allocated buffer from bulk handle",
-                __func__);
-        return gkfs::rpc::cleanup_respond(&handle, &in, &out, &bulk_handle);
+    // take a pre-registered buffer from the pool. The lease adds a reference
+    // to the pooled bulk handle which is dropped when bulk_handle is freed.
+    gkfs::rpc::BulkLease bulk_lease{RPC_DATA->bulk_pool(),
+                                    in.total_chunk_size};
+    if(bulk_lease) {
+        bulk_handle = bulk_lease.handle();
+        bulk_buf = bulk_lease.data();
+    } else {
+        // no pool or transfer too large for it: create bulk handle and
+        // allocate memory for buffer with buf_sizes information
+        ret = margo_bulk_create(mid, 1, nullptr, &in.total_chunk_size,
+                                HG_BULK_READWRITE, &bulk_handle);
+        if(ret != HG_SUCCESS) {
+            GKFS_DATA->spdlogger()->error("{}() Failed to create bulk handle",
+                                          __func__);
+            return gkfs::rpc::cleanup_respond(
+                    &handle, &in, &out, static_cast<hg_bulk_t*>(nullptr));
+        }
+        // access the internally allocated memory buffer and put it into
+        // buf_ptrs
+        uint32_t actual_count;
+        ret = margo_bulk_access(bulk_handle, 0, in.total_chunk_size,
+                                HG_BULK_READWRITE, 1, &bulk_buf,
+                                &in.total_chunk_size, &actual_count);
+        if(ret != HG_SUCCESS || actual_count != 1) {
+            GKFS_DATA->spdlogger()->error(
+                    "{}() Failed to access allocated buffer from bulk handle",
+                    __func__);
+            return gkfs::rpc::cleanup_respond(&handle, &in, &out,
+                                              &bulk_handle);
+        }
     }
 #ifndef GKFS_ENABLE_FORWARDING
     auto const host_id = in.host_id;
     auto const host_size = in.host_size;
+    auto const& replica_manager = GKFS_DATA->replica_manager();
+    // chunks that became hot with this read with their replication version
+    vector<pair<uint64_t, uint64_t>> hot_chunks{};
+    // smallest number of replicas of all served chunks
+    auto replicas = replica_manager ? replica_manager->replicas() : 0;
+    // version of the copy in single chunk mode, 0 if the chunk is owned
+    uint64_t copy_version = 0;
 #endif
     auto path = make_shared<string>(in.path);
     // chnk_ids used by this host
@@ -521,15 +597,42 @@ rpc_srv_read(hg_handle_t handle) {
         chnk_id_file++) {
         // Continue if chunk does not hash to this host
 #ifndef GKFS_ENABLE_FORWARDING
-        if(RPC_DATA->distributor()->locate_data(in.path, chnk_id_file,
-                                                host_size) != host_id) {
+        auto owned = RPC_DATA->distributor()->locate_data(
+                             in.path, chnk_id_file, host_size) == host_id;
+        if(in.replica_chunk >= 0) {
+            // single chunk mode: the client reads one chunk which may be a
+            // replica of a hot chunk owned by another daemon
+            if(chnk_id_file != static_cast<uint64_t>(in.replica_chunk))
+                continue;
+            if(!owned) {
+                copy_version = replica_manager ? replica_manager->copy_version(
+                                                         in.path, chnk_id_file)
+                                               : 0;
+                if(copy_version == 0) {
+                    GKFS_DATA->spdlogger()->debug(
+                            "{}() no valid replica of chunk '{}'", __func__,
+                            chnk_id_file);
+                    out.err = ESTALE;
+                    return gkfs::rpc::cleanup_respond(&handle, &in, &out,
+                                                      &bulk_handle);
+                }
+            }
+        } else if(!owned) {
             GKFS_DATA->spdlogger()->trace(
                     "{}() chunkid '{}' ignored as it does not match to this host with id '{}'. chnk_id_curr '{}'",
                     __func__, chnk_id_file, host_id, chnk_id_curr);
             continue;
         }
-        if(GKFS_DATA->enable_chunkstats()) {
+        if(owned && GKFS_DATA->enable_chunkstats())
             GKFS_DATA->stats()->add_read(in.path, chnk_id_file);
+        if(owned && replica_manager) {
+            auto version = replica_manager->record_read(
+                    in.path, chnk_id_file,
+                    gkfs::data::replica_hosts(host_id, host_size));
+            if(version != 0)
+                hot_chunks.emplace_back(chnk_id_file, version);
+            replicas = min(replicas,
+                           replica_manager->replicated(in.path, chnk_id_file));
         }
 #endif
 
@@ -587,6 +690,8 @@ rpc_srv_read(hg_handle_t handle) {
             // fails, something is really wrong
             GKFS_DATA->spdlogger()->error("{}() while read_nonblock err '{}'",
                                           __func__, e.what());
+            // earlier chunks may still be read into bulk_buf
+            chunk_read_op.cancel_all_tasks();
             return gkfs::rpc::cleanup_respond(&handle, &in, &out, &bulk_handle);
         }
         chnk_id_curr++;
@@ -609,10 +714,31 @@ rpc_srv_read(hg_handle_t handle) {
     bulk_args.local_bulk_handle = bulk_handle;
     bulk_args.local_offsets = &local_offsets;
     bulk_args.chunk_ids = &chnk_ids_host;
+    // data ranges pushed to the client. The client zeroes everything else.
+    vector<gkfs::rpc::data_extent> extents{};
+    bulk_args.extents = &extents;
     // wait for all tasklets and push read data back to client
+    auto io_span = trace_span.child("io_push");
     auto read_result = chunk_read_op.wait_for_tasks_and_push_back(bulk_args);
+    io_span.end();
     out.err = read_result.first;
     out.io_size = read_result.second;
+    string extents_str{};
+    if(out.err == 0) {
+        extents_str = gkfs::rpc::encode_extents(extents);
+        out.extents = extents_str.c_str();
+    }
+#ifndef GKFS_ENABLE_FORWARDING
+    if(copy_version != 0) {
+        // the copy may have been invalidated while it was read
+        if(replica_manager->copy_version(in.path, in.replica_chunk) !=
+           copy_version)
+            out.err = ESTALE;
+    } else if(chnk_id_curr > 0) {
+        // tell the client which of its reads may use the replicas
+        out.replicas = replicas;
+    }
+#endif
 
     /*
      * 5. Respond and cleanup
@@ -623,8 +749,17 @@ rpc_srv_read(hg_handle_t handle) {
             gkfs::rpc::cleanup_respond(&handle, &in, &out, &bulk_handle);
     if(GKFS_DATA->enable_stats()) {
         GKFS_DATA->stats()->add_value_size(
-                gkfs::utils::Stats::SizeOp::read_size, bulk_size);
+                gkfs::utils::Stats::SizeOp::read_size, bulk_size, started);
+    }
+    trace_span.end();
+#ifndef GKFS_ENABLE_FORWARDING
+    // replicate chunks that became hot off the critical path
+    for(const auto& [chunk_id, version] : hot_chunks) {
+        gkfs::data::replicate_chunk_async(
+                *path, chunk_id, version,
+                gkfs::data::replica_hosts(host_id, host_size));
     }
+#endif
     return handler_ret;
 }
 
@@ -644,6 +779,8 @@ rpc_srv_read(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_truncate(hg_handle_t handle) {
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::truncate);
+    const gkfs::rpc::inflight_guard running(inflight);
     rpc_trunc_in_t in{};
     rpc_err_out_t out{};
     out.err = EIO;
@@ -657,6 +794,11 @@ rpc_srv_truncate(hg_handle_t handle) {
     GKFS_DATA->spdlogger()->debug("{}() path: '{}', length: '{}'", __func__,
                                   in.path, in.length);
 
+    // the chunk that is cut is not mapped and no mapped read pushes from it
+    // while its chunk file shrinks
+    const gkfs::data::ChunkShrinkGuard shrink_guard(
+            in.path, gkfs::utils::arithmetic::block_index(
+                             in.length, gkfs::config::rpc::chunksize));
     gkfs::data::ChunkTruncateOperation chunk_op{in.path};
     try {
         // start tasklet for truncate operation
@@ -672,6 +814,16 @@ rpc_srv_truncate(hg_handle_t handle) {
     // wait and get output
     out.err = chunk_op.wait_for_task();
 
+#ifndef GKFS_ENABLE_FORWARDING
+    if(GKFS_DATA->replica_manager()) {
+        auto chunk_start = gkfs::utils::arithmetic::block_index(
+                in.length, gkfs::config::rpc::chunksize);
+        gkfs::data::invalidate_replicas(
+                in.path, GKFS_DATA->replica_manager()->invalidate_from(
+                                 in.path, chunk_start));
+    }
+#endif
+
     GKFS_DATA->spdlogger()->debug("{}() Sending output response '{}'", __func__,
                                   out.err);
     return gkfs::rpc::cleanup_respond(&handle, &in, &out);
@@ -682,6 +834,9 @@ rpc_srv_truncate(hg_handle_t handle) {
  * @brief Serves a chunk stat request, responding with space information of the
  * node local file system.
  * @internal
+ * The number of I/O tasks currently queued in the I/O pools is reported as well
+ * so that clients can use it as a load indicator, e.g., for placing new files
+ * in federated mode.
  * All exceptions must be caught here and dealt with accordingly.
  * @endinteral
  * @param handle Mercury RPC handle
@@ -689,6 +844,8 @@ rpc_srv_truncate(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_get_chunk_stat(hg_handle_t handle) {
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::get_chunk_stat);
+    const gkfs::rpc::inflight_guard running(inflight);
     GKFS_DATA->spdlogger()->debug("{}() enter", __func__);
     rpc_chunk_stat_out_t out{};
     out.err = EIO;
@@ -697,6 +854,10 @@ rpc_srv_get_chunk_stat(hg_handle_t handle) {
         out.chunk_size = chk_stat.chunk_size;
         out.chunk_total = chk_stat.chunk_total;
         out.chunk_free = chk_stat.chunk_free;
+        size_t queue_depth = 0;
+        for(auto length : RPC_DATA->io_queue_lengths())
+            queue_depth += length;
+        out.queue_depth = queue_depth;
         out.err = 0;
     } catch(const gkfs::data::ChunkStorageException& err) {
         GKFS_DATA->spdlogger()->error("{}() {}", __func__, err.what());
@@ -712,6 +873,131 @@ rpc_srv_get_chunk_stat(hg_handle_t handle) {
     return gkfs::rpc::cleanup_respond(&handle, &out);
 }
 
+/**
+ * @brief Serves a request of another daemon to store a replica of one of its
+ * hot chunks.
+ * @internal
+ * The chunk is pulled from the owning daemon and stored under its regular
+ * chunk path, replacing an older copy. Clients never write chunks to a daemon
+ * that is not their owner, so the chunk file is not accessed by other I/O
+ * tasks except for reads of this copy. Those reads only proceed while the copy
+ * is marked valid in the ReplicaManager.
+ *
+ * All exceptions must be caught here and dealt with accordingly.
+ * @endinteral
+ * @param handle Mercury RPC handle
+ * @return Mercury error code to Mercury
+ */
+hg_return_t
+rpc_srv_replicate_chunk(hg_handle_t handle) {
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::replicate_chunk);
+    const gkfs::rpc::inflight_guard running(inflight);
+    rpc_replicate_chunk_in_t in{};
+    rpc_err_out_t out{};
+    hg_bulk_t bulk_handle = nullptr;
+    out.err = EIO;
+    auto ret = margo_get_input(handle, &in);
+    if(ret != HG_SUCCESS) {
+        GKFS_DATA->spdlogger()->error(
+                "{}() Could not get RPC input data with err {}", __func__, ret);
+        return gkfs::rpc::cleanup_respond(&handle, &in, &out);
+    }
+    GKFS_DATA->spdlogger()->debug(
+            "{}() path: '{}' chunk_id '{}' version '{}' size '{}'", __func__,
+            in.path, in.chunk_id, in.version, in.size);
+    auto& replica_manager = GKFS_DATA->replica_manager();
+    if(!replica_manager || in.size > gkfs::config::rpc::chunksize) {
+        out.err = ENOTSUP;
+        return gkfs::rpc::cleanup_respond(&handle, &in, &out);
+    }
+    if(!replica_manager->accept_copy(in.path, in.chunk_id, in.version)) {
+        out.err = ESTALE;
+        return gkfs::rpc::cleanup_respond(&handle, &in, &out);
+    }
+    auto hgi = margo_get_info(handle);
+    auto mid = margo_hg_info_get_instance(hgi);
+    vector<char> buf(in.size);
+    auto buf_ptr = static_cast<void*>(buf.data());
+    hg_size_t size = in.size;
+    ret = margo_bulk_create(mid, 1, &buf_ptr, &size, HG_BULK_WRITE_ONLY,
+                            &bulk_handle);
+    if(ret != HG_SUCCESS) {
+        GKFS_DATA->spdlogger()->error("{}() Failed to create bulk handle",
+                                      __func__);
+        return gkfs::rpc::cleanup_respond(&handle, &in, &out,
+                                          static_cast<hg_bulk_t*>(nullptr));
+    }
+    ret = margo_bulk_transfer(mid, HG_BULK_PULL, hgi->addr, in.bulk_handle, 0,
+                              bulk_handle, 0, size);
+    if(ret != HG_SUCCESS) {
+        GKFS_DATA->spdlogger()->error(
+                "{}() Failed to pull chunk '{}' of '{}' from owning daemon",
+                __func__, in.chunk_id, in.path);
+        out.err = EBUSY;
+        return gkfs::rpc::cleanup_respond(&handle, &in, &out, &bulk_handle);
+    }
+    try {
+        GKFS_DATA->storage()->remove_chunk(in.path, in.chunk_id);
+        GKFS_DATA->storage()->write_chunk(in.path, in.chunk_id, buf.data(),
+                                          size, 0);
+        gkfs::data::invalidate_mapped_chunk(in.path, in.chunk_id);
+        if(replica_manager->commit_copy(in.path, in.chunk_id, in.version)) {
+            out.err = 0;
+        } else {
+            // invalidated while being stored
+            GKFS_DATA->storage()->remove_chunk(in.path, in.chunk_id);
+            gkfs::data::invalidate_mapped_chunk(in.path, in.chunk_id);
+            out.err = ESTALE;
+        }
+    } catch(const gkfs::data::ChunkStorageException& e) {
+        GKFS_DATA->spdlogger()->error("{}() {}", __func__, e.what());
+        out.err = e.code().value();
+    }
+    return gkfs::rpc::cleanup_respond(&handle, &in, &out, &bulk_handle);
+}
+
+/**
+ * @brief Serves a request of another daemon to drop the replica of a chunk
+ * that was modified or removed on its owner.
+ * @internal
+ * All exceptions must be caught here and dealt with accordingly.
+ * @endinteral
+ * @param handle Mercury RPC handle
+ * @return Mercury error code to Mercury
+ */
+hg_return_t
+rpc_srv_invalidate_replica(hg_handle_t handle) {
+    static auto& inflight =
+            RPC_DATA->inflight(gkfs::rpc::tag::invalidate_replica);
+    const gkfs::rpc::inflight_guard running(inflight);
+    rpc_invalidate_replica_in_t in{};
+    rpc_err_out_t out{};
+    out.err = EIO;
+    auto ret = margo_get_input(handle, &in);
+    if(ret != HG_SUCCESS) {
+        GKFS_DATA->spdlogger()->error(
+                "{}() Could not get RPC input data with err {}", __func__, ret);
+        return gkfs::rpc::cleanup_respond(&handle, &in, &out);
+    }
+    GKFS_DATA->spdlogger()->debug("{}() path: '{}' chunk_id '{}' version '{}'",
+                                  __func__, in.path, in.chunk_id, in.version);
+    if(!GKFS_DATA->replica_manager()) {
+        out.err = ENOTSUP;
+        return gkfs::rpc::cleanup_respond(&handle, &in, &out);
+    }
+    // mark the copy invalid first so that no read is served from it anymore
+    GKFS_DATA->replica_manager()->drop_copy(in.path, in.chunk_id, in.version);
+    try {
+        GKFS_DATA->storage()->remove_chunk(in.path, in.chunk_id);
+        gkfs::data::invalidate_mapped_chunk(in.path, in.chunk_id);
+        out.err = 0;
+    } catch(const gkfs::data::ChunkStorageException& e) {
+        GKFS_DATA->spdlogger()->error("{}() {}", __func__, e.what());
+        out.err = e.code().value();
+    }
+    return gkfs::rpc::cleanup_respond(&handle, &in, &out);
+}
+
 } // namespace
 
 DEFINE_MARGO_RPC_HANDLER(rpc_srv_write)
@@ -722,6 +1008,10 @@ DEFINE_MARGO_RPC_HANDLER(rpc_srv_truncate)
 
 DEFINE_MARGO_RPC_HANDLER(rpc_srv_get_chunk_stat)
 
+DEFINE_MARGO_RPC_HANDLER(rpc_srv_replicate_chunk)
+
+DEFINE_MARGO_RPC_HANDLER(rpc_srv_invalidate_replica)
+
 #ifdef GKFS_ENABLE_AGIOS
 void*
 agios_eventual_callback(int64_t request_id, void* info) {
@@ -35,8 +35,13 @@
  */
 #include <daemon/daemon.hpp>
 #include <daemon/handler/rpc_defs.hpp>
+#include <daemon/handler/rpc_util.hpp>
+#include <daemon/backend/metadata/db.hpp>
+#include <daemon/classes/bulk_buffer_pool.hpp>
 
 #include <common/rpc/rpc_types.hpp>
+#include <common/rpc/rpc_util.hpp>
+#include <common/statistics/stats.hpp>
 
 extern "C" {
 #include <unistd.h>
@@ -58,6 +63,8 @@ namespace {
  */
 hg_return_t
 rpc_srv_get_fs_config(hg_handle_t handle) {
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::fs_config);
+    const gkfs::rpc::inflight_guard running(inflight);
     rpc_config_out_t out{};
 
     GKFS_DATA->spdlogger()->debug("{}() Got config RPC", __func__);
@@ -86,6 +93,72 @@ rpc_srv_get_fs_config(hg_handle_t handle) {
     return HG_SUCCESS;
 }
 
+/**
+ * @brief Responds with the live state of the daemon, polled by monitoring
+ * tools such as gkfs-top.
+ * @internal
+ * The state is sent as named counters (see gkfs::rpc::encode_status()):
+ * running handlers per RPC, handler and I/O pool queue lengths, bulk bytes in
+ * flight, metadata backend properties, and, if statistics are enabled,
+ * operation totals and the hottest chunks.
+ * @endinteral
+ * @param handle Mercury RPC handle
+ * @return Mercury error code to Mercury
+ */
+hg_return_t
+rpc_srv_get_daemon_status(hg_handle_t handle) {
+    rpc_daemon_status_out_t out{};
+    vector<gkfs::rpc::status_entry> status{};
+
+    GKFS_DATA->spdlogger()->debug("{}() Got daemon status RPC", __func__);
+
+    try {
+        const string prefix = "rpc_srv_";
+        for(auto& [rpc, count] : RPC_DATA->inflight()) {
+            auto name = rpc.compare(0, prefix.size(), prefix) == 0
+                                ? rpc.substr(prefix.size())
+                                : rpc;
+            status.emplace_back("inflight/" + name, count);
+        }
+        status.emplace_back("queue/handler",
+                            RPC_DATA->handler_queue_length());
+        auto io_queues = RPC_DATA->io_queue_lengths();
+        for(size_t i = 0; i < io_queues.size(); i++)
+            status.emplace_back("queue/io/" + to_string(i), io_queues[i]);
+        status.emplace_back("bulk/inflight", RPC_DATA->bulk_inflight().load());
+        if(const auto& pool = RPC_DATA->bulk_pool()) {
+            status.emplace_back("bulk/pool_in_use", pool->in_use());
+            status.emplace_back("bulk/pool_allocated", pool->allocated());
+        }
+        for(auto& [name, value] : GKFS_DATA->mdb()->properties())
+            status.emplace_back("db/" + name, value);
+        if(const auto& stats = GKFS_DATA->stats()) {
+            for(auto& entry :
+                stats->status(gkfs::config::stats::hot_chunks_status))
+                status.emplace_back(move(entry));
+        }
+        out.err = 0;
+    } catch(const std::exception& e) {
+        GKFS_DATA->spdlogger()->error("{}() Failed to collect status: '{}'",
+                                      __func__, e.what());
+        out.err = EBUSY;
+    }
+
+    auto encoded = gkfs::rpc::encode_status(status);
+    out.status = encoded.c_str();
+    auto hret = margo_respond(handle, &out);
+    if(hret != HG_SUCCESS) {
+        GKFS_DATA->spdlogger()->error(
+                "{}() Failed to respond to daemon status request", __func__);
+    }
+
+    // Destroy handle when finished
+    margo_destroy(handle);
+    return HG_SUCCESS;
+}
+
 } // namespace
 
 DEFINE_MARGO_RPC_HANDLER(rpc_srv_get_fs_config)
+
+DEFINE_MARGO_RPC_HANDLER(rpc_srv_get_daemon_status)
@@ -38,11 +38,15 @@
 #include <daemon/handler/rpc_util.hpp>
 #include <daemon/backend/metadata/db.hpp>
 #include <daemon/backend/data/chunk_storage.hpp>
+#include <daemon/classes/chunk_map_cache.hpp>
+#include <daemon/classes/chunk_collector.hpp>
 #include <daemon/ops/metadentry.hpp>
+#include <daemon/ops/replication.hpp>
 
 #include <common/rpc/rpc_types.hpp>
 #include <common/rpc/rpc_util.hpp>
 #include <common/statistics/stats.hpp>
+#include <common/trace_util.hpp>
 
 using namespace std;
 
@@ -64,6 +68,9 @@ namespace {
  */
 hg_return_t
 rpc_srv_create(hg_handle_t handle) {
+    const auto started = gkfs::utils::Stats::clock::now();
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::create);
+    const gkfs::rpc::inflight_guard running(inflight);
     rpc_mk_node_in_t in;
     rpc_err_out_t out;
 
@@ -99,7 +106,7 @@ rpc_srv_create(hg_handle_t handle) {
     margo_destroy(handle);
     if(GKFS_DATA->enable_stats()) {
         GKFS_DATA->stats()->add_value_iops(
-                gkfs::utils::Stats::IopsOp::iops_create);
+                gkfs::utils::Stats::IopsOp::iops_create, started);
     }
     return HG_SUCCESS;
 }
@@ -119,6 +126,9 @@ rpc_srv_create(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_stat(hg_handle_t handle) {
+    const auto started = gkfs::utils::Stats::clock::now();
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::stat);
+    const gkfs::rpc::inflight_guard running(inflight);
     rpc_path_only_in_t in{};
     rpc_stat_out_t out{};
     auto ret = margo_get_input(handle, &in);
@@ -158,7 +168,7 @@ rpc_srv_stat(hg_handle_t handle) {
 
     if(GKFS_DATA->enable_stats()) {
         GKFS_DATA->stats()->add_value_iops(
-                gkfs::utils::Stats::IopsOp::iops_stats);
+                gkfs::utils::Stats::IopsOp::iops_stats, started);
     }
     return HG_SUCCESS;
 }
@@ -175,6 +185,8 @@ rpc_srv_stat(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_decr_size(hg_handle_t handle) {
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::decr_size);
+    const gkfs::rpc::inflight_guard running(inflight);
     rpc_trunc_in_t in{};
     rpc_err_out_t out{};
 
@@ -231,6 +243,9 @@ rpc_srv_decr_size(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_remove_metadata(hg_handle_t handle) {
+    const auto started = gkfs::utils::Stats::clock::now();
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::remove_metadata);
+    const gkfs::rpc::inflight_guard running(inflight);
     rpc_rm_node_in_t in{};
     rpc_rm_metadata_out_t out{};
 
@@ -250,8 +265,14 @@ rpc_srv_remove_metadata(hg_handle_t handle) {
         out.mode = md.mode();
         out.size = md.size();
         if constexpr(gkfs::config::metadata::implicit_data_removal) {
-            if(S_ISREG(md.mode()) && (md.size() != 0))
-                GKFS_DATA->storage()->destroy_chunk_space(in.path);
+            if(S_ISREG(md.mode()) && (md.size() != 0)) {
+                if(GKFS_DATA->replica_manager())
+                    gkfs::data::invalidate_replicas(
+                            in.path,
+                            GKFS_DATA->replica_manager()->forget(in.path));
+                gkfs::data::remove_chunk_space(in.path);
+                gkfs::data::invalidate_mapped_file(in.path);
+            }
         }
 
     } catch(const gkfs::metadata::DBException& e) {
@@ -280,7 +301,7 @@ rpc_srv_remove_metadata(hg_handle_t handle) {
     margo_destroy(handle);
     if(GKFS_DATA->enable_stats()) {
         GKFS_DATA->stats()->add_value_iops(
-                gkfs::utils::Stats::IopsOp::iops_remove);
+                gkfs::utils::Stats::IopsOp::iops_remove, started);
     }
     return HG_SUCCESS;
 }
@@ -288,8 +309,9 @@ rpc_srv_remove_metadata(hg_handle_t handle) {
 /**
  * @brief Serves a request to remove all file data chunks on this daemon.
  * @internal
- * The handler simply issues the removal of all chunk files on the local file
- * system.
+ * The handler moves the file's chunks to a tombstone which the chunk
+ * collector reclaims in the background. Hence, it does not wait for the chunk
+ * files to be removed from the local file system.
  *
  * All exceptions must be caught here and dealt with accordingly. Any errors are
  * placed in the response.
@@ -299,6 +321,8 @@ rpc_srv_remove_metadata(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_remove_data(hg_handle_t handle) {
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::remove_data);
+    const gkfs::rpc::inflight_guard running(inflight);
     rpc_rm_node_in_t in{};
     rpc_err_out_t out{};
 
@@ -312,7 +336,12 @@ rpc_srv_remove_data(hg_handle_t handle) {
 
     // Remove all chunks for that file
     try {
-        GKFS_DATA->storage()->destroy_chunk_space(in.path);
+        // replicas are removed with the chunks as every daemon receives this
+        // request
+        if(GKFS_DATA->replica_manager())
+            GKFS_DATA->replica_manager()->forget(in.path);
+        gkfs::data::remove_chunk_space(in.path);
+        gkfs::data::invalidate_mapped_file(in.path);
         out.err = 0;
     } catch(const gkfs::data::ChunkStorageException& e) {
         GKFS_DATA->spdlogger()->error(
@@ -348,6 +377,9 @@ rpc_srv_remove_data(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_update_metadentry(hg_handle_t handle) {
+    static auto& inflight =
+            RPC_DATA->inflight(gkfs::rpc::tag::update_metadentry);
+    const gkfs::rpc::inflight_guard running(inflight);
     // Note: Currently this handler is not called by the client.
     rpc_update_metadentry_in_t in{};
     rpc_err_out_t out{};
@@ -409,6 +441,9 @@ rpc_srv_update_metadentry(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_update_metadentry_size(hg_handle_t handle) {
+    static auto& inflight =
+            RPC_DATA->inflight(gkfs::rpc::tag::update_metadentry_size);
+    const gkfs::rpc::inflight_guard running(inflight);
     rpc_update_metadentry_size_in_t in{};
     rpc_update_metadentry_size_out_t out{};
 
@@ -420,7 +455,11 @@ rpc_srv_update_metadentry_size(hg_handle_t handle) {
     GKFS_DATA->spdlogger()->debug(
             "{}() path: '{}', size: '{}', offset: '{}', append: '{}'", __func__,
             in.path, in.size, in.offset, in.append);
+    auto trace_span = gkfs::trace::handler_span(
+            GKFS_DATA->tracer().get(), "handler:size",
+            {in.trace_id, in.span_id, in.send_time});
 
+    auto db_span = trace_span.child("db");
     try {
         std::string cpy(in.buf);
         cpy = gkfs::rpc::decode_string(cpy);
@@ -437,6 +476,7 @@ rpc_srv_update_metadentry_size(hg_handle_t handle) {
                 e.what());
         out.err = EBUSY;
     }
+    db_span.end();
 
     GKFS_DATA->spdlogger()->debug("{}() Sending output '{}'", __func__,
                                   out.err);
@@ -462,6 +502,9 @@ rpc_srv_update_metadentry_size(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_get_metadentry_size(hg_handle_t handle) {
+    static auto& inflight =
+            RPC_DATA->inflight(gkfs::rpc::tag::get_metadentry_size);
+    const gkfs::rpc::inflight_guard running(inflight);
     rpc_path_only_in_t in{};
     rpc_get_metadentry_size_out_t out{};
 
@@ -522,6 +565,9 @@ rpc_srv_get_metadentry_size(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_get_dirents(hg_handle_t handle) {
+    const auto started = gkfs::utils::Stats::clock::now();
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::get_dirents);
+    const gkfs::rpc::inflight_guard running(inflight);
     rpc_get_dirents_in_t in{};
     rpc_get_dirents_out_t out{};
     out.err = EIO;
@@ -651,7 +697,7 @@ rpc_srv_get_dirents(hg_handle_t handle) {
             __func__, out.err, out.dirents_size);
     if(GKFS_DATA->enable_stats()) {
         GKFS_DATA->stats()->add_value_iops(
-                gkfs::utils::Stats::IopsOp::iops_dirent);
+                gkfs::utils::Stats::IopsOp::iops_dirent, started);
     }
     return gkfs::rpc::cleanup_respond(&handle, &in, &out, &bulk_handle);
 }
@@ -681,6 +727,9 @@ rpc_srv_get_dirents(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_get_dirents_extended(hg_handle_t handle) {
+    static auto& inflight =
+            RPC_DATA->inflight(gkfs::rpc::tag::get_dirents_extended);
+    const gkfs::rpc::inflight_guard running(inflight);
     rpc_get_dirents_in_t in{};
     rpc_get_dirents_out_t out{};
     out.err = EIO;
@@ -840,6 +889,8 @@ rpc_srv_get_dirents_extended(hg_handle_t handle) {
  */
 hg_return_t
 rpc_srv_mk_symlink(hg_handle_t handle) {
+    static auto& inflight = RPC_DATA->inflight(gkfs::rpc::tag::mk_symlink);
+    const gkfs::rpc::inflight_guard running(inflight);
     rpc_mk_symlink_in_t in{};
     rpc_err_out_t out{};
 
@@ -31,7 +31,10 @@
 
 #include <daemon/ops/data.hpp>
 #include <daemon/backend/data/chunk_storage.hpp>
+#include <daemon/scheduler/io_scheduler.hpp>
+#include <daemon/classes/chunk_map_cache.hpp>
 #include <common/arithmetic/arithmetic.hpp>
+#include <cstring>
 #include <utility>
 
 extern "C" {
@@ -73,6 +76,9 @@ ChunkTruncateOperation::truncate_abt(void* _arg) {
     try {
         // get chunk from where to cut off
         auto chunk_id_start = block_index(size, gkfs::config::rpc::chunksize);
+        // mappings must not reach beyond the new end of the chunk files. The
+        // handler holds a ChunkShrinkGuard for the chunk that is cut.
+        invalidate_mapped_file(path, chunk_id_start);
         // do not last delete chunk if it is in the middle of a chunk
         auto left_pad = block_overrun(size, gkfs::config::rpc::chunksize);
         if(left_pad != 0) {
@@ -81,6 +87,8 @@ ChunkTruncateOperation::truncate_abt(void* _arg) {
             chunk_id_start++;
         }
         GKFS_DATA->storage()->trim_chunk_space(path, chunk_id_start);
+        invalidate_mapped_file(
+                path, block_index(size, gkfs::config::rpc::chunksize));
     } catch(const ChunkStorageException& err) {
         GKFS_DATA->spdlogger()->error("{}() {}", __func__, err.what());
         err_response = err.code().value();
@@ -191,6 +199,8 @@ ChunkWriteOperation::write_file_abt(void* _arg) {
     try {
         wrote = GKFS_DATA->storage()->write_chunk(path, arg->chnk_id, arg->buf,
                                                   arg->size, arg->off);
+        // the chunk file may have grown beyond an existing mapping
+        invalidate_mapped_chunk(path, arg->chnk_id);
     } catch(const ChunkStorageException& err) {
         GKFS_DATA->spdlogger()->error("{}() {}", __func__, err.what());
         wrote = -(err.code().value());
@@ -206,11 +216,29 @@ ChunkWriteOperation::write_file_abt(void* _arg) {
 void
 ChunkWriteOperation::clear_task_args() {
     task_args_.clear();
+    scheduled_.clear();
 }
 
 ChunkWriteOperation::ChunkWriteOperation(const string& path, size_t n)
     : ChunkOperation{path, n} {
     task_args_.resize(n);
+    scheduled_.resize(n, false);
+}
+
+ChunkWriteOperation::~ChunkWriteOperation() {
+    abort_tasks();
+}
+
+void
+ChunkWriteOperation::abort_tasks() {
+    // eventuals are freed in wait_for_tasks(). Remaining ones were abandoned
+    // by an error path but may still be set by the scheduler's dispatcher.
+    for(size_t idx = 0; idx < scheduled_.size(); idx++) {
+        if(scheduled_[idx] && task_eventuals_[idx] != ABT_EVENTUAL_NULL)
+            ABT_eventual_wait(task_eventuals_[idx], nullptr);
+    }
+    // cancels tasklets that have not started and joins running ones
+    cancel_all_tasks();
 }
 
 /**
@@ -247,6 +275,19 @@ ChunkWriteOperation::write_nonblock(size_t idx, const uint64_t chunk_id,
     task_arg.off = offset;
     task_arg.eventual = task_eventuals_[idx];
 
+    if(GKFS_DATA->io_scheduler()) {
+        try {
+            GKFS_DATA->io_scheduler()->write(path_, chunk_id, bulk_buf_ptr,
+                                             size, offset,
+                                             task_eventuals_[idx]);
+        } catch(const std::runtime_error& e) {
+            throw ChunkWriteOpException(fmt::format(
+                    "ChunkWriteOperation::{}() {}", __func__, e.what()));
+        }
+        scheduled_[idx] = true;
+        return;
+    }
+
     abt_err = ABT_task_create(RPC_DATA->io_pool(), write_file_abt,
                               &task_args_[idx], &abt_tasks_[idx]);
     if(abt_err != ABT_SUCCESS) {
@@ -324,10 +365,28 @@ ChunkReadOperation::read_file_abt(void* _arg) {
     const string& path = *(arg->path);
     ssize_t read = 0;
     try {
+        arg->extents.clear();
+        const auto& map_cache = GKFS_DATA->chunk_map_cache();
+        if(map_cache) {
+            // push from the mapped chunk file without copying. Holes are sent
+            // as zeros. Falls back to reading if the mapping is not usable.
+            arg->mapping = map_cache->get(path, arg->chnk_id);
+            if(arg->mapping) {
+                auto off = static_cast<size_t>(arg->off);
+                if(off < arg->mapping->size)
+                    read = static_cast<ssize_t>(
+                            min(arg->size, arg->mapping->size - off));
+                if(read > 0)
+                    arg->extents.emplace_back(0, static_cast<size_t>(read));
+                ABT_eventual_set(arg->eventual, &read, sizeof(read));
+                return;
+            }
+        }
         // Under expected circumstances (error or no error) read_chunk will
         // signal the eventual
-        read = GKFS_DATA->storage()->read_chunk(path, arg->chnk_id, arg->buf,
-                                                arg->size, arg->off);
+        read = GKFS_DATA->storage()->read_chunk_extents(
+                path, arg->chnk_id, arg->buf, arg->size, arg->off,
+                arg->extents);
     } catch(const ChunkStorageException& err) {
         GKFS_DATA->spdlogger()->error("{}() {}", __func__, err.what());
         read = -(err.code().value());
@@ -438,26 +497,62 @@ ChunkReadOperation::wait_for_tasks_and_push_back(const bulk_args& args) {
             ABT_eventual_free(&task_eventuals_[idx]);
             continue;
         } else {
-            // successful case, push read data back to client
-            GKFS_DATA->spdlogger()->trace(
-                    "ChunkReadOperation::{}() BULK_TRANSFER_PUSH file '{}' chnkid '{}' origin offset '{}' local offset '{}' transfersize '{}'",
-                    __func__, path_, args.chunk_ids->at(idx),
-                    args.origin_offsets->at(idx), args.local_offsets->at(idx),
-                    *task_size);
+            // successful case, push the data regions back to client. Small
+            // holes are zeroed and pushed with their neighbors.
+            auto& extents = task_args_[idx].extents;
+            size_t merged = 0;
+            for(size_t i = 1; i < extents.size(); i++) {
+                auto& prev = extents[merged];
+                auto prev_end = prev.first + prev.second;
+                if(extents[i].first - prev_end <
+                   static_cast<size_t>(gkfs::config::io::sparse_read_min_hole)) {
+                    memset(task_args_[idx].buf + prev_end, 0,
+                           extents[i].first - prev_end);
+                    prev.second = extents[i].first + extents[i].second -
+                                  prev.first;
+                } else {
+                    extents[++merged] = extents[i];
+                }
+            }
+            if(!extents.empty())
+                extents.resize(merged + 1);
             assert(task_args_[idx].chnk_id == args.chunk_ids->at(idx));
-            auto margo_err = margo_bulk_transfer(
-                    args.mid, HG_BULK_PUSH, args.origin_addr,
-                    args.origin_bulk_handle, args.origin_offsets->at(idx),
-                    args.local_bulk_handle, args.local_offsets->at(idx),
-                    *task_size);
-            if(margo_err != HG_SUCCESS) {
-                GKFS_DATA->spdlogger()->error(
-                        "ChunkReadOperation::{}() Failed to margo_bulk_transfer with margo err: '{}'",
-                        __func__, margo_err);
-                io_err = EBUSY;
-                continue;
+            // mapped chunks are pushed from the chunk offset in the mapping
+            const auto& mapping = task_args_[idx].mapping;
+            auto local_handle =
+                    mapping ? mapping->handle : args.local_bulk_handle;
+            auto local_offset =
+                    mapping ? static_cast<size_t>(task_args_[idx].off)
+                            : args.local_offsets->at(idx);
+            for(const auto& [extent_off, extent_size] : extents) {
+                GKFS_DATA->spdlogger()->trace(
+                        "ChunkReadOperation::{}() BULK_TRANSFER_PUSH file '{}' chnkid '{}' origin offset '{}' local offset '{}' transfersize '{}' mapped '{}'",
+                        __func__, path_, args.chunk_ids->at(idx),
+                        args.origin_offsets->at(idx) + extent_off,
+                        local_offset + extent_off, extent_size,
+                        mapping != nullptr);
+                auto margo_err = margo_bulk_transfer(
+                        args.mid, HG_BULK_PUSH, args.origin_addr,
+                        args.origin_bulk_handle,
+                        args.origin_offsets->at(idx) + extent_off,
+                        local_handle, local_offset + extent_off, extent_size);
+                if(margo_err != HG_SUCCESS) {
+                    GKFS_DATA->spdlogger()->error(
+                            "ChunkReadOperation::{}() Failed to margo_bulk_transfer with margo err: '{}'",
+                            __func__, margo_err);
+                    io_err = EBUSY;
+                    break;
+                }
+                total_read += extent_size;
+                if(args.extents)
+                    args.extents->push_back(
+                            {args.origin_offsets->at(idx) + extent_off,
+                             extent_size});
             }
-            total_read += *task_size;
+            // a truncate of the chunk waits for this reader
+            task_args_[idx].mapping.reset();
+            if(io_err != 0)
+                continue;
         }
         ABT_eventual_free(&task_eventuals_[idx]);
     }
@@ -0,0 +1,310 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#include <daemon/ops/replication.hpp>
+#include <daemon/daemon.hpp>
+#include <daemon/backend/data/chunk_storage.hpp>
+#include <common/rpc/distributor.hpp>
+#include <common/rpc/rpc_types.hpp>
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+
+mutex peer_mutex;
+unordered_map<uint64_t, hg_addr_t> peer_addrs;
+// URIs of the hosts file by daemon id, empty for malformed lines
+vector<string> peer_uris;
+
+/**
+ * @brief Returns the URI of another daemon. The hosts file is only read again
+ * if it did not contain the daemon yet, e.g., while daemons are starting.
+ * Called under peer_mutex.
+ * @return URI or an empty string if the daemon is unknown
+ */
+string
+peer_uri(uint64_t host_id) {
+    if(host_id >= peer_uris.size()) {
+        ifstream lf(GKFS_DATA->hosts_file());
+        const regex line_re("^(\\S+)\\s+(\\S+)$");
+        string line;
+        smatch match;
+        peer_uris.clear();
+        while(getline(lf, line)) {
+            peer_uris.emplace_back(
+                    regex_match(line, match, line_re) ? match[2] : string{});
+        }
+    }
+    return host_id < peer_uris.size() ? peer_uris[host_id] : string{};
+}
+
+/**
+ * @brief Resolves the address of another daemon. The daemon id is the line
+ * number in the hosts file which is the order clients use as well.
+ * @param host_id Daemon id
+ * @return Mercury address or HG_ADDR_NULL on failure
+ */
+hg_addr_t
+peer_addr(uint64_t host_id) {
+    string uri{};
+    {
+        lock_guard<mutex> lock(peer_mutex);
+        auto it = peer_addrs.find(host_id);
+        if(it != peer_addrs.end())
+            return it->second;
+        uri = peer_uri(host_id);
+    }
+    if(uri.empty()) {
+        GKFS_DATA->spdlogger()->error(
+                "{}() Daemon with id '{}' not found in hosts file '{}'",
+                __func__, host_id, GKFS_DATA->hosts_file());
+        return HG_ADDR_NULL;
+    }
+    // lookup outside of the lock as it yields the calling ULT
+    auto mid = RPC_DATA->server_rpc_mid();
+    hg_addr_t addr = HG_ADDR_NULL;
+    if(margo_addr_lookup(mid, uri.c_str(), &addr) != HG_SUCCESS) {
+        GKFS_DATA->spdlogger()->error("{}() Failed to lookup address '{}'",
+                                      __func__, uri);
+        return HG_ADDR_NULL;
+    }
+    lock_guard<mutex> lock(peer_mutex);
+    auto [it, inserted] = peer_addrs.emplace(host_id, addr);
+    if(!inserted)
+        margo_addr_free(mid, addr);
+    return it->second;
+}
+
+/**
+ * @brief Sends a single RPC to another daemon and returns the error code in
+ * its response.
+ * @return 0 on success or an errno value
+ */
+template <typename InputType>
+int
+forward_to_peer(uint64_t host_id, const char* rpc_name, InputType* in) {
+    auto mid = RPC_DATA->server_rpc_mid();
+    auto addr = peer_addr(host_id);
+    if(addr == HG_ADDR_NULL)
+        return EHOSTUNREACH;
+    hg_id_t rpc_id;
+    hg_bool_t registered = HG_FALSE;
+    margo_registered_name(mid, rpc_name, &rpc_id, &registered);
+    if(!registered)
+        return ENOTSUP;
+    hg_handle_t handle;
+    if(margo_create(mid, addr, rpc_id, &handle) != HG_SUCCESS)
+        return EBUSY;
+    int err = EBUSY;
+    if(margo_forward(handle, in) == HG_SUCCESS) {
+        rpc_err_out_t out{};
+        if(margo_get_output(handle, &out) == HG_SUCCESS) {
+            err = out.err;
+            margo_free_output(handle, &out);
+        }
+    }
+    margo_destroy(handle);
+    return err;
+}
+
+struct replicate_args {
+    string path;
+    uint64_t chunk_id;
+    uint64_t version;
+    vector<uint64_t> hosts;
+};
+
+/**
+ * @brief ULT reading an owned chunk and pushing it to all replica daemons.
+ * @internal
+ * The read is not ordered with writes to the chunk, so the copy may be torn.
+ * Such a write completes after the replication was started and invalidates
+ * it, so replication_done() fails and the replica daemons drop the copy.
+ * @endinternal
+ */
+void
+replicate_chunk_ult(void* _arg) {
+    unique_ptr<replicate_args> args(static_cast<replicate_args*>(_arg));
+    auto& rm = GKFS_DATA->replica_manager();
+    auto mid = RPC_DATA->server_rpc_mid();
+    vector<char> buf(gkfs::config::rpc::chunksize);
+    hg_size_t size = 0;
+    try {
+        size = GKFS_DATA->storage()->read_chunk(args->path, args->chunk_id,
+                                                buf.data(), buf.size(), 0);
+    } catch(const gkfs::data::ChunkStorageException& e) {
+        GKFS_DATA->spdlogger()->warn(
+                "{}() Failed to read chunk '{}' of '{}' for replication: {}",
+                __func__, args->chunk_id, args->path, e.what());
+        rm->replication_failed(args->path, args->chunk_id, args->version);
+        return;
+    }
+    auto buf_ptr = static_cast<void*>(buf.data());
+    hg_bulk_t bulk_handle = nullptr;
+    if(size == 0 || margo_bulk_create(mid, 1, &buf_ptr, &size,
+                                      HG_BULK_READ_ONLY,
+                                      &bulk_handle) != HG_SUCCESS) {
+        rm->replication_failed(args->path, args->chunk_id, args->version);
+        return;
+    }
+    rpc_replicate_chunk_in_t in{};
+    in.path = args->path.c_str();
+    in.chunk_id = args->chunk_id;
+    in.version = args->version;
+    in.size = size;
+    in.bulk_handle = bulk_handle;
+    auto failed = false;
+    for(auto host : args->hosts) {
+        auto err = forward_to_peer(host, gkfs::rpc::tag::replicate_chunk, &in);
+        if(err != 0) {
+            GKFS_DATA->spdlogger()->warn(
+                    "{}() Replicating chunk '{}' of '{}' to daemon '{}' failed with err '{}'",
+                    __func__, args->chunk_id, args->path, host, err);
+            failed = true;
+        }
+    }
+    margo_bulk_free(bulk_handle);
+    if(failed) {
+        // a partial push must not outlive the failure
+        auto set = rm->invalidate(args->path, args->chunk_id);
+        if(!set.hosts.empty())
+            gkfs::data::invalidate_replicas(args->path, {set});
+    } else if(rm->replication_done(args->path, args->chunk_id,
+                                   args->version)) {
+        GKFS_DATA->spdlogger()->debug(
+                "{}() Chunk '{}' of '{}' replicated to {} daemons", __func__,
+                args->chunk_id, args->path, args->hosts.size());
+    }
+}
+
+struct invalidate_args {
+    string path;
+    vector<gkfs::data::ReplicaSet> sets;
+};
+
+/**
+ * @brief ULT notifying the replica daemons of invalidated chunks. Daemons that
+ * fail are retried a few times before the copies are given up on. These are
+ * not announced to clients again but may still be read by clients that
+ * learned of them before.
+ */
+void
+invalidate_replicas_ult(void* _arg) {
+    unique_ptr<invalidate_args> args(static_cast<invalidate_args*>(_arg));
+    auto& rm = GKFS_DATA->replica_manager();
+    for(auto& set : args->sets) {
+        rpc_invalidate_replica_in_t in{};
+        in.path = args->path.c_str();
+        in.chunk_id = set.chunk_id;
+        in.version = set.version;
+        auto hosts = set.hosts;
+        for(unsigned int attempt = 0;
+            !hosts.empty() &&
+            attempt <= gkfs::config::replication::invalidate_retries;
+            attempt++) {
+            if(attempt > 0)
+                margo_thread_sleep(
+                        RPC_DATA->server_rpc_mid(),
+                        gkfs::config::replication::invalidate_retry_delay);
+            vector<uint64_t> failed{};
+            for(auto host : hosts) {
+                auto err = forward_to_peer(
+                        host, gkfs::rpc::tag::invalidate_replica, &in);
+                if(err != 0) {
+                    GKFS_DATA->spdlogger()->warn(
+                            "{}() Invalidating chunk '{}' of '{}' on daemon '{}' failed with err '{}'",
+                            __func__, set.chunk_id, args->path, host, err);
+                    failed.push_back(host);
+                }
+            }
+            hosts = move(failed);
+        }
+        if(!hosts.empty())
+            GKFS_DATA->spdlogger()->error(
+                    "{}() Giving up invalidating chunk '{}' of '{}' on {} daemons",
+                    __func__, set.chunk_id, args->path, hosts.size());
+        rm->invalidation_done(args->path, set.chunk_id, set.version);
+    }
+}
+
+} // namespace
+
+namespace gkfs::data {
+
+vector<uint64_t>
+replica_hosts(uint64_t owner, uint64_t host_size) {
+    vector<uint64_t> hosts{};
+    auto& rm = GKFS_DATA->replica_manager();
+    if(!rm || host_size < 2)
+        return hosts;
+    auto replicas = min<uint64_t>(rm->replicas(), host_size - 1);
+    for(unsigned int r = 1; r <= replicas; r++)
+        hosts.push_back(gkfs::rpc::locate_replica(owner, r, host_size));
+    return hosts;
+}
+
+void
+replicate_chunk_async(const string& path, uint64_t chunk_id, uint64_t version,
+                      const vector<uint64_t>& hosts) {
+    auto args = new replicate_args{path, chunk_id, version, hosts};
+    auto abt_err = ABT_thread_create(RPC_DATA->io_pool(), replicate_chunk_ult,
+                                     args, ABT_THREAD_ATTR_NULL, nullptr);
+    if(abt_err != ABT_SUCCESS) {
+        delete args;
+        GKFS_DATA->spdlogger()->error(
+                "{}() Failed to create ULT to replicate chunk '{}' of '{}'",
+                __func__, chunk_id, path);
+        GKFS_DATA->replica_manager()->replication_failed(path, chunk_id,
+                                                         version);
+    }
+}
+
+void
+invalidate_replicas(const string& path, const vector<ReplicaSet>& sets) {
+    if(sets.empty())
+        return;
+    auto args = new invalidate_args{path, sets};
+    auto abt_err = ABT_thread_create(RPC_DATA->io_pool(),
+                                     invalidate_replicas_ult, args,
+                                     ABT_THREAD_ATTR_NULL, nullptr);
+    if(abt_err != ABT_SUCCESS) {
+        GKFS_DATA->spdlogger()->warn(
+                "{}() Failed to create ULT, invalidating replicas of '{}' in place",
+                __func__, path);
+        invalidate_replicas_ult(args);
+    }
+}
+
+} // namespace gkfs::data
@@ -0,0 +1,209 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#include <daemon/scheduler/io_scheduler.hpp>
+#include <daemon/scheduler/range_merge.hpp>
+#include <daemon/backend/data/chunk_storage.hpp>
+#include <daemon/classes/fs_data.hpp>
+#include <daemon/classes/rpc_data.hpp>
+#include <daemon/classes/chunk_map_cache.hpp>
+#include <common/statistics/stats.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+extern "C" {
+#include <sys/uio.h>
+#include <time.h>
+}
+
+using namespace std;
+
+namespace gkfs::data {
+
+IoScheduler::IoScheduler(chrono::microseconds window,
+                         chrono::microseconds deadline)
+    : window_(window), deadline_(max(window, deadline)) {
+    if(ABT_mutex_create(&queue_mutex_) != ABT_SUCCESS)
+        throw runtime_error("Failed to create I/O scheduler mutex");
+    if(ABT_cond_create(&window_cond_) != ABT_SUCCESS) {
+        ABT_mutex_free(&queue_mutex_);
+        throw runtime_error("Failed to create I/O scheduler condition");
+    }
+}
+
+IoScheduler::~IoScheduler() {
+    ABT_cond_free(&window_cond_);
+    ABT_mutex_free(&queue_mutex_);
+}
+
+void
+IoScheduler::write(const string& path, gkfs::rpc::chnk_id_t chunk_id,
+                   const char* buf, size_t size, off64_t offset,
+                   ABT_eventual eventual) {
+    auto now = chrono::steady_clock::now();
+    ABT_mutex_lock(queue_mutex_);
+    auto [it, idle] = queues_.try_emplace(chunk_key{path, chunk_id});
+    auto& queue = it->second;
+    if(queue.pending.empty())
+        queue.first_arrival = now;
+    queue.last_arrival = now;
+    queue.pending.push_back(write_request{buf, size, offset, eventual});
+    if(!idle) {
+        // the chunk's dispatcher picks the request up with its next batch
+        ABT_mutex_unlock(queue_mutex_);
+        return;
+    }
+    auto* args = new dispatch_args{this, it->first};
+    auto abt_err = ABT_thread_create(RPC_DATA->io_pool(), dispatch_ult, args,
+                                     ABT_THREAD_ATTR_NULL, nullptr);
+    if(abt_err != ABT_SUCCESS) {
+        queues_.erase(it);
+        ABT_mutex_unlock(queue_mutex_);
+        delete args;
+        throw runtime_error(fmt::format(
+                "Failed to create I/O scheduler ULT with abt_err '{}'",
+                abt_err));
+    }
+    ABT_mutex_unlock(queue_mutex_);
+}
+
+void
+IoScheduler::wait_for_window(const chunk_key& key) {
+    ABT_mutex_lock(queue_mutex_);
+    while(true) {
+        const auto& queue = queues_.at(key);
+        auto due = min(queue.last_arrival + window_,
+                       queue.first_arrival + deadline_);
+        auto remaining = due - chrono::steady_clock::now();
+        if(remaining <= chrono::steady_clock::duration::zero())
+            break;
+        // ABT_cond_timedwait expects an absolute CLOCK_REALTIME time
+        struct timespec ts {};
+        clock_gettime(CLOCK_REALTIME, &ts);
+        auto ns =
+                chrono::duration_cast<chrono::nanoseconds>(remaining).count() +
+                ts.tv_nsec;
+        ts.tv_sec += ns / 1000000000L;
+        ts.tv_nsec = ns % 1000000000L;
+        ABT_cond_timedwait(window_cond_, queue_mutex_, &ts);
+    }
+    ABT_mutex_unlock(queue_mutex_);
+}
+
+void
+IoScheduler::dispatch_ult(void* _arg) {
+    auto* args = static_cast<dispatch_args*>(_arg);
+    auto* scheduler = args->scheduler;
+    const auto& key = args->key;
+    while(true) {
+        scheduler->wait_for_window(key);
+        ABT_mutex_lock(scheduler->queue_mutex_);
+        auto batch = std::move(scheduler->queues_.at(key).pending);
+        scheduler->queues_.at(key).pending.clear();
+        ABT_mutex_unlock(scheduler->queue_mutex_);
+
+        scheduler->write_batch(key, batch);
+
+        ABT_mutex_lock(scheduler->queue_mutex_);
+        auto it = scheduler->queues_.find(key);
+        if(it->second.pending.empty()) {
+            scheduler->queues_.erase(it);
+            ABT_mutex_unlock(scheduler->queue_mutex_);
+            break;
+        }
+        ABT_mutex_unlock(scheduler->queue_mutex_);
+    }
+    delete args;
+}
+
+void
+IoScheduler::write_batch(const chunk_key& key, vector<write_request>& batch) {
+    const auto& [path, chunk_id] = key;
+    vector<io_range> ranges{};
+    ranges.reserve(batch.size());
+    for(const auto& req : batch)
+        ranges.push_back(io_range{req.offset, req.size});
+    auto groups = merge_ranges(ranges);
+
+    for(auto& group : groups) {
+        ssize_t err = 0;
+        try {
+            if(group.members.size() == 1) {
+                const auto& req = batch[group.members.front()];
+                GKFS_DATA->storage()->write_chunk(path, chunk_id, req.buf,
+                                                  req.size, req.offset);
+            } else if(!group.overlapping) {
+                vector<struct iovec> iov{};
+                iov.reserve(group.members.size());
+                for(auto idx : group.members)
+                    iov.push_back(iovec{const_cast<char*>(batch[idx].buf),
+                                        batch[idx].size});
+                GKFS_DATA->storage()->write_chunk(
+                        path, chunk_id, std::move(iov), group.offset);
+            } else {
+                // apply overlapping requests in arrival order
+                vector<char> merged(group.size);
+                sort(group.members.begin(), group.members.end());
+                for(auto idx : group.members) {
+                    const auto& req = batch[idx];
+                    ::memcpy(merged.data() + (req.offset - group.offset),
+                             req.buf, req.size);
+                }
+                GKFS_DATA->storage()->write_chunk(path, chunk_id, merged.data(),
+                                                  merged.size(), group.offset);
+            }
+        } catch(const ChunkStorageException& e) {
+            GKFS_DATA->spdlogger()->error("IoScheduler::{}() {}", __func__,
+                                          e.what());
+            err = -(e.code().value());
+        } catch(const ::exception& e) {
+            GKFS_DATA->spdlogger()->error(
+                    "IoScheduler::{}() Unexpected error writing chunk {} of file {}",
+                    __func__, chunk_id, path);
+            err = -EIO;
+        }
+        // the chunk file may have grown beyond an existing mapping
+        invalidate_mapped_chunk(path, chunk_id);
+        for(auto idx : group.members) {
+            auto& req = batch[idx];
+            ssize_t wrote = err < 0 ? err : static_cast<ssize_t>(req.size);
+            ABT_eventual_set(req.eventual, &wrote, sizeof(wrote));
+        }
+    }
+
+    if(GKFS_DATA->enable_stats())
+        GKFS_DATA->stats()->add_write_merge(batch.size(), groups.size());
+    GKFS_DATA->spdlogger()->trace(
+            "IoScheduler::{}() path '{}' chunk '{}' requests '{}' disk ops '{}'",
+            __func__, path, chunk_id, batch.size(), groups.size());
+}
+
+} // namespace gkfs::data
@@ -0,0 +1,68 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#include <daemon/scheduler/range_merge.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+
+namespace gkfs::data {
+
+vector<merged_range>
+merge_ranges(const vector<io_range>& ranges) {
+    vector<size_t> order(ranges.size());
+    iota(order.begin(), order.end(), 0);
+    // stable sort keeps the arrival order for requests at the same offset
+    stable_sort(order.begin(), order.end(), [&ranges](size_t a, size_t b) {
+        return ranges[a].offset < ranges[b].offset;
+    });
+
+    vector<merged_range> groups{};
+    for(auto idx : order) {
+        const auto& r = ranges[idx];
+        if(!groups.empty()) {
+            auto& g = groups.back();
+            auto g_end = g.offset + static_cast<off64_t>(g.size);
+            if(r.offset <= g_end) {
+                auto r_end = r.offset + static_cast<off64_t>(r.size);
+                if(r.offset < g_end && r.size > 0)
+                    g.overlapping = true;
+                g.size = static_cast<size_t>(max(g_end, r_end) - g.offset);
+                g.members.push_back(idx);
+                continue;
+            }
+        }
+        groups.push_back(merged_range{r.offset, r.size, {idx}, false});
+    }
+    return groups;
+}
+
+} // namespace gkfs::data
@@ -31,6 +31,14 @@
 
 #include <common/rpc/rpc_util.hpp>
 
+#include <fstream>
+#include <sstream>
+
+extern "C" {
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+}
+
 using namespace std;
 
 namespace gkfs::utils {
@@ -85,4 +93,66 @@ destroy_hosts_file() {
     std::remove(GKFS_DATA->hosts_file().c_str());
 }
 
+vector<unsigned int>
+parse_cpu_list(const string& cpu_list) {
+    vector<unsigned int> cpus{};
+    stringstream ss(cpu_list);
+    string range;
+    while(getline(ss, range, ',')) {
+        if(range.empty())
+            continue;
+        size_t pos = 0;
+        auto first = stoul(range, &pos);
+        auto last = first;
+        if(pos < range.size()) {
+            if(range[pos] != '-')
+                throw invalid_argument(
+                        fmt::format("Invalid CPU range '{}'", range));
+            size_t end_pos = 0;
+            last = stoul(range.substr(pos + 1), &end_pos);
+            if(end_pos != range.size() - pos - 1 || last < first)
+                throw invalid_argument(
+                        fmt::format("Invalid CPU range '{}'", range));
+        }
+        for(auto cpu = first; cpu <= last; cpu++)
+            cpus.push_back(static_cast<unsigned int>(cpu));
+    }
+    return cpus;
+}
+
+vector<unsigned int>
+numa_node_cpus(int numa_node) {
+    ifstream cpulist(fmt::format("/sys/devices/system/node/node{}/cpulist",
+                                 numa_node));
+    string line;
+    if(!cpulist || !getline(cpulist, line))
+        return {};
+    return parse_cpu_list(line);
+}
+
+/**
+ * @internal
+ * The block device of a partition has no NUMA node of its own. Therefore, the
+ * device links of the partition's parent are followed as well. For NVMe
+ * namespaces, the PCI device is one level further down.
+ * @endinternal
+ */
+int
+numa_node_of_path(const string& path) {
+    struct stat st {};
+    if(stat(path.c_str(), &st) != 0)
+        return -1;
+    auto dev = fmt::format("/sys/dev/block/{}:{}", major(st.st_dev),
+                           minor(st.st_dev));
+    for(const auto& candidate :
+        {"/device/numa_node", "/device/device/numa_node",
+         "/../device/numa_node", "/../device/device/numa_node"}) {
+        ifstream numa_file(dev + candidate);
+        int numa_node = -1;
+        if(numa_file >> numa_node && numa_node >= 0)
+            return numa_node;
+    }
+    return -1;
+}
+
 } // namespace gkfs::utils
@@ -36,10 +36,26 @@ struct cli_options {
 
 int main(int argc, char** argv)
 {
-    string registry_file  = gkfs::env::get_var(gkfs::env::REGISTRY_FILE,
-                                        gkfs::config::registryfile_path);
-    
-    auto rpc_protocol = string(gkfs::rpc::protocol::ofi_sockets);
+    cli_options opts{};
+    opts.register_path = gkfs::env::get_var(gkfs::env::REGISTRY_FILE,
+                                            gkfs::config::registryfile_path);
+    opts.rpc_protocol = gkfs::rpc::protocol::ofi_sockets;
+
+    CLI::App desc{"Allowed options"};
+    desc.add_option("--registry-file,-r", opts.register_path,
+                    "Path to the file the registry address is written to "
+                    "(default: $GKFS_REGISTRY_FILE or ./gkfs_registry.txt).");
+    desc.add_option("--rpc-protocol,-P", opts.rpc_protocol,
+                    "Mercury protocol of the registry. Clients use the same "
+                    "protocol for the daemons (default: ofi+sockets).");
+    try {
+        desc.parse(argc, argv);
+    } catch(const CLI::ParseError& e) {
+        return desc.exit(e);
+    }
+
+    string registry_file = opts.register_path;
+    auto rpc_protocol = opts.rpc_protocol;
 
 
     hg_return_t            hret;
@@ -0,0 +1,796 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+/**
+ * @brief gkfs_local: runs a complete GekkoFS deployment on a single machine.
+ * @internal
+ * The driver starts a registry and one or more file systems of N daemons each.
+ * Every daemon gets its own rootdir (via --rootdir-suffix) and all of them use
+ * shared memory or the loopback interface. Hosts files are written by the
+ * daemons, hosts config files by the driver. With several file systems, each
+ * one is registered with the registry as workflow `fs<i>` by a short-lived
+ * client and a merged view of all of them is requested, as in a federated
+ * deployment.
+ *
+ * The driver then runs a bundled IOR/mdtest-like workload: client processes
+ * are started with the interception library and run the same executable in
+ * worker mode. Phases are synchronized with pipes. Each worker records the
+ * latency of every operation in a histogram and writes it to the work
+ * directory, from which the driver reports throughput and latency
+ * percentiles per phase.
+ * @endinternal
+ */
+
+#include <config.hpp>
+#include <common/common_defs.hpp>
+#include <common/statistics/histogram.hpp>
+
+#include <CLI/CLI.hpp>
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+}
+
+using namespace std;
+namespace fs = std::filesystem;
+using gkfs::utils::LatencyHistogram;
+
+namespace {
+
+constexpr auto all_phases = "write,read,create,stat,remove";
+
+struct cli_options {
+    unsigned int daemons{4};
+    unsigned int filesystems{1};
+    unsigned int clients{4};
+    string protocol{gkfs::rpc::protocol::na_sm};
+    string listen{"lo"};
+    string workdir{"/dev/shm/gkfs_local"};
+    string daemon_bin{};
+    string registry_bin{};
+    string preload_lib{};
+    string daemon_args{};
+    string workload{all_phases};
+    uint64_t block_size{64 * 1024 * 1024};
+    uint64_t transfer_size{1024 * 1024};
+    unsigned int files{1000};
+    string output{};
+    unsigned int timeout{60};
+    // worker mode, set by the driver only
+    int worker_rank{-1};
+    string worker_fds{};
+};
+
+volatile sig_atomic_t interrupted = 0;
+
+void
+on_signal(int) {
+    interrupted = 1;
+}
+
+vector<string>
+split(const string& s, char sep) {
+    vector<string> out{};
+    stringstream ss(s);
+    string item;
+    while(getline(ss, item, sep))
+        if(!item.empty())
+            out.push_back(item);
+    return out;
+}
+
+uint64_t
+now_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+                   chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+/*
+ * Worker
+ */
+
+/**
+ * @brief Result of one phase of one worker. Written to
+ * `<workdir>/results/<phase>.<rank>` as a line `start end ops bytes errors`
+ * followed by `bucket count` lines of the latency histogram.
+ */
+struct phase_result {
+    uint64_t start{0};
+    uint64_t end{0};
+    uint64_t ops{0};
+    uint64_t bytes{0};
+    uint64_t errors{0};
+    LatencyHistogram::counts latency{};
+};
+
+class worker {
+private:
+    const cli_options& opts_;
+    string mount_;
+    string file_;
+    string dir_;
+    phase_result result_{};
+
+    template <typename Op>
+    void
+    timed(Op&& op) {
+        const auto start = now_ns();
+        const auto ok = op();
+        result_.latency[LatencyHistogram::bucket_of(now_ns() - start)]++;
+        result_.ops++;
+        if(!ok)
+            result_.errors++;
+    }
+
+    void
+    write_phase() {
+        auto fd = ::open(file_.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+        if(fd < 0) {
+            result_.errors++;
+            return;
+        }
+        vector<char> buf(opts_.transfer_size, static_cast<char>('a' + opts_.worker_rank % 26));
+        for(uint64_t off = 0; off < opts_.block_size;
+            off += opts_.transfer_size) {
+            const auto size = min(opts_.transfer_size, opts_.block_size - off);
+            timed([&] {
+                return ::pwrite(fd, buf.data(), size, off) ==
+                       static_cast<ssize_t>(size);
+            });
+            result_.bytes += size;
+        }
+        ::close(fd);
+    }
+
+    void
+    read_phase() {
+        auto fd = ::open(file_.c_str(), O_RDONLY);
+        if(fd < 0) {
+            result_.errors++;
+            return;
+        }
+        vector<char> buf(opts_.transfer_size);
+        for(uint64_t off = 0; off < opts_.block_size;
+            off += opts_.transfer_size) {
+            const auto size = min(opts_.transfer_size, opts_.block_size - off);
+            timed([&] {
+                return ::pread(fd, buf.data(), size, off) ==
+                       static_cast<ssize_t>(size);
+            });
+            result_.bytes += size;
+        }
+        ::close(fd);
+    }
+
+    string
+    md_file(unsigned int i) const {
+        return fmt::format("{}/f.{}", dir_, i);
+    }
+
+    void
+    create_phase() {
+        for(unsigned int i = 0; i < opts_.files; i++) {
+            timed([&] {
+                auto fd = ::open(md_file(i).c_str(), O_CREAT | O_WRONLY, 0644);
+                return fd >= 0 && ::close(fd) == 0;
+            });
+        }
+    }
+
+    void
+    stat_phase() {
+        struct stat st {};
+        for(unsigned int i = 0; i < opts_.files; i++)
+            timed([&] { return ::stat(md_file(i).c_str(), &st) == 0; });
+    }
+
+    void
+    remove_phase() {
+        for(unsigned int i = 0; i < opts_.files; i++)
+            timed([&] { return ::unlink(md_file(i).c_str()) == 0; });
+    }
+
+    void
+    save(const string& phase) const {
+        ofstream of(fmt::format("{}/results/{}.{}", opts_.workdir, phase,
+                                opts_.worker_rank));
+        of << fmt::format("{} {} {} {} {}\n", result_.start, result_.end,
+                          result_.ops, result_.bytes, result_.errors);
+        for(unsigned int b = 0; b < LatencyHistogram::num_buckets; b++)
+            if(result_.latency[b])
+                of << b << ' ' << result_.latency[b] << '\n';
+    }
+
+public:
+    explicit worker(const cli_options& opts) : opts_(opts) {
+        mount_ = opts.workdir + "/mnt";
+        file_ = fmt::format("{}/bench/file.{}", mount_, opts.worker_rank);
+        dir_ = fmt::format("{}/bench/rank.{}", mount_, opts.worker_rank);
+    }
+
+    int
+    run() {
+        // fds: <ready write end>,<go read end of phase 0>,...
+        auto fds = split(opts_.worker_fds, ',');
+        auto phases = split(opts_.workload, ',');
+        if(fds.size() != phases.size() + 1)
+            return EXIT_FAILURE;
+        const auto ready = stoi(fds[0]);
+
+        ::mkdir((mount_ + "/bench").c_str(), 0755);
+        ::mkdir(dir_.c_str(), 0755);
+        for(size_t i = 0; i < phases.size(); i++) {
+            const auto go = stoi(fds[i + 1]);
+            char c = 'r';
+            if(::write(ready, &c, 1) != 1)
+                return EXIT_FAILURE;
+            // the driver closes the pipe once all workers are ready
+            while(::read(go, &c, 1) > 0) {
+            }
+            ::close(go);
+
+            result_ = phase_result{};
+            result_.start = now_ns();
+            if(phases[i] == "write")
+                write_phase();
+            else if(phases[i] == "read")
+                read_phase();
+            else if(phases[i] == "create")
+                create_phase();
+            else if(phases[i] == "stat")
+                stat_phase();
+            else if(phases[i] == "remove")
+                remove_phase();
+            result_.end = now_ns();
+            save(phases[i]);
+        }
+        ::unlink(file_.c_str());
+        ::rmdir(dir_.c_str());
+        ::close(ready);
+        return EXIT_SUCCESS;
+    }
+};
+
+/*
+ * Driver
+ */
+
+struct process {
+    string name;
+    pid_t pid;
+};
+
+/**
+ * @brief Starts a program with additional environment variables. Its output
+ * goes to `log`.
+ * @param in_child Called in the child before exec, e.g., to close fds
+ */
+pid_t
+spawn(const vector<string>& args, const vector<pair<string, string>>& env,
+      const string& log, const function<void()>& in_child = {}) {
+    auto pid = fork();
+    if(pid < 0)
+        throw runtime_error(
+                fmt::format("fork() failed: {}", strerror(errno)));
+    if(pid > 0)
+        return pid;
+    for(const auto& [name, value] : env)
+        setenv(name.c_str(), value.c_str(), 1);
+    auto fd = ::open(log.c_str(), O_CREAT | O_WRONLY | O_APPEND, 0644);
+    if(fd >= 0) {
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        ::close(fd);
+    }
+    if(in_child)
+        in_child();
+    vector<char*> argv{};
+    for(const auto& a : args)
+        argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+    execv(argv[0], argv.data());
+    fmt::print(stderr, "Failed to execute '{}': {}\n", args[0],
+               strerror(errno));
+    _exit(127);
+}
+
+size_t
+count_lines(const string& path) {
+    ifstream f(path);
+    size_t lines = 0;
+    string line;
+    while(getline(f, line))
+        if(!line.empty())
+            lines++;
+    return lines;
+}
+
+/**
+ * @brief Returns the first existing path of `candidates`, relative to the
+ * directory of this executable.
+ */
+string
+find_binary(const vector<string>& candidates) {
+    const auto exe_dir = fs::read_symlink("/proc/self/exe").parent_path();
+    for(const auto& c : candidates) {
+        auto path = exe_dir / c;
+        if(fs::exists(path))
+            return fs::canonical(path).string();
+    }
+    return (exe_dir / candidates.front()).lexically_normal().string();
+}
+
+class driver {
+private:
+    cli_options& opts_;
+    vector<process> services_{}; // registry and daemons
+    vector<pair<string, string>> client_env_{};
+
+    string
+    path(const string& name) const {
+        return opts_.workdir + "/" + name;
+    }
+
+    /**
+     * @brief Waits until `ready` returns true or a service died.
+     */
+    void
+    wait_for(const string& what, const function<bool()>& ready) {
+        const auto deadline =
+                chrono::steady_clock::now() + chrono::seconds(opts_.timeout);
+        while(!ready()) {
+            for(const auto& p : services_) {
+                if(waitpid(p.pid, nullptr, WNOHANG) == p.pid)
+                    throw runtime_error(fmt::format(
+                            "{} exited while waiting for {}", p.name, what));
+            }
+            if(interrupted)
+                throw runtime_error("Interrupted");
+            if(chrono::steady_clock::now() > deadline)
+                throw runtime_error(fmt::format("Timeout waiting for {}", what));
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+    }
+
+    void
+    start_registry() {
+        const auto registry_file = path("registry.txt");
+        services_.push_back(
+                {"registry",
+                 spawn({opts_.registry_bin, "-P", opts_.protocol, "-r",
+                        registry_file},
+                       {}, path("registry.log"))});
+        wait_for("the registry", [&] { return count_lines(registry_file); });
+    }
+
+    void
+    start_filesystem(unsigned int id) {
+        const auto dir = path(fmt::format("fs{}", id));
+        fs::create_directories(dir);
+        const auto hosts_file = dir + "/hosts.txt";
+        for(unsigned int d = 0; d < opts_.daemons; d++) {
+            vector<string> args{opts_.daemon_bin,
+                                "-r",
+                                dir + "/root",
+                                "--rootdir-suffix",
+                                fmt::format("d{}", d),
+                                "-m",
+                                path("mnt"),
+                                "-H",
+                                hosts_file,
+                                "-P",
+                                opts_.protocol};
+            if(opts_.protocol != gkfs::rpc::protocol::na_sm) {
+                args.emplace_back("-l");
+                args.push_back(opts_.listen);
+            }
+            for(auto& a : split(opts_.daemon_args, ' '))
+                args.push_back(a);
+            const auto log = fmt::format("{}/daemon{}.log", dir, d);
+            services_.push_back({fmt::format("daemon {} of fs{}", d, id),
+                                 spawn(args,
+                                       {{"GKFS_DAEMON_LOG_PATH", log},
+                                        {"GKFS_DAEMON_LOG_LEVEL", "info"}},
+                                       log)});
+        }
+        wait_for(fmt::format("{} daemons of fs{}", opts_.daemons, id), [&] {
+            return count_lines(hosts_file) >= opts_.daemons;
+        });
+        ofstream(dir + "/hosts_config.txt") << opts_.daemons << " 1\n";
+    }
+
+    /**
+     * @brief Runs a client that only initializes and shuts down, e.g., to
+     * register a workflow or to request a merged view from the registry.
+     */
+    void
+    run_client(const vector<pair<string, string>>& env) {
+        auto pid = spawn({fs::read_symlink("/proc/self/exe").string(),
+                          "--worker-rank", "0", "--workload", "none",
+                          "--worker-fds", "-1", "--workdir", opts_.workdir},
+                         env, path("client.log"));
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw runtime_error(fmt::format(
+                    "Client failed, see '{}'", path("client.log")));
+    }
+
+    void
+    setup_clients() {
+        client_env_ = {{"LD_PRELOAD", opts_.preload_lib},
+                       {"LIBGKFS_REGISTRY_FILE", path("registry.txt")},
+                       {"LIBGKFS_LOG_OUTPUT", path("client.log")}};
+        if(opts_.filesystems == 1) {
+            client_env_.emplace_back("LIBGKFS_HOSTS_FILE",
+                                     path("fs0/hosts.txt"));
+            client_env_.emplace_back("LIBGKFS_HOSTS_CONFIG_FILE",
+                                     path("fs0/hosts_config.txt"));
+            client_env_.emplace_back("LIBGKFS_WORK_FLOW", "fs0");
+            return;
+        }
+        // clients register the workflow of their file system on shutdown
+        string flows{};
+        for(unsigned int i = 0; i < opts_.filesystems; i++) {
+            auto env = client_env_;
+            env.emplace_back("LIBGKFS_HOSTS_FILE",
+                             path(fmt::format("fs{}/hosts.txt", i)));
+            env.emplace_back("LIBGKFS_HOSTS_CONFIG_FILE",
+                             path(fmt::format("fs{}/hosts_config.txt", i)));
+            env.emplace_back("LIBGKFS_WORK_FLOW", fmt::format("fs{}", i));
+            run_client(env);
+            flows += fmt::format("{}fs{}", i ? ";" : "", i);
+        }
+        // the first client of the merged view has the registry write its
+        // hosts files, which are then used by all later clients
+        client_env_.emplace_back("LIBGKFS_HOSTS_FILE", path("hosts.txt"));
+        client_env_.emplace_back("LIBGKFS_HOSTS_CONFIG_FILE",
+                                 path("hosts_config.txt"));
+        client_env_.emplace_back("LIBGKFS_WORK_FLOW", "merged");
+        client_env_.emplace_back("LIBGKFS_MERGE", "on");
+        client_env_.emplace_back("LIBGKFS_MERGE_FLOWS", flows);
+        run_client(client_env_);
+    }
+
+    void
+    run_workload(const vector<string>& phases) {
+        fs::create_directories(path("results"));
+        int ready[2];
+        if(pipe(ready) != 0)
+            throw runtime_error("pipe() failed");
+        vector<array<int, 2>> go(phases.size());
+        for(auto& p : go)
+            if(pipe(p.data()) != 0)
+                throw runtime_error("pipe() failed");
+
+        string fds = to_string(ready[1]);
+        for(const auto& p : go)
+            fds += "," + to_string(p[0]);
+        vector<pid_t> workers{};
+        for(unsigned int r = 0; r < opts_.clients; r++) {
+            workers.push_back(spawn(
+                    {fs::read_symlink("/proc/self/exe").string(),
+                     "--worker-rank", to_string(r), "--worker-fds", fds,
+                     "--workdir", opts_.workdir, "--workload", opts_.workload,
+                     "--block-size", to_string(opts_.block_size),
+                     "--transfer-size", to_string(opts_.transfer_size),
+                     "--files", to_string(opts_.files)},
+                    client_env_, path(fmt::format("results/worker{}.log", r)),
+                    [&] {
+                        ::close(ready[0]);
+                        for(const auto& p : go)
+                            ::close(p[1]);
+                    }));
+        }
+        ::close(ready[1]);
+        for(const auto& p : go)
+            ::close(p[0]);
+
+        for(size_t i = 0; i < phases.size(); i++) {
+            for(unsigned int n = 0; n < opts_.clients;) {
+                char c;
+                auto ret = ::read(ready[0], &c, 1);
+                if(ret == 1) {
+                    n++;
+                } else if(ret == 0 || errno != EINTR || interrupted) {
+                    for(auto pid : workers)
+                        kill(pid, SIGKILL);
+                    throw runtime_error(fmt::format(
+                            "A worker failed before phase '{}', see '{}'",
+                            phases[i], path("results")));
+                }
+            }
+            fmt::print(stderr, "Running phase '{}' ...\n", phases[i]);
+            ::close(go[i][1]);
+        }
+        ::close(ready[0]);
+        bool failed = false;
+        for(auto pid : workers) {
+            int status = 0;
+            waitpid(pid, &status, 0);
+            failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+        }
+        if(failed)
+            throw runtime_error(fmt::format("A worker failed, see '{}'",
+                                            path("results")));
+    }
+
+    phase_result
+    load_phase(const string& phase) const {
+        phase_result total{};
+        total.start = UINT64_MAX;
+        for(unsigned int r = 0; r < opts_.clients; r++) {
+            ifstream f(path(fmt::format("results/{}.{}", phase, r)));
+            phase_result w{};
+            if(!(f >> w.start >> w.end >> w.ops >> w.bytes >> w.errors))
+                throw runtime_error(fmt::format(
+                        "Missing result of worker {} for phase '{}'", r,
+                        phase));
+            unsigned int bucket;
+            uint64_t count;
+            while(f >> bucket >> count)
+                if(bucket < LatencyHistogram::num_buckets)
+                    total.latency[bucket] += count;
+            total.start = min(total.start, w.start);
+            total.end = max(total.end, w.end);
+            total.ops += w.ops;
+            total.bytes += w.bytes;
+            total.errors += w.errors;
+        }
+        return total;
+    }
+
+    void
+    report(const vector<string>& phases) const {
+        constexpr double mib = 1024.0 * 1024.0;
+        fmt::print("\ngkfs_local: {} file system(s) x {} daemons ({}), {} "
+                   "clients\n\n",
+                   opts_.filesystems, opts_.daemons, opts_.protocol,
+                   opts_.clients);
+        fmt::print("{:<8} {:>10} {:>10} {:>12} {:>10} {:>10} {:>10} {:>10} "
+                   "{:>10} {:>8}\n",
+                   "PHASE", "OPS", "SECONDS", "OPS/S", "MiB/S", "P50_US",
+                   "P90_US", "P99_US", "MAX_US", "ERRORS");
+        string json = "{\n  \"config\": {";
+        json += fmt::format(
+                "\"filesystems\": {}, \"daemons\": {}, \"clients\": {}, "
+                "\"protocol\": \"{}\", \"block_size\": {}, "
+                "\"transfer_size\": {}, \"files\": {}}},\n  \"phases\": [",
+                opts_.filesystems, opts_.daemons, opts_.clients,
+                opts_.protocol, opts_.block_size, opts_.transfer_size,
+                opts_.files);
+        for(size_t i = 0; i < phases.size(); i++) {
+            const auto r = load_phase(phases[i]);
+            const auto seconds =
+                    r.end > r.start ? (r.end - r.start) / 1e9 : 0.0;
+            const auto rate = seconds > 0 ? r.ops / seconds : 0.0;
+            const auto bw = seconds > 0 ? r.bytes / seconds : 0.0;
+            double us[4];
+            const double percentiles[] = {50.0, 90.0, 99.0, 100.0};
+            for(int p = 0; p < 4; p++)
+                us[p] = LatencyHistogram::value_at(r.latency, percentiles[p]) /
+                        1000.0;
+            fmt::print("{:<8} {:>10} {:>10.3f} {:>12.0f} {:>10.1f} {:>10.1f} "
+                       "{:>10.1f} {:>10.1f} {:>10.1f} {:>8}\n",
+                       phases[i], r.ops, seconds, rate, bw / mib, us[0], us[1],
+                       us[2], us[3], r.errors);
+            json += i ? ",\n" : "\n";
+            json += fmt::format(
+                    "    {{\"name\": \"{}\", \"ops\": {}, \"bytes\": {}, "
+                    "\"seconds\": {:.6f}, \"ops_per_second\": {:.1f}, "
+                    "\"bytes_per_second\": {:.0f}, \"latency_us\": "
+                    "{{\"p50\": {:.1f}, \"p90\": {:.1f}, \"p99\": {:.1f}, "
+                    "\"max\": {:.1f}}}, \"errors\": {}}}",
+                    phases[i], r.ops, r.bytes, seconds, rate, bw, us[0], us[1],
+                    us[2], us[3], r.errors);
+        }
+        json += "\n  ]\n}\n";
+        if(!opts_.output.empty()) {
+            ofstream of(opts_.output);
+            of << json;
+            if(!of)
+                throw runtime_error(fmt::format(
+                        "Failed to write report to '{}'", opts_.output));
+        }
+    }
+
+    void
+    wait_interrupted() const {
+        fmt::print("\nGekkoFS is running. Use it with:\n\n");
+        for(const auto& [name, value] : client_env_)
+            fmt::print("export {}={}\n", name, value);
+        fmt::print("\nMountdir: {}\nPress Ctrl-C to shut down.\n",
+                   path("mnt"));
+        while(!interrupted)
+            pause();
+    }
+
+public:
+    explicit driver(cli_options& opts) : opts_(opts) {}
+
+    ~driver() {
+        // daemons and registry shut down cleanly on SIGINT
+        for(auto it = services_.rbegin(); it != services_.rend(); ++it)
+            kill(it->pid, SIGINT);
+        const auto deadline =
+                chrono::steady_clock::now() + chrono::seconds(10);
+        for(const auto& p : services_) {
+            while(waitpid(p.pid, nullptr, WNOHANG) == 0) {
+                if(chrono::steady_clock::now() > deadline) {
+                    kill(p.pid, SIGKILL);
+                    waitpid(p.pid, nullptr, 0);
+                    break;
+                }
+                this_thread::sleep_for(chrono::milliseconds(50));
+            }
+        }
+    }
+
+    void
+    run() {
+        // only remove what a previous run of the driver created
+        fs::create_directories(opts_.workdir);
+        for(const auto& entry : fs::directory_iterator(opts_.workdir)) {
+            const auto name = entry.path().filename().string();
+            if(name.rfind("fs", 0) == 0 || name == "mnt" ||
+               name == "results" || name.rfind("hosts", 0) == 0 ||
+               name.rfind("registry", 0) == 0 || name == "client.log")
+                fs::remove_all(entry.path());
+        }
+        fs::create_directories(path("mnt"));
+
+        fmt::print(stderr, "Starting registry ...\n");
+        start_registry();
+        for(unsigned int i = 0; i < opts_.filesystems; i++) {
+            fmt::print(stderr, "Starting {} daemons of fs{} ...\n",
+                       opts_.daemons, i);
+            start_filesystem(i);
+        }
+        setup_clients();
+
+        const auto phases = split(opts_.workload, ',');
+        if(phases.empty() || phases.front() == "none") {
+            wait_interrupted();
+            return;
+        }
+        run_workload(phases);
+        report(phases);
+    }
+};
+
+} // namespace
+
+int
+main(int argc, const char* argv[]) {
+    cli_options opts{};
+    opts.daemon_bin =
+            find_binary({"../daemon/gkfs_daemon", "gkfs_daemon"});
+    opts.registry_bin =
+            find_binary({"../registry/gkfs_registry", "gkfs_registry"});
+    opts.preload_lib = find_binary({"../client/libgkfs_intercept.so",
+                                    "../lib64/libgkfs_intercept.so",
+                                    "../lib/libgkfs_intercept.so"});
+
+    CLI::App desc{"Runs GekkoFS with several daemons on this machine and an "
+                  "optional benchmark workload"};
+    // clang-format off
+    desc.add_option("--daemons,-n", opts.daemons,
+                    "Daemons per file system (default: 4).");
+    desc.add_option("--filesystems,-f", opts.filesystems,
+                    "File systems that are registered with the registry and merged (default: 1).");
+    desc.add_option("--clients,-c", opts.clients,
+                    "Client processes of the workload (default: 4).");
+    desc.add_option("--rpc-protocol,-P", opts.protocol,
+                    "Mercury protocol, e.g., na+sm or ofi+tcp (default: na+sm).");
+    desc.add_option("--listen,-l", opts.listen,
+                    "Network interface for ofi protocols (default: lo).");
+    desc.add_option("--workdir,-w", opts.workdir,
+                    "Directory of rootdirs, mountdir, hosts files, and logs (default: /dev/shm/gkfs_local).");
+    desc.add_option("--daemon", opts.daemon_bin, "Path to gkfs_daemon.");
+    desc.add_option("--registry", opts.registry_bin, "Path to gkfs_registry.");
+    desc.add_option("--preload", opts.preload_lib, "Path to libgkfs_intercept.so.");
+    desc.add_option("--daemon-args,-a", opts.daemon_args,
+                    "Additional daemon arguments, e.g., \"--dbbackend memory\".");
+    desc.add_option("--workload", opts.workload,
+                    fmt::format("Comma-separated phases out of {}, or none to keep GekkoFS running (default: all).", all_phases));
+    desc.add_option("--block-size,-b", opts.block_size,
+                    "Bytes written and read per client (default: 64 MiB).");
+    desc.add_option("--transfer-size,-t", opts.transfer_size,
+                    "Bytes per write and read call (default: 1 MiB).");
+    desc.add_option("--files", opts.files,
+                    "Files per client in the create, stat, and remove phases (default: 1000).");
+    desc.add_option("--output,-o", opts.output,
+                    "Writes the report as JSON to this file.");
+    desc.add_option("--timeout", opts.timeout,
+                    "Seconds to wait for the registry and daemons to start (default: 60).");
+    desc.add_option("--worker-rank", opts.worker_rank)->group("");
+    desc.add_option("--worker-fds", opts.worker_fds)->group("");
+    // clang-format on
+    try {
+        desc.parse(argc, argv);
+    } catch(const CLI::ParseError& e) {
+        return desc.exit(e);
+    }
+    if(opts.transfer_size == 0)
+        opts.transfer_size = 1;
+
+    if(opts.worker_rank >= 0) {
+        if(opts.workload == "none")
+            return EXIT_SUCCESS; // client that only registers or merges
+        return worker(opts).run();
+    }
+
+    const auto known = split(all_phases, ',');
+    for(const auto& phase : split(opts.workload, ',')) {
+        if(phase != "none" &&
+           find(known.begin(), known.end(), phase) == known.end()) {
+            cerr << fmt::format("Unknown workload phase '{}'", phase) << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if(opts.daemons == 0 || opts.filesystems == 0 || opts.clients == 0) {
+        cerr << "Daemons, file systems, and clients must be at least 1"
+             << endl;
+        return EXIT_FAILURE;
+    }
+
+    struct sigaction sa {};
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    try {
+        driver d(opts);
+        d.run();
+    } catch(const exception& e) {
+        cerr << "gkfs_local: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
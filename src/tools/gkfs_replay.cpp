@@ -0,0 +1,551 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+/**
+ * @brief gkfs_replay: replays syscalls captured by the client library.
+ * @internal
+ * Clients started with LIBGKFS_CAPTURE_DIR write the GekkoFS-bound syscalls
+ * of each process to a capture file (see common/capture_util.hpp). Every
+ * capture file is replayed by its own thread in the order of the capture,
+ * with paths relative to the given mountdir and file descriptors mapped to
+ * the ones opened during the replay. Threads of a captured process are
+ * therefore serialized. Calls are issued at their original time since the
+ * start of the capture, scaled by --speed, or as fast as possible.
+ *
+ * The replay reports, per operation, the latencies of the capture and of the
+ * replay, and the calls that diverged, i.e., that failed in one of them but
+ * not in the other.
+ * @endinternal
+ */
+
+#include <common/capture_util.hpp>
+#include <common/statistics/histogram.hpp>
+
+#include <CLI/CLI.hpp>
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+}
+
+using namespace std;
+using namespace gkfs::capture;
+using gkfs::utils::LatencyHistogram;
+
+namespace {
+
+struct cli_options {
+    vector<string> captures{};
+    string mountdir{};
+    double speed{1.0};
+    bool fast{false};
+    bool prepare{false};
+    bool dump{false};
+    string output{};
+};
+
+using replay_clock = chrono::steady_clock;
+
+struct op_stats {
+    uint64_t count{0};
+    uint64_t diverged{0};
+    uint64_t skipped{0};
+    uint64_t bytes{0};
+    LatencyHistogram::counts captured{};
+    LatencyHistogram::counts replayed{};
+
+    void
+    add(const op_stats& other) {
+        count += other.count;
+        diverged += other.diverged;
+        skipped += other.skipped;
+        bytes += other.bytes;
+        for(unsigned int i = 0; i < LatencyHistogram::num_buckets; i++) {
+            captured[i] += other.captured[i];
+            replayed[i] += other.replayed[i];
+        }
+    }
+};
+
+using stats = array<op_stats, static_cast<size_t>(op::count)>;
+
+vector<entry>
+load(const string& path, file_header& header) {
+    reader r(path);
+    header = r.header();
+    vector<entry> entries{};
+    entry e{};
+    while(r.next(e)) {
+        if(e.rec.op >= static_cast<uint16_t>(op::count)) {
+            throw runtime_error(fmt::format(
+                    "'{}' has a record with unknown operation {}", path,
+                    e.rec.op));
+        }
+        entries.push_back(e);
+    }
+    return entries;
+}
+
+string
+replay_path(const string& mountdir, const string& path) {
+    return path == "/" ? mountdir : mountdir + path;
+}
+
+/**
+ * Replays the records of one capture file.
+ */
+class replayer {
+private:
+    const cli_options& opts_;
+    const vector<entry>& entries_;
+    uint64_t offset_; ///< ns between the start of all captures and this one
+    unordered_map<int32_t, int> fds_{};
+    vector<char> buffer_{};
+    stats stats_{};
+
+    /// Returns the replayed fd of a captured fd, or -1 if it is unknown
+    int
+    fd(int32_t captured) const {
+        auto it = fds_.find(captured);
+        return it == fds_.end() ? -1 : it->second;
+    }
+
+    char*
+    buffer(uint64_t size) {
+        if(buffer_.size() < size) {
+            buffer_.resize(size, 'r');
+        }
+        return buffer_.data();
+    }
+
+    /**
+     * @brief Issues the syscall of a record
+     * @return result, -errno on failure
+     */
+    long
+    issue(const record& r, const string& path, const string& path2) {
+        const auto p = replay_path(opts_.mountdir, path);
+        long ret;
+        switch(static_cast<op>(r.op)) {
+            case op::open:
+                ret = ::open(p.c_str(), static_cast<int>(r.flags), r.mode);
+                break;
+            case op::close:
+                ret = ::close(fd(r.fd));
+                break;
+            case op::read:
+                ret = ::read(fd(r.fd), buffer(r.size), r.size);
+                break;
+            case op::write:
+                ret = ::write(fd(r.fd), buffer(r.size), r.size);
+                break;
+            case op::pread:
+                ret = ::pread(fd(r.fd), buffer(r.size), r.size, r.offset);
+                break;
+            case op::pwrite:
+                ret = ::pwrite(fd(r.fd), buffer(r.size), r.size, r.offset);
+                break;
+            case op::lseek:
+                ret = ::lseek(fd(r.fd), r.offset, static_cast<int>(r.flags));
+                break;
+            case op::stat: {
+                struct stat st {};
+                ret = ::fstatat(AT_FDCWD, p.c_str(), &st,
+                                static_cast<int>(r.flags) &
+                                        (AT_SYMLINK_NOFOLLOW | AT_EMPTY_PATH));
+                break;
+            }
+            case op::fstat: {
+                struct stat st {};
+                ret = ::fstat(fd(r.fd), &st);
+                break;
+            }
+            case op::unlink:
+                ret = ::unlink(p.c_str());
+                break;
+            case op::rmdir:
+                ret = ::rmdir(p.c_str());
+                break;
+            case op::mkdir:
+                ret = ::mkdir(p.c_str(), r.mode);
+                break;
+            case op::truncate:
+                ret = ::truncate(p.c_str(), r.offset);
+                break;
+            case op::ftruncate:
+                ret = ::ftruncate(fd(r.fd), r.offset);
+                break;
+            case op::fsync:
+                ret = ::fsync(fd(r.fd));
+                break;
+            case op::getdents:
+                ret = ::syscall(SYS_getdents64, fd(r.fd), buffer(r.size),
+                                r.size);
+                break;
+            case op::access:
+                ret = ::faccessat(AT_FDCWD, p.c_str(), static_cast<int>(r.mode),
+                                  static_cast<int>(r.flags));
+                break;
+            case op::rename:
+                ret = ::syscall(SYS_renameat2, AT_FDCWD, p.c_str(), AT_FDCWD,
+                                replay_path(opts_.mountdir, path2).c_str(),
+                                r.flags);
+                break;
+            case op::dup:
+                ret = ::dup(fd(r.fd));
+                break;
+            default:
+                return -ENOSYS;
+        }
+        return ret < 0 ? -errno : ret;
+    }
+
+public:
+    replayer(const cli_options& opts, const vector<entry>& entries,
+             uint64_t offset)
+        : opts_(opts), entries_(entries), offset_(offset) {}
+
+    void
+    run(replay_clock::time_point start) {
+        for(const auto& e : entries_) {
+            const auto& r = e.rec;
+            auto& s = stats_[r.op];
+            s.count++;
+            // calls on fds that were not opened successfully are not replayed
+            if(r.fd >= 0 && fds_.find(r.fd) == fds_.end()) {
+                s.skipped++;
+                continue;
+            }
+            if(!opts_.fast) {
+                this_thread::sleep_until(
+                        start + chrono::nanoseconds(static_cast<uint64_t>(
+                                        (offset_ + r.start) / opts_.speed)));
+            }
+            const auto call_start = replay_clock::now();
+            const auto ret = issue(r, e.path, e.path2);
+            const auto ns = chrono::duration_cast<chrono::nanoseconds>(
+                                    replay_clock::now() - call_start)
+                                    .count();
+            s.captured[LatencyHistogram::bucket_of(r.duration)]++;
+            s.replayed[LatencyHistogram::bucket_of(ns)]++;
+            if((ret < 0) != (r.result < 0)) {
+                s.diverged++;
+            }
+            if(ret > 0 && (r.op == static_cast<uint16_t>(op::read) ||
+                           r.op == static_cast<uint16_t>(op::write) ||
+                           r.op == static_cast<uint16_t>(op::pread) ||
+                           r.op == static_cast<uint16_t>(op::pwrite))) {
+                s.bytes += ret;
+            }
+
+            // keep the fd table in line with the capture
+            const auto o = static_cast<op>(r.op);
+            if(o == op::close) {
+                fds_.erase(r.fd);
+            } else if((o == op::open || o == op::dup) && r.result >= 0) {
+                if(ret >= 0) {
+                    fds_[static_cast<int32_t>(r.result)] =
+                            static_cast<int>(ret);
+                }
+            } else if((o == op::open || o == op::dup) && ret >= 0) {
+                ::close(static_cast<int>(ret));
+            }
+        }
+        for(const auto& fd : fds_) {
+            ::close(fd.second);
+        }
+    }
+
+    const stats&
+    result() const {
+        return stats_;
+    }
+};
+
+/**
+ * @brief Creates what the captured process expected to exist: parent
+ * directories of all paths unless they are created by a captured mkdir, and
+ * files that were opened without being created, as large as they were read.
+ */
+void
+prepare(const cli_options& opts, const vector<vector<entry>>& captures) {
+    set<string> created_dirs{};
+    map<string, uint64_t> files{}; // existing files and their size
+    set<string> paths{};
+    for(const auto& entries : captures) {
+        set<string> created_files{};
+        unordered_map<int32_t, pair<string, uint64_t>> fds{}; // path, pos
+        for(const auto& e : entries) {
+            const auto& r = e.rec;
+            const auto o = static_cast<op>(r.op);
+            if(!e.path.empty())
+                paths.insert(e.path);
+            if(o == op::mkdir && r.result == 0) {
+                created_dirs.insert(e.path);
+            } else if(o == op::open && r.result >= 0) {
+                if((r.flags & O_CREAT) || created_files.count(e.path)) {
+                    created_files.insert(e.path);
+                } else if(!(r.flags & O_DIRECTORY)) {
+                    files.emplace(e.path, 0);
+                }
+                fds[static_cast<int32_t>(r.result)] = {e.path, 0};
+            } else if(r.fd >= 0 && fds.count(r.fd)) {
+                auto& f = fds[r.fd];
+                uint64_t end = 0;
+                if(o == op::read && r.result > 0) {
+                    f.second += r.result;
+                    end = f.second;
+                } else if(o == op::pread && r.result > 0) {
+                    end = r.offset + r.result;
+                } else if(o == op::lseek && r.result >= 0) {
+                    f.second = r.result;
+                } else if(o == op::write && r.result > 0) {
+                    f.second += r.result;
+                }
+                auto it = files.find(f.first);
+                if(it != files.end())
+                    it->second = max(it->second, end);
+                if(o == op::close)
+                    fds.erase(r.fd);
+            }
+        }
+    }
+
+    auto make_parents = [&](const string& path) {
+        string dir{};
+        size_t pos = 0;
+        while((pos = path.find('/', pos + 1)) != string::npos) {
+            dir = path.substr(0, pos);
+            if(created_dirs.count(dir))
+                return;
+            ::mkdir(replay_path(opts.mountdir, dir).c_str(), 0755);
+        }
+    };
+    for(const auto& path : paths)
+        make_parents(path);
+    vector<char> zeros(1024 * 1024, 0);
+    for(const auto& [path, size] : files) {
+        auto fd = ::open(replay_path(opts.mountdir, path).c_str(),
+                         O_CREAT | O_WRONLY, 0644);
+        if(fd < 0) {
+            cerr << fmt::format("Failed to prepare '{}': {}", path,
+                                strerror(errno))
+                 << endl;
+            continue;
+        }
+        for(uint64_t off = 0; off < size; off += zeros.size())
+            if(::pwrite(fd, zeros.data(), min<uint64_t>(zeros.size(), size - off),
+                        off) < 0)
+                break;
+        ::close(fd);
+    }
+    cerr << fmt::format("Prepared {} files\n", files.size());
+}
+
+void
+dump(const string& path, const file_header& header,
+     const vector<entry>& entries) {
+    fmt::print("# {} host {} pid {} start {} ns\n", path, header.host,
+               header.pid, header.start_time);
+    for(const auto& e : entries) {
+        const auto& r = e.rec;
+        fmt::print("{:>14.6f} {:>10} {:<9} fd={} size={} offset={} "
+                   "flags={:#o} mode={:#o} result={} duration={}ns{}{}\n",
+                   r.start / 1e9, r.tid, op_name(static_cast<op>(r.op)), r.fd,
+                   r.size, r.offset, r.flags, r.mode, r.result, r.duration,
+                   e.path.empty() ? "" : " " + e.path,
+                   e.path2.empty() ? "" : " " + e.path2);
+    }
+}
+
+void
+report(const cli_options& opts, const stats& total, double seconds,
+       double captured_seconds) {
+    fmt::print("\ngkfs_replay: {} capture(s), {:.3f} s captured, {:.3f} s "
+               "replayed\n\n",
+               opts.captures.size(), captured_seconds, seconds);
+    fmt::print("{:<10} {:>10} {:>10} {:>10} {:>11} {:>11} {:>11} {:>11} "
+               "{:>12}\n",
+               "OP", "COUNT", "DIVERGED", "SKIPPED", "CAP_P50_US",
+               "REP_P50_US", "CAP_P99_US", "REP_P99_US", "MiB");
+    string json = fmt::format(
+            "{{\n  \"captures\": {}, \"captured_seconds\": {:.6f}, "
+            "\"replayed_seconds\": {:.6f}, \"speed\": {},\n  \"ops\": [",
+            opts.captures.size(), captured_seconds, seconds,
+            opts.fast ? 0.0 : opts.speed);
+    bool first = true;
+    for(size_t i = 0; i < total.size(); i++) {
+        const auto& s = total[i];
+        if(s.count == 0)
+            continue;
+        const auto us = [](const LatencyHistogram::counts& c, double pct) {
+            return LatencyHistogram::value_at(c, pct) / 1000.0;
+        };
+        const auto name = op_name(static_cast<op>(i));
+        fmt::print("{:<10} {:>10} {:>10} {:>10} {:>11.1f} {:>11.1f} "
+                   "{:>11.1f} {:>11.1f} {:>12.1f}\n",
+                   name, s.count, s.diverged, s.skipped, us(s.captured, 50),
+                   us(s.replayed, 50), us(s.captured, 99), us(s.replayed, 99),
+                   s.bytes / (1024.0 * 1024.0));
+        json += fmt::format(
+                "{}\n    {{\"op\": \"{}\", \"count\": {}, \"diverged\": {}, "
+                "\"skipped\": {}, \"bytes\": {}, \"captured_us\": "
+                "{{\"p50\": {:.1f}, \"p99\": {:.1f}}}, \"replayed_us\": "
+                "{{\"p50\": {:.1f}, \"p99\": {:.1f}}}}}",
+                first ? "" : ",", name, s.count, s.diverged, s.skipped,
+                s.bytes, us(s.captured, 50), us(s.captured, 99),
+                us(s.replayed, 50), us(s.replayed, 99));
+        first = false;
+    }
+    json += "\n  ]\n}\n";
+    if(!opts.output.empty()) {
+        ofstream of(opts.output);
+        of << json;
+        if(!of)
+            throw runtime_error(fmt::format("Failed to write report to '{}'",
+                                            opts.output));
+    }
+}
+
+} // namespace
+
+int
+main(int argc, const char* argv[]) {
+    cli_options opts{};
+    CLI::App desc{"Replays syscalls captured with LIBGKFS_CAPTURE_DIR"};
+    // clang-format off
+    desc.add_option("captures", opts.captures,
+                    "Capture files, one per process.")->required();
+    desc.add_option("--mountdir,-m", opts.mountdir,
+                    "Mountdir the captured paths are replayed in.");
+    desc.add_option("--speed,-s", opts.speed,
+                    "Factor applied to the captured timing, e.g., 2 replays twice as fast (default: 1).");
+    desc.add_flag("--fast,-f", opts.fast,
+                  "Replays as fast as possible instead of with the captured timing.");
+    desc.add_flag("--prepare,-p", opts.prepare,
+                  "Creates directories and files the captured processes expected to exist.");
+    desc.add_flag("--dump,-d", opts.dump,
+                  "Prints the captured records instead of replaying them.");
+    desc.add_option("--output,-o", opts.output,
+                    "Writes the report as JSON to this file.");
+    // clang-format on
+    try {
+        desc.parse(argc, argv);
+    } catch(const CLI::ParseError& e) {
+        return desc.exit(e);
+    }
+    if(!opts.dump && opts.mountdir.empty()) {
+        cerr << "--mountdir is required to replay" << endl;
+        return EXIT_FAILURE;
+    }
+    if(opts.speed <= 0) {
+        opts.fast = true;
+    }
+    while(opts.mountdir.size() > 1 && opts.mountdir.back() == '/') {
+        opts.mountdir.pop_back();
+    }
+
+    vector<vector<entry>> captures{};
+    vector<file_header> headers(opts.captures.size());
+    try {
+        for(size_t i = 0; i < opts.captures.size(); i++)
+            captures.push_back(load(opts.captures[i], headers[i]));
+    } catch(const exception& e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    if(opts.dump) {
+        for(size_t i = 0; i < captures.size(); i++)
+            dump(opts.captures[i], headers[i], captures[i]);
+        return EXIT_SUCCESS;
+    }
+    if(opts.prepare) {
+        prepare(opts, captures);
+    }
+
+    // processes started at different times, which is kept in the replay
+    uint64_t first_start = UINT64_MAX;
+    for(const auto& h : headers)
+        first_start = min(first_start, h.start_time);
+    double captured_seconds = 0;
+    vector<replayer> replayers{};
+    for(size_t i = 0; i < captures.size(); i++) {
+        const auto offset = headers[i].start_time - first_start;
+        if(!captures[i].empty()) {
+            const auto& last = captures[i].back().rec;
+            captured_seconds = max(
+                    captured_seconds,
+                    (offset + last.start + last.duration) / 1e9);
+        }
+        replayers.emplace_back(opts, captures[i], offset);
+    }
+
+    const auto start = replay_clock::now();
+    vector<thread> threads{};
+    for(auto& r : replayers)
+        threads.emplace_back([&r, start] { r.run(start); });
+    for(auto& t : threads)
+        t.join();
+    const auto seconds = chrono::duration<double>(replay_clock::now() - start)
+                                 .count();
+
+    stats total{};
+    uint64_t diverged = 0;
+    for(const auto& r : replayers) {
+        for(size_t i = 0; i < total.size(); i++) {
+            total[i].add(r.result()[i]);
+        }
+    }
+    for(const auto& s : total)
+        diverged += s.diverged;
+    try {
+        report(opts, total, seconds, captured_seconds);
+    } catch(const exception& e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return diverged ? 2 : EXIT_SUCCESS;
+}
@@ -0,0 +1,335 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+/**
+ * @brief gkfs-top: live monitor of all GekkoFS daemons of a deployment.
+ * @internal
+ * Polls the daemon status RPC (gkfs::rpc::tag::daemon_status) of every daemon
+ * in the hosts file and shows per-daemon queue depths, bytes in flight,
+ * metadata backend pressure, and operation rates. Rates are derived from the
+ * cumulative counters of two consecutive polls.
+ * @endinternal
+ */
+
+#include <config.hpp>
+#include <client/env.hpp>
+#include <common/env_util.hpp>
+#include <common/common_defs.hpp>
+#include <common/rpc/rpc_types.hpp>
+#include <common/rpc/rpc_util.hpp>
+
+#include <CLI/CLI.hpp>
+#include <fmt/format.h>
+
+extern "C" {
+#include <margo.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+using status_map = map<string, uint64_t>;
+using poll_clock = chrono::steady_clock;
+
+struct cli_options {
+    string hosts_file;
+    double interval{1.0};
+    unsigned int iterations{0};
+    unsigned int timeout{1000};
+};
+
+struct daemon_state {
+    string host;
+    string uri;
+    hg_addr_t addr{HG_ADDR_NULL};
+    optional<status_map> current{};
+    optional<status_map> previous{};
+    poll_clock::time_point current_time{};
+    poll_clock::time_point previous_time{};
+};
+
+/**
+ * @brief Reads the `<hostname> <uri>` lines of a GekkoFS hosts file.
+ * @throws std::runtime_error if the file cannot be read or has no entries
+ */
+vector<daemon_state>
+read_hosts_file(const string& path) {
+    ifstream lf(path);
+    if(!lf) {
+        throw runtime_error(
+                fmt::format("Failed to open hosts file '{}'", path));
+    }
+    const regex line_re("^(\\S+)\\s+(\\S+)$",
+                        regex::ECMAScript | regex::optimize);
+    vector<daemon_state> daemons{};
+    string line;
+    smatch match;
+    while(getline(lf, line)) {
+        if(!regex_match(line, match, line_re))
+            continue;
+        daemon_state d{};
+        d.host = match[1];
+        d.uri = match[2];
+        daemons.emplace_back(move(d));
+    }
+    if(daemons.empty()) {
+        throw runtime_error(
+                fmt::format("Hosts file '{}' has no daemons", path));
+    }
+    return daemons;
+}
+
+/**
+ * @brief Returns the Mercury protocol of a daemon URI, e.g., `ofi+sockets`.
+ */
+string
+protocol_of(const string& uri) {
+    auto pos = uri.find("://");
+    return pos == string::npos ? uri : uri.substr(0, pos);
+}
+
+/**
+ * @brief Sends one status RPC to a daemon.
+ * @return The daemon's counters or nothing if the daemon did not respond
+ */
+optional<status_map>
+query(margo_instance_id mid, hg_id_t rpc_id, daemon_state& d,
+      unsigned int timeout) {
+    if(d.addr == HG_ADDR_NULL &&
+       margo_addr_lookup(mid, d.uri.c_str(), &d.addr) != HG_SUCCESS) {
+        d.addr = HG_ADDR_NULL;
+        return {};
+    }
+    hg_handle_t handle;
+    if(margo_create(mid, d.addr, rpc_id, &handle) != HG_SUCCESS)
+        return {};
+    optional<status_map> result{};
+    if(margo_forward_timed(handle, nullptr, timeout) == HG_SUCCESS) {
+        rpc_daemon_status_out_t out{};
+        if(margo_get_output(handle, &out) == HG_SUCCESS) {
+            if(out.err == 0 && out.status != nullptr) {
+                result = status_map{};
+                for(auto& [name, value] : gkfs::rpc::decode_status(out.status))
+                    (*result)[name] = value;
+            }
+            margo_free_output(handle, &out);
+        }
+    }
+    margo_destroy(handle);
+    return result;
+}
+
+/**
+ * @brief Sums all counters whose name starts with `prefix`.
+ */
+uint64_t
+sum_of(const status_map& status, const string& prefix) {
+    uint64_t sum = 0;
+    for(auto it = status.lower_bound(prefix);
+        it != status.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+        ++it)
+        sum += it->second;
+    return sum;
+}
+
+uint64_t
+value_of(const status_map& status, const string& name) {
+    auto it = status.find(name);
+    return it == status.end() ? 0 : it->second;
+}
+
+/**
+ * @brief Rate per second of a cumulative counter between the last two polls.
+ */
+double
+rate_of(const daemon_state& d, const string& name) {
+    if(!d.current || !d.previous)
+        return 0.0;
+    const chrono::duration<double> elapsed = d.current_time - d.previous_time;
+    const auto now = value_of(*d.current, name);
+    const auto before = value_of(*d.previous, name);
+    if(elapsed.count() <= 0.0 || now < before)
+        return 0.0;
+    return static_cast<double>(now - before) / elapsed.count();
+}
+
+constexpr double mib = 1024.0 * 1024.0;
+
+void
+render(const vector<daemon_state>& daemons) {
+    // clear the screen and move the cursor home
+    string out = "\033[2J\033[H";
+    out += fmt::format("gkfs-top - {} daemons\n\n", daemons.size());
+    out += fmt::format(
+            "{:<24} {:>6} {:>6} {:>7} {:>9} {:>9} {:>9} {:>9} {:>9} {:>9} {:>9} {:>9}\n",
+            "HOST", "RPCS", "HQUEUE", "IOQUEUE", "BULK_MiB", "POOL_MiB",
+            "COMP_MiB", "MEMT_MiB", "W_OPS/s", "R_OPS/s", "W_MiB/s",
+            "R_MiB/s");
+
+    double totals[6]{};
+    map<string, uint64_t> hot_reads{};
+    map<string, uint64_t> hot_writes{};
+    for(const auto& d : daemons) {
+        if(!d.current) {
+            out += fmt::format("{:<24} (no response)\n", d.host);
+            continue;
+        }
+        const auto& s = *d.current;
+        // the status RPC counts itself as running
+        const auto rpcs = sum_of(s, "inflight/") -
+                          value_of(s, "inflight/daemon_status");
+        const double row[] = {
+                rate_of(d, "ops/iops_write"), rate_of(d, "ops/iops_read"),
+                rate_of(d, "bytes/write_size") / mib,
+                rate_of(d, "bytes/read_size") / mib};
+        out += fmt::format(
+                "{:<24} {:>6} {:>6} {:>7} {:>9.1f} {:>9.1f} {:>9.1f} {:>9.1f} {:>9.0f} {:>9.0f} {:>9.1f} {:>9.1f}\n",
+                d.host, rpcs, value_of(s, "queue/handler"),
+                sum_of(s, "queue/io/"), value_of(s, "bulk/inflight") / mib,
+                value_of(s, "bulk/pool_in_use") / mib,
+                value_of(s, "db/estimate-pending-compaction-bytes") / mib,
+                value_of(s, "db/cur-size-all-mem-tables") / mib, row[0],
+                row[1], row[2], row[3]);
+        totals[0] += rpcs;
+        totals[1] += value_of(s, "bulk/inflight") / mib;
+        for(int i = 0; i < 4; i++)
+            totals[2 + i] += row[i];
+        for(const auto& [name, count] : s) {
+            if(name.compare(0, 9, "hot_read/") == 0)
+                hot_reads[name.substr(9)] += count;
+            else if(name.compare(0, 10, "hot_write/") == 0)
+                hot_writes[name.substr(10)] += count;
+        }
+    }
+    out += fmt::format(
+            "\n{:<24} {:>6} {:>6} {:>7} {:>9.1f} {:>9} {:>9} {:>9} {:>9.0f} {:>9.0f} {:>9.1f} {:>9.1f}\n",
+            "TOTAL", static_cast<uint64_t>(totals[0]), "", "", totals[1], "",
+            "", "", totals[2], totals[3], totals[4], totals[5]);
+
+    // hot chunks are only reported by daemons with --enable-chunkstats
+    auto print_hot = [&out](const string& title,
+                            const map<string, uint64_t>& hot) {
+        if(hot.empty())
+            return;
+        vector<pair<string, uint64_t>> sorted(hot.begin(), hot.end());
+        sort(sorted.begin(), sorted.end(),
+             [](const auto& a, const auto& b) { return a.second > b.second; });
+        const size_t shown = gkfs::config::stats::hot_chunks_status;
+        if(sorted.size() > shown)
+            sorted.resize(shown);
+        out += fmt::format("\n{:>12}  {}\n", title, "CHUNK/PATH");
+        for(const auto& [chunk, count] : sorted)
+            out += fmt::format("{:>12}  {}\n", count, chunk);
+    };
+    print_hot("HOT READS", hot_reads);
+    print_hot("HOT WRITES", hot_writes);
+    cout << out << flush;
+}
+
+} // namespace
+
+int
+main(int argc, const char* argv[]) {
+    cli_options opts{};
+    opts.hosts_file = gkfs::env::get_var(gkfs::env::HOSTS_FILE,
+                                         gkfs::config::hostfile_path);
+
+    CLI::App desc{"Live monitor of GekkoFS daemons"};
+    // clang-format off
+    desc.add_option("--hosts-file,-H", opts.hosts_file,
+                    "Path to the hosts file written by the daemons (default: "
+                    "$LIBGKFS_HOSTS_FILE or ./gkfs_hosts.txt).");
+    desc.add_option("--interval,-i", opts.interval,
+                    "Seconds between two polls (default: 1).");
+    desc.add_option("--iterations,-n", opts.iterations,
+                    "Number of polls before exiting. 0 runs until interrupted (default: 0).");
+    desc.add_option("--timeout,-t", opts.timeout,
+                    "Milliseconds to wait for a daemon to respond (default: 1000).");
+    // clang-format on
+    try {
+        desc.parse(argc, argv);
+    } catch(const CLI::ParseError& e) {
+        return desc.exit(e);
+    }
+
+    vector<daemon_state> daemons{};
+    try {
+        daemons = read_hosts_file(opts.hosts_file);
+    } catch(const exception& e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    const auto protocol = protocol_of(daemons.front().uri);
+    auto mid = margo_init(protocol.c_str(), MARGO_CLIENT_MODE, 0, 0);
+    if(mid == MARGO_INSTANCE_NULL) {
+        cerr << fmt::format("Failed to initialize Margo with protocol '{}'",
+                            protocol)
+             << endl;
+        return EXIT_FAILURE;
+    }
+    auto rpc_id = MARGO_REGISTER(mid, gkfs::rpc::tag::daemon_status, void,
+                                 rpc_daemon_status_out_t, NULL);
+
+    const auto interval = chrono::duration<double>(opts.interval);
+    for(unsigned int i = 0; opts.iterations == 0 || i < opts.iterations; i++) {
+        const auto start = poll_clock::now();
+        for(auto& d : daemons) {
+            d.previous = move(d.current);
+            d.previous_time = d.current_time;
+            d.current = query(mid, rpc_id, d, opts.timeout);
+            d.current_time = poll_clock::now();
+        }
+        render(daemons);
+        if(opts.iterations != 0 && i + 1 == opts.iterations)
+            break;
+        this_thread::sleep_until(
+                start + chrono::duration_cast<poll_clock::duration>(interval));
+    }
+
+    for(auto& d : daemons) {
+        if(d.addr != HG_ADDR_NULL)
+            margo_addr_free(mid, d.addr);
+    }
+    margo_finalize(mid);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,695 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+/*
+ * gkfs_bench: MPI workload driver in the style of IOR and mdtest. Every phase
+ * is run by all ranks between two barriers. Per operation latencies are
+ * collected in a log-linear histogram on each rank, the histograms are summed
+ * on rank 0, and percentiles, operation rates, and the aggregate bandwidth
+ * (total bytes over the time from the first start to the last end) are
+ * reported per phase. Run it with the client library on a GekkoFS mountdir:
+ *
+ *   mpirun -np 16 -x LD_PRELOAD=libgkfs_intercept.so \
+ *       ./gkfs_bench -d /tmp/mountdir/bench -o result.json
+ *
+ * Read phases read what their write phase wrote and verify the content. The
+ * exit code is non-zero if any operation failed, so the driver can be used as
+ * a regression suite.
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <mpi.h>
+
+using namespace std;
+
+namespace {
+
+struct options {
+    string dir{"/tmp/mountdir/gkfs_bench"};
+    string phases{};
+    uint64_t block_size{16 * 1024 * 1024};
+    uint64_t transfer_size{1024 * 1024};
+    unsigned long files{1000};
+    unsigned long scans{3};
+    // gkfs::config::metadata::smallfilesize of the daemons
+    uint64_t small_size{4096};
+    string output{};
+    bool keep{false};
+};
+
+constexpr auto default_phases =
+        "write-nn,read-nn,write-n1,read-n1,write-strided,read-strided,append,"
+        "create,stat,remove,readdir,small-write,small-read";
+
+/*
+ * Log-linear latency histogram: values below 16 ns have their own bucket,
+ * above that every power of two is split into 16 buckets (< 6.25% error).
+ */
+constexpr unsigned sub_bucket_bits = 4;
+constexpr unsigned sub_buckets = 1u << sub_bucket_bits;
+constexpr unsigned max_bits = 40;
+constexpr unsigned num_buckets = (max_bits - sub_bucket_bits + 1) * sub_buckets;
+using histogram = array<uint64_t, num_buckets>;
+
+unsigned
+bucket_of(uint64_t ns) {
+    ns = min(ns, (uint64_t{1} << max_bits) - 1);
+    if(ns < sub_buckets)
+        return static_cast<unsigned>(ns);
+    const unsigned msb = 63 - __builtin_clzll(ns);
+    const unsigned shift = msb - sub_bucket_bits;
+    return (shift + 1) * sub_buckets +
+           static_cast<unsigned>((ns >> shift) - sub_buckets);
+}
+
+uint64_t
+bucket_max(unsigned bucket) {
+    if(bucket < sub_buckets)
+        return bucket;
+    const unsigned shift = bucket / sub_buckets - 1;
+    const uint64_t base = (bucket % sub_buckets) + sub_buckets;
+    return ((base + 1) << shift) - 1;
+}
+
+uint64_t
+percentile(const histogram& h, double pct) {
+    uint64_t total = 0;
+    for(auto c : h)
+        total += c;
+    if(total == 0)
+        return 0;
+    auto rank = static_cast<uint64_t>(pct / 100.0 * total + 0.5);
+    rank = max<uint64_t>(1, min(rank, total));
+    uint64_t seen = 0;
+    for(unsigned b = 0; b < num_buckets; b++) {
+        seen += h[b];
+        if(seen >= rank)
+            return bucket_max(b);
+    }
+    return bucket_max(num_buckets - 1);
+}
+
+/// Result of one phase on one rank
+struct result {
+    uint64_t ops{0};
+    uint64_t bytes{0};
+    uint64_t errors{0};
+    histogram latency{};
+};
+
+class bench {
+private:
+    const options& opts_;
+    int rank_;
+    int size_;
+    result res_{};
+    vector<char> buf_;
+    vector<char> expected_;
+
+    template <typename Op>
+    void
+    timed(Op&& op) {
+        const auto start = chrono::steady_clock::now();
+        const bool ok = op();
+        const auto ns = chrono::duration_cast<chrono::nanoseconds>(
+                                chrono::steady_clock::now() - start)
+                                .count();
+        res_.latency[bucket_of(static_cast<uint64_t>(ns))]++;
+        res_.ops++;
+        if(!ok)
+            res_.errors++;
+    }
+
+    void
+    error(const string& what) {
+        cerr << "rank " << rank_ << ": " << what << ": " << strerror(errno)
+             << endl;
+        res_.errors++;
+    }
+
+    string
+    path(const string& name) const {
+        return opts_.dir + "/" + name;
+    }
+
+    uint64_t
+    transfers() const {
+        return opts_.block_size / opts_.transfer_size;
+    }
+
+    /// Content of a transfer is derived from its offset in the file
+    static char
+    pattern(uint64_t offset) {
+        return static_cast<char>('a' + (offset / 4096) % 26);
+    }
+
+    void
+    fill(vector<char>& buf, uint64_t offset, uint64_t size) {
+        for(uint64_t pos = 0; pos < size;) {
+            const auto page_end = min(size, (offset + pos) / 4096 * 4096 +
+                                                    4096 - offset);
+            memset(buf.data() + pos, pattern(offset + pos), page_end - pos);
+            pos = page_end;
+        }
+    }
+
+    void
+    write_at(int fd, uint64_t offset) {
+        fill(buf_, offset, opts_.transfer_size);
+        timed([&] {
+            return pwrite(fd, buf_.data(), opts_.transfer_size, offset) ==
+                   static_cast<ssize_t>(opts_.transfer_size);
+        });
+        res_.bytes += opts_.transfer_size;
+    }
+
+    void
+    read_at(int fd, uint64_t offset) {
+        bool ok = false;
+        timed([&] {
+            ok = pread(fd, buf_.data(), opts_.transfer_size, offset) ==
+                 static_cast<ssize_t>(opts_.transfer_size);
+            return ok;
+        });
+        res_.bytes += opts_.transfer_size;
+        if(ok) {
+            fill(expected_, offset, opts_.transfer_size);
+            if(memcmp(buf_.data(), expected_.data(), opts_.transfer_size) !=
+               0) {
+                cerr << "rank " << rank_ << ": wrong data at offset "
+                     << offset << endl;
+                res_.errors++;
+            }
+        }
+    }
+
+    int
+    open_file(const string& p, int flags) {
+        auto fd = open(p.c_str(), flags, 0644);
+        if(fd < 0)
+            error("open " + p);
+        return fd;
+    }
+
+    /// File per rank, written and read sequentially
+    void
+    nn(bool write) {
+        auto fd = open_file(path("nn." + to_string(rank_)),
+                            write ? O_CREAT | O_WRONLY | O_TRUNC : O_RDONLY);
+        if(fd < 0)
+            return;
+        for(uint64_t i = 0; i < transfers(); i++) {
+            if(write)
+                write_at(fd, i * opts_.transfer_size);
+            else
+                read_at(fd, i * opts_.transfer_size);
+        }
+        close(fd);
+    }
+
+    /// Shared file. Segmented: each rank owns a contiguous block. Strided:
+    /// transfers of all ranks are interleaved.
+    void
+    n1(const string& name, bool write, bool strided) {
+        auto fd = open_file(path(name), write ? O_WRONLY : O_RDONLY);
+        if(fd < 0)
+            return;
+        for(uint64_t i = 0; i < transfers(); i++) {
+            const auto offset =
+                    strided ? (i * size_ + rank_) * opts_.transfer_size
+                            : rank_ * opts_.block_size +
+                                      i * opts_.transfer_size;
+            if(write)
+                write_at(fd, offset);
+            else
+                read_at(fd, offset);
+        }
+        close(fd);
+    }
+
+    void
+    append() {
+        auto fd = open_file(path("append"), O_WRONLY | O_APPEND);
+        if(fd < 0)
+            return;
+        memset(buf_.data(), 'a' + rank_ % 26, opts_.transfer_size);
+        for(uint64_t i = 0; i < transfers(); i++) {
+            timed([&] {
+                return write(fd, buf_.data(), opts_.transfer_size) ==
+                       static_cast<ssize_t>(opts_.transfer_size);
+            });
+            res_.bytes += opts_.transfer_size;
+        }
+        close(fd);
+    }
+
+    string
+    md_file(unsigned long i) const {
+        return path("md." + to_string(rank_) + "/f." + to_string(i));
+    }
+
+    string
+    readdir_file(unsigned long i) const {
+        return path("readdir/r" + to_string(rank_) + "." + to_string(i));
+    }
+
+    /// Lists the shared directory that holds `files` entries of every rank
+    void
+    readdir_scan() {
+        const auto expected = opts_.files * size_;
+        for(unsigned long s = 0; s < opts_.scans; s++) {
+            unsigned long entries = 0;
+            timed([&] {
+                auto dir = opendir(path("readdir").c_str());
+                if(!dir)
+                    return false;
+                while(auto e = readdir(dir)) {
+                    if(strcmp(e->d_name, ".") != 0 &&
+                       strcmp(e->d_name, "..") != 0)
+                        entries++;
+                }
+                closedir(dir);
+                return entries == expected;
+            });
+        }
+    }
+
+    /// Sizes around the inline data threshold of the daemons
+    uint64_t
+    small_size(unsigned long i) const {
+        const auto s = opts_.small_size;
+        const uint64_t sizes[] = {s / 2, s - 1, s, s + 1, 2 * s};
+        return max<uint64_t>(1, sizes[i % 5]);
+    }
+
+    string
+    small_file(unsigned long i) const {
+        return path("small." + to_string(rank_) + "/s." + to_string(i));
+    }
+
+    void
+    small(bool write) {
+        for(unsigned long i = 0; i < opts_.files; i++) {
+            const auto size = small_size(i);
+            bool ok = false;
+            if(write) {
+                fill(buf_, 0, size);
+                timed([&] {
+                    auto fd = open(small_file(i).c_str(),
+                                   O_CREAT | O_WRONLY | O_TRUNC, 0644);
+                    if(fd < 0)
+                        return false;
+                    ok = ::write(fd, buf_.data(), size) ==
+                         static_cast<ssize_t>(size);
+                    return close(fd) == 0 && ok;
+                });
+            } else {
+                // read one byte more than the file size to check the size
+                timed([&] {
+                    auto fd = open(small_file(i).c_str(), O_RDONLY);
+                    if(fd < 0)
+                        return false;
+                    ok = read(fd, buf_.data(), size + 1) ==
+                         static_cast<ssize_t>(size);
+                    return close(fd) == 0 && ok;
+                });
+                fill(expected_, 0, size);
+                if(ok && memcmp(buf_.data(), expected_.data(), size) != 0) {
+                    cerr << "rank " << rank_ << ": wrong data in "
+                         << small_file(i) << endl;
+                    res_.errors++;
+                }
+            }
+            res_.bytes += size;
+        }
+    }
+
+    void
+    make_dir(const string& p) {
+        if(mkdir(p.c_str(), 0755) != 0 && errno != EEXIST)
+            error("mkdir " + p);
+    }
+
+    /// Untimed preparation of a phase, followed by a barrier
+    void
+    setup(const string& phase) {
+        if(phase == "write-n1" || phase == "write-strided" ||
+           phase == "append") {
+            if(rank_ == 0) {
+                const auto name = phase == "write-n1"        ? "n1"
+                                  : phase == "write-strided" ? "strided"
+                                                             : "append";
+                auto fd = open_file(path(name), O_CREAT | O_WRONLY | O_TRUNC);
+                if(fd >= 0)
+                    close(fd);
+            }
+        } else if(phase == "create") {
+            make_dir(path("md." + to_string(rank_)));
+        } else if(phase == "readdir") {
+            if(rank_ == 0)
+                make_dir(path("readdir"));
+            MPI_Barrier(MPI_COMM_WORLD);
+            for(unsigned long i = 0; i < opts_.files; i++) {
+                auto fd = open_file(readdir_file(i), O_CREAT | O_WRONLY);
+                if(fd >= 0)
+                    close(fd);
+            }
+        } else if(phase == "small-write") {
+            make_dir(path("small." + to_string(rank_)));
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+
+    void
+    run(const string& phase) {
+        if(phase == "write-nn" || phase == "read-nn")
+            nn(phase == "write-nn");
+        else if(phase == "write-n1" || phase == "read-n1")
+            n1("n1", phase == "write-n1", false);
+        else if(phase == "write-strided" || phase == "read-strided")
+            n1("strided", phase == "write-strided", true);
+        else if(phase == "append")
+            append();
+        else if(phase == "create")
+            for(unsigned long i = 0; i < opts_.files; i++)
+                timed([&] {
+                    auto fd = open(md_file(i).c_str(), O_CREAT | O_WRONLY,
+                                   0644);
+                    return fd >= 0 && close(fd) == 0;
+                });
+        else if(phase == "stat") {
+            struct stat st {};
+            for(unsigned long i = 0; i < opts_.files; i++)
+                timed([&] { return stat(md_file(i).c_str(), &st) == 0; });
+        } else if(phase == "remove")
+            for(unsigned long i = 0; i < opts_.files; i++)
+                timed([&] { return unlink(md_file(i).c_str()) == 0; });
+        else if(phase == "readdir")
+            readdir_scan();
+        else if(phase == "small-write" || phase == "small-read")
+            small(phase == "small-write");
+    }
+
+    /// Checks that concurrent appends did not overwrite each other
+    void
+    check(const string& phase) {
+        if(phase != "append" || rank_ != 0)
+            return;
+        struct stat st {};
+        const auto expected =
+                static_cast<off_t>(transfers() * opts_.transfer_size * size_);
+        if(stat(path("append").c_str(), &st) != 0) {
+            error("stat " + path("append"));
+        } else if(st.st_size != expected) {
+            cerr << "append: file size " << st.st_size << " instead of "
+                 << expected << endl;
+            res_.errors++;
+        }
+    }
+
+public:
+    bench(const options& opts, int rank, int size)
+        : opts_(opts), rank_(rank), size_(size),
+          buf_(max(opts.transfer_size, 2 * opts.small_size + 1)),
+          expected_(buf_.size()) {}
+
+    /// Runs a phase on all ranks. Returns the summed result on rank 0 and the
+    /// wall time of the phase in seconds.
+    result
+    phase(const string& name, double& seconds) {
+        res_ = result{};
+        setup(name);
+        const double start = MPI_Wtime();
+        run(name);
+        const double end = MPI_Wtime();
+        MPI_Barrier(MPI_COMM_WORLD);
+        check(name);
+
+        result total{};
+        double first_start = 0, last_end = 0;
+        MPI_Reduce(&start, &first_start, 1, MPI_DOUBLE, MPI_MIN, 0,
+                   MPI_COMM_WORLD);
+        MPI_Reduce(&end, &last_end, 1, MPI_DOUBLE, MPI_MAX, 0,
+                   MPI_COMM_WORLD);
+        uint64_t local[3] = {res_.ops, res_.bytes, res_.errors};
+        uint64_t sum[3] = {0, 0, 0};
+        MPI_Reduce(local, sum, 3, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(res_.latency.data(), total.latency.data(), num_buckets,
+                   MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+        total.ops = sum[0];
+        total.bytes = sum[1];
+        total.errors = sum[2];
+        seconds = last_end - first_start;
+        return total;
+    }
+
+    /// Removes everything the phases created
+    void
+    cleanup() {
+        unlink(path("nn." + to_string(rank_)).c_str());
+        for(unsigned long i = 0; i < opts_.files; i++) {
+            unlink(md_file(i).c_str());
+            unlink(readdir_file(i).c_str());
+            unlink(small_file(i).c_str());
+        }
+        rmdir(path("md." + to_string(rank_)).c_str());
+        rmdir(path("small." + to_string(rank_)).c_str());
+        MPI_Barrier(MPI_COMM_WORLD);
+        if(rank_ == 0) {
+            for(auto name : {"n1", "strided", "append"})
+                unlink(path(name).c_str());
+            rmdir(path("readdir").c_str());
+        }
+    }
+};
+
+vector<string>
+split(const string& s) {
+    vector<string> out;
+    stringstream ss(s);
+    string item;
+    while(getline(ss, item, ','))
+        if(!item.empty())
+            out.push_back(item);
+    return out;
+}
+
+void
+usage(const char* name) {
+    cout << "Usage: " << name << " [options]\n"
+         << "  -d, --dir <path>          directory on GekkoFS (default: "
+            "/tmp/mountdir/gkfs_bench)\n"
+         << "  -p, --phases <list>       comma-separated phases (default: "
+            "all)\n"
+         << "                            "
+         << default_phases << "\n"
+         << "  -b, --block-size <bytes>  bytes per rank in data phases "
+            "(default: 16 MiB)\n"
+         << "  -t, --transfer-size <bytes>  bytes per read and write call "
+            "(default: 1 MiB)\n"
+         << "  -n, --files <n>           files per rank in metadata, "
+            "readdir, and small-file phases (default: 1000)\n"
+         << "  -r, --scans <n>           directory listings per rank in the "
+            "readdir phase (default: 3)\n"
+         << "  -s, --small-size <bytes>  inline data threshold "
+            "(smallfilesize) of the daemons (default: 4096)\n"
+         << "  -o, --output <file>       write results as JSON\n"
+         << "  -k, --keep                keep the files of the benchmark\n"
+         << "  -h, --help                show this help\n";
+}
+
+bool
+parse(int argc, char* argv[], options& opts) {
+    const struct option long_opts[] = {
+            {"dir", required_argument, nullptr, 'd'},
+            {"phases", required_argument, nullptr, 'p'},
+            {"block-size", required_argument, nullptr, 'b'},
+            {"transfer-size", required_argument, nullptr, 't'},
+            {"files", required_argument, nullptr, 'n'},
+            {"scans", required_argument, nullptr, 'r'},
+            {"small-size", required_argument, nullptr, 's'},
+            {"output", required_argument, nullptr, 'o'},
+            {"keep", no_argument, nullptr, 'k'},
+            {"help", no_argument, nullptr, 'h'},
+            {nullptr, 0, nullptr, 0}};
+    opts.phases = default_phases;
+    int c;
+    while((c = getopt_long(argc, argv, "d:p:b:t:n:r:s:o:kh", long_opts,
+                           nullptr)) != -1) {
+        switch(c) {
+            case 'd':
+                opts.dir = optarg;
+                break;
+            case 'p':
+                opts.phases = optarg;
+                break;
+            case 'b':
+                opts.block_size = strtoull(optarg, nullptr, 10);
+                break;
+            case 't':
+                opts.transfer_size = strtoull(optarg, nullptr, 10);
+                break;
+            case 'n':
+                opts.files = strtoul(optarg, nullptr, 10);
+                break;
+            case 'r':
+                opts.scans = strtoul(optarg, nullptr, 10);
+                break;
+            case 's':
+                opts.small_size = strtoull(optarg, nullptr, 10);
+                break;
+            case 'o':
+                opts.output = optarg;
+                break;
+            case 'k':
+                opts.keep = true;
+                break;
+            default:
+                return false;
+        }
+    }
+    if(opts.transfer_size == 0 || opts.small_size == 0 ||
+       opts.block_size % opts.transfer_size != 0) {
+        cerr << "The block size must be a multiple of the transfer size" << endl;
+        return false;
+    }
+    const auto known = split(default_phases);
+    for(const auto& p : split(opts.phases)) {
+        if(find(known.begin(), known.end(), p) == known.end()) {
+            cerr << "Unknown phase '" << p << "'" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+
+    MPI_Init(&argc, &argv);
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    options opts;
+    if(!parse(argc, argv, opts)) {
+        if(rank == 0)
+            usage(argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+
+    if(rank == 0 && mkdir(opts.dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        cerr << "mkdir " << opts.dir << ": " << strerror(errno) << endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    if(rank == 0) {
+        printf("gkfs_bench: %d ranks, block %llu, transfer %llu, files %lu, "
+               "small size %llu\n\n",
+               size, static_cast<unsigned long long>(opts.block_size),
+               static_cast<unsigned long long>(opts.transfer_size), opts.files,
+               static_cast<unsigned long long>(opts.small_size));
+        printf("%-14s %10s %9s %12s %10s %9s %9s %9s %9s %7s\n", "PHASE", "OPS",
+               "SECONDS", "OPS/S", "MiB/S", "P50_US", "P90_US", "P99_US",
+               "MAX_US", "ERRORS");
+    }
+
+    bench b(opts, rank, size);
+    uint64_t errors = 0;
+    stringstream json;
+    json << "{\n  \"ranks\": " << size
+         << ", \"block_size\": " << opts.block_size
+         << ", \"transfer_size\": " << opts.transfer_size
+         << ", \"files\": " << opts.files
+         << ", \"small_size\": " << opts.small_size << ",\n  \"phases\": [";
+    const auto phases = split(opts.phases);
+    for(size_t i = 0; i < phases.size(); i++) {
+        double seconds = 0;
+        const auto r = b.phase(phases[i], seconds);
+        if(rank != 0)
+            continue;
+        errors += r.errors;
+        const double rate = seconds > 0 ? r.ops / seconds : 0;
+        const double bw = seconds > 0 ? r.bytes / seconds : 0;
+        double us[4];
+        const double pcts[] = {50, 90, 99, 100};
+        for(int p = 0; p < 4; p++)
+            us[p] = percentile(r.latency, pcts[p]) / 1000.0;
+        printf("%-14s %10llu %9.3f %12.0f %10.1f %9.1f %9.1f %9.1f %9.1f "
+               "%7llu\n",
+               phases[i].c_str(), static_cast<unsigned long long>(r.ops),
+               seconds, rate, bw / (1024 * 1024), us[0], us[1], us[2], us[3],
+               static_cast<unsigned long long>(r.errors));
+        fflush(stdout);
+        json << (i ? ",\n" : "\n") << "    {\"name\": \"" << phases[i]
+             << "\", \"ops\": " << r.ops << ", \"bytes\": " << r.bytes
+             << ", \"seconds\": " << seconds << ", \"ops_per_second\": " << rate
+             << ", \"bytes_per_second\": " << bw << ", \"latency_us\": {"
+             << "\"p50\": " << us[0] << ", \"p90\": " << us[1]
+             << ", \"p99\": " << us[2] << ", \"max\": " << us[3]
+             << "}, \"errors\": " << r.errors << "}";
+    }
+    json << "\n  ]\n}\n";
+
+    if(!opts.keep)
+        b.cleanup();
+    if(rank == 0 && !opts.output.empty()) {
+        ofstream of(opts.output);
+        of << json.str();
+        if(!of) {
+            cerr << "Failed to write " << opts.output << endl;
+            errors++;
+        }
+    }
+
+    MPI_Bcast(&errors, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    MPI_Finalize();
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,76 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+/*
+ * Syscall storm on paths outside of GekkoFS, e.g., the library and module
+ * lookups of interpreters. Compare the time per call with and without the
+ * client and with LIBGKFS_PATH_CACHE_ENTRIES=0:
+ *
+ *   LD_PRELOAD=libgkfs_intercept.so ./gkfs_test_path_storm [iterations] [path...]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+
+    long iterations = argc > 1 ? atol(argv[1]) : 1000000;
+    vector<string> paths;
+    for(int i = 2; i < argc; i++)
+        paths.emplace_back(argv[i]);
+    if(paths.empty())
+        paths = {"/usr/lib", "/usr/lib/os-release", "/etc/passwd",
+                 "/usr/share/zoneinfo/UTC", "/tmp/gkfs_path_storm_missing"};
+
+    struct stat st{};
+    long found = 0;
+    auto start = chrono::steady_clock::now();
+    for(long i = 0; i < iterations; i++) {
+        if(stat(paths[i % paths.size()].c_str(), &st) == 0)
+            found++;
+        if(access(paths[i % paths.size()].c_str(), F_OK) == 0)
+            found++;
+    }
+    auto ns = chrono::duration<double, nano>(chrono::steady_clock::now() -
+                                             start).count();
+
+    cout << "calls: " << 2 * iterations << ", found: " << found
+         << ", ns per call: " << ns / (2 * iterations) << endl;
+    return 0;
+}
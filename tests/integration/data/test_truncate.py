@@ -158,3 +158,39 @@ def test_fail_truncate(gkfs_daemon, gkfs_client):
     assert ret.statbuf.st_size == buf_length+1
 
 
+def test_read_trailing_hole(gkfs_daemon, gkfs_client):
+    """A file extended with truncate reads as zeros up to its size, also if
+    the requested range ends in a hole or lies entirely in one"""
+    holefile = gkfs_daemon.mountdir / "hole_file"
+
+    ret = gkfs_client.open(holefile, os.O_CREAT | os.O_WRONLY, stat.S_IRWXU | stat.S_IRWXG | stat.S_IRWXO)
+    assert ret.retval != -1
+
+    # data in the first chunk that is too large to be inlined as a small file
+    buf = b'x' * 8192
+    ret = gkfs_client.write(holefile, buf, len(buf))
+    assert ret.retval == len(buf)
+
+    # extend the file over two more chunks (512 KiB each)
+    file_size = 3 * 524288
+    ret = gkfs_client.truncate(holefile, file_size)
+    assert ret.retval == 0
+
+    # read across the end of the data into the trailing hole
+    ret = gkfs_client.pread(holefile, 16384, 0)
+    assert ret.retval == 16384
+    assert ret.buf == buf + bytes(8192)
+
+    # read only the hole, in a chunk without a chunk file
+    ret = gkfs_client.pread(holefile, 4096, 524288 + 100)
+    assert ret.retval == 4096
+    assert ret.buf == bytes(4096)
+
+    # a read beyond the file size ends at the size
+    ret = gkfs_client.pread(holefile, 8192, file_size - 4096)
+    assert ret.retval == 4096
+    assert ret.buf[:4096] == bytes(4096)
+
+    # nothing is read at the end of the file
+    ret = gkfs_client.pread(holefile, 4096, file_size)
+    assert ret.retval == 0
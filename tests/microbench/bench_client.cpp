@@ -0,0 +1,81 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include "microbench.hpp"
+
+#include <client/open_file_map.hpp>
+
+#include <fmt/format.h>
+
+#include <memory>
+#include <vector>
+
+extern "C" {
+#include <fcntl.h>
+}
+
+using namespace gkfs::filemap;
+
+namespace {
+
+constexpr size_t open_files = 256; // power of two
+
+} // namespace
+
+GKFS_BENCHMARK("open_file_map/get") {
+    auto map = std::make_shared<OpenFileMap>();
+    std::vector<int> fds{};
+    for(size_t i = 0; i < open_files; i++)
+        fds.push_back(map->add(std::make_shared<OpenFile>(
+                fmt::format("/file_{}", i), O_RDWR)));
+    return [map, fds](gkfs::bench::state& s) {
+        for(uint64_t i = 0; i < s.iterations(); i++)
+            gkfs::bench::keep(map->get(fds[i & (open_files - 1)]));
+    };
+}
+
+GKFS_BENCHMARK("open_file_map/exist_miss") {
+    auto map = std::make_shared<OpenFileMap>();
+    for(size_t i = 0; i < open_files; i++)
+        map->add(std::make_shared<OpenFile>(fmt::format("/file_{}", i),
+                                            O_RDWR));
+    return [map](gkfs::bench::state& s) {
+        // fds of the kernel are looked up on every intercepted call
+        for(uint64_t i = 0; i < s.iterations(); i++)
+            gkfs::bench::keep(map->exist(static_cast<int>(i & 63)));
+    };
+}
+
+GKFS_BENCHMARK("open_file_map/add_remove") {
+    auto map = std::make_shared<OpenFileMap>();
+    auto file = std::make_shared<OpenFile>("/file", O_RDWR);
+    return [map, file](gkfs::bench::state& s) {
+        for(uint64_t i = 0; i < s.iterations(); i++)
+            map->remove(map->add(file));
+    };
+}
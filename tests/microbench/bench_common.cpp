@@ -0,0 +1,127 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include "microbench.hpp"
+
+#include <common/metadata.hpp>
+#include <common/rpc/distributor.hpp>
+#include <common/rpc/rpc_util.hpp>
+
+#include <fmt/format.h>
+
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <sys/stat.h>
+}
+
+namespace {
+
+constexpr unsigned int daemons = 64;
+constexpr size_t path_count = 1024; // power of two
+
+std::vector<std::string>
+make_paths() {
+    std::vector<std::string> paths{};
+    for(size_t i = 0; i < path_count; i++)
+        paths.emplace_back(fmt::format("/job/output/rank_{:05}/file.dat", i));
+    return paths;
+}
+
+gkfs::metadata::Metadata
+make_metadata() {
+    gkfs::metadata::Metadata md(S_IFREG | S_IRUSR | S_IWUSR);
+    md.size(123456789);
+    md.blocks(241130);
+    md.atime(1700000000);
+    md.mtime(1700000000);
+    md.ctime(1700000000);
+    return md;
+}
+
+} // namespace
+
+GKFS_BENCHMARK("distributor/locate_data") {
+    auto distributor = std::make_shared<gkfs::rpc::SimpleHashDistributor>(
+            0, std::vector<unsigned int>{daemons}, nullptr, 0);
+    return [distributor, paths = make_paths()](gkfs::bench::state& s) {
+        for(uint64_t i = 0; i < s.iterations(); i++)
+            gkfs::bench::keep(distributor->locate_data(
+                    paths[i & (path_count - 1)], i));
+    };
+}
+
+GKFS_BENCHMARK("distributor/locate_file_metadata") {
+    auto distributor = std::make_shared<gkfs::rpc::SimpleHashDistributor>(
+            0, std::vector<unsigned int>{daemons}, nullptr, 0);
+    return [distributor, paths = make_paths()](gkfs::bench::state& s) {
+        for(uint64_t i = 0; i < s.iterations(); i++)
+            gkfs::bench::keep(distributor->locate_file_metadata(
+                    paths[i & (path_count - 1)]));
+    };
+}
+
+GKFS_BENCHMARK("metadata/serialize") {
+    return [md = make_metadata()](gkfs::bench::state& s) {
+        for(uint64_t i = 0; i < s.iterations(); i++)
+            gkfs::bench::keep(md.serialize());
+    };
+}
+
+GKFS_BENCHMARK("metadata/parse") {
+    return [value = make_metadata().serialize()](gkfs::bench::state& s) {
+        for(uint64_t i = 0; i < s.iterations(); i++) {
+            gkfs::metadata::Metadata md(value);
+            gkfs::bench::keep(md);
+        }
+    };
+}
+
+GKFS_BENCHMARK("rpc/encode_string_4k") {
+    std::string input(4096, '\0');
+    for(size_t i = 0; i < input.size(); i++)
+        input[i] = static_cast<char>(i * 7);
+    return [input](gkfs::bench::state& s) mutable {
+        s.bytes_per_iteration(input.size());
+        for(uint64_t i = 0; i < s.iterations(); i++)
+            gkfs::bench::keep(gkfs::rpc::encode_string(input));
+    };
+}
+
+GKFS_BENCHMARK("rpc/decode_string_4k") {
+    std::string input(4096, '\0');
+    for(size_t i = 0; i < input.size(); i++)
+        input[i] = static_cast<char>(i * 7);
+    auto encoded = gkfs::rpc::encode_string(input);
+    return [encoded](gkfs::bench::state& s) mutable {
+        s.bytes_per_iteration(encoded.size() / 2);
+        for(uint64_t i = 0; i < s.iterations(); i++)
+            gkfs::bench::keep(gkfs::rpc::decode_string(encoded));
+    };
+}
@@ -0,0 +1,194 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include "microbench.hpp"
+
+#include <daemon/backend/data/chunk_storage.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <sys/mman.h>
+}
+
+namespace {
+
+constexpr size_t chunksize = 512 * 1024;
+constexpr gkfs::rpc::chnk_id_t chunks = 64;
+
+std::shared_ptr<gkfs::data::ChunkStorage>
+make_storage(const gkfs::bench::context& ctx, std::string_view backend) {
+    // the daemon creates the root directory before the storage
+    auto root = ctx.root + "/chunks";
+    std::filesystem::create_directories(root);
+    return std::make_shared<gkfs::data::ChunkStorage>(root, chunksize,
+                                                      backend);
+}
+
+gkfs::bench::loop
+write_chunks(const gkfs::bench::context& ctx, std::string_view backend,
+             size_t size) {
+    auto storage = make_storage(ctx, backend);
+    return [storage, size](gkfs::bench::state& s) {
+        std::vector<char> buf(size, 'x');
+        s.bytes_per_iteration(size);
+        for(uint64_t i = 0; i < s.iterations(); i++)
+            storage->write_chunk("/bench_file", i % chunks, buf.data(), size,
+                                 0);
+    };
+}
+
+gkfs::bench::loop
+read_chunks(const gkfs::bench::context& ctx, std::string_view backend,
+            size_t size) {
+    auto storage = make_storage(ctx, backend);
+    std::vector<char> buf(size, 'x');
+    for(gkfs::rpc::chnk_id_t id = 0; id < chunks; id++)
+        storage->write_chunk("/bench_file", id, buf.data(), size, 0);
+    return [storage, size](gkfs::bench::state& s) {
+        std::vector<char> buf(size);
+        s.bytes_per_iteration(size);
+        for(uint64_t i = 0; i < s.iterations(); i++)
+            gkfs::bench::keep(storage->read_chunk("/bench_file", i % chunks,
+                                                  buf.data(), size, 0));
+    };
+}
+
+/*
+ * The daemon read paths up to the bulk push. The push is modeled as a copy
+ * into the client buffer, which is what na+sm does. The pread() path reads
+ * the chunk into a bulk buffer and pushes from there. The mapped path
+ * (--chunk-map-cache) pushes from the mapping of the chunk file directly,
+ * either from a cached mapping or after mapping the chunk on a miss.
+ */
+
+gkfs::bench::loop
+push_read_chunks(const gkfs::bench::context& ctx, size_t size) {
+    auto storage = make_storage(ctx, gkfs::data::file_backend);
+    std::vector<char> buf(size, 'x');
+    for(gkfs::rpc::chnk_id_t id = 0; id < chunks; id++)
+        storage->write_chunk("/bench_file", id, buf.data(), size, 0);
+    return [storage, size](gkfs::bench::state& s) {
+        std::vector<char> bulk(size);
+        std::vector<char> client(size);
+        std::vector<std::pair<size_t, size_t>> extents;
+        s.bytes_per_iteration(size);
+        for(uint64_t i = 0; i < s.iterations(); i++) {
+            storage->read_chunk_extents("/bench_file", i % chunks,
+                                        bulk.data(), size, 0, extents);
+            for(const auto& [off, len] : extents)
+                memcpy(client.data() + off, bulk.data() + off, len);
+            gkfs::bench::keep(client[i % size]);
+        }
+    };
+}
+
+/**
+ * @brief Mappings of the chunks of a file, as if the cache held them.
+ */
+struct mapped_chunks {
+    std::vector<std::pair<void*, size_t>> mappings;
+
+    ~mapped_chunks() {
+        for(const auto& [addr, size] : mappings)
+            munmap(addr, size);
+    }
+};
+
+gkfs::bench::loop
+push_mapped_chunks(const gkfs::bench::context& ctx, size_t size,
+                   bool cached) {
+    auto storage = make_storage(ctx, gkfs::data::file_backend);
+    std::vector<char> buf(size, 'x');
+    for(gkfs::rpc::chnk_id_t id = 0; id < chunks; id++)
+        storage->write_chunk("/bench_file", id, buf.data(), size, 0);
+    auto cache = std::make_shared<mapped_chunks>();
+    for(gkfs::rpc::chnk_id_t id = 0; cached && id < chunks; id++) {
+        size_t mapped = 0;
+        auto* addr = storage->map_chunk("/bench_file", id, mapped);
+        cache->mappings.emplace_back(addr, mapped);
+    }
+    return [storage, size, cache](gkfs::bench::state& s) {
+        std::vector<char> client(size);
+        s.bytes_per_iteration(size);
+        for(uint64_t i = 0; i < s.iterations(); i++) {
+            auto id = i % chunks;
+            if(!cache->mappings.empty()) {
+                memcpy(client.data(), cache->mappings[id].first, size);
+            } else {
+                size_t mapped = 0;
+                auto* addr = storage->map_chunk("/bench_file", id, mapped);
+                memcpy(client.data(), addr, size);
+                munmap(addr, mapped);
+            }
+            gkfs::bench::keep(client[i % size]);
+        }
+    };
+}
+
+} // namespace
+
+GKFS_BENCHMARK("chunk_storage/write_4k") {
+    return write_chunks(ctx, gkfs::data::file_backend, 4096);
+}
+
+GKFS_BENCHMARK("chunk_storage/write_512k") {
+    return write_chunks(ctx, gkfs::data::file_backend, chunksize);
+}
+
+GKFS_BENCHMARK("chunk_storage/read_4k") {
+    return read_chunks(ctx, gkfs::data::file_backend, 4096);
+}
+
+GKFS_BENCHMARK("chunk_storage/read_512k") {
+    return read_chunks(ctx, gkfs::data::file_backend, chunksize);
+}
+
+GKFS_BENCHMARK("chunk_storage/container_write_4k") {
+    return write_chunks(ctx, gkfs::data::container_backend, 4096);
+}
+
+GKFS_BENCHMARK("chunk_storage/container_read_4k") {
+    return read_chunks(ctx, gkfs::data::container_backend, 4096);
+}
+
+GKFS_BENCHMARK("chunk_storage/push_pread_512k") {
+    return push_read_chunks(ctx, chunksize);
+}
+
+GKFS_BENCHMARK("chunk_storage/push_mapped_512k") {
+    return push_mapped_chunks(ctx, chunksize, true);
+}
+
+GKFS_BENCHMARK("chunk_storage/push_mapped_miss_512k") {
+    return push_mapped_chunks(ctx, chunksize, false);
+}
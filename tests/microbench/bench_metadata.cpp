@@ -0,0 +1,126 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include "microbench.hpp"
+
+#include <common/metadata.hpp>
+#include <daemon/backend/metadata/merge.hpp>
+#include <daemon/backend/metadata/rocksdb_backend.hpp>
+
+#include <fmt/format.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <sys/stat.h>
+}
+
+using namespace gkfs::metadata;
+
+namespace {
+
+constexpr size_t operands = 16;
+constexpr size_t entries = 1000;
+
+std::shared_ptr<RocksDBBackend>
+make_db(const gkfs::bench::context& ctx) {
+    auto db = std::make_shared<RocksDBBackend>(ctx.root + "/rocksdb");
+    const auto file = Metadata(S_IFREG | S_IRUSR | S_IWUSR).serialize();
+    const auto dir = Metadata(S_IFDIR | S_IRWXU).serialize();
+    db->put("/dir", dir);
+    db->put("/other", dir);
+    for(size_t i = 0; i < entries; i++) {
+        db->put(fmt::format("/dir/file_{:05}", i), file);
+        db->put(fmt::format("/other/file_{:05}", i), file);
+    }
+    return db;
+}
+
+} // namespace
+
+GKFS_BENCHMARK("merge/increase_size_serialize") {
+    return [](gkfs::bench::state& s) {
+        for(uint64_t i = 0; i < s.iterations(); i++) {
+            IncreaseSizeOperand op(4096, "", static_cast<off_t>(i * 4096), 0);
+            gkfs::bench::keep(op.serialize());
+        }
+    };
+}
+
+GKFS_BENCHMARK("merge/increase_size_parse") {
+    return [serialized = IncreaseSizeOperand(4096, "", 1 << 30, 0).serialize()](
+                   gkfs::bench::state& s) {
+        const auto params = MergeOperand::get_params(serialized);
+        for(uint64_t i = 0; i < s.iterations(); i++) {
+            IncreaseSizeOperand op(params);
+            gkfs::bench::keep(op);
+        }
+    };
+}
+
+GKFS_BENCHMARK("merge/full_merge_v2_16_operands") {
+    auto state = std::make_shared<std::vector<std::string>>();
+    state->push_back(Metadata(S_IFREG | S_IRUSR | S_IWUSR).serialize());
+    for(size_t i = 0; i < operands; i++)
+        state->push_back(
+                IncreaseSizeOperand(4096, "", static_cast<off_t>(i * 4096), 0)
+                        .serialize());
+    return [state](gkfs::bench::state& s) {
+        const MetadataMergeOperator merge_operator{};
+        const rdb::Slice key{"/bench_file"};
+        const rdb::Slice existing{state->front()};
+        const std::vector<rdb::Slice> operand_list(state->begin() + 1,
+                                                   state->end());
+        for(uint64_t i = 0; i < s.iterations(); i++) {
+            std::string new_value{};
+            rdb::Slice existing_operand{};
+            rdb::MergeOperator::MergeOperationOutput out(new_value,
+                                                         existing_operand);
+            const rdb::MergeOperator::MergeOperationInput in(
+                    key, &existing, operand_list, nullptr);
+            merge_operator.FullMergeV2(in, &out);
+            gkfs::bench::keep(new_value);
+        }
+    };
+}
+
+GKFS_BENCHMARK("rocksdb/get_dirents_1000") {
+    return [db = make_db(ctx)](gkfs::bench::state& s) {
+        for(uint64_t i = 0; i < s.iterations(); i++)
+            gkfs::bench::keep(db->get_dirents("/dir/"));
+    };
+}
+
+GKFS_BENCHMARK("rocksdb/get_dirents_extended_1000") {
+    return [db = make_db(ctx)](gkfs::bench::state& s) {
+        for(uint64_t i = 0; i < s.iterations(); i++)
+            gkfs::bench::keep(db->get_dirents_extended("/dir/"));
+    };
+}
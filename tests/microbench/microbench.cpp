@@ -0,0 +1,293 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+/**
+ * @brief Runner of the GekkoFS microbenchmarks.
+ * @internal
+ * Every benchmark is calibrated to run for at least --min-time seconds per
+ * sample and then sampled --repetitions times. Setup and teardown of the
+ * fixture are not timed. Results are printed as a table to stderr and as JSON
+ * to stdout or --output, so that runs of different commits can be compared
+ * with scripts/dev/gkfs_microbench_compare.py.
+ * @endinternal
+ */
+
+#include "microbench.hpp"
+
+#include <common/log_util.hpp>
+#include <daemon/backend/metadata/metadata_module.hpp>
+#include <daemon/backend/data/data_module.hpp>
+#include <version.hpp>
+
+#include <CLI/CLI.hpp>
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <regex>
+
+extern "C" {
+#include <unistd.h>
+}
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace gkfs::bench {
+
+vector<benchmark>&
+registry() {
+    static vector<benchmark> benchmarks{};
+    return benchmarks;
+}
+
+} // namespace gkfs::bench
+
+namespace {
+
+using bench_clock = chrono::steady_clock;
+
+struct cli_options {
+    string filter{".*"};
+    string root{};
+    string output{};
+    double min_time{0.2};
+    unsigned int repetitions{5};
+};
+
+struct result {
+    string name;
+    uint64_t iterations;
+    uint64_t bytes_per_iteration;
+    vector<double> ns_per_op;
+};
+
+/**
+ * @brief Runs one sample of `iterations` operations in a fresh scratch dir.
+ * @return Elapsed seconds and the bytes per iteration set by the benchmark
+ */
+pair<double, uint64_t>
+sample(const gkfs::bench::benchmark& b, const gkfs::bench::context& ctx,
+       uint64_t iterations) {
+    fs::create_directories(ctx.root);
+    double elapsed;
+    uint64_t bytes;
+    {
+        auto body = b.setup(ctx);
+        gkfs::bench::state s(iterations);
+        const auto start = bench_clock::now();
+        body(s);
+        const auto stop = bench_clock::now();
+        elapsed = chrono::duration<double>(stop - start).count();
+        bytes = s.bytes_per_iteration();
+    }
+    fs::remove_all(ctx.root);
+    return {elapsed, bytes};
+}
+
+result
+measure(const gkfs::bench::benchmark& b, const gkfs::bench::context& ctx,
+        const cli_options& opts) {
+    // grow the iteration count until a sample takes at least min_time
+    uint64_t iterations = 1;
+    for(;;) {
+        const auto elapsed = sample(b, ctx, iterations).first;
+        if(elapsed >= opts.min_time || iterations >= (uint64_t{1} << 40))
+            break;
+        const auto scale = elapsed > 0.0 ? 1.2 * opts.min_time / elapsed : 10.0;
+        iterations = max(iterations + 1,
+                         static_cast<uint64_t>(static_cast<double>(iterations) *
+                                               min(scale, 10.0)));
+    }
+    result r{b.name, iterations, 0, {}};
+    for(unsigned int i = 0; i < opts.repetitions; i++) {
+        auto [elapsed, bytes] = sample(b, ctx, iterations);
+        r.ns_per_op.push_back(elapsed * 1e9 / static_cast<double>(iterations));
+        r.bytes_per_iteration = bytes;
+    }
+    return r;
+}
+
+double
+median(vector<double> values) {
+    sort(values.begin(), values.end());
+    const auto n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+}
+
+string
+json_escape(const string& s) {
+    string out{};
+    for(auto c : s) {
+        if(c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+string
+to_json(const vector<result>& results, const cli_options& opts) {
+    char host[256]{};
+    gethostname(host, sizeof(host) - 1);
+    const auto now = time(nullptr);
+    char date[32]{};
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    string out = "{\n  \"context\": {\n";
+    out += fmt::format("    \"version\": \"{}\",\n", GKFS_VERSION_STRING);
+    out += fmt::format("    \"date\": \"{}\",\n", date);
+    out += fmt::format("    \"host\": \"{}\",\n", json_escape(host));
+    out += fmt::format("    \"min_time_s\": {},\n", opts.min_time);
+    out += fmt::format("    \"repetitions\": {}\n  }},\n", opts.repetitions);
+    out += "  \"benchmarks\": [";
+    for(size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        const auto& ns = r.ns_per_op;
+        const auto mean = accumulate(ns.begin(), ns.end(), 0.0) / ns.size();
+        double var = 0.0;
+        for(auto v : ns)
+            var += (v - mean) * (v - mean);
+        const auto stddev = ns.size() > 1 ? sqrt(var / (ns.size() - 1)) : 0.0;
+        const auto med = median(ns);
+        out += i ? ",\n" : "\n";
+        out += fmt::format("    {{\"name\": \"{}\", \"iterations\": {}, ",
+                           json_escape(r.name), r.iterations);
+        out += fmt::format(
+                "\"ns_per_op\": {{\"median\": {:.3f}, \"mean\": {:.3f}, "
+                "\"min\": {:.3f}, \"max\": {:.3f}, \"stddev\": {:.3f}}}",
+                med, mean, *min_element(ns.begin(), ns.end()),
+                *max_element(ns.begin(), ns.end()), stddev);
+        if(r.bytes_per_iteration)
+            out += fmt::format(", \"bytes_per_second\": {:.0f}",
+                               r.bytes_per_iteration * 1e9 / med);
+        out += "}";
+    }
+    out += "\n  ]\n}\n";
+    return out;
+}
+
+} // namespace
+
+int
+main(int argc, const char* argv[]) {
+    cli_options opts{};
+    opts.root = fs::is_directory("/dev/shm")
+                        ? "/dev/shm"
+                        : fs::temp_directory_path().string();
+
+    CLI::App desc{"GekkoFS microbenchmarks"};
+    // clang-format off
+    desc.add_option("--filter,-f", opts.filter,
+                    "Regular expression selecting the benchmarks to run (default: all).");
+    desc.add_option("--min-time", opts.min_time,
+                    "Minimum seconds per sample (default: 0.2).");
+    desc.add_option("--repetitions,-r", opts.repetitions,
+                    "Samples per benchmark (default: 5).");
+    desc.add_option("--root", opts.root,
+                    "Scratch directory for storage benchmarks, preferably on tmpfs (default: /dev/shm).");
+    desc.add_option("--output,-o", opts.output,
+                    "Writes the JSON results to this file instead of stdout.");
+    desc.add_flag("--list,-l", "Lists the benchmarks and exits.");
+    // clang-format on
+    try {
+        desc.parse(argc, argv);
+    } catch(const CLI::ParseError& e) {
+        return desc.exit(e);
+    }
+    if(opts.repetitions == 0)
+        opts.repetitions = 1;
+
+    auto benchmarks = gkfs::bench::registry();
+    sort(benchmarks.begin(), benchmarks.end(),
+         [](const auto& a, const auto& b) { return a.name < b.name; });
+    const regex filter(opts.filter);
+    benchmarks.erase(remove_if(benchmarks.begin(), benchmarks.end(),
+                               [&filter](const auto& b) {
+                                   return !regex_search(b.name, filter);
+                               }),
+                     benchmarks.end());
+    if(desc.count("--list")) {
+        for(const auto& b : benchmarks)
+            cout << b.name << endl;
+        return EXIT_SUCCESS;
+    }
+
+    // daemon components log to these module loggers
+    gkfs::log::setup({gkfs::metadata::MetadataModule::LOGGER_NAME,
+                      gkfs::data::DataModule::LOGGER_NAME},
+                     spdlog::level::off, "/dev/null");
+
+    gkfs::bench::context ctx{};
+    ctx.root = (fs::path(opts.root) /
+                fmt::format("gkfs_microbench_{}", getpid()))
+                       .string();
+
+    vector<result> results{};
+    cerr << fmt::format("{:<48} {:>12} {:>14} {:>12}\n", "BENCHMARK",
+                        "ITERATIONS", "NS/OP", "MiB/S");
+    for(const auto& b : benchmarks) {
+        try {
+            auto r = measure(b, ctx, opts);
+            const auto med = median(r.ns_per_op);
+            cerr << fmt::format(
+                    "{:<48} {:>12} {:>14.1f} {:>12}\n", r.name, r.iterations,
+                    med,
+                    r.bytes_per_iteration
+                            ? fmt::format("{:.1f}", r.bytes_per_iteration *
+                                                            1e9 / med /
+                                                            (1024.0 * 1024.0))
+                            : "-");
+            results.emplace_back(move(r));
+        } catch(const exception& e) {
+            fs::remove_all(ctx.root);
+            cerr << fmt::format("{:<48} failed: {}\n", b.name, e.what());
+            return EXIT_FAILURE;
+        }
+    }
+
+    const auto json = to_json(results, opts);
+    if(opts.output.empty()) {
+        cout << json;
+    } else {
+        ofstream of(opts.output);
+        of << json;
+        if(!of) {
+            cerr << fmt::format("Failed to write results to '{}'\n",
+                                opts.output);
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef GKFS_TESTS_MICROBENCH_HPP
+#define GKFS_TESTS_MICROBENCH_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Minimal harness for the microbenchmarks of GekkoFS hot paths.
+ * @internal
+ * A benchmark is registered with GKFS_BENCHMARK(name) { ... }. Its body runs
+ * once per sample to set up the fixture and returns the loop to be timed,
+ * which runs the operation a given number of times. The fixture is released
+ * when the loop is destroyed, i.e., it lives in the loop's captures.
+ *
+ *     GKFS_BENCHMARK("component/operation") {
+ *         auto input = make_input();
+ *         return [input](gkfs::bench::state& s) {
+ *             for(uint64_t i = 0; i < s.iterations(); i++)
+ *                 gkfs::bench::keep(operation(input));
+ *         };
+ *     }
+ * @endinternal
+ */
+namespace gkfs::bench {
+
+/**
+ * @brief Settings shared by all benchmarks.
+ */
+struct context {
+    std::string root; //!< scratch directory, should be on tmpfs
+};
+
+/**
+ * @brief Per-sample state passed to the timed loop.
+ */
+class state {
+private:
+    uint64_t iterations_;
+    uint64_t bytes_{0};
+
+public:
+    explicit state(uint64_t iterations) : iterations_(iterations) {}
+
+    [[nodiscard]] uint64_t
+    iterations() const {
+        return iterations_;
+    }
+
+    /**
+     * @brief Sets the bytes moved per iteration to report a bandwidth.
+     */
+    void
+    bytes_per_iteration(uint64_t bytes) {
+        bytes_ = bytes;
+    }
+
+    [[nodiscard]] uint64_t
+    bytes_per_iteration() const {
+        return bytes_;
+    }
+};
+
+using loop = std::function<void(state&)>;
+using fixture = std::function<loop(const context&)>;
+
+struct benchmark {
+    std::string name;
+    fixture setup;
+};
+
+std::vector<benchmark>&
+registry();
+
+struct registrar {
+    registrar(const char* name, fixture setup) {
+        registry().push_back({name, std::move(setup)});
+    }
+};
+
+/**
+ * @brief Keeps the compiler from optimizing away a computed value.
+ */
+template <typename T>
+inline void
+keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+} // namespace gkfs::bench
+
+#define GKFS_BENCH_CONCAT_(a, b) a##b
+#define GKFS_BENCH_CONCAT(a, b) GKFS_BENCH_CONCAT_(a, b)
+#define GKFS_BENCH_FN GKFS_BENCH_CONCAT(gkfs_bench_fixture_, __LINE__)
+
+#define GKFS_BENCHMARK(name)                                                   \
+    static gkfs::bench::loop GKFS_BENCH_FN(const gkfs::bench::context&);      \
+    static const gkfs::bench::registrar GKFS_BENCH_CONCAT(                     \
+            gkfs_bench_registrar_, __LINE__)(name, GKFS_BENCH_FN);             \
+    static gkfs::bench::loop GKFS_BENCH_FN(                                    \
+            [[maybe_unused]] const gkfs::bench::context& ctx)
+
+#endif // GKFS_TESTS_MICROBENCH_HPP
@@ -0,0 +1,152 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <common/capture_util.hpp>
+
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace gkfs::capture;
+
+namespace {
+
+long
+write_fd(int fd, const void* buf, size_t count) {
+    return ::write(fd, buf, count);
+}
+
+std::string
+tmp_path() {
+    char path[] = "/tmp/gkfs_test_capture_XXXXXX";
+    int fd = ::mkstemp(path);
+    REQUIRE(fd != -1);
+    ::close(fd);
+    return path;
+}
+
+std::vector<entry>
+read_entries(const std::string& path) {
+    reader r(path);
+    REQUIRE(r.header().pid == static_cast<uint32_t>(::getpid()));
+    std::vector<entry> entries;
+    entry e{};
+    while(r.next(e)) {
+        entries.push_back(e);
+    }
+    return entries;
+}
+
+record
+make_record(op o, int32_t fd, int64_t result) {
+    record r{};
+    r.op = static_cast<uint16_t>(o);
+    r.fd = fd;
+    r.result = result;
+    return r;
+}
+
+} // namespace
+
+SCENARIO("syscalls are written to a capture file", "[capture_util]") {
+
+    GIVEN("A writer to a temporary file") {
+        auto path = tmp_path();
+        FILE* file = std::fopen(path.c_str(), "w");
+        REQUIRE(file != nullptr);
+        auto w = std::make_unique<writer>(fileno(file), write_fd);
+
+        WHEN("Records with and without paths are added") {
+            auto open = make_record(op::open, -1, 3);
+            open.start = w->elapsed();
+            w->add(open, "/dir/file");
+            auto pwrite = make_record(op::pwrite, 3, 4096);
+            pwrite.size = 4096;
+            pwrite.offset = 8192;
+            w->add(pwrite);
+            w->add(make_record(op::rename, -1, 0), "/dir/file", "/dir/new");
+            w.reset();
+
+            THEN("They are read back in order with their paths") {
+                auto entries = read_entries(path);
+                REQUIRE(entries.size() == 3);
+                REQUIRE(entries[0].rec.op == static_cast<uint16_t>(op::open));
+                REQUIRE(entries[0].rec.result == 3);
+                REQUIRE(entries[0].path == "/dir/file");
+                REQUIRE(entries[0].path2.empty());
+                REQUIRE(entries[1].rec.size == 4096);
+                REQUIRE(entries[1].rec.offset == 8192);
+                REQUIRE(entries[1].path.empty());
+                REQUIRE(entries[2].path == "/dir/file");
+                REQUIRE(entries[2].path2 == "/dir/new");
+                for(const auto& e : entries) {
+                    REQUIRE(e.rec.tid != 0);
+                }
+            }
+        }
+
+        WHEN("More records are added than fit into the buffer") {
+            const auto n = writer::buffer_bytes / sizeof(record) + 10;
+            for(size_t i = 0; i < n; i++) {
+                w->add(make_record(op::read, 3, 1));
+            }
+            THEN("Full buffers are written out, the rest on destruction") {
+                std::fflush(file);
+                REQUIRE(read_entries(path).size() ==
+                        writer::buffer_bytes / sizeof(record));
+                w.reset();
+                REQUIRE(read_entries(path).size() == n);
+            }
+        }
+
+        w.reset();
+        std::fclose(file);
+        ::unlink(path.c_str());
+    }
+
+    GIVEN("A file that is not a capture") {
+        auto path = tmp_path();
+        THEN("The reader refuses it") {
+            REQUIRE_THROWS_AS(reader(path), std::runtime_error);
+            REQUIRE_THROWS_AS(reader(path + ".missing"), std::runtime_error);
+        }
+        ::unlink(path.c_str());
+    }
+
+    GIVEN("The captured operations") {
+        THEN("Every operation has a name") {
+            REQUIRE(std::string(op_name(op::open)) == "open");
+            REQUIRE(std::string(op_name(op::dup)) == "dup");
+            REQUIRE(std::string(op_name(op::count)) == "unknown");
+        }
+    }
+}
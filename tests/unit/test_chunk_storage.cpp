@@ -0,0 +1,139 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <daemon/backend/data/chunk_storage.hpp>
+#include <daemon/backend/data/data_module.hpp>
+#include <config.hpp>
+#include "helpers/helpers.hpp"
+
+#include <spdlog/sinks/null_sink.h>
+
+using namespace gkfs::data;
+
+namespace {
+
+/**
+ * Number of entries, i.e., tombstones, chunk files, and directories, left in
+ * the trash directory.
+ */
+size_t
+trash_entries(const fs::path& trash) {
+    size_t entries = 0;
+    for(auto it = fs::recursive_directory_iterator(trash);
+        it != fs::recursive_directory_iterator(); ++it)
+        entries++;
+    return entries;
+}
+
+} // namespace
+
+SCENARIO("chunks of removed files are reclaimed from tombstones",
+         "[chunk_storage][tombstones]") {
+
+    if(!spdlog::get(DataModule::LOGGER_NAME))
+        spdlog::create<spdlog::sinks::null_sink_mt>(DataModule::LOGGER_NAME);
+
+    GIVEN("A file chunk storage with a file of 4 chunks") {
+        helpers::temporary_directory tmpdir{};
+        auto root = (tmpdir.dirname() / "chunks").native();
+        fs::create_directories(root);
+        const auto trash = tmpdir.dirname() / gkfs::config::data::trash_dir;
+        const size_t chunksize = 4096;
+        ChunkStorage storage(root, chunksize);
+        const std::string data(chunksize, 'a');
+        for(gkfs::rpc::chnk_id_t chunk = 0; chunk < 4; chunk++)
+            storage.write_chunk("/f", chunk, data.data(), data.size(), 0);
+
+        WHEN("The file is removed") {
+            REQUIRE(storage.tombstone_chunk_space("/f"));
+
+            THEN("Its chunks are gone but not yet reclaimed") {
+                std::string buf(chunksize, '\0');
+                REQUIRE_THROWS_AS(
+                        storage.read_chunk("/f", 0, buf.data(), chunksize, 0),
+                        ChunkStorageException);
+                // the tombstone and its 4 chunk files
+                REQUIRE(trash_entries(trash) == 5);
+                // nothing left to tombstone
+                REQUIRE(!storage.tombstone_chunk_space("/f"));
+            }
+
+            THEN("A file re-created under the same path starts empty") {
+                const std::string other(chunksize, 'b');
+                storage.write_chunk("/f", 1, other.data(), other.size(), 0);
+                std::string buf(chunksize, '\0');
+                REQUIRE(storage.read_chunk("/f", 1, buf.data(), chunksize,
+                                           0) == chunksize);
+                REQUIRE(buf == other);
+                REQUIRE_THROWS_AS(
+                        storage.read_chunk("/f", 0, buf.data(), chunksize, 0),
+                        ChunkStorageException);
+                // reclaiming the old chunks keeps the new ones
+                REQUIRE(storage.reclaim_tombstones(100) == 5);
+                REQUIRE(storage.read_chunk("/f", 1, buf.data(), chunksize,
+                                           0) == chunksize);
+                REQUIRE(buf == other);
+                // and its removal leaves a tombstone of its own
+                REQUIRE(storage.tombstone_chunk_space("/f"));
+                REQUIRE(trash_entries(trash) == 2);
+            }
+
+            THEN("Tombstones are reclaimed in batches") {
+                REQUIRE(storage.reclaim_tombstones(2) == 2);
+                REQUIRE(trash_entries(trash) == 3);
+                REQUIRE(storage.reclaim_tombstones(2) == 2);
+                // the tombstone directory itself
+                REQUIRE(storage.reclaim_tombstones(2) == 1);
+                REQUIRE(trash_entries(trash) == 0);
+                REQUIRE(storage.reclaim_tombstones(2) == 0);
+            }
+        }
+
+        WHEN("A tombstone holds an entry that cannot be unlinked") {
+            REQUIRE(storage.tombstone_chunk_space("/f"));
+            // unlink() fails with EISDIR on a directory, even for root
+            auto tombstone = fs::directory_iterator(trash)->path();
+            fs::create_directories(tombstone / "stuck" / "x");
+            storage.write_chunk("/g", 0, data.data(), data.size(), 0);
+            REQUIRE(storage.tombstone_chunk_space("/g"));
+
+            THEN("It is skipped and failures are not counted as removed") {
+                // the chunk file and tombstone of /g and the chunk files of
+                // /f that were listed before the stuck entry
+                auto removed = storage.reclaim_tombstones(100);
+                REQUIRE(removed >= 2);
+                REQUIRE(removed <= 6);
+                REQUIRE(trash_entries(trash) == 9 - removed);
+                REQUIRE(fs::exists(tombstone / "stuck"));
+                // no progress is reported for it afterwards
+                REQUIRE(storage.reclaim_tombstones(100) == 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,213 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <daemon/backend/data/container_store.hpp>
+#include <daemon/backend/data/chunk_storage.hpp>
+#include "helpers/helpers.hpp"
+
+#include <spdlog/sinks/null_sink.h>
+
+#include <optional>
+#include <thread>
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+using namespace gkfs::data;
+
+namespace {
+
+constexpr size_t chunksize = 64 * 1024;
+constexpr size_t block = 4096;
+
+std::shared_ptr<spdlog::logger>
+null_logger() {
+    return std::make_shared<spdlog::logger>(
+            "container_store",
+            std::make_shared<spdlog::sinks::null_sink_mt>());
+}
+
+ssize_t
+write(ContainerStore& store, const std::string& path,
+      gkfs::rpc::chnk_id_t chunk_id, const std::string& data, off64_t offset) {
+    std::string buf(data);
+    return store.write(path, chunk_id, {iovec{buf.data(), buf.size()}},
+                       offset);
+}
+
+std::string
+read(const ContainerStore& store, const std::string& path,
+     gkfs::rpc::chnk_id_t chunk_id, size_t size = chunksize,
+     off64_t offset = 0) {
+    std::string buf(size, 'x');
+    auto read = store.read(path, chunk_id, buf.data(), size, offset);
+    buf.resize(read);
+    return buf;
+}
+
+/**
+ * Index of the container file whose first block holds `data`.
+ */
+std::optional<int>
+container_at_start(const fs::path& dir, const std::string& data) {
+    for(int c = 0; fs::exists(dir / fmt::format("container.{}", c)); c++) {
+        auto path = dir / fmt::format("container.{}", c);
+        std::string buf(data.size(), '\0');
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        auto read = ::pread(fd, buf.data(), buf.size(), 0);
+        ::close(fd);
+        if(read == static_cast<ssize_t>(data.size()) && buf == data)
+            return c;
+    }
+    return {};
+}
+
+} // namespace
+
+SCENARIO("chunks are stored as extents in container files",
+         "[chunk_storage][containers]") {
+
+    GIVEN("An empty container store") {
+        helpers::temporary_directory tmpdir{};
+        const auto dir = tmpdir.dirname();
+        auto store = std::make_unique<ContainerStore>(dir, chunksize,
+                                                      null_logger());
+
+        THEN("Chunks are read back as written") {
+            const std::string data(100, 'a');
+            REQUIRE(write(*store, "/f", 0, data, 0) == 100);
+            REQUIRE(read(*store, "/f", 0) == data);
+            REQUIRE(read(*store, "/f", 0, 10, 95) == std::string(5, 'a'));
+            // at or beyond the chunk length
+            REQUIRE(read(*store, "/f", 0, 10, 100).empty());
+            REQUIRE_THROWS_AS(read(*store, "/f", 1), ChunkStorageException);
+        }
+
+        THEN("Writes beyond an extent move the chunk to a larger one") {
+            REQUIRE(write(*store, "/f", 0, std::string(100, 'a'), 0) == 100);
+            // the first extent holds one block
+            const std::string tail(1000, 'b');
+            REQUIRE(write(*store, "/f", 0, tail, 3 * block) == 1000);
+            auto chunk = read(*store, "/f", 0);
+            REQUIRE(chunk.size() == 3 * block + 1000);
+            REQUIRE(chunk.substr(0, 100) == std::string(100, 'a'));
+            // the gap reads as zeros
+            REQUIRE(chunk.substr(100, 3 * block - 100) ==
+                    std::string(3 * block - 100, '\0'));
+            REQUIRE(chunk.substr(3 * block) == tail);
+            // up to a whole chunk
+            const std::string full(chunksize, 'c');
+            REQUIRE(write(*store, "/f", 0, full, 0) == chunksize);
+            REQUIRE(read(*store, "/f", 0) == full);
+        }
+
+        THEN("Trimmed space is reused without leaking old data") {
+            // chunks 8 apart of a path are in the same container
+            for(gkfs::rpc::chnk_id_t chunk = 0; chunk < 24; chunk += 8)
+                REQUIRE(write(*store, "/f", chunk, std::string(block, 'a'),
+                              0) == block);
+            auto free_before = store->free_bytes();
+            store->trim("/f", 8);
+            REQUIRE(read(*store, "/f", 0) == std::string(block, 'a'));
+            REQUIRE_THROWS_AS(read(*store, "/f", 8), ChunkStorageException);
+            REQUIRE_THROWS_AS(read(*store, "/f", 16), ChunkStorageException);
+            REQUIRE(store->free_bytes() == free_before + 2 * block);
+            REQUIRE(write(*store, "/f", 8, std::string(10, 'b'), 0) == 10);
+            REQUIRE(store->free_bytes() == free_before + block);
+            REQUIRE(read(*store, "/f", 8) == std::string(10, 'b'));
+            store->truncate("/f", 8, block);
+            REQUIRE(read(*store, "/f", 8) ==
+                    std::string(10, 'b') + std::string(block - 10, '\0'));
+            store->truncate("/f", 8, 5);
+            REQUIRE(read(*store, "/f", 8) == std::string(5, 'b'));
+        }
+
+        THEN("Compaction moves extents into free space below them") {
+            // chunks 8 apart of a path are in the same container
+            for(gkfs::rpc::chnk_id_t chunk = 0; chunk < 32; chunk += 8)
+                write(*store, "/f", chunk,
+                      std::string(block, static_cast<char>('a' + chunk / 8)),
+                      0);
+            const std::string last(block, 'd');
+            for(gkfs::rpc::chnk_id_t chunk = 0; chunk < 24; chunk += 8)
+                store->remove("/f", chunk);
+            REQUIRE(!container_at_start(dir, last));
+            store->compact();
+            REQUIRE(container_at_start(dir, last));
+            REQUIRE(read(*store, "/f", 24) == last);
+            // the old extent was freed
+            REQUIRE(write(*store, "/f", 0, std::string(block, 'e'), 0) ==
+                    block);
+            REQUIRE(read(*store, "/f", 24) == last);
+            REQUIRE(read(*store, "/f", 0) == std::string(block, 'e'));
+        }
+
+        THEN("A stale extent log is rewritten while chunks are written") {
+            for(gkfs::rpc::chnk_id_t chunk = 0; chunk < 1000; chunk++) {
+                write(*store, "/t", chunk, std::string(10, 't'), 0);
+                store->remove("/t", chunk);
+            }
+            std::thread writer([&] {
+                for(gkfs::rpc::chnk_id_t chunk = 0; chunk < 200; chunk++)
+                    write(*store, "/w", chunk, std::to_string(chunk), 0);
+            });
+            store->compact();
+            writer.join();
+            store.reset();
+            store = std::make_unique<ContainerStore>(dir, chunksize,
+                                                     null_logger());
+            for(gkfs::rpc::chnk_id_t chunk = 0; chunk < 200; chunk++)
+                REQUIRE(read(*store, "/w", chunk) == std::to_string(chunk));
+            REQUIRE_THROWS_AS(read(*store, "/t", 0), ChunkStorageException);
+        }
+
+        THEN("The extent index is reloaded after a restart") {
+            write(*store, "/f", 0, std::string(100, 'a'), 0);
+            write(*store, "/f", 1, std::string(3 * block, 'b'), 0);
+            write(*store, "/g", 0, std::string(10, 'c'), 0);
+            store->truncate("/f", 1, block + 1);
+            store->remove("/g", 0);
+            auto free_before = store->free_bytes();
+            store.reset();
+            store = std::make_unique<ContainerStore>(dir, chunksize,
+                                                     null_logger());
+            REQUIRE(read(*store, "/f", 0) == std::string(100, 'a'));
+            REQUIRE(read(*store, "/f", 1) == std::string(block + 1, 'b'));
+            REQUIRE_THROWS_AS(read(*store, "/g", 0), ChunkStorageException);
+            REQUIRE(store->free_bytes() == free_before);
+            // new chunks do not overwrite reloaded ones
+            write(*store, "/h", 0, std::string(block, 'd'), 0);
+            write(*store, "/f", 8, std::string(block, 'e'), 0);
+            REQUIRE(read(*store, "/f", 0) == std::string(100, 'a'));
+            REQUIRE(read(*store, "/f", 1) == std::string(block + 1, 'b'));
+        }
+    }
+}
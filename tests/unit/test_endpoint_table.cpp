@@ -0,0 +1,140 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <client/rpc/endpoint_table.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gkfs::rpc;
+
+SCENARIO("daemon endpoints are looked up on first use", "[endpoints]") {
+
+    GIVEN("A table of four hosts") {
+        std::vector<std::string> uris{"h0", "h1", "h2", "bad"};
+        std::atomic<int> lookups{0};
+        EndpointTable<std::string> table(uris, [&](const std::string& uri) {
+            lookups++;
+            if(uri == "bad")
+                throw std::runtime_error("lookup failed");
+            return "resolved:" + uri;
+        });
+
+        THEN("Nothing is looked up before it is used") {
+            REQUIRE(table.size() == 4);
+            REQUIRE(lookups == 0);
+            REQUIRE(table.resolved() == 0);
+        }
+
+        THEN("A host is looked up only once") {
+            REQUIRE(table.get(1) == "resolved:h1");
+            REQUIRE(table.get(1) == "resolved:h1");
+            REQUIRE(lookups == 1);
+            REQUIRE(table.resolved() == 1);
+            REQUIRE_FALSE(table.get(4));
+        }
+
+        THEN("A failed lookup returns no endpoint and is tried again") {
+            REQUIRE_FALSE(table.get(3));
+            REQUIRE_FALSE(table.get(3));
+            REQUIRE(lookups == 2);
+            REQUIRE(table.resolved() == 0);
+        }
+
+        WHEN("All hosts are resolved in the background") {
+            std::vector<size_t> order(uris.size());
+            std::iota(order.begin(), order.end(), 0);
+            table.resolve_all(2, order);
+            table.wait();
+
+            THEN("Every host is looked up once and failures are counted") {
+                REQUIRE(lookups == 4);
+                REQUIRE(table.resolved() == 3);
+                REQUIRE(table.failed() == 1);
+                std::vector<std::string> endpoints;
+                for(size_t id = 0; id < 3; id++)
+                    endpoints.push_back(*table.get(id));
+                REQUIRE(endpoints.back() == "resolved:h2");
+                REQUIRE(lookups == 4);
+            }
+        }
+    }
+
+    GIVEN("Concurrent users of a host whose first lookup fails") {
+        std::atomic<int> lookups{0};
+        EndpointTable<std::string> table(
+                std::vector<std::string>(1, "h"),
+                [&](const std::string& uri) {
+                    // let the other users queue up behind the first lookup
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    if(lookups++ == 0)
+                        throw std::runtime_error("lookup failed");
+                    return uri;
+                });
+        std::atomic<int> found{0};
+        std::vector<std::thread> users;
+        for(int t = 0; t < 8; t++)
+            users.emplace_back([&] {
+                if(table.get(0))
+                    found++;
+            });
+        for(auto& user : users)
+            user.join();
+
+        THEN("A waiting user retries the lookup and the others reuse it") {
+            REQUIRE(lookups == 2);
+            REQUIRE(found == 7);
+            REQUIRE(table.get(0) == "h");
+            REQUIRE(table.resolved() == 1);
+        }
+    }
+
+    GIVEN("Many concurrent users of one host") {
+        std::atomic<int> lookups{0};
+        EndpointTable<std::string> table(
+                std::vector<std::string>(64, "h"),
+                [&](const std::string& uri) {
+                    lookups++;
+                    return uri;
+                });
+        std::vector<size_t> order(64, 0);
+        table.resolve_all(8, order);
+        table.wait();
+
+        THEN("The host is looked up once") {
+            REQUIRE(lookups == 1);
+            REQUIRE(table.resolved() == 1);
+        }
+    }
+}
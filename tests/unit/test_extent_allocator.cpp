@@ -0,0 +1,98 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <daemon/backend/data/extent_allocator.hpp>
+
+using namespace gkfs::data;
+
+SCENARIO("container space is allocated and reclaimed", "[extent_allocator]") {
+
+    GIVEN("An empty allocator") {
+        ExtentAllocator alloc{};
+
+        THEN("Ranges are appended to the end") {
+            REQUIRE(alloc.allocate(4096) == 0);
+            REQUIRE(alloc.allocate(8192) == 4096);
+            REQUIRE(alloc.end() == 12288);
+            REQUIRE(alloc.free_bytes() == 0);
+        }
+
+        THEN("Released ranges are reused with best fit") {
+            auto a = alloc.allocate(8192);
+            alloc.allocate(4096);
+            auto c = alloc.allocate(4096);
+            alloc.allocate(4096);
+            alloc.release(a, 8192);
+            alloc.release(c, 4096);
+            REQUIRE(alloc.free_bytes() == 12288);
+            // the smaller hole fits exactly
+            REQUIRE(alloc.allocate(4096) == c);
+            // the remainder of a split hole stays free
+            REQUIRE(alloc.allocate(4096) == a);
+            REQUIRE(alloc.free_bytes() == 4096);
+            REQUIRE(alloc.end() == 20480);
+        }
+
+        THEN("Neighboring free ranges are coalesced and shrink the end") {
+            auto a = alloc.allocate(4096);
+            auto b = alloc.allocate(4096);
+            auto c = alloc.allocate(4096);
+            alloc.release(a, 4096);
+            alloc.release(b, 4096);
+            REQUIRE(alloc.free_bytes() == 8192);
+            REQUIRE(alloc.allocate(8192) == a);
+            alloc.release(a, 8192);
+            alloc.release(c, 4096);
+            REQUIRE(alloc.end() == 0);
+            REQUIRE(alloc.free_bytes() == 0);
+        }
+
+        THEN("Free ranges above a limit are not used for compaction") {
+            alloc.allocate(4096);
+            auto b = alloc.allocate(4096);
+            auto c = alloc.allocate(4096);
+            alloc.allocate(4096);
+            alloc.release(c, 4096);
+            REQUIRE(!alloc.allocate_free(4096, b));
+            REQUIRE(alloc.allocate_free(4096, c + 1) == c);
+        }
+    }
+
+    GIVEN("Ranges loaded from the extent index") {
+        ExtentAllocator alloc{};
+        alloc.rebuild({{8192, 4096}, {0, 4096}, {20480, 4096}});
+
+        THEN("Gaps between them are free") {
+            REQUIRE(alloc.end() == 24576);
+            REQUIRE(alloc.free_bytes() == 12288);
+            REQUIRE(alloc.allocate(8192) == 12288);
+            REQUIRE(alloc.allocate(4096) == 4096);
+        }
+    }
+}
@@ -0,0 +1,123 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <client/host_segment.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+using namespace gkfs::utils;
+
+namespace {
+
+void
+write_file(const std::string& path, const std::string& content) {
+    std::ofstream f(path, std::ios::trunc);
+    f << content;
+}
+
+} // namespace
+
+SCENARIO("clients share the parsed hosts files", "[host_segment]") {
+
+    GIVEN("A hosts file and a hosts config file") {
+        auto dir = std::string("/tmp/gkfs_host_segment_") +
+                   std::to_string(getpid());
+        auto hostfile = dir + "_hosts.txt";
+        auto hostconfigfile = dir + "_hosts_config.txt";
+        write_file(hostfile, "node0 ofi+tcp://10.0.0.1:4433\n"
+                             "node1 ofi+tcp://10.0.0.2:4433\n");
+        write_file(hostconfigfile, "2 1\n");
+
+        HostSegment segment(hostfile, hostconfigfile);
+        segment.remove();
+        HostTable table{{{"node0", "ofi+tcp://10.0.0.1:4433"},
+                         {"node1", "ofi+tcp://10.0.0.2:4433"}},
+                        {2},
+                        {1}};
+
+        THEN("Nothing can be loaded before the table is published") {
+            REQUIRE(segment.epoch() != 0);
+            REQUIRE_FALSE(segment.load(segment.epoch()));
+        }
+
+        WHEN("The table is published") {
+            auto epoch = segment.epoch();
+            REQUIRE(segment.publish(epoch, table));
+
+            THEN("Another process loads the same table") {
+                HostSegment other(hostfile, hostconfigfile);
+                REQUIRE(other.name() == segment.name());
+                auto loaded = other.load(other.epoch());
+                REQUIRE(loaded);
+                REQUIRE(loaded->hosts == table.hosts);
+                REQUIRE(loaded->fs_sizes == table.fs_sizes);
+                REQUIRE(loaded->priorities == table.priorities);
+            }
+
+            THEN("It is published only once") {
+                REQUIRE_FALSE(segment.publish(epoch, table));
+            }
+
+            AND_WHEN("The hosts file changes") {
+                // make sure that the mtime differs on coarse clocks
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                write_file(hostfile, "node0 ofi+tcp://10.0.0.1:4433\n");
+                auto new_epoch = segment.epoch();
+
+                THEN("The stale table is not loaded and is replaced") {
+                    REQUIRE(new_epoch != epoch);
+                    REQUIRE_FALSE(segment.load(new_epoch));
+                    table.hosts.pop_back();
+                    REQUIRE(segment.publish(new_epoch, table));
+                    auto loaded = segment.load(new_epoch);
+                    REQUIRE(loaded);
+                    REQUIRE(loaded->hosts.size() == 1);
+                }
+            }
+        }
+
+        WHEN("A hosts file does not exist") {
+            unlink(hostconfigfile.c_str());
+
+            THEN("There is no epoch and nothing is published") {
+                REQUIRE(segment.epoch() == 0);
+                REQUIRE_FALSE(segment.publish(0, table));
+            }
+        }
+
+        segment.remove();
+        unlink(hostfile.c_str());
+        unlink(hostconfigfile.c_str());
+    }
+}
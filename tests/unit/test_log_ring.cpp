@@ -0,0 +1,146 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <client/log_ring.hpp>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gkfs::log;
+
+namespace {
+
+bool
+push(ring_buffer& ring, const std::string& text) {
+    auto header = ring.reserve(text.size());
+    if(header == nullptr)
+        return false;
+    header->kind = record_kind::message;
+    std::memcpy(header + 1, text.data(), text.size());
+    ring.commit(header);
+    return true;
+}
+
+std::vector<std::string>
+drain(ring_buffer& ring) {
+    std::vector<std::string> out;
+    ring.consume([&](const record_header& header, const char* payload) {
+        out.emplace_back(payload, header.length);
+    });
+    return out;
+}
+
+} // namespace
+
+SCENARIO("log records pass through a ring buffer", "[log_ring]") {
+
+    GIVEN("A ring of 256 bytes") {
+        ring_buffer ring(256);
+        REQUIRE(ring.capacity() == 256);
+        REQUIRE(ring.empty());
+
+        WHEN("Records are committed") {
+            REQUIRE(push(ring, "first"));
+            REQUIRE(push(ring, "second"));
+
+            THEN("They are consumed in order") {
+                REQUIRE(drain(ring) == std::vector<std::string>{"first",
+                                                                "second"});
+                REQUIRE(ring.empty());
+            }
+        }
+
+        WHEN("The ring is full") {
+            int pushed = 0;
+            while(push(ring, std::string(40, 'x')))
+                pushed++;
+
+            THEN("Records are dropped and counted") {
+                REQUIRE(pushed == 4);
+                REQUIRE(ring.take_dropped() == 1);
+                REQUIRE(ring.take_dropped() == 0);
+                REQUIRE(drain(ring).size() == 4);
+            }
+        }
+
+        WHEN("Records wrap around the end of the ring") {
+            std::vector<std::string> expected;
+            for(int i = 0; i < 100; i++) {
+                auto text = std::string(static_cast<size_t>(i % 50 + 1),
+                                        static_cast<char>('a' + i % 26));
+                REQUIRE(push(ring, text));
+                expected.push_back(text);
+                if(i % 2 == 1) {
+                    auto out = drain(ring);
+                    REQUIRE(out == std::vector<std::string>(expected.end() - 2,
+                                                            expected.end()));
+                }
+            }
+
+            THEN("No record is torn or lost") {
+                REQUIRE(ring.empty());
+            }
+        }
+
+        WHEN("A record is larger than half of the ring") {
+            THEN("It is dropped") {
+                REQUIRE_FALSE(push(ring, std::string(200, 'x')));
+            }
+        }
+    }
+
+    GIVEN("A producer and a consumer thread") {
+        ring_buffer ring(4096);
+        const int count = 100000;
+
+        std::thread producer([&] {
+            for(int i = 0; i < count;) {
+                if(push(ring, std::to_string(i)))
+                    i++;
+            }
+        });
+
+        int next = 0;
+        bool in_order = true;
+        while(next < count) {
+            ring.consume([&](const record_header& header, const char* payload) {
+                in_order &= std::string(payload, header.length) ==
+                            std::to_string(next++);
+            });
+        }
+        producer.join();
+
+        THEN("All records arrive in order") {
+            REQUIRE(in_order);
+            REQUIRE(next == count);
+        }
+    }
+}
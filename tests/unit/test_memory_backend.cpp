@@ -0,0 +1,130 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <daemon/backend/metadata/memory_backend.hpp>
+#include <common/metadata.hpp>
+
+#include <algorithm>
+#include <thread>
+
+extern "C" {
+#include <sys/stat.h>
+}
+
+using namespace gkfs::metadata;
+
+SCENARIO("metadata is kept in memory", "[metadata][memory]") {
+
+    GIVEN("An empty in-memory backend") {
+        MemoryBackend db("/tmp");
+        const auto file_md = Metadata(S_IFREG | 0644).serialize();
+        const auto dir_md = Metadata(S_IFDIR | 0755).serialize();
+
+        THEN("Entries are created, found, and removed") {
+            db.put_no_exist("/f", file_md);
+            REQUIRE(db.exists("/f"));
+            REQUIRE(db.get("/f") == file_md);
+            REQUIRE_THROWS_AS(db.put_no_exist("/f", dir_md), ExistsException);
+            // like a create merge operand, put keeps an existing entry
+            db.put("/f", dir_md);
+            REQUIRE(db.get("/f") == file_md);
+            db.remove("/f");
+            REQUIRE(!db.exists("/f"));
+            REQUIRE_THROWS_AS(db.get("/f"), NotFoundException);
+            REQUIRE_NOTHROW(db.remove("/f"));
+        }
+
+        THEN("Sizes are updated as by the merge operator") {
+            db.put("/s", file_md);
+            REQUIRE(db.increase_size("/s", 100, 0, false, 0) == -1);
+            REQUIRE(Metadata(db.get("/s")).size() == 100);
+            // writes before the end do not shrink the file
+            db.increase_size("/s", 10, 20, false, 0);
+            REQUIRE(Metadata(db.get("/s")).size() == 100);
+            // appends start at the current size
+            REQUIRE(db.increase_size("/s", 50, 0, true, 0) == 100);
+            REQUIRE(Metadata(db.get("/s")).size() == 150);
+            db.decrease_size("/s", 30);
+            REQUIRE(Metadata(db.get("/s")).size() == 30);
+            REQUIRE_THROWS_AS(db.increase_size("/missing", 1, 0, false, 0),
+                              NotFoundException);
+        }
+
+        THEN("Inline data of small files is kept until they grow") {
+            db.put("/i", file_md);
+            db.increase_size("/i", 5, 0, false, 5, "hello");
+            db.increase_size("/i", 6, 0, true, 6, " world");
+            Metadata md(db.get("/i"));
+            REQUIRE(md.use_buf());
+            REQUIRE(md.buf() == "hello world");
+            db.increase_size("/i", gkfs::config::rpc::smallfilesize, 11, false,
+                             0);
+            md = Metadata(db.get("/i"));
+            REQUIRE(!md.use_buf());
+            REQUIRE(md.buf().empty());
+        }
+
+        THEN("Directory scans return first-level entries in name order") {
+            db.put("/d", dir_md);
+            db.put("/d/b", file_md);
+            db.put("/d/a", dir_md);
+            db.put("/d/a/deep", file_md);
+            db.put("/dx", file_md);
+            auto entries = db.get_dirents("/d/");
+            REQUIRE(entries.size() == 2);
+            REQUIRE(entries[0] == std::make_pair(std::string("a"), true));
+            REQUIRE(entries[1] == std::make_pair(std::string("b"), false));
+            auto root = db.get_dirents("/");
+            REQUIRE(root.size() == 2);
+            db.update("/d/b", "/d/c", file_md);
+            entries = db.get_dirents("/d/");
+            REQUIRE(entries.size() == 2);
+            REQUIRE(entries[1].first == "c");
+            db.remove("/d/a");
+            auto extended = db.get_dirents_extended("/d/");
+            REQUIRE(extended.size() == 1);
+            REQUIRE(std::get<0>(extended[0]) == "c");
+        }
+
+        THEN("Concurrent appends get distinct offsets") {
+            db.put("/p", file_md);
+            std::vector<std::thread> threads;
+            std::vector<off_t> offsets(8);
+            for(size_t t = 0; t < offsets.size(); t++)
+                threads.emplace_back([&, t] {
+                    offsets[t] = db.increase_size("/p", 10000, 0, true, 0);
+                });
+            for(auto& thread : threads)
+                thread.join();
+            std::sort(offsets.begin(), offsets.end());
+            for(size_t t = 0; t < offsets.size(); t++)
+                REQUIRE(offsets[t] == static_cast<off_t>(t * 10000));
+        }
+    }
+}
@@ -0,0 +1,188 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <client/open_file_map.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <fcntl.h>
+}
+
+using namespace gkfs::filemap;
+
+namespace {
+
+std::shared_ptr<OpenFile>
+make_file(const std::string& path) {
+    return std::make_shared<OpenFile>(path, O_RDWR);
+}
+
+} // namespace
+
+SCENARIO("open files are kept in an fd-indexed table", "[open_file_map]") {
+
+    GIVEN("A table with 64 slots") {
+        OpenFileMap map(64);
+        auto file = make_file("/a");
+
+        WHEN("A file is added") {
+            auto fd = map.add(file);
+
+            THEN("It is found by its fd until it is removed") {
+                REQUIRE(map.exist(fd));
+                REQUIRE(map.get(fd) == file);
+                REQUIRE(map.remove(fd));
+                REQUIRE_FALSE(map.exist(fd));
+                REQUIRE(map.get(fd) == nullptr);
+                REQUIRE_FALSE(map.remove(fd));
+            }
+
+            THEN("A closed fd is not handed out again right away") {
+                REQUIRE(map.remove(fd));
+                REQUIRE(map.add(make_file("/b")) != fd);
+            }
+
+            THEN("dup() returns a new fd sharing the open file") {
+                auto dup_fd = map.dup(fd);
+                REQUIRE(dup_fd != fd);
+                REQUIRE(map.get(dup_fd) == file);
+                map.get(dup_fd)->pos(42);
+                REQUIRE(map.get(fd)->pos() == 42);
+                REQUIRE(map.remove(fd));
+                REQUIRE(map.get(dup_fd) == file);
+            }
+
+            THEN("dup2() replaces an fd in use") {
+                auto other_fd = map.add(make_file("/b"));
+                REQUIRE(map.dup2(fd, other_fd) == other_fd);
+                REQUIRE(map.get(other_fd) == file);
+            }
+
+            THEN("dup2() onto a free fd claims it") {
+                auto free_fd = fd + 10;
+                REQUIRE_FALSE(map.exist(free_fd));
+                REQUIRE(map.dup2(fd, free_fd) == free_fd);
+                REQUIRE(map.get(free_fd) == file);
+                // add() does not hand out the claimed fd
+                std::set<int> fds;
+                for(int i = 0; i < 62; i++)
+                    fds.insert(map.add(make_file("/c")));
+                REQUIRE(fds.count(free_fd) == 0);
+                REQUIRE(map.get(free_fd) == file);
+            }
+
+            THEN("dup2() onto an fd outside of the table works") {
+                REQUIRE(map.dup2(fd, 3) == 3);
+                REQUIRE(map.get(3) == file);
+                REQUIRE(map.remove(3));
+                REQUIRE_FALSE(map.exist(3));
+            }
+
+            THEN("dup() and dup2() of an unknown fd fail with EBADF") {
+                errno = 0;
+                REQUIRE(map.dup(fd + 1) == -1);
+                REQUIRE(errno == EBADF);
+                errno = 0;
+                REQUIRE(map.dup2(fd + 1, fd + 2) == -1);
+                REQUIRE(errno == EBADF);
+            }
+        }
+
+        WHEN("More files are added than the table holds") {
+            std::vector<int> fds;
+            for(int i = 0; i < 66; i++)
+                fds.push_back(map.add(make_file("/f" + std::to_string(i))));
+
+            THEN("The remaining files get fds after the table") {
+                std::set<int> unique(fds.begin(), fds.end());
+                REQUIRE(unique.size() == fds.size());
+                REQUIRE(fds[64] == fds[0] + 64);
+                REQUIRE(fds[65] == fds[0] + 65);
+                for(size_t i = 0; i < fds.size(); i++)
+                    REQUIRE(map.get(fds[i])->path() ==
+                            "/f" + std::to_string(i));
+            }
+
+            THEN("Files after the table can be removed") {
+                REQUIRE(map.remove(fds[64]));
+                REQUIRE_FALSE(map.exist(fds[64]));
+                REQUIRE(map.exist(fds[65]));
+            }
+
+            THEN("A freed slot of the table is used again") {
+                REQUIRE(map.remove(fds[7]));
+                REQUIRE(map.add(make_file("/g")) == fds[7]);
+            }
+        }
+    }
+
+    GIVEN("Threads that add, remove and dup2() concurrently") {
+        OpenFileMap map(64);
+        auto file = make_file("/a");
+        auto src = map.add(file);
+        auto target = src + 1;
+        std::atomic<bool> failed{false};
+
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 2; t++)
+            threads.emplace_back([&] {
+                for(int i = 0; i < 20000; i++) {
+                    auto own = make_file("/own");
+                    auto fd = map.add(own);
+                    // only target is replaced by the other threads
+                    if(fd != target && map.get(fd) != own)
+                        failed = true;
+                    map.remove(fd);
+                }
+            });
+        threads.emplace_back([&] {
+            for(int i = 0; i < 20000; i++)
+                map.dup2(src, target);
+        });
+        threads.emplace_back([&] {
+            for(int i = 0; i < 20000; i++)
+                map.remove(target);
+        });
+        for(auto& thread : threads)
+            thread.join();
+
+        THEN("Every fd with a file is marked as used") {
+            REQUIRE_FALSE(failed);
+            auto used = map.exist(target);
+            REQUIRE(map.remove(target) == used);
+            REQUIRE(map.get(src) == file);
+        }
+    }
+}
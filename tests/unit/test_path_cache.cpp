@@ -0,0 +1,112 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <client/path_cache.hpp>
+
+#include <string>
+#include <thread>
+
+using namespace gkfs::path;
+using namespace std::chrono_literals;
+
+SCENARIO("resolved paths are cached per cwd generation", "[path_cache]") {
+
+    GIVEN("A cache with room for two paths") {
+        PathCache cache(2, 10s);
+        PathCache::kind type;
+        std::string target;
+
+        WHEN("A directory and a link are inserted") {
+            cache.insert("/usr", 1, PathCache::kind::directory);
+            cache.insert("/lib", 1, PathCache::kind::link, "/usr/lib");
+
+            THEN("Both are found in the same generation") {
+                REQUIRE(cache.lookup("/usr", 1, type));
+                REQUIRE(type == PathCache::kind::directory);
+                REQUIRE(cache.lookup("/lib", 1, type, &target));
+                REQUIRE(type == PathCache::kind::link);
+                REQUIRE(target == "/usr/lib");
+                REQUIRE(cache.stats().hits == 2);
+            }
+
+            THEN("Nothing is found in another generation") {
+                REQUIRE_FALSE(cache.lookup("/usr", 2, type));
+                REQUIRE(cache.stats().misses == 1);
+            }
+
+            THEN("Inserting in a new generation discards the old entries") {
+                cache.insert("/etc", 2, PathCache::kind::directory);
+                REQUIRE(cache.size() == 1);
+                REQUIRE(cache.lookup("/etc", 2, type));
+                REQUIRE_FALSE(cache.lookup("/usr", 2, type));
+            }
+
+            THEN("The cache does not grow beyond its capacity") {
+                cache.insert("/etc/passwd", 1, PathCache::kind::other);
+                REQUIRE(cache.size() == 2);
+                REQUIRE(cache.lookup("/etc/passwd", 1, type));
+                REQUIRE(type == PathCache::kind::other);
+            }
+
+            THEN("Clearing removes all entries") {
+                cache.clear();
+                REQUIRE(cache.size() == 0);
+                REQUIRE_FALSE(cache.lookup("/usr", 1, type));
+            }
+        }
+    }
+
+    GIVEN("A cache whose entries expire after 10ms") {
+        PathCache cache(2, 10ms);
+        PathCache::kind type;
+        cache.insert("/lib", 1, PathCache::kind::directory);
+
+        THEN("Entries are looked up again once expired") {
+            REQUIRE(cache.lookup("/lib", 1, type));
+            std::this_thread::sleep_for(20ms);
+            REQUIRE_FALSE(cache.lookup("/lib", 1, type));
+            // e.g., replaced by a link in the meantime
+            cache.insert("/lib", 1, PathCache::kind::link, "/usr/lib");
+            REQUIRE(cache.lookup("/lib", 1, type));
+            REQUIRE(type == PathCache::kind::link);
+            REQUIRE(cache.size() == 1);
+        }
+    }
+
+    GIVEN("A disabled cache") {
+        PathCache cache(0, 10s);
+        PathCache::kind type;
+        cache.insert("/usr", 1, PathCache::kind::directory);
+
+        THEN("Nothing is cached") {
+            REQUIRE(cache.size() == 0);
+            REQUIRE_FALSE(cache.lookup("/usr", 1, type));
+        }
+    }
+}
@@ -0,0 +1,115 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+#include <catch2/catch.hpp>
+#include <common/rpc/placement.hpp>
+
+using namespace gkfs::rpc;
+
+SCENARIO("new paths are placed on a file system of a federated mount",
+         "[placement]") {
+
+    const std::vector<unsigned int> hosts_size{2, 4, 2};
+    std::vector<FsLoad> loads{{100, 10, 8}, {100, 80, 8}, {100, 40, 1}};
+    int fetches = 0;
+    auto fetcher = [&]() {
+        fetches++;
+        return loads;
+    };
+
+    GIVEN("The local first policy") {
+        auto policy = make_placement_policy("local", 2, hosts_size, fetcher);
+        REQUIRE(policy);
+
+        THEN("Every path goes to the local file system") {
+            REQUIRE(policy->place("/a", false) == 2);
+            REQUIRE(policy->place("/b/c", false) == 2);
+            REQUIRE(!policy->follows_parent());
+            REQUIRE(fetches == 0);
+        }
+    }
+
+    GIVEN("The round robin policy") {
+        auto policy =
+                make_placement_policy("roundrobin", 1, hosts_size, fetcher);
+        REQUIRE(policy);
+
+        THEN("Directories are assigned in turn starting at the local fs") {
+            REQUIRE(policy->place("/d0", true) == 1);
+            REQUIRE(policy->place("/d1", true) == 2);
+            REQUIRE(policy->place("/d2", true) == 0);
+            REQUIRE(policy->place("/d3", true) == 1);
+            REQUIRE(policy->place("/d1/f", false) == 2);
+            REQUIRE(policy->place("/f", false) == 2);
+            REQUIRE(policy->place("/g", false) == 2);
+        }
+    }
+
+    GIVEN("The capacity aware policy") {
+        auto policy = make_placement_policy("capacity", 0, hosts_size, fetcher);
+        REQUIRE(policy);
+
+        THEN("The file system with the most free chunks is chosen") {
+            REQUIRE(policy->place("/a", false) == 1);
+            REQUIRE(policy->place("/b", false) == 1);
+            // stats are cached within the refresh interval
+            REQUIRE(fetches == 1);
+        }
+    }
+
+    GIVEN("The load aware policy") {
+        auto policy = make_placement_policy("load", 0, hosts_size, fetcher);
+        REQUIRE(policy);
+
+        THEN("The file system with the shortest queues per daemon is chosen") {
+            // per daemon: 4, 2, 0.5
+            REQUIRE(policy->place("/a", false) == 2);
+            REQUIRE(policy->place("/b", false) == 2);
+            REQUIRE(policy->place("/c", false) == 2);
+            // 2.0 on fs 2 ties with fs 1, placements are counted as load
+            REQUIRE(policy->place("/d", false) == 1);
+        }
+    }
+
+    GIVEN("A load based policy without stats") {
+        auto policy = make_placement_policy(
+                "capacity", 2, hosts_size,
+                []() { return std::vector<FsLoad>{}; });
+
+        THEN("The local file system is used") {
+            REQUIRE(policy->place("/a", false) == 2);
+        }
+    }
+
+    GIVEN("An unknown policy name") {
+        THEN("No policy is created") {
+            REQUIRE(!make_placement_policy("random", 0, hosts_size, fetcher));
+        }
+    }
+}
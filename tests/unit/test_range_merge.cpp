@@ -0,0 +1,81 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <daemon/scheduler/range_merge.hpp>
+
+using namespace gkfs::data;
+
+SCENARIO("queued chunk writes are merged by offset", "[io_scheduler]") {
+
+    GIVEN("Adjacent writes arriving out of order") {
+        std::vector<io_range> ranges{{200, 100}, {0, 100}, {100, 100}};
+        auto groups = merge_ranges(ranges);
+
+        THEN("They are merged into one ordered, non-overlapping write") {
+            REQUIRE(groups.size() == 1);
+            REQUIRE(groups[0].offset == 0);
+            REQUIRE(groups[0].size == 300);
+            REQUIRE(groups[0].members == std::vector<size_t>{1, 2, 0});
+            REQUIRE(!groups[0].overlapping);
+        }
+    }
+
+    GIVEN("Writes separated by a gap") {
+        std::vector<io_range> ranges{{0, 100}, {101, 50}, {500, 10}};
+        auto groups = merge_ranges(ranges);
+
+        THEN("Each write is issued on its own") {
+            REQUIRE(groups.size() == 3);
+            REQUIRE(groups[1].offset == 101);
+            REQUIRE(groups[1].size == 50);
+            REQUIRE(groups[2].members == std::vector<size_t>{2});
+        }
+    }
+
+    GIVEN("Overlapping writes") {
+        std::vector<io_range> ranges{{50, 100}, {0, 100}, {50, 10}, {300, 1}};
+        auto groups = merge_ranges(ranges);
+
+        THEN("They are merged and flagged as overlapping") {
+            REQUIRE(groups.size() == 2);
+            REQUIRE(groups[0].offset == 0);
+            REQUIRE(groups[0].size == 150);
+            // same offset keeps arrival order
+            REQUIRE(groups[0].members == std::vector<size_t>{1, 0, 2});
+            REQUIRE(groups[0].overlapping);
+            REQUIRE(!groups[1].overlapping);
+        }
+    }
+
+    GIVEN("No writes") {
+        THEN("Nothing is planned") {
+            REQUIRE(merge_ranges({}).empty());
+        }
+    }
+}
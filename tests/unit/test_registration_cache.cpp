@@ -0,0 +1,137 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <client/rpc/registration_cache.hpp>
+
+#include <vector>
+
+using namespace gkfs::rpc;
+
+SCENARIO("registrations of reused buffers are cached", "[reg_cache]") {
+
+    GIVEN("A cache with room for two registrations") {
+        RegistrationCache<int> cache(2, 1024 * 1024);
+        std::vector<char> a(4096), b(4096), c(4096);
+
+        cache.insert(a.data(), a.size(), 0, 1);
+        cache.insert(b.data(), b.size(), 0, 2);
+
+        THEN("A buffer with the same start, size, and mode hits") {
+            REQUIRE(cache.lookup(a.data(), 4096, 0) == 1);
+            REQUIRE(cache.lookup(b.data(), 4096, 0) == 2);
+            REQUIRE(cache.stats().hits == 2);
+        }
+
+        THEN("Other sizes, modes, or inner addresses miss") {
+            REQUIRE(!cache.lookup(a.data(), 100, 0));
+            REQUIRE(!cache.lookup(a.data(), 4096, 1));
+            REQUIRE(!cache.lookup(a.data() + 1, 10, 0));
+            REQUIRE(cache.stats().misses == 3);
+        }
+
+        WHEN("A third buffer is registered") {
+            REQUIRE(cache.lookup(a.data(), 4096, 0) == 1);
+            cache.insert(c.data(), c.size(), 0, 3);
+
+            THEN("The least recently used registration is evicted") {
+                REQUIRE(cache.size() == 2);
+                REQUIRE(!cache.lookup(b.data(), 4096, 0));
+                REQUIRE(cache.lookup(a.data(), 4096, 0) == 1);
+                REQUIRE(cache.lookup(c.data(), 4096, 0) == 3);
+                REQUIRE(cache.stats().evictions == 1);
+            }
+        }
+    }
+
+    GIVEN("A cache limited by bytes") {
+        RegistrationCache<int> cache(16, 8192);
+        std::vector<char> a(8192), b(4096);
+
+        cache.insert(a.data(), a.size(), 0, 1);
+        cache.insert(b.data(), b.size(), 0, 2);
+
+        THEN("Registrations are evicted until the new one fits") {
+            REQUIRE(cache.size() == 1);
+            REQUIRE(cache.bytes() == 4096);
+            REQUIRE(cache.lookup(b.data(), 4096, 0) == 2);
+        }
+
+        THEN("Registrations larger than the limit are not cached") {
+            std::vector<char> big(16384);
+            cache.insert(big.data(), big.size(), 0, 3);
+            REQUIRE(!cache.lookup(big.data(), big.size(), 0));
+        }
+    }
+}
+
+SCENARIO("unmapped memory invalidates registrations", "[reg_cache]") {
+
+    GIVEN("Registrations of three parts of one region") {
+        RegistrationCache<int> cache(16, 1024 * 1024);
+        std::vector<char> region(3 * 4096);
+        auto* base = region.data();
+
+        cache.insert(base, 4096, 0, 1);
+        cache.insert(base + 4096, 4096, 0, 2);
+        cache.insert(base + 4096, 4096, 1, 3);
+        cache.insert(base + 8192, 4096, 0, 4);
+
+        WHEN("The middle part is unmapped") {
+            auto dropped = cache.invalidate(base + 4096, 4096);
+
+            THEN("Only registrations overlapping it are dropped") {
+                REQUIRE(dropped == 2);
+                REQUIRE(cache.lookup(base, 4096, 0) == 1);
+                REQUIRE(!cache.lookup(base + 4096, 4096, 0));
+                REQUIRE(!cache.lookup(base + 4096, 4096, 1));
+                REQUIRE(cache.lookup(base + 8192, 4096, 0) == 4);
+            }
+        }
+
+        WHEN("A range ending inside the first part is unmapped") {
+            auto dropped = cache.invalidate(base - 100, 200);
+
+            THEN("The registration reaching into it is dropped") {
+                REQUIRE(dropped == 1);
+                REQUIRE(!cache.lookup(base, 4096, 0));
+                REQUIRE(cache.size() == 3);
+            }
+        }
+
+        WHEN("A range starting in the last part is unmapped") {
+            auto dropped = cache.invalidate(base + 3 * 4096 - 1, 4096);
+
+            THEN("The registration reaching into it is dropped") {
+                REQUIRE(dropped == 1);
+                REQUIRE(!cache.lookup(base + 8192, 4096, 0));
+                REQUIRE(cache.stats().invalidations == 1);
+            }
+        }
+    }
+}
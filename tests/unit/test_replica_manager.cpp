@@ -0,0 +1,212 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+
+
+#include <catch2/catch.hpp>
+#include <daemon/classes/replica_manager.hpp>
+#include <common/statistics/stats.hpp>
+#include <config.hpp>
+
+#include <thread>
+
+using namespace gkfs::data;
+using namespace std::chrono_literals;
+
+SCENARIO("hot chunks are replicated and invalidated", "[replication]") {
+
+    const std::vector<uint64_t> hosts{2, 3};
+
+    GIVEN("A replica manager with a threshold of 3 reads") {
+        ReplicaManager rm(2, 3, 10s);
+
+        THEN("A chunk becomes hot once the threshold is reached") {
+            REQUIRE(rm.record_read("/f", 0, hosts) == 0);
+            REQUIRE(rm.record_read("/f", 0, hosts) == 0);
+            auto version = rm.record_read("/f", 0, hosts);
+            REQUIRE(version != 0);
+            // pending replications are not started twice
+            REQUIRE(rm.record_read("/f", 0, hosts) == 0);
+            REQUIRE(rm.replicated("/f", 0) == 0);
+            REQUIRE(rm.replication_done("/f", 0, version));
+            REQUIRE(rm.replicated("/f", 0) == 2);
+        }
+
+        THEN("A write invalidates the replicas") {
+            for(int reads = 1; reads < 3; reads++)
+                rm.record_read("/f", 1, hosts);
+            auto version = rm.record_read("/f", 1, hosts);
+            REQUIRE(rm.replication_done("/f", 1, version));
+            auto set = rm.invalidate("/f", 1);
+            REQUIRE(set.hosts == hosts);
+            REQUIRE(set.version > version);
+            REQUIRE(rm.replicated("/f", 1) == 0);
+            // nothing left to invalidate
+            REQUIRE(rm.invalidate("/f", 1).hosts.empty());
+            // not hot again before the replica daemons were notified
+            for(int reads = 0; reads < 3; reads++)
+                REQUIRE(rm.record_read("/f", 1, hosts) == 0);
+            rm.invalidation_done("/f", 1, set.version);
+            for(int reads = 1; reads < 3; reads++)
+                REQUIRE(rm.record_read("/f", 1, hosts) == 0);
+            REQUIRE(rm.record_read("/f", 1, hosts) > set.version);
+        }
+
+        THEN("A replication finishing after an invalidation is discarded") {
+            for(int reads = 1; reads < 3; reads++)
+                rm.record_read("/f", 2, hosts);
+            auto version = rm.record_read("/f", 2, hosts);
+            REQUIRE(rm.invalidate("/f", 2).hosts == hosts);
+            REQUIRE(!rm.replication_done("/f", 2, version));
+            REQUIRE(rm.replicated("/f", 2) == 0);
+        }
+
+        THEN("A truncate invalidates all chunks from its start") {
+            for(uint64_t chunk = 0; chunk < 3; chunk++) {
+                rm.record_read("/t", chunk, hosts);
+                rm.record_read("/t", chunk, hosts);
+                auto version = rm.record_read("/t", chunk, hosts);
+                REQUIRE(rm.replication_done("/t", chunk, version));
+            }
+            auto sets = rm.invalidate_from("/t", 1);
+            REQUIRE(sets.size() == 2);
+            REQUIRE(rm.replicated("/t", 0) == 2);
+            REQUIRE(rm.replicated("/t", 1) == 0);
+            REQUIRE(rm.forget("/t").size() == 1);
+            REQUIRE(rm.replicated("/t", 0) == 0);
+        }
+    }
+
+    GIVEN("Replica managers of a daemon before and after a restart") {
+        auto version = ReplicaManager(1, 1, 10s).record_read("/f", 0, hosts);
+        ReplicaManager restarted(1, 1, 10s);
+
+        THEN("Versions keep increasing") {
+            REQUIRE(restarted.record_read("/f", 0, hosts) > version);
+        }
+    }
+
+    GIVEN("A replica manager tracking at most 4 chunks") {
+        ReplicaManager rm(1, 2, 10s, 4);
+
+        THEN("Replicated chunks are kept and new chunks are not tracked") {
+            for(uint64_t chunk = 0; chunk < 4; chunk++) {
+                rm.record_read("/f", chunk, hosts);
+                REQUIRE(rm.replication_done(
+                        "/f", chunk, rm.record_read("/f", chunk, hosts)));
+            }
+            REQUIRE(rm.record_read("/f", 4, hosts) == 0);
+            REQUIRE(rm.record_read("/f", 4, hosts) == 0);
+            REQUIRE(rm.replicated("/f", 0) == hosts.size());
+        }
+
+        THEN("Cold chunks make room for new ones") {
+            for(uint64_t chunk = 0; chunk < 4; chunk++)
+                rm.record_read("/f", chunk, hosts);
+            rm.record_read("/f", 4, hosts);
+            REQUIRE(rm.record_read("/f", 4, hosts) != 0);
+        }
+    }
+
+    GIVEN("A replica manager with a short window holding at most 4 copies") {
+        ReplicaManager rm(1, 2, 10ms, 4);
+
+        THEN("Copies invalidated more than a window ago are pruned") {
+            for(uint64_t chunk = 0; chunk < 4; chunk++)
+                rm.drop_copy("/c", chunk, 10);
+            REQUIRE(!rm.accept_copy("/c", 4, 5));
+            std::this_thread::sleep_for(20ms);
+            REQUIRE(rm.accept_copy("/c", 4, 5));
+            REQUIRE(rm.commit_copy("/c", 4, 5));
+            REQUIRE(rm.copy_version("/c", 4) == 5);
+        }
+    }
+
+    GIVEN("A replica manager with a short window") {
+        ReplicaManager rm(1, 3, 10ms);
+
+        THEN("Reads spread over several windows do not make a chunk hot") {
+            REQUIRE(rm.record_read("/f", 0, hosts) == 0);
+            REQUIRE(rm.record_read("/f", 0, hosts) == 0);
+            std::this_thread::sleep_for(20ms);
+            REQUIRE(rm.record_read("/f", 0, hosts) == 0);
+        }
+    }
+
+    GIVEN("Chunk statistics whose read sketch churns") {
+        // as in rpc_srv_read_data: the sketch is updated before the read is
+        // recorded for replication
+        gkfs::utils::Stats stats(true, false, "", "");
+        ReplicaManager rm(1, 3, 10s);
+        const auto cold_chunks = 4 * gkfs::config::stats::hot_chunks_tracked;
+
+        THEN("Cold chunks re-admitted to the sketch are not replicated") {
+            for(int round = 0; round < 2; round++) {
+                for(uint64_t chunk = 0; chunk < cold_chunks; chunk++) {
+                    stats.add_read("/c", chunk);
+                    REQUIRE(rm.record_read("/c", chunk, hosts) == 0);
+                }
+            }
+            // a chunk that is really read three times still is
+            stats.add_read("/c", 0);
+            REQUIRE(rm.record_read("/c", 0, hosts) != 0);
+        }
+    }
+
+    GIVEN("A daemon holding copies") {
+        ReplicaManager rm(2, 3, 10s);
+
+        THEN("Only valid copies of the current version are served") {
+            REQUIRE(rm.copy_version("/f", 0) == 0);
+            REQUIRE(rm.accept_copy("/f", 0, 5));
+            // not readable while being stored
+            REQUIRE(rm.copy_version("/f", 0) == 0);
+            REQUIRE(rm.commit_copy("/f", 0, 5));
+            REQUIRE(rm.copy_version("/f", 0) == 5);
+            rm.drop_copy("/f", 0, 6);
+            REQUIRE(rm.copy_version("/f", 0) == 0);
+            // a late push of an older version is rejected
+            REQUIRE(!rm.accept_copy("/f", 0, 5));
+            REQUIRE(rm.accept_copy("/f", 0, 7));
+        }
+
+        THEN("An invalidation overtaken by a newer push keeps the copy") {
+            REQUIRE(rm.accept_copy("/f", 2, 7));
+            REQUIRE(rm.commit_copy("/f", 2, 7));
+            rm.drop_copy("/f", 2, 6);
+            REQUIRE(rm.copy_version("/f", 2) == 7);
+        }
+
+        THEN("An invalidation during the transfer discards the copy") {
+            REQUIRE(rm.accept_copy("/f", 1, 5));
+            rm.drop_copy("/f", 1, 6);
+            REQUIRE(!rm.commit_copy("/f", 1, 5));
+            REQUIRE(rm.copy_version("/f", 1) == 0);
+        }
+    }
+}
@@ -0,0 +1,268 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <common/statistics/stats.hpp>
+
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gkfs::utils;
+
+SCENARIO(" latency histogram buckets bound the relative error ",
+         "[stats][histogram]") {
+
+    GIVEN(" the bucket of a value ") {
+
+        THEN(" small values are counted exactly ") {
+            for(uint64_t v = 0; v < LatencyHistogram::sub_buckets; v++) {
+                REQUIRE(LatencyHistogram::bucket_of(v) == v);
+                REQUIRE(LatencyHistogram::lowest_value(v) == v);
+                REQUIRE(LatencyHistogram::highest_value(v) == v);
+            }
+        }
+
+        THEN(" every value lies within its bucket ") {
+            for(uint64_t v = 1; v < (uint64_t{1} << 36); v = v * 3 + 7) {
+                const auto b = LatencyHistogram::bucket_of(v);
+                REQUIRE(b < LatencyHistogram::num_buckets);
+                REQUIRE(LatencyHistogram::lowest_value(b) <= v);
+                REQUIRE(LatencyHistogram::highest_value(b) >= v);
+                const auto width = LatencyHistogram::highest_value(b) -
+                                   LatencyHistogram::lowest_value(b) + 1;
+                REQUIRE(width * LatencyHistogram::sub_buckets <=
+                        LatencyHistogram::lowest_value(b) +
+                                LatencyHistogram::sub_buckets);
+            }
+        }
+
+        THEN(" buckets are contiguous ") {
+            for(unsigned b = 1; b < LatencyHistogram::num_buckets; b++) {
+                REQUIRE(LatencyHistogram::lowest_value(b) ==
+                        LatencyHistogram::highest_value(b - 1) + 1);
+                REQUIRE(LatencyHistogram::bucket_of(
+                                LatencyHistogram::lowest_value(b)) == b);
+            }
+        }
+
+        THEN(" values beyond the range go to the last bucket ") {
+            REQUIRE(LatencyHistogram::bucket_of(~uint64_t{0}) ==
+                    LatencyHistogram::num_buckets - 1);
+        }
+    }
+
+    GIVEN(" a histogram of 1000 values ") {
+        LatencyHistogram h;
+        for(uint64_t v = 1; v <= 1000; v++) {
+            h.record(v * 1000);
+        }
+        LatencyHistogram::counts counts{};
+        h.add_to(counts);
+
+        THEN(" percentiles are within the bucket precision ") {
+            for(double p : {1.0, 50.0, 90.0, 99.0, 100.0}) {
+                const auto expected = p * 10 * 1000;
+                const auto value =
+                        static_cast<double>(LatencyHistogram::value_at(counts, p));
+                REQUIRE(value >= expected * 0.99);
+                REQUIRE(value <= expected * (1.0 + 1.0 / 16));
+            }
+        }
+    }
+
+    GIVEN(" an empty histogram ") {
+        LatencyHistogram::counts counts{};
+
+        THEN(" percentiles are zero ") {
+            REQUIRE(LatencyHistogram::value_at(counts, 50) == 0);
+        }
+    }
+}
+
+SCENARIO(" stats are collected from concurrent threads ", "[stats]") {
+
+    GIVEN(" a Stats instance without output ") {
+        Stats stats(false, false, "", "");
+
+        WHEN(" more threads than shards add values ") {
+            const int threads = gkfs::config::stats::shards + 4;
+            const int per_thread = 10000;
+            std::vector<std::thread> workers;
+            for(int t = 0; t < threads; t++) {
+                workers.emplace_back([&] {
+                    const auto started = Stats::clock::now();
+                    for(int i = 0; i < per_thread; i++) {
+                        stats.add_value_iops(Stats::IopsOp::iops_create);
+                        stats.add_value_size(Stats::SizeOp::write_size, 4096,
+                                             started);
+                    }
+                });
+            }
+            for(auto& w : workers) {
+                w.join();
+            }
+
+            THEN(" no update is lost ") {
+                LatencyHistogram::counts counts = stats.get_latency(
+                        Stats::IopsOp::iops_write);
+                uint64_t n = 0;
+                for(auto c : counts) {
+                    n += c;
+                }
+                REQUIRE(n == uint64_t(threads) * per_thread);
+                REQUIRE(LatencyHistogram::value_at(
+                                stats.get_latency(Stats::IopsOp::iops_create),
+                                50) == 0);
+
+                const auto create = stats.get_four_means(
+                        Stats::IopsOp::iops_create);
+                const auto write = stats.get_four_means(
+                        Stats::SizeOp::write_size);
+                REQUIRE(create.size() == 4);
+                REQUIRE(write.size() == 4);
+                // all windows start with the server
+                REQUIRE(create[1] == Approx(create[3]));
+                REQUIRE(write[1] == Approx(write[2]));
+                REQUIRE(create[1] > 0);
+            }
+        }
+    }
+}
+
+SCENARIO(" the status lists totals and hot chunks ", "[stats]") {
+
+    GIVEN(" a Stats instance with chunk statistics ") {
+        Stats stats(true, false, "", "");
+
+        WHEN(" chunks are read and written ") {
+            for(int i = 0; i < 3; i++) {
+                stats.add_value_size(Stats::SizeOp::read_size, 100);
+                stats.add_read("/a", 1);
+            }
+            stats.add_read("/b", 7);
+            stats.add_value_size(Stats::SizeOp::write_size, 10);
+            stats.add_write("/a", 2);
+
+            THEN(" the status has the totals and the hottest chunks ") {
+                std::map<std::string, uint64_t> status{};
+                std::vector<std::string> hot_reads{};
+                for(const auto& [name, value] : stats.status(1)) {
+                    status[name] = value;
+                    if(name.rfind("hot_read/", 0) == 0)
+                        hot_reads.push_back(name);
+                }
+                REQUIRE(status["ops/iops_read"] == 3);
+                REQUIRE(status["ops/iops_write"] == 1);
+                REQUIRE(status["bytes/read_size"] == 300);
+                REQUIRE(status["bytes/write_size"] == 10);
+                REQUIRE(status.count("p99_ns/iops_create") == 1);
+                REQUIRE(hot_reads == std::vector<std::string>{"hot_read/1//a"});
+                REQUIRE(status["hot_read/1//a"] == 3);
+                REQUIRE(status["hot_write/2//a"] == 1);
+            }
+        }
+    }
+
+    GIVEN(" a Stats instance without chunk statistics ") {
+        Stats stats(false, false, "", "");
+        stats.add_read("/a", 1);
+
+        THEN(" no hot chunks are listed ") {
+            for(const auto& entry : stats.status(8)) {
+                REQUIRE(entry.first.rfind("hot_", 0) == std::string::npos);
+            }
+        }
+    }
+}
+
+SCENARIO(" the space-saving sketch finds the most frequent keys ",
+         "[stats][top_k]") {
+
+    GIVEN(" a sketch of 16 keys and a skewed stream of 1000 keys ") {
+        SpaceSaving<int> sketch(16);
+        // key k < 8 occurs 1000 * (8 - k) times, every other key once
+        std::vector<int> stream;
+        for(int k = 0; k < 8; k++) {
+            stream.insert(stream.end(), 1000 * (8 - k), k);
+        }
+        for(int k = 8; k < 1000; k++) {
+            stream.push_back(k);
+        }
+        // interleave the heavy keys with the tail
+        for(std::size_t i = 0; i < stream.size(); i += 7) {
+            std::swap(stream[i], stream[stream.size() - 1 - i / 7]);
+        }
+        for(auto k : stream) {
+            sketch.add(k);
+        }
+
+        THEN(" memory is bounded ") {
+            REQUIRE(sketch.size() == 16);
+        }
+
+        THEN(" the heavy keys are reported in order ") {
+            const auto top = sketch.top(8);
+            REQUIRE(top.size() == 8);
+            for(int k = 0; k < 8; k++) {
+                REQUIRE(top[k].first == k);
+                // counts overestimate by at most the minimum count
+                REQUIRE(top[k].second >= uint64_t(1000 * (8 - k)));
+                REQUIRE(top[k].second <= uint64_t(1000 * (8 - k)) +
+                                                  stream.size() / 16);
+            }
+        }
+
+        WHEN(" an interval is taken ") {
+            auto first = sketch.take_interval(4);
+            REQUIRE(first.size() == 4);
+            REQUIRE(first[0].first == 0);
+
+            THEN(" the next interval only counts new occurrences ") {
+                REQUIRE(sketch.take_interval(4).empty());
+                sketch.add(5, 3);
+                sketch.add(6);
+                const auto second = sketch.take_interval(4);
+                REQUIRE(second.size() == 2);
+                REQUIRE(second[0] == std::pair<int, uint64_t>(5, 3));
+                REQUIRE(second[1] == std::pair<int, uint64_t>(6, 1));
+            }
+        }
+    }
+
+    GIVEN(" a sketch without capacity ") {
+        SpaceSaving<int> sketch(0);
+
+        THEN(" nothing is tracked ") {
+            REQUIRE(sketch.add(1, 2) == 2);
+            REQUIRE(sketch.size() == 0);
+            REQUIRE(sketch.estimate(1) == 0);
+        }
+    }
+}
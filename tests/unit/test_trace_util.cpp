@@ -0,0 +1,186 @@
+/*
+  Copyright 2018-2022, Barcelona Supercomputing Center (BSC), Spain
+  Copyright 2015-2022, Johannes Gutenberg Universitaet Mainz, Germany
+
+  This software was partially supported by the
+  EC H2020 funded project NEXTGenIO (Project ID: 671951, www.nextgenio.eu).
+
+  This software was partially supported by the
+  ADA-FS project under the SPPEXA project funded by the DFG.
+
+  This file is part of GekkoFS.
+
+  GekkoFS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  GekkoFS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with GekkoFS.  If not, see <https://www.gnu.org/licenses/>.
+
+  SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <catch2/catch.hpp>
+#include <common/trace_util.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace gkfs::trace;
+
+namespace {
+
+long
+write_fd(int fd, const void* buf, size_t count) {
+    return ::write(fd, buf, count);
+}
+
+/**
+ * Reads the records of a trace file and checks its header
+ */
+std::vector<record>
+read_records(FILE* file) {
+    std::fflush(file);
+    std::rewind(file);
+    file_header header{};
+    REQUIRE(std::fread(&header, sizeof(header), 1, file) == 1);
+    REQUIRE(std::memcmp(header.magic, file_magic, sizeof(file_magic)) == 0);
+    std::vector<record> records;
+    record r{};
+    while(std::fread(&r, sizeof(r), 1, file) == 1) {
+        records.push_back(r);
+    }
+    return records;
+}
+
+const record*
+find(const std::vector<record>& records, const std::string& name) {
+    for(const auto& r : records) {
+        if(name == r.name)
+            return &r;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+SCENARIO("spans are written to a trace file", "[trace_util]") {
+
+    GIVEN("A writer to a temporary file") {
+        FILE* file = std::tmpfile();
+        REQUIRE(file != nullptr);
+        auto w = std::make_unique<writer>(fileno(file), write_fd);
+
+        WHEN("A span with nested spans ends") {
+            uint64_t trace_id = new_id();
+            {
+                span root(w.get(), "pwrite", trace_id, 0);
+                auto rpc = root.child("rpc:write");
+                auto ctx = rpc.rpc_context();
+                REQUIRE(ctx);
+                REQUIRE(ctx.trace_id == trace_id);
+                REQUIRE(ctx.span_id == rpc.id());
+
+                // the serving side continues the trace from the context
+                auto handler = handler_span(w.get(), "handler:write", ctx);
+                REQUIRE(handler.active());
+                handler.child("io_wait").end();
+            }
+            w->flush();
+
+            THEN("All spans are recorded with their parents") {
+                auto records = read_records(file);
+                REQUIRE(records.size() == 5);
+                auto root = find(records, "pwrite");
+                auto rpc = find(records, "rpc:write");
+                auto handler = find(records, "handler:write");
+                auto io = find(records, "io_wait");
+                REQUIRE(root);
+                REQUIRE(rpc);
+                REQUIRE(handler);
+                REQUIRE(io);
+                for(const auto& r : records) {
+                    REQUIRE(r.trace_id == trace_id);
+                    REQUIRE(r.start <= r.end);
+                    REQUIRE(r.pid == static_cast<uint32_t>(::getpid()));
+                }
+                REQUIRE(root->parent_id == 0);
+                REQUIRE(rpc->parent_id == root->span_id);
+                REQUIRE(handler->parent_id == rpc->span_id);
+                REQUIRE(io->parent_id == handler->span_id);
+            }
+            THEN("The time between sending and serving is a queue span") {
+                auto records = read_records(file);
+                auto rpc = find(records, "rpc:write");
+                auto queue = find(records, "queue");
+                REQUIRE(queue);
+                REQUIRE(queue->parent_id == rpc->span_id);
+                REQUIRE(queue->start >= rpc->start);
+                REQUIRE(queue->end <= find(records, "handler:write")->start);
+            }
+        }
+
+        WHEN("Spans are not part of a trace") {
+            span none(w.get(), "pwrite", 0, 0);
+            auto child = none.child("rpc:write");
+            auto handler = handler_span(w.get(), "handler:write",
+                                        child.rpc_context());
+            THEN("Nothing is recorded") {
+                REQUIRE_FALSE(none.active());
+                REQUIRE_FALSE(child.active());
+                REQUIRE_FALSE(child.rpc_context());
+                REQUIRE_FALSE(handler.active());
+                w->flush();
+                REQUIRE(read_records(file).empty());
+            }
+        }
+
+        WHEN("More records are added than fit into the buffer") {
+            for(size_t i = 0; i < writer::buffer_records + 10; i++) {
+                span(w.get(), "op", 1, 0).end();
+            }
+            THEN("Full buffers are written out, the rest on destruction") {
+                REQUIRE(read_records(file).size() == writer::buffer_records);
+                w.reset();
+                REQUIRE(read_records(file).size() ==
+                        writer::buffer_records + 10);
+            }
+        }
+
+        w.reset();
+        std::fclose(file);
+    }
+}
+
+SCENARIO("operations are sampled", "[trace_util]") {
+
+    GIVEN("Sampling rates") {
+        THEN("The fraction of sampled calls matches the rate") {
+            REQUIRE_FALSE(sample(0.0));
+            REQUIRE(sample(1.0));
+            int sampled = 0;
+            for(int i = 0; i < 100000; i++) {
+                sampled += sample(0.1);
+            }
+            REQUIRE(sampled > 9000);
+            REQUIRE(sampled < 11000);
+        }
+        THEN("Ids are unique and not zero") {
+            auto a = new_id();
+            auto b = new_id();
+            REQUIRE(a != 0);
+            REQUIRE(b != 0);
+            REQUIRE(a != b);
+        }
+    }
+}